@@ -0,0 +1,497 @@
+/**
+ * @file compile_bench.c
+ * @brief 编译时间伸缩性基准：逐维度放大合成 SysY 程序，测量每个阶段与每个优化遍。
+ * @details
+ * 对 sysy_gen 的五个维度（函数个数、循环嵌套、表达式深度、数组长度、CFG 宽度）
+ * 分别按倍数序列放大，其余维度保持默认值，生成程序后以
+ * `sysyc --perf-counters -S` 编译，从其报告中读出各阶段（parse、semantic、
+ * ir_gen+opt、ipo）与 ir_optimizer.c 中各分析/变换遍的累计时间，并记录：
+ *   - 时间：每个配置重复编译若干次，各区间取最小值以压低噪声；
+ *   - 内存：编译进程的峰值 RSS（wait4 返回的 ru_maxrss）；
+ *   - 吞吐：输出 IR 的指令条数除以区间时间（指令/秒）。
+ *
+ * 伸缩性：对每个维度、每个区间，以 log(时间) 对 log(IR 指令数) 做最小二乘拟合，
+ * 斜率超过 --max-slope 视为超线性。低于 --min-ms 的测量点只含噪声，不参与拟合。
+ *
+ * 回归：--save-baseline 记录本次结果；--baseline 读入之前的结果，任一区间的时间
+ * 超过基线 (1 + --threshold) 倍且绝对差超过 --min-ms 即视为回归。
+ *
+ * 发现超线性或回归时以状态 1 退出，其他错误以状态 2 退出。
+ *
+ * 用法: compile_bench --compiler <sysyc> [--work-dir DIR] [--sizes 1,2,4,8]
+ *                     [--dims functions,loop_depth,...] [--repeat N] [--jobs N]
+ *                     [--baseline FILE] [--save-baseline FILE] [--threshold PCT]
+ *                     [--max-slope X] [--min-ms MS]
+ */
+#define _DEFAULT_SOURCE /* wait4 */
+#include "sysy_gen.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SIZES 8
+#define MAX_REGIONS 64
+#define NAME_LEN 32
+
+enum { DIM_FUNCTIONS, DIM_LOOP_DEPTH, DIM_EXPR_DEPTH, DIM_ARRAY_SIZE, DIM_CFG_WIDTH, DIM_COUNT };
+
+/* 一个维度：放大时取 unit * 倍数 */
+static const struct {
+  const char *name;
+  int unit;
+} dims[DIM_COUNT] = {
+    [DIM_FUNCTIONS] = {"functions", 32},   [DIM_LOOP_DEPTH] = {"loop_depth", 1},
+    [DIM_EXPR_DEPTH] = {"expr_depth", 8},  [DIM_ARRAY_SIZE] = {"array_size", 64},
+    [DIM_CFG_WIDTH] = {"cfg_width", 4},
+};
+
+typedef struct {
+  char name[NAME_LEN];
+  double ms;
+} Region;
+
+/* 一次配置（维度 × 倍数）的测量结果；regions[0] 为整个编译进程 */
+typedef struct {
+  int mult;
+  long instrs;
+  long rss_kb;
+  int region_count;
+  Region regions[MAX_REGIONS];
+} Run;
+
+static struct {
+  const char *compiler;
+  char work_dir[256];
+  int sizes[MAX_SIZES];
+  int size_count;
+  bool dim_enabled[DIM_COUNT];
+  int repeat;
+  int jobs;
+  const char *baseline;
+  const char *save_baseline;
+  double threshold;
+  double max_slope;
+  double min_ms;
+} opts = {
+    .sizes = {1, 2, 4, 8},
+    .size_count = 4,
+    .repeat = 3,
+    .jobs = 1,
+    .threshold = 25.0,
+    .max_slope = 1.3,
+    .min_ms = 2.0,
+};
+
+static int failures = 0;
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static const Region *find_region(const Run *run, const char *name) {
+  for (int i = 0; i < run->region_count; i++)
+    if (strcmp(run->regions[i].name, name) == 0)
+      return &run->regions[i];
+  return NULL;
+}
+
+/* 记录一次测量，重复测量取最小值 */
+static void record(Run *run, const char *name, double ms) {
+  Region *r = (Region *)find_region(run, name);
+  if (!r) {
+    if (run->region_count == MAX_REGIONS)
+      return;
+    r = &run->regions[run->region_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+  } else if (r->ms <= ms) {
+    return;
+  }
+  r->ms = ms;
+}
+
+/* 解析 --perf-counters 报告中的 "Per-phase counters:" 与 "Per-pass counters:" 两张表 */
+static void parse_report(Run *run, const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return;
+  char line[512];
+  bool in_table = false;
+  while (fgets(line, sizeof(line), fp)) {
+    if (strncmp(line, "Per-phase counters:", 19) == 0 || strncmp(line, "Per-pass counters:", 18) == 0) {
+      in_table = true;
+      continue;
+    }
+    if (!in_table)
+      continue;
+    if (strncmp(line, "  ", 2) != 0) {
+      in_table = false;
+      continue;
+    }
+    char name[NAME_LEN];
+    unsigned calls;
+    double ms;
+    if (sscanf(line, "%31s %u %lf", name, &calls, &ms) == 3)
+      record(run, name, ms);
+  }
+  fclose(fp);
+}
+
+/* 输出 IR 中以两个空格缩进的行即指令 */
+static long count_instructions(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return 0;
+  char line[4096];
+  long count = 0;
+  bool line_start = true;
+  while (fgets(line, sizeof(line), fp)) {
+    if (line_start && line[0] == ' ' && line[1] == ' ' && line[2] != ' ')
+      count++;
+    line_start = strchr(line, '\n') != NULL;
+  }
+  fclose(fp);
+  return count;
+}
+
+static void dump_file(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return;
+  char line[512];
+  while (fgets(line, sizeof(line), fp))
+    fputs(line, stderr);
+  fclose(fp);
+}
+
+/* 在工作目录中编译一次 src，把输出写到 out、报告写到 log；成功时返回 true */
+static bool compile_once(const char *src, const char *out, const char *log, Run *run) {
+  char jobs[16];
+  snprintf(jobs, sizeof(jobs), "%d", opts.jobs);
+  char *const argv[] = {(char *)opts.compiler, "-S", "-o", (char *)out, "--perf-counters",
+                        "--log-level", "warning", "-j", jobs, "asm", (char *)src, NULL};
+
+  double t0 = now_ms();
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    return false;
+  }
+  if (pid == 0) {
+    /* sysyc 把中间文件写在当前目录，因此在工作目录中运行 */
+    int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || chdir(opts.work_dir) != 0)
+      _exit(127);
+    dup2(fd, 2);
+    close(fd);
+    execv(opts.compiler, argv);
+    _exit(127);
+  }
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    perror("wait4");
+    return false;
+  }
+  double elapsed = now_ms() - t0;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "compile_bench: '%s' failed on %s (status %d):\n", opts.compiler, src, status);
+    dump_file(log);
+    return false;
+  }
+  record(run, "total", elapsed);
+  if (usage.ru_maxrss > run->rss_kb)
+    run->rss_kb = usage.ru_maxrss;
+  parse_report(run, log);
+  return true;
+}
+
+static bool measure(int dim, int mult, Run *run) {
+  SysyGenParams params;
+  sysy_gen_default_params(&params);
+  int value = dims[dim].unit * mult;
+  switch (dim) {
+  case DIM_FUNCTIONS:
+    params.functions = value;
+    break;
+  case DIM_LOOP_DEPTH:
+    params.loop_depth = value;
+    break;
+  case DIM_EXPR_DEPTH:
+    params.expr_depth = value;
+    break;
+  case DIM_ARRAY_SIZE:
+    params.array_size = value;
+    break;
+  default:
+    params.cfg_width = value;
+    break;
+  }
+
+  char src[512], out[512], log[512];
+  snprintf(src, sizeof(src), "%s/%s_x%d.sy", opts.work_dir, dims[dim].name, mult);
+  snprintf(out, sizeof(out), "%s/%s_x%d.ll", opts.work_dir, dims[dim].name, mult);
+  snprintf(log, sizeof(log), "%s/%s_x%d.log", opts.work_dir, dims[dim].name, mult);
+  FILE *fp = fopen(src, "w");
+  if (!fp) {
+    perror(src);
+    return false;
+  }
+  sysy_gen_write(fp, &params);
+  fclose(fp);
+
+  memset(run, 0, sizeof(*run));
+  run->mult = mult;
+  for (int r = 0; r < opts.repeat; r++)
+    if (!compile_once(src, out, log, run))
+      return false;
+  run->instrs = count_instructions(out);
+  return true;
+}
+
+/* log(ms) 对 log(instrs) 的最小二乘斜率；有效点少于两个或规模变化太小时返回 NAN */
+static double fit_slope(const Run *runs, int count, const char *name) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int n = 0;
+  long lo = 0, hi = 0;
+  for (int i = 0; i < count; i++) {
+    const Region *r = find_region(&runs[i], name);
+    if (!r || r->ms < opts.min_ms || runs[i].instrs <= 0)
+      continue;
+    double x = log((double)runs[i].instrs), y = log(r->ms);
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    if (n == 0 || runs[i].instrs < lo)
+      lo = runs[i].instrs;
+    if (runs[i].instrs > hi)
+      hi = runs[i].instrs;
+    n++;
+  }
+  if (n < 2 || (double)hi < 1.5 * (double)lo)
+    return NAN;
+  double denom = n * sxx - sx * sx;
+  return denom > 0 ? (n * sxy - sx * sy) / denom : NAN;
+}
+
+static void report_dim(int dim, const Run *runs, int count) {
+  printf("\n== %s ==\n  %-18s", dims[dim].name, "size");
+  for (int i = 0; i < count; i++)
+    printf(" %10d", dims[dim].unit * runs[i].mult);
+  printf("\n  %-18s", "IR instructions");
+  for (int i = 0; i < count; i++)
+    printf(" %10ld", runs[i].instrs);
+  printf("\n  %-18s", "peak RSS (MB)");
+  for (int i = 0; i < count; i++)
+    printf(" %10.1f", (double)runs[i].rss_kb / 1024.0);
+  printf("\n  %-18s", "time (ms)");
+  printf("%*s %6s %12s\n", 11 * count, "", "slope", "Minstr/s");
+
+  /* 区间按最大规模那次的出现顺序列出：先总时间，再阶段，再各遍 */
+  const Run *last = &runs[count - 1];
+  for (int k = 0; k < last->region_count; k++) {
+    const char *name = last->regions[k].name;
+    printf("  %-18s", name);
+    for (int i = 0; i < count; i++) {
+      const Region *r = find_region(&runs[i], name);
+      printf(" %10.3f", r ? r->ms : 0.0);
+    }
+    double slope = fit_slope(runs, count, name);
+    double ms = last->regions[k].ms;
+    double throughput = ms > 0 ? (double)last->instrs / ms / 1e3 : 0.0;
+    if (isnan(slope))
+      printf(" %6s %12.3f\n", "-", throughput);
+    else
+      printf(" %6.2f %12.3f%s\n", slope, throughput,
+             slope > opts.max_slope ? "  <-- superlinear" : "");
+    if (!isnan(slope) && slope > opts.max_slope)
+      failures++;
+  }
+}
+
+static void save_baseline(FILE *fp, int dim, const Run *runs, int count) {
+  for (int i = 0; i < count; i++)
+    for (int k = 0; k < runs[i].region_count; k++)
+      fprintf(fp, "%s %d %s %.3f\n", dims[dim].name, runs[i].mult, runs[i].regions[k].name,
+              runs[i].regions[k].ms);
+}
+
+/* 逐行读入基线，与本次结果中相同 (维度, 倍数, 区间) 的测量比较 */
+static void compare_baseline(FILE *fp, Run all_runs[DIM_COUNT][MAX_SIZES]) {
+  char line[256];
+  int compared = 0;
+  printf("\n== baseline comparison (threshold %.0f%%) ==\n", opts.threshold);
+  while (fgets(line, sizeof(line), fp)) {
+    char dim_name[NAME_LEN], name[NAME_LEN];
+    int mult;
+    double base_ms;
+    if (line[0] == '#' || sscanf(line, "%31s %d %31s %lf", dim_name, &mult, name, &base_ms) != 4)
+      continue;
+    for (int d = 0; d < DIM_COUNT; d++) {
+      if (!opts.dim_enabled[d] || strcmp(dims[d].name, dim_name) != 0)
+        continue;
+      for (int i = 0; i < opts.size_count; i++) {
+        if (all_runs[d][i].mult != mult)
+          continue;
+        const Region *r = find_region(&all_runs[d][i], name);
+        if (!r)
+          continue;
+        compared++;
+        if (r->ms > base_ms * (1.0 + opts.threshold / 100.0) && r->ms - base_ms > opts.min_ms) {
+          printf("  REGRESSION %-10s x%-2d %-18s %10.3f ms -> %10.3f ms (%+.0f%%)\n", dim_name,
+                 mult, name, base_ms, r->ms, (r->ms / base_ms - 1.0) * 100.0);
+          failures++;
+        }
+      }
+    }
+  }
+  printf("  %d measurements compared\n", compared);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s --compiler <sysyc> [--work-dir DIR] [--sizes 1,2,4,8]\n"
+          "          [--dims functions,loop_depth,expr_depth,array_size,cfg_width]\n"
+          "          [--repeat N] [--jobs N] [--baseline FILE] [--save-baseline FILE]\n"
+          "          [--threshold PCT] [--max-slope X] [--min-ms MS]\n",
+          prog);
+}
+
+static bool parse_list(char *list, bool dims_list) {
+  if (dims_list)
+    memset(opts.dim_enabled, 0, sizeof(opts.dim_enabled));
+  else
+    opts.size_count = 0;
+  for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+    if (!dims_list) {
+      int mult = atoi(tok);
+      if (mult <= 0 || opts.size_count == MAX_SIZES)
+        return false;
+      opts.sizes[opts.size_count++] = mult;
+      continue;
+    }
+    int d = 0;
+    while (d < DIM_COUNT && strcmp(dims[d].name, tok) != 0)
+      d++;
+    if (d == DIM_COUNT)
+      return false;
+    opts.dim_enabled[d] = true;
+  }
+  return dims_list || opts.size_count > 0;
+}
+
+int main(int argc, char **argv) {
+  for (int d = 0; d < DIM_COUNT; d++)
+    opts.dim_enabled[d] = true;
+  for (int i = 1; i < argc; i++) {
+    const char *opt = argv[i];
+    char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    bool ok = value != NULL;
+    if (ok && strcmp(opt, "--compiler") == 0)
+      opts.compiler = value;
+    else if (ok && strcmp(opt, "--work-dir") == 0)
+      snprintf(opts.work_dir, sizeof(opts.work_dir), "%s", value);
+    else if (ok && strcmp(opt, "--sizes") == 0)
+      ok = parse_list(value, false);
+    else if (ok && strcmp(opt, "--dims") == 0)
+      ok = parse_list(value, true);
+    else if (ok && strcmp(opt, "--repeat") == 0)
+      ok = (opts.repeat = atoi(value)) > 0;
+    else if (ok && strcmp(opt, "--jobs") == 0)
+      ok = (opts.jobs = atoi(value)) >= 0;
+    else if (ok && strcmp(opt, "--baseline") == 0)
+      opts.baseline = value;
+    else if (ok && strcmp(opt, "--save-baseline") == 0)
+      opts.save_baseline = value;
+    else if (ok && strcmp(opt, "--threshold") == 0)
+      opts.threshold = atof(value);
+    else if (ok && strcmp(opt, "--max-slope") == 0)
+      opts.max_slope = atof(value);
+    else if (ok && strcmp(opt, "--min-ms") == 0)
+      opts.min_ms = atof(value);
+    else
+      ok = false;
+    if (!ok) {
+      usage(argv[0]);
+      return 2;
+    }
+    i++;
+  }
+  if (!opts.compiler) {
+    usage(argv[0]);
+    return 2;
+  }
+  /* 工作目录会被 chdir，编译器路径需为绝对路径 */
+  static char compiler_path[4096];
+  if (!realpath(opts.compiler, compiler_path)) {
+    perror(opts.compiler);
+    return 2;
+  }
+  opts.compiler = compiler_path;
+  if (opts.work_dir[0] == '\0') {
+    snprintf(opts.work_dir, sizeof(opts.work_dir), "/tmp/sysyc_bench_XXXXXX");
+    if (!mkdtemp(opts.work_dir)) {
+      perror("mkdtemp");
+      return 2;
+    }
+  } else if (mkdir(opts.work_dir, 0755) != 0 && errno != EEXIST) {
+    perror(opts.work_dir);
+    return 2;
+  }
+  char work_dir[4096];
+  if (!realpath(opts.work_dir, work_dir) || strlen(work_dir) >= sizeof(opts.work_dir)) {
+    perror(opts.work_dir);
+    return 2;
+  }
+  snprintf(opts.work_dir, sizeof(opts.work_dir), "%s", work_dir);
+
+  printf("compile_bench: %s, work dir %s, %d repeat(s), -j %d\n", opts.compiler, opts.work_dir,
+         opts.repeat, opts.jobs);
+  static Run runs[DIM_COUNT][MAX_SIZES];
+  for (int d = 0; d < DIM_COUNT; d++) {
+    if (!opts.dim_enabled[d])
+      continue;
+    for (int i = 0; i < opts.size_count; i++)
+      if (!measure(d, opts.sizes[i], &runs[d][i]))
+        return 2;
+    report_dim(d, runs[d], opts.size_count);
+  }
+
+  if (opts.baseline) {
+    FILE *fp = fopen(opts.baseline, "r");
+    if (fp) {
+      compare_baseline(fp, runs);
+      fclose(fp);
+    } else {
+      printf("\nbaseline %s not found; skipping comparison\n", opts.baseline);
+    }
+  }
+  if (opts.save_baseline) {
+    FILE *fp = fopen(opts.save_baseline, "w");
+    if (!fp) {
+      perror(opts.save_baseline);
+      return 2;
+    }
+    fprintf(fp, "# dimension multiplier region ms\n");
+    for (int d = 0; d < DIM_COUNT; d++)
+      if (opts.dim_enabled[d])
+        save_baseline(fp, d, runs[d], opts.size_count);
+    fclose(fp);
+    printf("\nbaseline written to %s\n", opts.save_baseline);
+  }
+
+  if (failures)
+    printf("\n%d scaling/regression failure(s)\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,455 @@
+/**
+ * @file ir_containers_bench.c
+ * @brief IR 核心容器的微基准：Worklist、BitSet、ValueMap、pool_alloc 与 use 链操作。
+ * @details
+ * 每个基准模拟一个真实遍中的访问模式，而不是孤立地反复调用单个函数：
+ *   - worklist/sccp_churn       SCCP 式的工作列表：弹出一条指令后把它的若干用户
+ *                               （in_worklist 去重）压回，列表每轮新建；
+ *   - bitset/dominators         compute_dominators 式的迭代数据流：对每个块求前驱
+ *                               支配集的交集，直到不动点；
+ *   - value_map/inliner_burst   内联式的突发映射：每个调用点新建 ValueMap，
+ *                               放入形参与被复制指令的映射，再逐个重映射操作数；
+ *   - pool_alloc/ir_objects     按指令、操作数、值的比例从新内存池分配 IR 对象；
+ *   - use_list/add_operand      add_value_operand 构建 use 链；
+ *   - use_list/rauw             replace_all_uses_with 把每个值的所有使用改到新值；
+ *   - use_list/change_operand   change_operand_value 随机改写操作数（单链 use 表的
+ *                               删除代价随使用数线性增长）。
+ *
+ * 每个基准重复运行直到累计时间达到 --min-time，报告 ns/op 以及每次操作的
+ * pool_alloc 次数、池字节数与 malloc 次数。分配次数通过链接器的
+ * `--wrap=pool_alloc,--wrap=malloc` 统计，因此只包含跨编译单元的调用
+ * （ast.c 内部对 pool_alloc 的调用，如 pool_strdup，不计入），计数本身的开销
+ * 也包含在 ns/op 中。准备数据的时间与分配不计入。
+ *
+ * --history FILE 把结果追加到 CSV 文件，并与该文件中同一基准的上一条记录比较，
+ * 便于在容器实现改动前后客观对比。
+ *
+ * 用法: ir_containers_bench [--min-time SEC] [--filter SUBSTR]
+ *                           [--history FILE] [--label TEXT]
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "ast.h"
+#include "ir/ir.h"
+#include "ir/ir_utils.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+IRModule *create_ir_module(const char *source_filename, LogConfig *log_config);
+
+/* --- 分配计数（链接时以 --wrap 接管）--- */
+typedef struct {
+  uint64_t pool_allocs;
+  uint64_t pool_bytes;
+  uint64_t mallocs;
+} AllocCounters;
+
+static AllocCounters counters;
+
+void *__real_pool_alloc(MemoryPool *pool, size_t size);
+void *__wrap_pool_alloc(MemoryPool *pool, size_t size) {
+  counters.pool_allocs++;
+  counters.pool_bytes += size;
+  return __real_pool_alloc(pool, size);
+}
+
+void *__real_malloc(size_t size);
+void *__wrap_malloc(size_t size) {
+  counters.mallocs++;
+  return __real_malloc(size);
+}
+
+/* --- 计时：基准可以暂停计时以排除准备数据的开销 --- */
+typedef struct {
+  double ns;           /* 已累计的计时时间 */
+  double started;      /* 当前计时段的起点 */
+  AllocCounters alloc; /* 已累计的分配 */
+  AllocCounters alloc_started;
+  uint64_t ops;
+} BenchCtx;
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench_resume(BenchCtx *ctx) {
+  ctx->alloc_started = counters;
+  ctx->started = now_ns();
+}
+
+static void bench_pause(BenchCtx *ctx) {
+  ctx->ns += now_ns() - ctx->started;
+  ctx->alloc.pool_allocs += counters.pool_allocs - ctx->alloc_started.pool_allocs;
+  ctx->alloc.pool_bytes += counters.pool_bytes - ctx->alloc_started.pool_bytes;
+  ctx->alloc.mallocs += counters.mallocs - ctx->alloc_started.mallocs;
+}
+
+/* 固定种子的 xorshift，使每次运行的访问序列一致 */
+static uint32_t rng_state;
+static uint32_t rng_next(void) {
+  uint32_t x = rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return rng_state = x;
+}
+
+/* --- worklist/sccp_churn --- */
+#define CHURN_INSTRS 4096
+
+static void bench_worklist_churn(BenchCtx *ctx) {
+  static IRInstruction instrs[CHURN_INSTRS];
+  static int users[CHURN_INSTRS][3];
+  for (int i = 0; i < CHURN_INSTRS; i++) {
+    instrs[i].in_worklist = false;
+    for (int k = 0; k < 3; k++)
+      users[i][k] = (int)(rng_next() % CHURN_INSTRS);
+  }
+  MemoryPool *pool = create_memory_pool();
+
+  bench_resume(ctx);
+  Worklist *wl = create_worklist(pool, 16);
+  uint64_t ops = 0, budget = 4 * CHURN_INSTRS;
+  for (int i = 0; i < CHURN_INSTRS; i++) {
+    worklist_add(wl, &instrs[i]);
+    instrs[i].in_worklist = true;
+    ops++;
+  }
+  while (!worklist_empty(wl)) {
+    IRInstruction *instr = worklist_pop(wl);
+    instr->in_worklist = false;
+    ops++;
+    /* 格值下降是有限的：总压入数有上限，保证收敛 */
+    int idx = (int)(instr - instrs);
+    for (int k = 0; k < 3 && budget; k++) {
+      IRInstruction *user = &instrs[users[idx][k]];
+      if (!user->in_worklist && (rng_next() & 1)) {
+        worklist_add(wl, user);
+        user->in_worklist = true;
+        ops++;
+        budget--;
+      }
+    }
+  }
+  destroy_worklist(wl);
+  bench_pause(ctx);
+
+  destroy_memory_pool(pool);
+  ctx->ops += ops;
+}
+
+/* --- bitset/dominators --- */
+#define DOM_BLOCKS 512
+#define DOM_MAX_PREDS 4
+
+static void bench_bitset_dominators(BenchCtx *ctx) {
+  /* 基本顺序链加随机前向边与回边，块号即逆后序 */
+  static int preds[DOM_BLOCKS][DOM_MAX_PREDS];
+  static int num_preds[DOM_BLOCKS];
+  for (int b = 0; b < DOM_BLOCKS; b++) {
+    num_preds[b] = 0;
+    if (b > 0)
+      preds[b][num_preds[b]++] = b - 1;
+  }
+  for (int b = 2; b < DOM_BLOCKS; b++) {
+    int extra = (int)(rng_next() % 3);
+    for (int k = 0; k < extra && num_preds[b] < DOM_MAX_PREDS; k++) {
+      int from = (int)(rng_next() % DOM_BLOCKS);
+      if (from != b && from != 0)
+        preds[b][num_preds[b]++] = from;
+    }
+  }
+  MemoryPool *pool = create_memory_pool();
+
+  bench_resume(ctx);
+  BitSet *dom[DOM_BLOCKS];
+  for (int b = 0; b < DOM_BLOCKS; b++) {
+    dom[b] = bitset_create(DOM_BLOCKS, pool);
+    if (b == 0)
+      bitset_add(dom[b], 0, NULL);
+    else
+      bitset_set_all(dom[b], DOM_BLOCKS);
+  }
+  BitSet *tmp = bitset_create(DOM_BLOCKS, pool);
+  uint64_t ops = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = 1; b < DOM_BLOCKS; b++) {
+      bitset_set_all(tmp, DOM_BLOCKS);
+      for (int k = 0; k < num_preds[b]; k++)
+        bitset_intersect(tmp, dom[preds[b][k]]);
+      bitset_add(tmp, b, NULL);
+      ops += num_preds[b] + 3;
+      if (!bitset_equals(tmp, dom[b])) {
+        bitset_copy(dom[b], tmp);
+        ops++;
+        changed = true;
+      }
+    }
+  }
+  bench_pause(ctx);
+
+  destroy_memory_pool(pool);
+  ctx->ops += ops;
+}
+
+/* --- value_map/inliner_burst --- */
+static volatile uintptr_t sink; /* 防止查找结果被优化掉 */
+#define BURST_SITES 64
+#define BURST_VALUES 256
+#define BURST_PARAMS 4
+
+static void bench_value_map_burst(BenchCtx *ctx) {
+  MemoryPool *pool = create_memory_pool();
+  Type *i32 = create_basic_type(BASIC_INT, false, pool);
+  IRValue *callee[BURST_VALUES], *clone[BURST_VALUES];
+  for (int i = 0; i < BURST_VALUES; i++) {
+    callee[i] = create_ir_value(pool);
+    callee[i]->type = i32;
+    clone[i] = create_ir_value(pool);
+    clone[i]->type = i32;
+  }
+  IRValue *globals[8];
+  for (int i = 0; i < 8; i++) {
+    globals[i] = create_ir_value(pool);
+    globals[i]->type = i32;
+  }
+  uint32_t operand_seq[2 * BURST_VALUES];
+  for (int i = 0; i < 2 * BURST_VALUES; i++)
+    operand_seq[i] = rng_next();
+
+  bench_resume(ctx);
+  uint64_t ops = 0;
+  for (int site = 0; site < BURST_SITES; site++) {
+    ValueMap map;
+    value_map_init(&map, pool);
+    /* 形参映射到实参，再按顺序复制每条指令：先重映射它的操作数，再登记结果 */
+    for (int p = 0; p < BURST_PARAMS; p++)
+      value_map_put(&map, callee[p], clone[p], NULL);
+    ops += BURST_PARAMS;
+    for (int i = BURST_PARAMS; i < BURST_VALUES; i++) {
+      for (int k = 0; k < 2; k++) {
+        uint32_t r = operand_seq[2 * i + k];
+        /* 约八分之一的操作数引用全局变量，查找失败后原样保留 */
+        IRValue *operand = (r & 7) == 0 ? globals[(r >> 3) & 7] : callee[(r >> 3) % (uint32_t)i];
+        sink ^= (uintptr_t)remap_value(&map, operand);
+      }
+      value_map_put(&map, callee[i], clone[i], NULL);
+      ops += 3;
+    }
+  }
+  bench_pause(ctx);
+
+  destroy_memory_pool(pool);
+  ctx->ops += ops;
+}
+
+/* --- pool_alloc/ir_objects --- */
+#define POOL_OBJECTS 65536
+
+static void bench_pool_alloc(BenchCtx *ctx) {
+  bench_resume(ctx);
+  MemoryPool *pool = create_memory_pool();
+  /* 典型比例：每条指令一个结果值、两个操作数 */
+  for (int i = 0; i < POOL_OBJECTS; i += 4) {
+    pool_alloc(pool, sizeof(IRInstruction));
+    pool_alloc(pool, sizeof(IRValue));
+    pool_alloc(pool, sizeof(IROperand));
+    pool_alloc(pool, sizeof(IROperand));
+  }
+  destroy_memory_pool(pool);
+  bench_pause(ctx);
+  ctx->ops += POOL_OBJECTS;
+}
+
+/* --- use_list/... --- */
+#define USE_VALUES 256
+#define USE_USERS 4096
+
+typedef struct {
+  IRModule *module;
+  IRBasicBlock *bb;
+  IRValue *defs[USE_VALUES];
+  IRValue *replacements[USE_VALUES];
+  IRInstruction *users[USE_USERS];
+} UseGraph;
+
+/* 创建 USE_VALUES 个由指令定义的值，以及 USE_USERS 条尚无操作数的用户指令 */
+static void use_graph_init(UseGraph *g) {
+  static LogConfig log_config;
+  logger_config_init_default(&log_config);
+  log_config.level = LOG_LEVEL_NONE;
+  g->module = create_ir_module("bench", &log_config);
+  MemoryPool *pool = g->module->pool;
+  Type *i32 = create_basic_type(BASIC_INT, false, pool);
+  IRFunction *func = create_ir_function("f", i32, g->module, pool);
+  g->bb = create_ir_basic_block("entry", func, pool);
+  for (int i = 0; i < USE_VALUES; i++) {
+    for (int k = 0; k < 2; k++) {
+      IRInstruction *def = create_ir_instruction(IR_OP_ADD, pool);
+      def->parent = g->bb;
+      def->dest = create_ir_value(pool);
+      def->dest->type = i32;
+      def->dest->def_instr = def;
+      (k ? g->replacements : g->defs)[i] = def->dest;
+    }
+  }
+  for (int u = 0; u < USE_USERS; u++) {
+    g->users[u] = create_ir_instruction(IR_OP_ADD, pool);
+    g->users[u]->parent = g->bb;
+  }
+}
+
+static void use_graph_add_operands(UseGraph *g) {
+  for (int u = 0; u < USE_USERS; u++) {
+    add_value_operand(g->users[u], g->defs[rng_next() % USE_VALUES]);
+    add_value_operand(g->users[u], g->defs[rng_next() % USE_VALUES]);
+  }
+}
+
+static void bench_use_add_operand(BenchCtx *ctx) {
+  UseGraph g;
+  use_graph_init(&g);
+  bench_resume(ctx);
+  use_graph_add_operands(&g);
+  bench_pause(ctx);
+  destroy_ir_module(g.module);
+  ctx->ops += 2 * USE_USERS;
+}
+
+static void bench_use_rauw(BenchCtx *ctx) {
+  UseGraph g;
+  use_graph_init(&g);
+  use_graph_add_operands(&g);
+  MemoryPool *pool = g.module->pool;
+  Worklist *wl = create_worklist(pool, 16);
+
+  bench_resume(ctx);
+  for (int i = 0; i < USE_VALUES; i++)
+    replace_all_uses_with(wl, g.defs[i], g.replacements[i]);
+  bench_pause(ctx);
+
+  destroy_ir_module(g.module);
+  ctx->ops += 2 * USE_USERS; /* 每个操作数恰好被改写一次 */
+}
+
+static void bench_use_change_operand(BenchCtx *ctx) {
+  UseGraph g;
+  use_graph_init(&g);
+  use_graph_add_operands(&g);
+  static uint32_t choices[2 * USE_USERS];
+  for (int i = 0; i < 2 * USE_USERS; i++)
+    choices[i] = rng_next();
+
+  bench_resume(ctx);
+  for (int i = 0; i < 2 * USE_USERS; i++) {
+    IRInstruction *user = g.users[choices[i] % USE_USERS];
+    IROperand *op = (choices[i] >> 16) & 1 ? user->operand_tail : user->operand_head;
+    change_operand_value(op, g.defs[(choices[i] >> 17) % USE_VALUES]);
+  }
+  bench_pause(ctx);
+
+  destroy_ir_module(g.module);
+  ctx->ops += 2 * USE_USERS;
+}
+
+/* --- 驱动 --- */
+static const struct {
+  const char *name;
+  void (*run)(BenchCtx *ctx);
+} benches[] = {
+    {"worklist/sccp_churn", bench_worklist_churn},
+    {"bitset/dominators", bench_bitset_dominators},
+    {"value_map/inliner_burst", bench_value_map_burst},
+    {"pool_alloc/ir_objects", bench_pool_alloc},
+    {"use_list/add_operand", bench_use_add_operand},
+    {"use_list/rauw", bench_use_rauw},
+    {"use_list/change_operand", bench_use_change_operand},
+};
+
+/* 在历史文件中查找基准 name 最近一次的 ns/op；没有时返回负数 */
+static double last_recorded(const char *path, const char *name) {
+  FILE *fp = path ? fopen(path, "r") : NULL;
+  if (!fp)
+    return -1.0;
+  char line[512];
+  double last = -1.0;
+  while (fgets(line, sizeof(line), fp)) {
+    char bench[128];
+    double ns;
+    /* timestamp,label,benchmark,ns_per_op,... */
+    char *p = strchr(line, ',');
+    p = p ? strchr(p + 1, ',') : NULL;
+    if (p && sscanf(p + 1, "%127[^,],%lf", bench, &ns) == 2 && strcmp(bench, name) == 0)
+      last = ns;
+  }
+  fclose(fp);
+  return last;
+}
+
+int main(int argc, char **argv) {
+  double min_time = 0.5;
+  const char *filter = NULL, *history = NULL, *label = "-";
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "--min-time") == 0)
+      min_time = atof(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "--filter") == 0)
+      filter = argv[++i];
+    else if (i + 1 < argc && strcmp(argv[i], "--history") == 0)
+      history = argv[++i];
+    else if (i + 1 < argc && strcmp(argv[i], "--label") == 0)
+      label = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [--min-time SEC] [--filter SUBSTR] [--history FILE] [--label TEXT]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  FILE *hist = history ? fopen(history, "r") : NULL;
+  if (hist)
+    fclose(hist);
+  else if (history && (hist = fopen(history, "w"))) {
+    fprintf(hist, "timestamp,label,benchmark,ns_per_op,pool_allocs_per_op,pool_bytes_per_op,"
+                  "mallocs_per_op\n");
+    fclose(hist);
+  }
+
+  time_t stamp = time(NULL);
+  printf("%-26s %12s %10s %12s %12s %12s %10s\n", "benchmark", "ops", "ns/op", "allocs/op",
+         "bytes/op", "mallocs/op", "vs last");
+  for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+    if (filter && !strstr(benches[b].name, filter))
+      continue;
+    BenchCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    rng_state = 2463534242u;
+    benches[b].run(&ctx); /* 预热 */
+    memset(&ctx, 0, sizeof(ctx));
+    while (ctx.ns < min_time * 1e9)
+      benches[b].run(&ctx);
+
+    double ops = (double)ctx.ops;
+    double ns_per_op = ctx.ns / ops;
+    double prev = last_recorded(history, benches[b].name);
+    char delta[32] = "-";
+    if (prev > 0)
+      snprintf(delta, sizeof(delta), "%+.1f%%", (ns_per_op / prev - 1.0) * 100.0);
+    printf("%-26s %12.0f %10.2f %12.4f %12.2f %12.4f %10s\n", benches[b].name, ops, ns_per_op,
+           (double)ctx.alloc.pool_allocs / ops, (double)ctx.alloc.pool_bytes / ops,
+           (double)ctx.alloc.mallocs / ops, delta);
+
+    if (history && (hist = fopen(history, "a"))) {
+      fprintf(hist, "%lld,%s,%s,%.3f,%.6f,%.3f,%.6f\n", (long long)stamp, label, benches[b].name,
+              ns_per_op, (double)ctx.alloc.pool_allocs / ops, (double)ctx.alloc.pool_bytes / ops,
+              (double)ctx.alloc.mallocs / ops);
+      fclose(hist);
+    }
+  }
+  return 0;
+}
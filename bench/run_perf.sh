@@ -0,0 +1,266 @@
+#!/bin/bash
+#
+# 生成代码的运行时性能基准。
+#
+# 对性能测试集中的每个 SysY 程序，在每个优化级别下编译、链接 sylib 并在本机
+# 运行，读取 sylib 计时器（starttime/stoptime）的 TOTAL，校验输出，与保存的
+# 基线比较，并输出每个程序的加速比/回归表。
+#
+# 只测量 IR 路径：sysyc -S 输出 LLVM IR，由 llc 只做代码生成（不运行 LLVM 的
+# IR 优化，使结果反映 sysyc 自身的优化）。RISC-V 后端目前还不翻译模块，生成的
+# 汇编无法链接运行，因此不提供 qemu 模式。
+#
+# 默认测试集是仓库中的 test/cases/performance（只含标量程序）。
+# 程序没有调用 starttime/stoptime 时 TOTAL 为 0，退化为测量整个进程的墙钟时间。
+# 同名的 .in 作为标准输入；存在 .out 时把“标准输出 + 返回值”与之比较。
+#
+# 用法: bench/run_perf.sh --compiler <sysyc> [--corpus DIR] [--sylib FILE]
+#                         [--levels "0 1 2"] [--repeat N]
+#                         [--baseline FILE] [--save-baseline FILE] [--threshold PCT]
+#                         [--work-dir DIR] [--timeout SEC]
+# 环境变量: CC（汇编与链接）、LLC（代码生成）
+#
+# 退出状态: 0 全部通过；1 有回归或输出错误；2 环境或参数错误。
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+REPO_DIR="$(dirname "${SCRIPT_DIR}")"
+
+COMPILER=""
+CORPUS="${REPO_DIR}/test/cases/performance"
+SYLIB="${REPO_DIR}/runtime/sylib.c"
+LEVELS="0 1 2"
+REPEAT=3
+BASELINE=""
+SAVE_BASELINE=""
+THRESHOLD=5
+WORK_DIR=""
+TIMEOUT=300
+
+CC="${CC:-cc}"
+LLC="${LLC:-llc}"
+
+FAILURES=0
+
+usage() {
+    cat >&2 << EOF
+usage: $0 --compiler <sysyc> [--corpus DIR] [--sylib FILE]
+          [--levels "0 1 2"] [--repeat N]
+          [--baseline FILE] [--save-baseline FILE] [--threshold PCT]
+          [--work-dir DIR] [--timeout SEC]
+EOF
+    exit 2
+}
+
+die() {
+    echo "run_perf: $*" >&2
+    exit 2
+}
+
+while [ $# -gt 0 ]; do
+    [ $# -ge 2 ] || usage
+    case "$1" in
+        --compiler) COMPILER="$2" ;;
+        --corpus) CORPUS="$2" ;;
+        --sylib) SYLIB="$2" ;;
+        --levels) LEVELS="$2" ;;
+        --repeat) REPEAT="$2" ;;
+        --baseline) BASELINE="$2" ;;
+        --save-baseline) SAVE_BASELINE="$2" ;;
+        --threshold) THRESHOLD="$2" ;;
+        --work-dir) WORK_DIR="$2" ;;
+        --timeout) TIMEOUT="$2" ;;
+        *) usage ;;
+    esac
+    shift 2
+done
+
+[ -n "${COMPILER}" ] || usage
+[ -x "${COMPILER}" ] || die "compiler '${COMPILER}' is not executable"
+[ -d "${CORPUS}" ] || die "corpus directory '${CORPUS}' not found (set --corpus)"
+[ -f "${SYLIB}" ] || die "sylib source '${SYLIB}' not found"
+command -v "${LLC}" > /dev/null || die "'${LLC}' not found (set LLC)"
+command -v "${CC}" > /dev/null || die "'${CC}' not found (set CC)"
+
+COMPILER="$(cd "$(dirname "${COMPILER}")" && pwd)/$(basename "${COMPILER}")"
+if [ -z "${WORK_DIR}" ]; then
+    WORK_DIR="$(mktemp -d /tmp/sysyc_perf_XXXXXX)"
+fi
+mkdir -p "${WORK_DIR}"
+WORK_DIR="$(cd "${WORK_DIR}" && pwd)"
+
+mapfile -t PROGRAMS < <(find "${CORPUS}" -maxdepth 1 -name '*.sy' | sort)
+[ ${#PROGRAMS[@]} -gt 0 ] || die "no .sy programs in '${CORPUS}'"
+
+# --- 运行时库：只编译一次 ---
+SYLIB_OBJ="${WORK_DIR}/sylib.o"
+"${CC}" -O2 -std=c11 -D_POSIX_C_SOURCE=200809L -c "${SYLIB}" -o "${SYLIB_OBJ}" \
+    || die "cannot compile sylib '${SYLIB}'"
+
+# 编译并链接一个程序；成功时输出可执行文件路径
+build_program() {
+    local src="$1" level="$2"
+    local stem="${WORK_DIR}/$(basename "${src}" .sy).O${level}"
+    # sysyc 把中间文件写在当前目录，在工作目录中运行以免互相覆盖
+    (cd "${WORK_DIR}" && "${COMPILER}" -O"${level}" -S -o "${stem}.ll" --log-level error asm "${src}") \
+        > "${stem}.compile.log" 2>&1 || return 1
+    "${LLC}" -O2 -relocation-model=pic "${stem}.ll" -o "${stem}.s" \
+        >> "${stem}.compile.log" 2>&1 || return 1
+    "${CC}" "${stem}.s" "${SYLIB_OBJ}" -lm -lpthread -o "${stem}" >> "${stem}.compile.log" 2>&1 || return 1
+    echo "${stem}"
+}
+
+# 运行一次；输出 “纳秒 退出码”，纳秒取 sylib 计时器的 TOTAL，没有时取墙钟时间
+run_once() {
+    local exe="$1" input="$2"
+    local start end rc=0 total
+    start=$(date +%s%N)
+    SYSY_TIMER_FORMAT=csv timeout "${TIMEOUT}" "${exe}" < "${input}" > "${exe}.stdout" 2> "${exe}.stderr" || rc=$?
+    end=$(date +%s%N)
+    total=$(awk -F, '$1 == "TOTAL" { ns = $4 } END { print ns + 0 }' "${exe}.stderr")
+    if [ "${total}" -eq 0 ]; then
+        total=$((end - start))
+    fi
+    echo "${total} ${rc}"
+}
+
+# 按测试集惯例把“标准输出 + 换行 + 返回值”与 .out 比较，忽略行尾空白
+check_output() {
+    local exe="$1" rc="$2" expected="$3"
+    [ -f "${expected}" ] || return 0
+    {
+        cat "${exe}.stdout"
+        if [ -s "${exe}.stdout" ] && [ -n "$(tail -c 1 "${exe}.stdout")" ]; then echo; fi
+        echo "${rc}"
+    } > "${exe}.actual"
+    diff -q -Z -B "${exe}.actual" "${expected}" > /dev/null
+}
+
+# 在基线文件中查找 “程序 级别 纳秒” 记录
+baseline_ns() {
+    [ -n "${BASELINE}" ] && [ -f "${BASELINE}" ] || return 0
+    awk -v p="$1" -v l="$2" '$1 == p && $2 == l { print $3 }' "${BASELINE}" | tail -n 1
+}
+
+declare -A RESULT
+read -r -a LEVEL_LIST <<< "${LEVELS}"
+FIRST_LEVEL="${LEVEL_LIST[0]}"
+
+echo "run_perf: levels ${LEVELS}, ${REPEAT} repeat(s), work dir ${WORK_DIR}"
+for src in "${PROGRAMS[@]}"; do
+    name="$(basename "${src}" .sy)"
+    input="${src%.sy}.in"
+    [ -f "${input}" ] || input=/dev/null
+    for level in "${LEVEL_LIST[@]}"; do
+        if ! exe="$(build_program "${src}" "${level}")"; then
+            echo "  ${name} -O${level}: compilation failed (see ${WORK_DIR}/${name}.O${level}.compile.log)"
+            RESULT["${name},${level}"]="CE"
+            FAILURES=$((FAILURES + 1))
+            continue
+        fi
+        best=""
+        status="ok"
+        for ((r = 0; r < REPEAT; r++)); do
+            read -r ns rc < <(run_once "${exe}" "${input}")
+            if [ "${rc}" -eq 124 ]; then status="TLE"; break; fi
+            if ! check_output "${exe}" "${rc}" "${src%.sy}.out"; then status="WA"; break; fi
+            if [ -z "${best}" ] || [ "${ns}" -lt "${best}" ]; then best="${ns}"; fi
+        done
+        if [ "${status}" != "ok" ]; then
+            echo "  ${name} -O${level}: ${status}"
+            RESULT["${name},${level}"]="${status}"
+            FAILURES=$((FAILURES + 1))
+        else
+            RESULT["${name},${level}"]="${best}"
+        fi
+    done
+done
+
+# --- 报告 ---
+echo
+printf "%-24s" "program"
+for level in "${LEVEL_LIST[@]}"; do printf " %10s" "O${level}(ms)"; done
+for level in "${LEVEL_LIST[@]:1}"; do printf " %8s" "O${level}/O${FIRST_LEVEL}"; done
+if [ -n "${BASELINE}" ]; then
+    for level in "${LEVEL_LIST[@]}"; do printf " %9s" "O${level}:base"; done
+fi
+echo
+
+declare -A LOG_SUM
+declare -A LOG_CNT
+for src in "${PROGRAMS[@]}"; do
+    name="$(basename "${src}" .sy)"
+    printf "%-24s" "${name:0:24}"
+    for level in "${LEVEL_LIST[@]}"; do
+        v="${RESULT["${name},${level}"]}"
+        if [[ "${v}" =~ ^[0-9]+$ ]]; then
+            printf " %10.3f" "$(awk -v n="${v}" 'BEGIN { print n / 1e6 }')"
+        else
+            printf " %10s" "${v}"
+        fi
+    done
+    base_v="${RESULT["${name},${FIRST_LEVEL}"]}"
+    for level in "${LEVEL_LIST[@]:1}"; do
+        v="${RESULT["${name},${level}"]}"
+        if [[ "${v}" =~ ^[0-9]+$ && "${base_v}" =~ ^[1-9][0-9]*$ && "${v}" -gt 0 ]]; then
+            printf " %7.2fx" "$(awk -v a="${base_v}" -v b="${v}" 'BEGIN { print a / b }')"
+            LOG_SUM[${level}]=$(awk -v s="${LOG_SUM[${level}]:-0}" -v a="${base_v}" -v b="${v}" 'BEGIN { print s + log(a / b) }')
+            LOG_CNT[${level}]=$(( ${LOG_CNT[${level}]:-0} + 1 ))
+        else
+            printf " %8s" "-"
+        fi
+    done
+    if [ -n "${BASELINE}" ]; then
+        regressed=""
+        for level in "${LEVEL_LIST[@]}"; do
+            v="${RESULT["${name},${level}"]}"
+            old="$(baseline_ns "${name}" "${level}")"
+            if [[ "${v}" =~ ^[0-9]+$ && "${old}" =~ ^[1-9][0-9]*$ ]]; then
+                pct=$(awk -v a="${v}" -v b="${old}" 'BEGIN { printf "%+.1f", (a / b - 1) * 100 }')
+                printf " %8s%%" "${pct}"
+                if awk -v p="${pct}" -v t="${THRESHOLD}" 'BEGIN { exit !(p > t) }'; then
+                    regressed="${regressed} O${level}"
+                fi
+            else
+                printf " %9s" "-"
+            fi
+        done
+        if [ -n "${regressed}" ]; then
+            printf "  <-- regression:%s" "${regressed}"
+            FAILURES=$((FAILURES + 1))
+        fi
+    fi
+    echo
+done
+
+printf "%-24s" "geomean speedup"
+for level in "${LEVEL_LIST[@]}"; do printf " %10s" ""; done
+for level in "${LEVEL_LIST[@]:1}"; do
+    if [ "${LOG_CNT[${level}]:-0}" -gt 0 ]; then
+        printf " %7.2fx" "$(awk -v s="${LOG_SUM[${level}]}" -v n="${LOG_CNT[${level}]}" 'BEGIN { print exp(s / n) }')"
+    else
+        printf " %8s" "-"
+    fi
+done
+echo
+
+if [ -n "${SAVE_BASELINE}" ]; then
+    {
+        echo "# program level ns"
+        for src in "${PROGRAMS[@]}"; do
+            name="$(basename "${src}" .sy)"
+            for level in "${LEVEL_LIST[@]}"; do
+                v="${RESULT["${name},${level}"]}"
+                if [[ "${v}" =~ ^[0-9]+$ ]]; then echo "${name} ${level} ${v}"; fi
+            done
+        done
+    } > "${SAVE_BASELINE}"
+    echo "baseline written to ${SAVE_BASELINE}"
+fi
+
+if [ ${FAILURES} -ne 0 ]; then
+    echo "${FAILURES} failure(s)"
+    exit 1
+fi
+exit 0
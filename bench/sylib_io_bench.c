@@ -0,0 +1,198 @@
+/**
+ * @file sylib_io_bench.c
+ * @brief sylib 运行时 I/O 吞吐基准测试。
+ * @details
+ * 生成 N 个随机整数与浮点数写入临时文件，分别用与旧版 sylib 等价的逐元素
+ * scanf/printf 实现和当前 sylib 的缓冲实现读取 / 输出，报告 MB/s 与加速比。
+ *
+ * 用法: sylib_io_bench [N]   (默认 N = 2000000)
+ *
+ * 与 SysY 程序一样只声明需要的运行时函数，不包含 sylib.h。
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+int getarray(int a[]);
+int getfarray(float a[]);
+void putarray(int n, int a[]);
+void putfarray(int n, float a[]);
+void putf(char a[], ...);
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* 把 path 重定向为 fd 目标（0 或 1），返回原 fd 的副本以便恢复 */
+static int redirect_fd(int target, const char *path, int flags) {
+  int saved = dup(target);
+  int fd = open(path, flags, 0644);
+  if (fd < 0 || saved < 0) {
+    perror(path);
+    exit(1);
+  }
+  dup2(fd, target);
+  close(fd);
+  return saved;
+}
+
+static void restore_fd(int target, int saved) {
+  dup2(saved, target);
+  close(saved);
+}
+
+/* --- 旧版 sylib 的逐元素实现，作为基线 --- */
+static int stdio_getarray(int a[]) {
+  int n;
+  if (scanf("%d", &n) != 1)
+    return 0;
+  for (int i = 0; i < n; i++)
+    if (scanf("%d", &a[i]) != 1)
+      break;
+  return n;
+}
+
+static int stdio_getfarray(float a[]) {
+  int n;
+  if (scanf("%d", &n) != 1)
+    return 0;
+  for (int i = 0; i < n; i++)
+    if (scanf("%a", &a[i]) != 1)
+      break;
+  return n;
+}
+
+static void stdio_putarray(int n, int a[]) {
+  printf("%d:", n);
+  for (int i = 0; i < n; i++)
+    printf(" %d", a[i]);
+  printf("\n");
+}
+
+static void stdio_putfarray(int n, float a[]) {
+  printf("%d:", n);
+  for (int i = 0; i < n; i++)
+    printf(" %a", a[i]);
+  printf("\n");
+}
+
+static void report(const char *what, long bytes, double t_old, double t_new) {
+  double mb = (double)bytes / (1024.0 * 1024.0);
+  printf("%-10s %8.1f MB  stdio %8.1f MB/s  sylib %8.1f MB/s  speedup %5.2fx\n",
+         what, mb, mb / t_old, mb / t_new, t_old / t_new);
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 2000000;
+  if (n <= 0)
+    n = 1;
+
+  int *ints = malloc(sizeof(int) * n);
+  float *floats = malloc(sizeof(float) * n);
+  int *ibuf = malloc(sizeof(int) * n);
+  float *fbuf = malloc(sizeof(float) * n);
+  if (!ints || !floats || !ibuf || !fbuf)
+    return 1;
+
+  srand(20220801);
+  for (int i = 0; i < n; i++) {
+    ints[i] = rand() - RAND_MAX / 2;
+    floats[i] = (float)(rand() - RAND_MAX / 2) / 1024.0f;
+  }
+
+  char int_path[] = "/tmp/sylib_bench_int_XXXXXX";
+  char flt_path[] = "/tmp/sylib_bench_flt_XXXXXX";
+  close(mkstemp(int_path));
+  close(mkstemp(flt_path));
+
+  FILE *fp = fopen(int_path, "w");
+  fprintf(fp, "%d\n", n);
+  for (int i = 0; i < n; i++)
+    fprintf(fp, "%d ", ints[i]);
+  long int_bytes = ftell(fp);
+  fclose(fp);
+
+  fp = fopen(flt_path, "w");
+  fprintf(fp, "%d\n", n);
+  for (int i = 0; i < n; i++)
+    fprintf(fp, "%a ", floats[i]);
+  long flt_bytes = ftell(fp);
+  fclose(fp);
+
+  double t0, t_old, t_new;
+  int saved;
+
+  /* 输入：两种实现各自独立打开 stdin，互不共享缓冲 */
+  saved = redirect_fd(0, int_path, O_RDONLY);
+  t0 = now_sec();
+  stdio_getarray(ibuf);
+  t_old = now_sec() - t0;
+  restore_fd(0, saved);
+  clearerr(stdin);
+
+  saved = redirect_fd(0, int_path, O_RDONLY);
+  t0 = now_sec();
+  getarray(ibuf);
+  t_new = now_sec() - t0;
+  restore_fd(0, saved);
+  if (memcmp(ibuf, ints, sizeof(int) * n) != 0)
+    fprintf(stderr, "getarray: result mismatch\n");
+  report("getarray", int_bytes, t_old, t_new);
+
+  saved = redirect_fd(0, flt_path, O_RDONLY);
+  t0 = now_sec();
+  stdio_getfarray(fbuf);
+  t_old = now_sec() - t0;
+  restore_fd(0, saved);
+  clearerr(stdin);
+
+  saved = redirect_fd(0, flt_path, O_RDONLY);
+  t0 = now_sec();
+  getfarray(fbuf);
+  t_new = now_sec() - t0;
+  restore_fd(0, saved);
+  if (memcmp(fbuf, floats, sizeof(float) * n) != 0)
+    fprintf(stderr, "getfarray: result mismatch\n");
+  report("getfarray", flt_bytes, t_old, t_new);
+
+  /* 输出：写到 /dev/null。putf 会先刷出 sylib 的输出缓冲，连同 fflush 一起计时 */
+  fflush(stdout);
+  saved = redirect_fd(1, "/dev/null", O_WRONLY);
+  t0 = now_sec();
+  stdio_putarray(n, ints);
+  fflush(stdout);
+  t_old = now_sec() - t0;
+  t0 = now_sec();
+  putarray(n, ints);
+  putf("");
+  fflush(stdout);
+  t_new = now_sec() - t0;
+  double t_old_f, t_new_f;
+  t0 = now_sec();
+  stdio_putfarray(n, floats);
+  fflush(stdout);
+  t_old_f = now_sec() - t0;
+  t0 = now_sec();
+  putfarray(n, floats);
+  putf("");
+  fflush(stdout);
+  t_new_f = now_sec() - t0;
+  restore_fd(1, saved);
+
+  report("putarray", int_bytes, t_old, t_new);
+  report("putfarray", flt_bytes, t_old_f, t_new_f);
+
+  unlink(int_path);
+  unlink(flt_path);
+  free(ints);
+  free(floats);
+  free(ibuf);
+  free(fbuf);
+  return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file sysy_gen.c
+ * @brief 合成 SysY 程序生成器（见 sysy_gen.h）。
+ * @details
+ * 每个函数 fK(n, a) 由四部分组成：带完整初始化列表的局部数组、
+ * loop_depth 层嵌套的 while 循环、循环体内若干深度为 expr_depth 的表达式，
+ * 以及一条 cfg_width 路的 if / else if 链；函数末尾调用 f(K-1)，main
+ * 依次调用所有函数，使内联与过程间优化有事可做，也不会把函数当作死代码删掉。
+ *
+ * 表达式按“一侧为叶子、另一侧继续展开”的方式生成，节点数与深度成线性关系，
+ * 因此每个维度翻倍时程序规模也大致翻倍。
+ *
+ * 编译时不定义 SYSY_GEN_NO_MAIN 时提供一个命令行入口:
+ *   sysy_gen [--functions N] [--loop-depth N] [--expr-depth N]
+ *            [--array-size N] [--cfg-width N] [--seed N]
+ * 生成的程序写到标准输出。
+ */
+#include "sysy_gen.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  FILE *out;
+  const SysyGenParams *params;
+  unsigned state; /* xorshift32 */
+} Gen;
+
+static unsigned next_rand(Gen *g) {
+  unsigned x = g->state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return g->state = x;
+}
+
+static int rand_below(Gen *g, int n) { return (int)(next_rand(g) % (unsigned)n); }
+
+static void indent(Gen *g, int level) {
+  for (int i = 0; i < level; i++)
+    fputs("  ", g->out);
+}
+
+/* 数组下标：有循环变量时随循环变化，否则为常量；总在 [0, array_size) 内 */
+static void emit_index(Gen *g) {
+  int depth = g->params->loop_depth;
+  int size = g->params->array_size;
+  if (depth > 0)
+    fprintf(g->out, "(i%d + %d) %% %d", rand_below(g, depth), rand_below(g, size), size);
+  else
+    fprintf(g->out, "%d", rand_below(g, size));
+}
+
+static void emit_leaf(Gen *g) {
+  int depth = g->params->loop_depth;
+  switch (rand_below(g, 7)) {
+  case 0:
+    fputs("s", g->out);
+    break;
+  case 1:
+    fputs("n", g->out);
+    break;
+  case 2:
+    if (depth > 0) {
+      fprintf(g->out, "i%d", rand_below(g, depth));
+      break;
+    }
+    /* fall through */
+  case 3:
+    fprintf(g->out, "%d", 1 + rand_below(g, 99));
+    break;
+  case 4:
+    fputs("a[", g->out);
+    emit_index(g);
+    fputs("]", g->out);
+    break;
+  case 5:
+    fputs("buf[", g->out);
+    emit_index(g);
+    fputs("]", g->out);
+    break;
+  default:
+    fputs("tbl[", g->out);
+    emit_index(g);
+    fputs("]", g->out);
+    break;
+  }
+}
+
+static void emit_expr(Gen *g, int depth) {
+  static const char *const ops[] = {"+", "-", "*", "+", "-"};
+  if (depth <= 0) {
+    emit_leaf(g);
+    return;
+  }
+  int shape = rand_below(g, 8);
+  fputs("(", g->out);
+  if (shape == 0) {
+    /* 除数与模数只用非零常量 */
+    emit_expr(g, depth - 1);
+    fprintf(g->out, " %s %d", rand_below(g, 2) ? "/" : "%", 2 + rand_below(g, 8));
+  } else if (shape & 1) {
+    emit_expr(g, depth - 1);
+    fprintf(g->out, " %s ", ops[rand_below(g, 5)]);
+    emit_leaf(g);
+  } else {
+    emit_leaf(g);
+    fprintf(g->out, " %s ", ops[rand_below(g, 5)]);
+    emit_expr(g, depth - 1);
+  }
+  fputs(")", g->out);
+}
+
+static void emit_init_list(Gen *g, int size) {
+  fputs("{", g->out);
+  for (int i = 0; i < size; i++) {
+    if (i)
+      fputs(i % 16 ? ", " : ",\n    ", g->out);
+    fprintf(g->out, "%d", rand_below(g, 100));
+  }
+  fputs("}", g->out);
+}
+
+static void emit_branch_chain(Gen *g, int level) {
+  int width = g->params->cfg_width;
+  if (width <= 0)
+    return;
+  indent(g, level);
+  for (int k = 0; k < width; k++) {
+    if (k == width - 1 && k > 0) {
+      fputs(" else {\n", g->out);
+    } else {
+      if (k > 0)
+        fputs(" else ", g->out);
+      fprintf(g->out, "if (s %% %d == %d) {\n", width, k);
+    }
+    indent(g, level + 1);
+    fputs("s = ", g->out);
+    emit_expr(g, 2);
+    fputs(";\n", g->out);
+    indent(g, level);
+    fputs("}", g->out);
+  }
+  fputs("\n", g->out);
+}
+
+static void emit_loop_body(Gen *g, int level) {
+  const SysyGenParams *p = g->params;
+  int depth = p->loop_depth;
+  indent(g, level);
+  fputs("s = s + ", g->out);
+  emit_expr(g, p->expr_depth);
+  fputs(";\n", g->out);
+  indent(g, level);
+  fputs("buf[", g->out);
+  if (depth > 0)
+    fprintf(g->out, "(i%d + s %% 7 + 7) %% %d", depth - 1, p->array_size);
+  else
+    fputs("0", g->out);
+  fputs("] = ", g->out);
+  emit_expr(g, p->expr_depth);
+  fputs(";\n", g->out);
+  emit_branch_chain(g, level);
+}
+
+static void emit_function(Gen *g, int index) {
+  const SysyGenParams *p = g->params;
+  fprintf(g->out, "int f%d(int n, int a[]) {\n  int s = %d;\n  int buf[%d] = ", index, index,
+          p->array_size);
+  emit_init_list(g, p->array_size);
+  fputs(";\n", g->out);
+
+  for (int d = 0; d < p->loop_depth; d++) {
+    indent(g, d + 1);
+    fprintf(g->out, "int i%d = 0;\n", d);
+    indent(g, d + 1);
+    fprintf(g->out, "while (i%d < n) {\n", d);
+  }
+  emit_loop_body(g, p->loop_depth + 1);
+  for (int d = p->loop_depth - 1; d >= 0; d--) {
+    indent(g, d + 2);
+    fprintf(g->out, "i%d = i%d + 1;\n", d, d);
+    indent(g, d + 1);
+    fputs("}\n", g->out);
+  }
+
+  if (index > 0)
+    fprintf(g->out, "  if (n > 1) s = s + f%d(n - 1, buf);\n", index - 1);
+  fprintf(g->out, "  return s + buf[%d];\n}\n\n", index % p->array_size);
+}
+
+void sysy_gen_default_params(SysyGenParams *params) {
+  params->functions = 32;
+  params->loop_depth = 2;
+  params->expr_depth = 8;
+  params->array_size = 64;
+  params->cfg_width = 4;
+  params->seed = 20220801;
+}
+
+void sysy_gen_write(FILE *out, const SysyGenParams *params) {
+  SysyGenParams p = *params;
+  if (p.functions < 0)
+    p.functions = 0;
+  if (p.loop_depth < 0)
+    p.loop_depth = 0;
+  if (p.expr_depth < 0)
+    p.expr_depth = 0;
+  if (p.array_size < 1)
+    p.array_size = 1;
+  if (p.cfg_width < 0)
+    p.cfg_width = 0;
+  Gen g = {out, &p, p.seed ? p.seed : 1};
+
+  fprintf(out,
+          "// generated by sysy_gen: functions=%d loop_depth=%d expr_depth=%d "
+          "array_size=%d cfg_width=%d seed=%u\n",
+          p.functions, p.loop_depth, p.expr_depth, p.array_size, p.cfg_width, p.seed);
+  fprintf(out, "const int tbl[%d] = ", p.array_size);
+  emit_init_list(&g, p.array_size);
+  fputs(";\n\n", out);
+
+  for (int f = 0; f < p.functions; f++)
+    emit_function(&g, f);
+
+  fprintf(out,
+          "int main() {\n"
+          "  int n = getint();\n"
+          "  int a[%d];\n"
+          "  int i = 0;\n"
+          "  while (i < %d) {\n"
+          "    a[i] = tbl[i];\n"
+          "    i = i + 1;\n"
+          "  }\n"
+          "  int s = 0;\n",
+          p.array_size, p.array_size);
+  for (int f = 0; f < p.functions; f++)
+    fprintf(out, "  s = s + f%d(n, a);\n", f);
+  fputs("  putint(s);\n  return 0;\n}\n", out);
+}
+
+#ifndef SYSY_GEN_NO_MAIN
+int main(int argc, char **argv) {
+  SysyGenParams params;
+  sysy_gen_default_params(&params);
+  for (int i = 1; i < argc; i++) {
+    const char *opt = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "usage: %s [--functions N] [--loop-depth N] [--expr-depth N] "
+                      "[--array-size N] [--cfg-width N] [--seed N]\n",
+              argv[0]);
+      return 1;
+    }
+    long value = strtol(argv[++i], NULL, 10);
+    if (strcmp(opt, "--functions") == 0)
+      params.functions = (int)value;
+    else if (strcmp(opt, "--loop-depth") == 0)
+      params.loop_depth = (int)value;
+    else if (strcmp(opt, "--expr-depth") == 0)
+      params.expr_depth = (int)value;
+    else if (strcmp(opt, "--array-size") == 0)
+      params.array_size = (int)value;
+    else if (strcmp(opt, "--cfg-width") == 0)
+      params.cfg_width = (int)value;
+    else if (strcmp(opt, "--seed") == 0)
+      params.seed = (unsigned)value;
+    else {
+      fprintf(stderr, "%s: unknown option '%s'\n", argv[0], opt);
+      return 1;
+    }
+  }
+  sysy_gen_write(stdout, &params);
+  return 0;
+}
+#endif
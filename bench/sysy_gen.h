@@ -0,0 +1,29 @@
+/**
+ * @file sysy_gen.h
+ * @brief 编译时间基准使用的合成 SysY 程序生成器。
+ * @details
+ * 生成的程序只依赖 getint/putint，能被前端完整接受；五个参数各自独立地
+ * 控制程序规模的一个维度，便于逐维度测量编译器各阶段与各优化遍的伸缩性。
+ * 相同的参数与种子总是生成逐字节相同的程序。
+ */
+#ifndef SYSY_GEN_H
+#define SYSY_GEN_H
+
+#include <stdio.h>
+
+typedef struct SysyGenParams {
+  int functions;   /* 函数个数（不含 main），每个函数调用前一个 */
+  int loop_depth;  /* 每个函数中 while 循环的嵌套层数 */
+  int expr_depth;  /* 最内层循环中每个表达式的嵌套深度 */
+  int array_size;  /* 全局常量表与局部数组的长度，两者都带完整的初始化列表 */
+  int cfg_width;   /* 最内层循环中 if / else if 链的分支数 */
+  unsigned seed;   /* 伪随机种子 */
+} SysyGenParams;
+
+/* 填入各维度的默认值 */
+void sysy_gen_default_params(SysyGenParams *params);
+
+/* 按 params 生成一个完整的 SysY 程序写入 out */
+void sysy_gen_write(FILE *out, const SysyGenParams *params);
+
+#endif /* SYSY_GEN_H */
@@ -180,6 +180,15 @@ bool add_error(ErrorContext* ctx, ErrorType type, const char* msg, SourceLocatio
 bool add_error_with_severity(ErrorContext* ctx, ErrorType type, ErrorSeverity severity,
                            const char* msg, SourceLocation loc);
 
+/**
+ * @brief 按原有顺序把 src 中的全部错误记录追加到 dest。
+ * @details 用于合并各工作线程分别收集的诊断；src 保持不变。
+ * @param dest 接收错误记录的错误上下文。
+ * @param src 被合并的错误上下文。
+ * @return 如果所有记录都成功追加，则返回 true，否则返回 false。
+ */
+bool merge_error_context(ErrorContext* dest, const ErrorContext* src);
+
 /**
  * @brief 释放错误上下文占用的所有内存。
  * @details
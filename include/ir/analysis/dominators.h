@@ -26,6 +26,18 @@
  */
 void compute_dominators(IRFunction* func);
 
+/**
+ * @brief 只计算支配树（直接支配者、支配树子节点、逆后序与时间戳），不计算支配边界。
+ *
+ * @details
+ * 支配边界只用于 mem2reg 放置 PHI 节点。当函数的标量已由 IR 生成器直接构造为
+ * SSA 形式、不再需要 mem2reg 时，用它代替 `compute_dominators` 可以省去
+ * 边界计算。各块的 `dom_frontier` 会被清空。
+ *
+ * @param func 要分析的函数。
+ */
+void compute_dominator_tree(IRFunction* func);
+
 /**
  * @brief 检查一个基本块是否支配（dominate）另一个基本块。
  *
@@ -0,0 +1,33 @@
+#ifndef FUNCTION_HASH_H
+#define FUNCTION_HASH_H
+
+#include "ir/ir_data_structures.h"
+#include <stdint.h>                 // for uint64_t
+
+/**
+ * @file function_hash.h
+ * @brief 定义函数结构哈希（Structural Hash）的公共接口。
+ */
+
+/**
+ * @brief 计算一个函数的结构哈希值。
+ *
+ * @details
+ * 哈希只取决于 IR 的结构，而与对象地址和虚拟寄存器的名字无关：
+ * - 每条指令贡献其操作码、条件码、结果类型、对齐与 inbounds 标记；
+ * - 寄存器操作数按其定义指令在函数中的位置编号，参数按下标编号，
+ *   常量按值，全局符号按名字；
+ * - 基本块按布局顺序编号，终结指令与 PHI 中的块操作数以编号参与哈希，
+ *   因此 CFG 的形状也被完整地反映出来。
+ *
+ * 每个基本块先单独折叠成一个块哈希，再按布局顺序组合成函数哈希。
+ * 两次调用之间 IR 结构没有变化时，返回值一定相同；结构不同的函数
+ * 以极高的概率得到不同的值。优化流水线用它判断一轮迭代是否真正
+ * 改变了函数，以及是否陷入了若干轮之间来回往复的循环。
+ *
+ * @param func 要计算哈希的函数。
+ * @return 64 位结构哈希值；`func` 为 NULL 或内存不足时返回 0。
+ */
+uint64_t compute_function_hash(IRFunction* func);
+
+#endif // FUNCTION_HASH_H
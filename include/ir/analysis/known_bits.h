@@ -0,0 +1,113 @@
+#ifndef KNOWN_BITS_H
+#define KNOWN_BITS_H
+
+#include "ir/ir_data_structures.h"
+#include <stdbool.h>                // for bool
+#include <stdint.h>                 // for uint64_t
+
+/**
+ * @file known_bits.h
+ * @brief 定义已知位（Known Bits）与需求位（Demanded Bits）分析的公共接口。
+ *
+ * @details
+ * - **已知位**：沿定义链向上推导，得出一个整数值的哪些位在任何执行中都一定是 0、
+ *   哪些位一定是 1。例如 `and x, 255` 的高 24 位已知为 0，`zext i1` 的结果
+ *   除最低位外都已知为 0。
+ * - **需求位**：沿使用链向下推导，得出一个值的哪些位真正影响了程序的可观察结果。
+ *   例如 `and y, 15` 只需要 y 的低 4 位，`trunc` 到 i8 只需要低 8 位。
+ *
+ * 两者都按值缓存在一个 `KnownBitsCache` 中，递归深度有上限，超过上限时给出
+ * 保守的答案（没有已知位 / 所有位都被需求）。
+ *
+ * 缓存的有效期：保持值语义不变的改写（常量折叠、代数恒等式、用等价值替换）
+ * 不会让已知位变得错误，因此已知位在这类改写之后仍然可以继续使用；需求位取决于
+ * 使用者，任何改动使用关系的改写之后都必须调用 `invalidate_demanded_bits`；
+ * 利用需求位改变了某个值中不被需求的位之后，必须调用 `invalidate_known_bits`。
+ */
+
+/**
+ * @struct KnownBits
+ * @brief 一个整数值的已知位。`zero` 与 `one` 不相交，且都只使用低 `width` 位。
+ */
+typedef struct KnownBits {
+    uint64_t zero;  ///< 已知为 0 的位
+    uint64_t one;   ///< 已知为 1 的位
+    unsigned width; ///< 值的位宽；不是整数值时为 0
+} KnownBits;
+
+/// 分析结果的缓存，按 `IRValue*` 索引。
+typedef struct KnownBitsCache KnownBitsCache;
+
+/**
+ * @brief 为一个函数创建已知位/需求位缓存，从函数所属模块的内存池分配。
+ * @param func 要分析的函数。
+ * @return 新建的空缓存。
+ */
+KnownBitsCache* create_known_bits_cache(IRFunction* func);
+
+/**
+ * @brief 使缓存中所有的已知位失效（同时也使需求位失效）。
+ */
+void invalidate_known_bits(KnownBitsCache* cache);
+
+/**
+ * @brief 使缓存中所有的需求位失效。
+ */
+void invalidate_demanded_bits(KnownBitsCache* cache);
+
+/**
+ * @brief 返回整数类型的位宽（i1、i8、i32、i64）；其他类型返回 0。
+ */
+unsigned known_bits_type_width(const Type* type);
+
+/**
+ * @brief 返回低 `width` 位全为 1 的掩码。
+ */
+uint64_t known_bits_mask(unsigned width);
+
+/**
+ * @brief 计算一个值的已知位。
+ * @details 常量的所有位都已知；参数、全局变量、load 与 call 的结果没有已知位。
+ * @param cache 分析缓存。
+ * @param val 要分析的值。
+ * @return 已知位；`val` 不是整数值时 `width` 为 0。
+ */
+KnownBits compute_known_bits(KnownBitsCache* cache, IRValue* val);
+
+/**
+ * @brief 计算一个值的需求位：它的所有使用者合起来会观察到哪些位。
+ * @details 被 ret、store、call、比较、分支、GEP 等使用的值，所有位都被需求；
+ *          被整数运算使用时，按运算的语义只传播真正影响结果中被需求的位。
+ * @param cache 分析缓存。
+ * @param val 要分析的值（通常是一条指令的结果）。
+ * @return 需求位掩码；`val` 不是整数值时返回 0。
+ */
+uint64_t compute_demanded_bits(KnownBitsCache* cache, IRValue* val);
+
+/**
+ * @brief 已知 `user` 的结果中被需求的位，求它的第 `index` 个操作数中被需求的位。
+ * @param cache 分析缓存（`and`/`or` 会用到另一个操作数的已知位）。
+ * @param user 使用者指令。
+ * @param index 操作数下标。
+ * @param demanded `user` 结果中被需求的位。
+ * @return 该操作数中被需求的位。
+ */
+uint64_t demanded_bits_of_operand(KnownBitsCache* cache, IRInstruction* user, int index, uint64_t demanded);
+
+/**
+ * @brief 只根据两个操作数的已知位判断整数比较的结果。
+ * @param pred 比较条件码（"eq"、"ne"、"slt"、"ult" 等）。
+ * @return 比较一定成立返回 1，一定不成立返回 0，无法确定返回 -1。
+ */
+int known_bits_evaluate_icmp(const char* pred, KnownBits lhs, KnownBits rhs);
+
+/// 所有位都已知（值是一个常量）。
+bool known_bits_is_constant(KnownBits known);
+
+/// 符号位已知为 0。
+bool known_bits_is_non_negative(KnownBits known);
+
+/// 把所有位都已知的值按其位宽做符号扩展后返回。
+int64_t known_bits_signed_value(KnownBits known);
+
+#endif // KNOWN_BITS_H
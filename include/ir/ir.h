@@ -3,6 +3,8 @@
 
 // 包含自研IR的核心数据结构定义
 #include "ir/ir_data_structures.h"
+#include "ir/ir_generator.h"
+#include "ir/ir_optimizer.h"
 
 /**
  * @file ir.h
@@ -27,6 +29,17 @@
  */
 bool optimize_ir(IRModule* module, const char* output_filename);
 
+/**
+ * @brief 使用指定的优化配置优化IR模块，并写回文件。
+ *
+ * @param module 指向待优化的、内存中的IR模块。
+ * @param output_filename 要将优化后的IR写入的文件路径。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ * @return 成功时返回 true，失败时返回 false。
+ */
+bool optimize_ir_with_config(IRModule* module, const char* output_filename,
+                             const OptimizationConfig* config);
+
 /**
  * @brief 从内存中的IR模块生成RISC-V汇编代码。
  * 
@@ -52,4 +65,30 @@ void destroy_ir_module(IRModule* module);
 // 只生成 IRModule 并返回指针，由调用者负责后续处理和销毁
 IRModule* generate_ir(ASTContext* ast_ctx);
 
+/**
+ * @brief 逐函数流式地生成 IR 并运行函数级优化，每个函数降级后立即释放其 AST。
+ *
+ * @details
+ * 生成每个函数后立即对其运行函数级优化，然后释放该函数体的 AST 子内存池。
+ * 返回的模块还需调用 `optimize_streamed_ir_with_config` 完成模块级优化。
+ *
+ * @param ast_ctx 已通过语义分析的 AST 上下文；调用后其函数体不可再使用。
+ * @param gen_options IR 生成选项（如直接构造 SSA）；为 NULL 时使用默认选项。
+ * @param config 函数级优化所用的配置；为 NULL 时只生成、不优化。
+ * @return 生成的 IRModule*，失败时返回 NULL。
+ */
+IRModule* generate_ir_streaming(ASTContext* ast_ctx, const IRGenOptions* gen_options,
+                                const OptimizationConfig* config);
+
+/**
+ * @brief 对已由 `generate_ir_streaming` 完成函数级优化的模块运行模块级优化，并写回文件。
+ *
+ * @param module 指向待优化的、内存中的IR模块。
+ * @param output_filename 要将优化后的IR写入的文件路径。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ * @return 成功时返回 true，失败时返回 false。
+ */
+bool optimize_streamed_ir_with_config(IRModule* module, const char* output_filename,
+                                      const OptimizationConfig* config);
+
 #endif // IR_H
\ No newline at end of file
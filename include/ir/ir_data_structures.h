@@ -84,10 +84,16 @@ typedef enum {
 /**
  * @struct ConstantAggregate
  * @brief 表示一个聚合常量，例如常量数组的初始化列表。
+ * @details 聚合常量只保存显式给出的非零元素，其余位置一律为零：
+ *          - `num_elements == 0` 表示整个聚合为 `zeroinitializer`；
+ *          - `indices == NULL` 为前缀形式，`elements[k]` 位于下标 `k`；
+ *          - 否则为稀疏形式，`elements[k]` 位于下标 `indices[k]`（严格递增）。
  */
 typedef struct ConstantAggregate {
-  IRValue **elements; ///< 指向常量元素值数组的指针
-  size_t count;       ///< 元素数量
+  IRValue **elements;  ///< 显式给出的非零元素
+  uint32_t *indices;   ///< 稀疏形式下各元素的下标，前缀形式为 NULL
+  size_t count;        ///< 逻辑元素数量（数组第一维的长度）
+  size_t num_elements; ///< `elements` 中的元素数量
 } ConstantAggregate;
 
 /**
@@ -169,6 +175,7 @@ struct IRInstruction {
   bool is_inbounds; ///< 用于 GEP 指令，标记地址计算是否保证在边界内
   bool in_worklist; ///< 用于优化器的工作列表，避免重复添加
   bool is_live;     ///< 用于死代码消除，标记指令是否为活跃的
+  unsigned modified_generation; ///< 最近一次被记入所在函数变更日志时的代次
 };
 
 /**
@@ -209,6 +216,18 @@ struct IRBasicBlock {
   int loop_depth; ///< 循环嵌套深度
 };
 
+/**
+ * @struct ModifiedInstrLog
+ * @brief 被 IR 修改工具改动过的指令日志（见 `begin_modification_tracking`）。
+ * @details 按修改顺序只追加、不删除；其中的指令之后可能已被删除，使用者需自行检查。
+ *          `items` 在堆上分配，由 `end_modification_tracking` 释放。
+ */
+typedef struct ModifiedInstrLog {
+  IRInstruction **items;
+  int count;
+  int capacity;
+} ModifiedInstrLog;
+
 /**
  * @struct IRFunction
  * @brief 表示一个函数。
@@ -221,6 +240,7 @@ struct IRFunction {
   IRBasicBlock *tail;    ///< 指向函数内基本块链表的尾部
   int block_count;       ///< 函数内的基本块数量
   int instruction_count; ///< 函数内的指令总数（缓存值）
+  int temp_name_count;   ///< 变换新建临时值的命名计数器，只增不减，函数内名字不会重复
   IRFunction *next;      ///< 用于链接模块中所有函数的链表指针
 
   // --- 新增参数值列表 ---
@@ -232,6 +252,14 @@ struct IRFunction {
       *reverse_post_order; ///< 基本块的逆后序（RPO）列表，由支配分析计算得出
   Loop *top_level_loops;   ///< 指向该函数内顶层循环链表的头部
 
+  bool scalars_in_ssa; ///< 标量局部变量已在 IR 生成时直接构造为 SSA（无需 mem2reg）
+
+  // --- 指令级变更跟踪（由优化流水线开启，IR 修改工具维护） ---
+  bool track_modifications;      ///< 是否记录被修改的指令
+  unsigned modified_generation;  ///< 日志去重的代次，每个检查点递增
+  int modified_seed;             ///< 当前遍应从日志的哪个位置开始处理，-1 表示整个函数
+  ModifiedInstrLog modified_log; ///< 被修改指令的日志
+
   IRModule *module; ///< 指向包含此函数的模块
 };
 
@@ -13,6 +13,27 @@ typedef struct ASTContext ASTContext;
  * @brief 定义从AST到自研IR的生成器接口。
  */
 
+/**
+ * @struct IRGenOptions
+ * @brief IR 生成选项。
+ */
+typedef struct IRGenOptions {
+    /**
+     * 在降级 AST 的同时直接构造 SSA（Braun et al., "Simple and Efficient SSA
+     * Construction"）：标量局部变量与参数不再分配 `alloca`，读写直接映射为
+     * SSA 值与 PHI 节点。生成的函数带有 `scalars_in_ssa` 标记，优化器据此
+     * 跳过 mem2reg 及其所需的支配边界计算。为 false 时保持 alloca/load/store 形式。
+     */
+    bool direct_ssa;
+    /**
+     * 降级函数体的最大工作线程数（含调用线程）。大于 1 时，全局变量与字符串
+     * 字面量先顺序生成，各函数体再在线程池上并行降级，每个线程使用私有的
+     * 内存池与错误缓冲区；函数与诊断最后按源码顺序合并，回调也按源码顺序
+     * 调用。不大于 1 时逐个函数顺序生成。
+     */
+    unsigned num_threads;
+} IRGenOptions;
+
 /**
  * @brief 从抽象语法树（AST）生成一个完整的、内存中的IR模块。
  *
@@ -28,4 +49,34 @@ typedef struct ASTContext ASTContext;
  */
 IRModule* generate_ir_module(ASTContext* ast_ctx);
 
+/**
+ * @brief 每个函数降级为 IR 之后调用的回调（例如运行函数级优化）。
+ * @param func 刚生成的函数；此时其 AST 尚未释放。
+ * @param user_data 调用者提供的上下文。
+ */
+typedef void (*IRFunctionCallback)(IRFunction* func, void* user_data);
+
+/**
+ * @brief 逐个顶层函数流式地生成 IR。
+ *
+ * @details
+ * 与 `generate_ir_module` 生成相同的模块，但每个函数生成完毕后立即调用
+ * `on_function`，随后释放该函数体的 AST 子内存池（见
+ * `ast_release_function_body`）。因此 AST 的峰值内存只取决于最大的单个函数，
+ * 而不是整个程序。调用后 AST 中的函数体不可再使用。
+ *
+ * 并行降级时（见 `IRGenOptions::num_threads`），函数体的 AST 要保留到所有
+ * 函数都降级完成后才释放。
+ *
+ * @param ast_ctx 已通过语义分析的 AST 上下文。
+ * @param options 生成选项，为 NULL 时使用默认选项（顺序生成，不直接构造 SSA）。
+ * @param on_function 每个函数生成后的回调，可以为 NULL。
+ * @param user_data 传给回调的上下文。
+ * @return 生成的 IR 模块，失败时返回 NULL。
+ */
+IRModule* generate_ir_module_streaming(ASTContext* ast_ctx,
+                                       const IRGenOptions* options,
+                                       IRFunctionCallback on_function,
+                                       void* user_data);
+
 #endif // IR_GENERATOR_H
\ No newline at end of file
@@ -33,8 +33,10 @@ typedef struct {
     bool enable_simplify_cfg;   ///< 启用控制流图简化
     bool enable_ind_var_simplify; ///< 启用归纳变量简化
     bool enable_inliner;        ///< 启用函数内联
+    bool enable_auto_parallel;  ///< 启用 DOALL 循环自动并行化（依赖 sylib 线程池运行时）
     int max_iterations;         ///< 组合优化流水线的最大迭代次数，用于达到不动点
     int max_loop_unroll_count;  ///< 循环展开的最大因子
+    unsigned num_threads;       ///< 输出优化后的 IR 时并行打印函数的线程数（不大于 1 时顺序打印）
 } OptimizationConfig;
 
 /**
@@ -62,6 +64,42 @@ void run_optimization_pipeline(IRModule* module);
  */
 void run_optimization_pipeline_with_config(IRModule* module, const OptimizationConfig* config);
 
+/**
+ * @brief 对单个函数运行函数级优化（即流水线的第一阶段）。
+ * @details 供流式 IR 生成在每个函数降级后立即调用；之后应使用
+ *          `run_module_optimization_pipeline` 完成模块级优化。
+ * @param func 要优化的函数，外部声明会被跳过。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ */
+void optimize_ir_function(IRFunction* func, const OptimizationConfig* config);
+
+/**
+ * @brief 在函数级优化已逐个完成后，运行流水线的模块级部分。
+ * @details 包括过程间优化（内联及其后的再优化、尾调用消除）与自动并行化。
+ * @param module 所有函数都已经过 `optimize_ir_function` 的模块。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ */
+void run_module_optimization_pipeline(IRModule* module, const OptimizationConfig* config);
+
+/**
+ * @brief 用默认优化配置初始化一个 `OptimizationConfig`。
+ * @details 供驱动程序在默认配置的基础上按命令行选项调整个别开关。
+ * @param config 要初始化的配置。
+ */
+void init_default_optimization_config(OptimizationConfig* config);
+
+/**
+ * @brief 按优化级别（`-O0` ~ `-O2`）初始化一个 `OptimizationConfig`。
+ * @details
+ * - 0：关闭所有变换遍，只构建分析所需的 CFG 与支配树；
+ * - 1：默认配置，与 `init_default_optimization_config` 相同；
+ * - 2 及以上：在默认配置基础上启用循环展开。
+ * 负数按 0 处理。
+ * @param config 要初始化的配置。
+ * @param level 优化级别。
+ */
+void init_optimization_config_for_level(OptimizationConfig* config, int level);
+
 /**
  * @brief 打印优化统计信息。
  * @param log_config 指向日志配置的指针，如果为 NULL 则使用默认配置。
@@ -10,6 +10,8 @@ extern "C" {
 /**
  * @file ir_printer.h
  * @brief 声明用于将内存中的自研IR打印成文本格式的函数。
+ * @details 输出经过内部缓冲并整块写入目标流；调用者在同一个流上混用
+ *          其他 stdio 输出时，顺序与调用顺序一致。
  */
 
 // 前向声明，避免在头文件中暴露IR数据结构的完整定义，降低耦合。
@@ -24,6 +26,16 @@ typedef struct IRBasicBlock IRBasicBlock;
  */
 void print_ir_module(IRModule* module, FILE* out);
 
+/**
+ * @brief 用至多 num_threads 个线程打印整个IR模块。
+ * @details 各函数并行打印进各自的内存缓冲区，再按模块中的顺序写出，
+ *          输出与 `print_ir_module` 逐字节相同。num_threads 不大于 1 时顺序打印。
+ * @param module 要打印的IR模块。
+ * @param out 目标输出文件流。
+ * @param num_threads 最大线程数。
+ */
+void print_ir_module_parallel(IRModule* module, FILE* out, unsigned num_threads);
+
 /**
  * @brief 将单个内存中的IR函数以文本形式打印到指定的输出流。
  * @param func 要打印的IR函数。
@@ -48,6 +60,14 @@ void print_basic_block(IRBasicBlock* bb, FILE* out);
  */
 void print_ir_to_file(IRModule* module, const char* filename);
 
+/**
+ * @brief `print_ir_to_file` 的并行版本，见 `print_ir_module_parallel`。
+ * @param module 要打印的IR模块。
+ * @param filename 目标输出文件的路径。
+ * @param num_threads 最大线程数。
+ */
+void print_ir_to_file_parallel(IRModule* module, const char* filename, unsigned num_threads);
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,6 +37,7 @@ typedef struct ValueMap {
     MemoryPool* pool;
     ValueMapEntry** hash_table;
     int hash_capacity;
+    bool opaque_keys; // 键只是借用 IRValue* 类型的任意指针（如 Symbol*），只按地址散列，从不解引用
 } ValueMap;
 
 // --- IR对象创建相关函数 ---
@@ -49,6 +50,8 @@ IROperand* create_ir_operand(OperandKind kind, void* data, IRInstruction* user,
 IRValue* create_constant_i1(bool val, MemoryPool* pool);
 IRValue* create_constant_i64(int64_t val, MemoryPool* pool);
 IRValue* create_constant_double(double val, MemoryPool* pool);
+IRValue* create_zero_aggregate(Type* type, MemoryPool* pool);
+bool is_zero_constant(IRValue* val);
 
 // --- IR对象链接函数 ---
 void link_function_to_module(IRFunction* func, IRModule* module);
@@ -85,6 +88,13 @@ void add_value_operand(IRInstruction* instr, IRValue* val);
 void add_bb_operand(IRInstruction* instr, IRBasicBlock* bb);
 IROperand* add_operand(IRInstruction* instr, OperandKind kind, void* data_ptr);
 
+// --- 指令级变更跟踪 ---
+void begin_modification_tracking(IRFunction* func);
+void end_modification_tracking(IRFunction* func);
+int checkpoint_modifications(IRFunction* func);
+void set_modification_seed(IRFunction* func, int position);
+void mark_instruction_modified(IRInstruction* instr);
+
 // --- CFG/支配树/PHI/块操作相关工具 ---
 void remove_predecessor(IRBasicBlock* block, IRBasicBlock* pred_to_remove);
 void remove_successor(IRBasicBlock* block, IRBasicBlock* succ_to_remove);
@@ -130,6 +140,7 @@ typedef void (*FunctionVisitor)(IRFunction* func, void* user_data);
 void visit_instructions(IRBasicBlock* bb, InstructionVisitor visitor, void* user_data);
 void visit_basic_blocks(IRFunction* func, BasicBlockVisitor visitor, void* user_data);
 void visit_functions(IRModule* module, FunctionVisitor visitor, void* user_data);
+int visit_modified_instructions(IRFunction* func, InstructionVisitor visitor, void* user_data);
 
 // --- IR克隆/重映射/循环分析工具 ---
 IRInstruction* clone_instruction(IRInstruction* instr, MemoryPool* pool);
@@ -146,6 +157,7 @@ void recalculate_instruction_count(IRFunction* func);
 
 // --- ValueMap管理工具 ---
 void value_map_init(ValueMap* map, MemoryPool* pool);
+void value_map_init_opaque(ValueMap* map, MemoryPool* pool);
 void value_map_put(ValueMap* map, IRValue* old_val, IRValue* new_val, LogConfig* log_config);
 IRValue* value_map_get(const ValueMap* map, IRValue* old_val, LogConfig* log_config);
 
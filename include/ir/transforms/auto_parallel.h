@@ -0,0 +1,57 @@
+#ifndef IR_TRANSFORMS_AUTO_PARALLEL_H
+#define IR_TRANSFORMS_AUTO_PARALLEL_H
+
+#include "ir/ir_data_structures.h"
+#include <stdbool.h>                // for bool
+
+/**
+ * @file auto_parallel.h
+ * @brief 定义 DOALL 循环自动并行化遍的公共接口。
+ */
+
+/**
+ * @brief 运行时并行入口的符号名：
+ *        `int _sysy_parallel_for(int lo, int hi, int (*body)(int, int), int op, int init)`。
+ */
+#define SYSY_PARALLEL_FOR_ENTRY "_sysy_parallel_for"
+
+/**
+ * @brief 传给运行时的归约操作编码，需与 runtime/sylib.c 保持一致。
+ */
+typedef enum {
+  SYSY_REDUCE_NONE = 0, ///< 无归约，运行时返回 0
+  SYSY_REDUCE_ADD = 1,  ///< 整数加法归约，单位元为 0
+  SYSY_REDUCE_MUL = 2,  ///< 整数乘法归约，单位元为 1
+} SysyReduceOp;
+
+/**
+ * @brief 将模块中可证明无循环携带依赖的计数循环外提为并行工作函数。
+ *
+ * @details
+ * 对每个函数自外向内检查循环，满足以下条件的循环被视为 DOALL 循环：
+ * 1.  规范形状：有前置头、唯一回边、唯一出口且只有循环头退出，
+ *     循环头只包含 PHI、比较链和条件跳转，条件为 `iv < limit`，
+ *     `iv` 为步长为 1 的 i32 归纳变量，`limit` 为循环不变量。
+ * 2.  无 I/O 与副作用调用：循环内不允许出现任何 `call`。
+ * 3.  无循环携带依赖：每条 store 的地址路径中都包含 `iv`，且 `iv` 之前的
+ *     下标全部为循环不变量（即每次迭代写入互不相交的切片）；读取被写入的
+ *     数组时必须使用与写入完全相同的下标前缀；通过指针参数的读取仅在
+ *     循环内没有任何 store 时才允许（参数之间可能存在别名）。
+ * 4.  除 `iv` 外至多一个 i32 归约变量，其回边值为 `r + x` 或 `r * x`。
+ *     浮点归约的重结合会改变结果，因此不做处理。
+ *
+ * 变换后，循环体被移动到新函数 `<func>.par.<k>(i32 lo, i32 hi)` 中，
+ * 返回该区间上的部分归约值；循环外定义的活跃值通过模块级全局槽
+ * `<func>.par.<k>.env.<j>` 传递。原位置替换为对 `_sysy_parallel_for`
+ * 的调用，由运行时把迭代空间切分到常驻线程池上执行并合并部分结果。
+ * 线程数由环境变量 `SYSY_NUM_THREADS` 控制。
+ *
+ * 该遍应在优化流水线的最后运行，此时循环已被规范化且不再被内联等
+ * 变换改写。
+ *
+ * @param module 要处理的模块。
+ * @return 如果至少并行化了一个循环，则返回 `true`。
+ */
+bool run_auto_parallel(IRModule* module);
+
+#endif // IR_TRANSFORMS_AUTO_PARALLEL_H
@@ -0,0 +1,35 @@
+#ifndef IR_TRANSFORMS_FUNC_INSTRUMENT_H
+#define IR_TRANSFORMS_FUNC_INSTRUMENT_H
+
+#include "ir/ir_data_structures.h"
+#include <stdbool.h>                // for bool
+
+/**
+ * @file func_instrument.h
+ * @brief 定义函数级性能剖析插桩遍的公共接口。
+ */
+
+/** @brief 函数入口钩子的运行时符号名：`void _sysy_prof_enter(int id, char name[])`。 */
+#define SYSY_PROF_ENTER_HOOK "_sysy_prof_enter"
+/** @brief 函数出口钩子的运行时符号名：`void _sysy_prof_exit(int id)`。 */
+#define SYSY_PROF_EXIT_HOOK "_sysy_prof_exit"
+
+/**
+ * @brief 为模块中所有已定义的函数插入入口/出口剖析钩子。
+ *
+ * @details
+ * 每个函数被分配一个从 0 开始的稠密编号，运行时以此编号直接索引其统计表，
+ * 避免在热路径上进行名字查找。插桩内容为：
+ * 1.  在入口块的 `alloca` 序列之后调用 `_sysy_prof_enter(id, @.prof.name.<id>)`，
+ *     函数名以常量字符串全局变量的形式传入，仅在首次调用时被运行时记录。
+ * 2.  在每条 `ret` 指令之前调用 `_sysy_prof_exit(id)`。
+ *
+ * 该遍应在 IR 生成之后、优化流水线之前运行，以便后续的内联等变换看到的
+ * 钩子调用与源程序中的函数边界一一对应。
+ *
+ * @param module 要插桩的模块。
+ * @return 如果至少有一个函数被插桩，则返回 `true`。
+ */
+bool run_func_instrument(IRModule* module);
+
+#endif // IR_TRANSFORMS_FUNC_INSTRUMENT_H
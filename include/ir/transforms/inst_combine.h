@@ -20,6 +20,8 @@
  *   `x * 1` 替换为 `x`，`x - x` 替换为 `0`。
  * - **强度削减 (Strength Reduction)**: 将代价高的运算替换为代价低的运算，例如将
  *   `x * 2` 替换为 `x << 1`。
+ * - **位级化简 (Bit-level Simplification)**: 借助已知位与需求位分析，例如将 `(x & 255) & 15`
+ *   中的内层掩码去掉，把已知非负值的 `srem x, 8` 替换为 `and x, 7`、`sext` 替换为 `zext`。
  *
  * 此优化遍被设计为可以反复运行，因为一次简化可能会为另一次简化创造新的机会。
  *
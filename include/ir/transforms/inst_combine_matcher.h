@@ -0,0 +1,46 @@
+#ifndef INST_COMBINE_MATCHER_H
+#define INST_COMBINE_MATCHER_H
+
+/**
+ * @file inst_combine_matcher.h
+ * @brief 定义指令合并模式匹配表的操作码。
+ *
+ * @details
+ * `inst_combine.pat` 中的声明式模式在构建时由 `inst_combine_gen` 编译成一张
+ * `int32_t` 匹配表（生成文件 `inst_combine_patterns.inc`），由 `inst_combine.c`
+ * 中的解释器执行。本头文件是生成器与解释器之间的约定，两边都包含它。
+ *
+ * 解释器维护一个“当前节点”栈（根节点是被访问指令的结果值）、一个记录数组，
+ * 以及一个回溯点栈。表中的每一项是一个操作码，后跟固定个数的参数：
+ *
+ * | 操作码                        | 参数                         | 含义 |
+ * |-------------------------------|------------------------------|------|
+ * | `MATCHER_SCOPE`               | {size, 子表...}*, 0          | 依次尝试每个子表，失败时回溯到下一个 |
+ * | `MATCHER_SWITCH_OPCODE`       | {size, opcode, nops, 子表...}*, 0 | 按当前节点定义指令的操作码直接跳到对应子表 |
+ * | `MATCHER_CHECK_OPCODE`        | opcode, nops                 | 当前节点由该操作码、该操作数个数的指令定义 |
+ * | `MATCHER_MOVE_CHILD`          | i                            | 进入当前节点定义指令的第 i 个操作数 |
+ * | `MATCHER_MOVE_PARENT`         | -                            | 回到上一层节点 |
+ * | `MATCHER_RECORD`              | -                            | 把当前节点追加到记录数组 |
+ * | `MATCHER_CHECK_SAME`          | n                            | 当前节点与第 n 个记录是同一个值 |
+ * | `MATCHER_CHECK_CONST`         | -                            | 当前节点是整数常量 |
+ * | `MATCHER_CHECK_INT`           | v                            | 当前节点是整数常量，按其位宽截断后与 v 相同 |
+ * | `MATCHER_COMPLETE`            | id                           | 调用第 id 个改写函数；改写条件不满足时视为失败 |
+ *
+ * `SWITCH_OPCODE` 的各个分支互斥，因此它不压入回溯点：选中分支失败即整体失败。
+ * 各子表的 size 不含 size 字段自身（`SWITCH_OPCODE` 中也不含 opcode、nops）。
+ */
+
+typedef enum MatcherOpcode {
+  MATCHER_SCOPE = 1,
+  MATCHER_SWITCH_OPCODE,
+  MATCHER_CHECK_OPCODE,
+  MATCHER_MOVE_CHILD,
+  MATCHER_MOVE_PARENT,
+  MATCHER_RECORD,
+  MATCHER_CHECK_SAME,
+  MATCHER_CHECK_CONST,
+  MATCHER_CHECK_INT,
+  MATCHER_COMPLETE,
+} MatcherOpcode;
+
+#endif // INST_COMBINE_MATCHER_H
@@ -24,11 +24,28 @@
  *   则将B合并到A的末尾。
  * - **跳转线程化 (Jump Threading)**: 绕过那些只包含一个无条件跳转的“跳板”块。
  *
- * 此函数会持续运行这些子优化，直到在一整轮迭代中CFG不再发生任何变化为止。
+ * 这些子优化由一个基本块工作列表驱动：一次变换只把受影响的相邻块重新入队，
+ * 直到工作列表为空、CFG不再发生任何变化为止。
+ *
+ * 返回时各块的前驱/后继数组与终结指令保持一致；若返回 `true`，支配信息
+ * 也已在返回前重新计算过一次。
  *
  * @param func 要被简化其CFG的函数。
  * @return 如果CFG发生了任何改变，则返回 `true`，否则返回 `false`。
  */
 bool run_simplify_cfg(IRFunction* func);
 
+/**
+ * @brief 删除所有从入口块不可达的基本块。
+ *
+ * @details
+ * IR 生成器在 `return`、`break`、`continue` 之后开启的新块没有前驱，支配分析
+ * 要求 CFG 连通，因此优化流水线在构建 CFG 后先调用本函数。调用前各块的
+ * 前驱/后继数组必须与终结指令一致；被删除块在后继 PHI 中的入口一并移除。
+ *
+ * @param func 目标函数。
+ * @return 如果删除了任何块，则返回 `true`。
+ */
+bool remove_unreachable_blocks(IRFunction* func);
+
 #endif // IR_TRANSFORMS_SIMPLIFY_CFG_H
\ No newline at end of file
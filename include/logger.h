@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdarg.h> // 用于 va_list
 #include <stdio.h>  // 用于 FILE
+#include <stddef.h> // 用于 size_t
 
 /**
  * @file logger.h
@@ -15,6 +16,12 @@
  *
  * 日志记录器现在基于上下文配置，每个调用者可以有自己的日志配置，
  * 完全消除了全局状态依赖，并支持彩色输出。
+ *
+ * `LOG_*` 宏在调用 `logger_log` 之前先内联检查级别与类别，未启用的消息
+ * 不会求值任何格式参数。高于编译期上限 `LOG_COMPILE_LEVEL` 的消息则整体
+ * 被编译器消除。配置中挂上 `LogRingBuffer` 后，消息写入无锁环形缓冲区，
+ * 由 `logger_ring_drain` 统一输出，多个工作线程记录日志时不会在 stdio 锁上串行。
+ * 积压达到容量的 3/4 时，写入者会就地把缓冲的消息输出到 stderr。
  */
 
 /**
@@ -69,6 +76,27 @@ typedef enum {
     LOG_COLOR_BRIGHT_WHITE     ///< 亮白色
 } LogColor;
 
+/**
+ * @brief 编译期允许的最高日志级别。
+ * @details 级别高于它的 `LOG_*` 宏展开为常量假的条件，连同参数求值一起被消除。
+ *          默认保留全部级别；构建时可以定义为某个 `LogLevel` 枚举值，
+ *          例如 `-DLOG_COMPILE_LEVEL=LOG_LEVEL_DEBUG` 去掉所有 TRACE 日志。
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define LOG_UNLIKELY(x) (x)
+#endif
+
+/**
+ * @brief 多生产者、单消费者的无锁日志环形缓冲区（不透明类型）。
+ */
+typedef struct LogRingBuffer LogRingBuffer;
+
 /**
  * @struct LogConfig
  * @brief 日志记录器的配置结构体。
@@ -82,6 +110,7 @@ typedef struct {
     LogCategory enabled_categories[10];///< 要启用的类别（如果为空，则全部启用）
     int enabled_category_count;        ///< 已启用类别的数量
     bool categories_explicitly_set;    ///< 类别是否已被显式设置
+    LogRingBuffer* ring;               ///< 非 NULL 时消息写入该缓冲区，而不是直接输出到 stderr
 } LogConfig;
 
 // --- 日志记录器配置 ---
@@ -92,6 +121,21 @@ typedef struct {
  */
 void logger_config_init_default(LogConfig* config);
 
+/**
+ * @brief 判断类别是否在显式设置的类别列表中。
+ * @details 仅在 `categories_explicitly_set` 为真时才需要调用，供 `logger_enabled` 使用。
+ */
+bool logger_category_listed(const LogConfig* config, LogCategory category);
+
+/**
+ * @brief 判断一条消息是否会被记录。
+ * @details 级别比较内联完成；只有设置了类别过滤时才调用 `logger_category_listed`。
+ */
+static inline bool logger_enabled(const LogConfig* config, LogLevel level, LogCategory category) {
+    return config && level <= config->level &&
+           (!config->categories_explicitly_set || logger_category_listed(config, category));
+}
+
 // --- 增强的日志记录函数 ---
 
 /**
@@ -120,9 +164,15 @@ void logger_vlog(const LogConfig* config, LogLevel level, LogCategory category,
 
 // --- 用于日志记录的便捷宏 ---
 // 宏现在需要接收一个配置对象的指针作为第一个参数。
+// 编译期上限与运行期级别/类别检查都在求值格式参数之前完成，未启用的日志几乎没有开销。
 
-#define LOG_WITH_CONFIG(config, level, category, format, ...) \
-    logger_log(config, level, category, __FILE__, __LINE__, format, ##__VA_ARGS__)
+#define LOG_WITH_CONFIG(config, level, category, format, ...)                          \
+    do {                                                                                \
+        const LogConfig* log_config_ = (config);                                        \
+        if ((level) <= LOG_COMPILE_LEVEL &&                                             \
+            LOG_UNLIKELY(logger_enabled(log_config_, level, category)))                 \
+            logger_log(log_config_, level, category, __FILE__, __LINE__, format, ##__VA_ARGS__); \
+    } while (0)
 
 #define LOG_ERROR(config, category, format, ...) \
     LOG_WITH_CONFIG(config, LOG_LEVEL_ERROR, category, format, ##__VA_ARGS__)
@@ -139,6 +189,31 @@ void logger_vlog(const LogConfig* config, LogLevel level, LogCategory category,
 #define LOG_TRACE(config, category, format, ...) \
     LOG_WITH_CONFIG(config, LOG_LEVEL_TRACE, category, format, ##__VA_ARGS__)
 
+// --- 环形缓冲区 sink ---
+
+/**
+ * @brief 创建一个日志环形缓冲区。
+ * @param capacity 可容纳的消息条数，向上取整为 2 的幂；为 0 时使用默认容量。
+ * @return 新缓冲区；内存不足时返回 NULL。
+ */
+LogRingBuffer* logger_ring_create(size_t capacity);
+
+/**
+ * @brief 销毁环形缓冲区。尚未输出的消息会被丢弃，需要时应先调用 `logger_ring_drain`。
+ */
+void logger_ring_destroy(LogRingBuffer* ring);
+
+/**
+ * @brief 按写入顺序输出并移除缓冲区中所有已完成的消息。
+ * @details 可以与写入者并发调用；与写入者触发的高水位输出互斥，不会交错。
+ *          缓冲区满时写入者丢弃消息而不是等待，丢弃的条数会在此处一并报告。
+ * @param config 决定输出格式（时间戳、类别、颜色等）的配置。
+ * @param ring 要输出的缓冲区。
+ * @param stream 输出流。
+ * @return 本次输出的消息条数。
+ */
+size_t logger_ring_drain(const LogConfig* config, LogRingBuffer* ring, FILE* stream);
+
 // --- 工具函数 ---
 
 /**
@@ -0,0 +1,42 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+/**
+ * @file parallel.h
+ * @brief 编译器内部按任务下标分发的简单线程池。
+ * @details
+ * 前端中可以独立处理的工作（例如各个函数体的语义检查与 IR 降级）被编号为
+ * `[0, count)` 的任务。`parallel_for` 启动若干工作线程（调用线程本身是 0 号
+ * 工作线程），各线程通过一个原子计数器动态领取下一个任务，直到全部完成后返回。
+ * 每个任务同时得到执行它的工作线程编号，调用者据此为每个线程准备私有的
+ * 内存池、错误缓冲区等状态，任务之间无需加锁。
+ */
+
+/**
+ * @brief 任务回调。
+ * @param index 任务下标，位于 `[0, count)`。
+ * @param worker 执行该任务的工作线程编号，位于 `[0, num_workers)`。
+ * @param user_data 调用者提供的上下文。
+ */
+typedef void (*ParallelTask)(size_t index, unsigned worker, void* user_data);
+
+/**
+ * @brief 返回默认的工作线程数：当前在线的 CPU 数（至少为 1）。
+ */
+unsigned parallel_default_workers(void);
+
+/**
+ * @brief 用至多 num_workers 个线程执行 count 个任务，全部完成后返回。
+ * @details 线程数不超过任务数；num_workers 不大于 1 或线程创建失败时，
+ *          剩余任务都在调用线程上顺序执行。任务的执行顺序不确定，
+ *          需要确定性结果的调用者应按任务下标保存输出，结束后再按下标合并。
+ * @param count 任务数。
+ * @param num_workers 最大工作线程数（含调用线程）。
+ * @param task 任务回调。
+ * @param user_data 传给回调的上下文。
+ */
+void parallel_for(size_t count, unsigned num_workers, ParallelTask task, void* user_data);
+
+#endif // PARALLEL_H
@@ -0,0 +1,103 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @file perf_counters.h
+ * @brief 按编译阶段与优化遍统计硬件性能计数器（`--perf-counters`）。
+ * @details
+ * 启用后通过 `perf_event_open` 为当前进程打开周期、指令、L1D 未命中、
+ * LLC 未命中与分支预测失败五个计数器（用户态、继承到之后创建的线程），
+ * 在每个被度量的区间前后各读一次，把差值累计到以区间名字区分的记录中。
+ * 区间可以嵌套：阶段（如 `ir_gen+opt`）的计数包含其中运行的各个优化遍。
+ *
+ * 某个计数器无法打开（内核不支持、权限不足或运行在虚拟机中）时它被标记为
+ * 不可用，报告中对应的列显示为 `-`；所有计数器都不可用时退化为只报告时间。
+ *
+ * 区间栈与累计表是进程全局的，只能由主线程调用；未启用时
+ * `perf_region_begin`/`perf_region_end` 只做一次标志检查。
+ */
+
+/**
+ * @enum PerfCounterKind
+ * @brief 采样的硬件事件。
+ */
+typedef enum {
+    PERF_COUNTER_CYCLES,        ///< CPU 周期
+    PERF_COUNTER_INSTRUCTIONS,  ///< 退休的指令数
+    PERF_COUNTER_L1D_MISSES,    ///< L1 数据缓存读未命中
+    PERF_COUNTER_LLC_MISSES,    ///< 末级缓存未命中
+    PERF_COUNTER_BRANCH_MISSES, ///< 分支预测失败
+    PERF_COUNTER_COUNT
+} PerfCounterKind;
+
+/**
+ * @enum PerfRegionKind
+ * @brief 区间的类别，决定它出现在报告的哪个表格中。
+ */
+typedef enum {
+    PERF_REGION_PHASE, ///< 编译器前端/后端阶段
+    PERF_REGION_PASS   ///< 单个分析或优化遍
+} PerfRegionKind;
+
+/**
+ * @struct PerfSample
+ * @brief 一组计数器读数及对应的时间。
+ */
+typedef struct PerfSample {
+    uint64_t values[PERF_COUNTER_COUNT]; ///< 各计数器的值（已按复用比例缩放）
+    double ms;                           ///< 单调时钟，毫秒
+} PerfSample;
+
+/**
+ * @brief 启用统计并尝试打开所有硬件计数器。
+ * @return 至少有一个计数器可用时返回 true；否则仍会记录时间，返回 false。
+ */
+bool perf_counters_enable(void);
+
+/**
+ * @brief 关闭计数器并停止统计。已累计的数据保留，仍可输出报告。
+ */
+void perf_counters_disable(void);
+
+/** @brief 是否已通过 `perf_counters_enable` 启用统计。*/
+bool perf_counters_enabled(void);
+
+/**
+ * @brief 读取当前的计数器值与时间。
+ * @param out 输出读数；不可用的计数器为 0。
+ */
+void perf_counters_read(PerfSample* out);
+
+/**
+ * @brief 开始一个度量区间（压入区间栈）。未启用时什么也不做。
+ */
+void perf_region_begin(void);
+
+/**
+ * @brief 结束最近开始的区间，并把差值累计到名为 name 的记录上。
+ * @param kind 区间类别。
+ * @param name 区间名字，需在报告输出前保持有效（通常为字符串字面量）。
+ */
+void perf_region_end(PerfRegionKind kind, const char* name);
+
+/** @brief `PERF_PASS` 的辅助函数：结束遍区间并原样返回遍的结果。*/
+bool perf_region_end_bool(const char* name, bool result);
+
+/**
+ * @brief 以表格形式输出各阶段与各遍的累计结果。
+ * @param out 输出流。
+ */
+void perf_counters_report(FILE* out);
+
+/**
+ * @brief 把 `expr` 作为名为 name 的优化遍度量，并返回 `expr` 的值。
+ * @details 逗号表达式保证 `perf_region_begin` 在 `expr` 求值前执行，
+ *          `perf_region_end_bool` 在其后执行。
+ */
+#define PERF_PASS(name, expr) (perf_region_begin(), perf_region_end_bool(name, (expr)))
+
+#endif // PERF_COUNTERS_H
@@ -4,6 +4,7 @@
 #include <stdio.h>     // 为了 FILE*
 #include "ast.h"       // 包含 AST 相关的定义
 #include "location.h"  // 假设 location.h 包含 SourceLocation 结构体定义
+#include "source_buffer.h"
 
 // 这是一个“不透明指针”的前向声明。
 // 真正的 `yyscan_t` 类型是由 Flex 在生成 lexer.yy.c 时内部定义的。
@@ -50,6 +51,11 @@ typedef struct ScannerContext {
      */
     size_t string_len;
 
+    /**
+     * @brief 当前字符串字面量内容（左引号之后）在源缓冲区中的偏移。
+     */
+    uint32_t string_start;
+
     // --- 位置跟踪 (用于特殊情况) ---
 
     /**
@@ -122,4 +128,22 @@ ScannerContext* yyget_extra(yyscan_t scanner);
  */
 void yyset_in(FILE* in_str, yyscan_t scanner);
 
+/**
+ * @brief 让 Flex 扫描器直接在一块内存上扫描，不复制输入。
+ * @details 缓冲区最后两个字节必须为 `\0`（见 `SOURCE_BUFFER_PADDING`），size 包含这两个字节。
+ *          扫描期间 Flex 会临时改写缓冲区中的字节，因此缓冲区必须可写。
+ * @param base 缓冲区起始地址。
+ * @param size 缓冲区总字节数。
+ * @param scanner Flex 扫描器实例。
+ * @return 新的 Flex 缓冲区状态；缓冲区不满足要求时返回 NULL。
+ */
+struct yy_buffer_state* yy_scan_buffer(char* base, size_t size, yyscan_t scanner);
+
+/**
+ * @brief 释放 `yy_scan_buffer` 创建的缓冲区状态（不会释放底层内存）。
+ * @param b 要释放的缓冲区状态。
+ * @param scanner Flex 扫描器实例。
+ */
+void yy_delete_buffer(struct yy_buffer_state* b, yyscan_t scanner);
+
 #endif // SCANNER_CONTEXT_H
\ No newline at end of file
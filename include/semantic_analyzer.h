@@ -12,12 +12,15 @@
  * @brief 对整个抽象语法树（AST）执行语义分析。
  * 
  * @details
- * 这是语义分析阶段的主要驱动函数。它对AST进行两次主要的遍历：
- * 1.  **符号表构建**: 遍历AST，为所有作用域构建嵌套的符号表，并用变量、常量和
- *     函数的声明来填充它们。此过程会检查在同一作用域内的重定义错误。
- * 2.  **语义检查**: 再次遍历AST，执行所有类型检查，验证符号的正确使用（例如，
- *     函数被调用，变量在使用前已定义），检查控制流（例如，非void函数有返回值），
- *     并执行常量折叠。
+ * 这是语义分析阶段的主要驱动函数。除提前登记所有函数签名外，只对AST进行
+ * 一次遍历，同时完成：
+ * 1.  **符号表构建**: 进入作用域时建立嵌套的符号表，遇到变量、常量和参数的
+ *     声明时立即加入当前作用域，并检查同一作用域内的重定义错误。
+ * 2.  **语义检查**: 离开节点时执行类型检查，验证符号的正确使用，检查控制流
+ *     （例如，非void函数有返回值），并执行常量折叠。
+ *
+ * 作用域规则与 C 相同：只有函数可以先使用后定义；全局变量与常量必须在使用
+ * 之前声明，函数体中引用定义在该函数之后的全局符号会报告未声明的标识符。
  * 
  * 此函数会就地修改AST：
  * - 将符号表作用域附加到相应的节点（FuncDecl, CompoundStmt）。
@@ -29,4 +32,17 @@
  */
 void perform_semantic_analysis(ASTContext* ctx);
 
+/**
+ * @brief 与 `perform_semantic_analysis` 相同，但在线程池上并行检查各函数体。
+ *
+ * @details
+ * 全局声明与函数签名先在调用线程上按源码顺序分析；此后全局状态只读，
+ * 各函数体由至多 `num_threads` 个工作线程独立检查。诊断按顶层声明分别缓存，
+ * 最后按源码顺序合并，因此结果与线程数无关。
+ *
+ * @param ctx 包含待分析AST根节点的AST上下文。
+ * @param num_threads 最大工作线程数（含调用线程）；不大于 1 时不创建线程。
+ */
+void perform_semantic_analysis_with_threads(ASTContext* ctx, unsigned num_threads);
+
 #endif // SEMANTIC_ANALYZER_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file source_buffer.h
+ * @brief 定义编译器读取源文件所用的只读输入缓冲区。
+ * @details
+ * 源文件被整体映射（mmap）进内存，Flex 通过 `yy_scan_buffer` 直接在该缓冲区上
+ * 扫描，不再经过 FILE 流与 Flex 自身的读缓冲。AST 中的标识符与字面量文本以
+ * `SourceSpan`（偏移 + 长度）引用这块内存，因此缓冲区的生命周期必须覆盖
+ * 所有仍在使用 AST 的阶段。
+ *
+ * `yy_scan_buffer` 要求缓冲区末尾有两个 `\0` 字节。当文件大小不是页大小的
+ * 整数倍时，映射最后一页中文件末尾之后的部分由内核保证清零，可以直接使用；
+ * 否则（或 mmap 不可用、输入是管道等非普通文件时）退化为读到 EOF 的堆缓冲区。
+ */
+
+/**
+ * @struct SourceSpan
+ * @brief 源文本中的一段区间，以相对于源缓冲区起始处的字节偏移和长度表示。
+ */
+typedef struct SourceSpan {
+    uint32_t offset; ///< 区间起始字节相对于源缓冲区起始处的偏移
+    uint32_t length; ///< 区间的字节长度
+} SourceSpan;
+
+/**
+ * @struct SourceBuffer
+ * @brief 持有一个源文件的全部内容。
+ */
+typedef struct SourceBuffer {
+    char* data;         ///< 文件内容，其后至少跟随两个 `\0` 字节
+    size_t size;        ///< 文件内容的字节数（不含结尾的 `\0`）
+    size_t alloc_size;  ///< 映射或分配的总字节数
+    bool is_mapped;     ///< `data` 来自 mmap（true）还是堆分配（false）
+} SourceBuffer;
+
+/** @brief `data` 末尾保证存在的 `\0` 字节数，即 Flex 的 `YY_END_OF_BUFFER_CHAR` 个数。 */
+#define SOURCE_BUFFER_PADDING 2
+
+/**
+ * @brief 打开并载入一个源文件。
+ * @param buf 要初始化的缓冲区。
+ * @param path 源文件路径。
+ * @return 成功返回 true；失败时返回 false 并设置 errno。超过 `UINT32_MAX` 字节、
+ *         无法用 `SourceSpan` 表示的输入设置为 `EFBIG`。
+ */
+bool source_buffer_open(SourceBuffer* buf, const char* path);
+
+/**
+ * @brief 释放源缓冲区占用的映射或内存。
+ * @param buf 要释放的缓冲区，可以是未成功打开的缓冲区。
+ */
+void source_buffer_close(SourceBuffer* buf);
+
+#endif // SOURCE_BUFFER_H
@@ -9,22 +9,45 @@
  * @file symbol_table.h
  * @brief 定义用于作用域管理的符号表数据结构和API。
  * @details
- * 符号表通过使用哈希表（采用链地址法解决冲突）实现了一个层级式的作用域系统。
- * 每个作用域都可以有一个父作用域，从而支持编程语言中的嵌套作用域。
+ * 符号表采用经典的“扁平名字表 + 作用域撤销日志”设计：
+ * - 整个翻译单元只有一张开放寻址的名字表，以驻留后的名字指针为键，
+ *   值为该名字当前最内层的可见绑定。被遮蔽的外层绑定通过 `Symbol::shadowed`
+ *   串成一条链，因此无论嵌套多深，查找都只需一次探测。
+ * - `SymbolTable` 只是一条轻量的作用域记录（父作用域、深度、本作用域声明的
+ *   符号），创建块作用域不再分配任何桶数组。
+ * - `enter_scope` 记下撤销日志的当前位置并把作用域中已有的符号重新压入名字表；
+ *   `exit_scope` 把日志回退到该位置，恢复每个名字被遮蔽前的绑定。
+ *
+ * 因为查找依赖名字表中的“当前绑定”，`find_symbol` / `find_symbol_in_scope`
+ * 只能作用于当前处于激活状态（已进入且尚未退出）的作用域；全局作用域在创建时
+ * 即被激活，且永不退出。
+ *
+ * 并行分析函数体时，每个工作线程另建一张私有名字表（`create_name_table`），
+ * 函数作用域通过 `create_symbol_table_in` 挂在它上面。局部绑定只写入私有表，
+ * 查找未命中时回退到全局作用域的名字表；全局名字表此时只读，可被多个线程
+ * 同时查找。
+ *
+ * 所有符号名都必须是经 `ast_intern` 驻留后的规范指针：名字表直接复用驻留时
+ * 计算好的哈希值，并用指针相等代替 `strcmp`。
  */
 
+typedef struct NameTable NameTable; ///< 扁平名字表与撤销日志，定义见 symbol_table.c
+
 /**
  * @struct Symbol
  * @brief 表示作用域中一个已命名的实体（变量、常量或函数）。
  */
 typedef struct Symbol {
-    char* name;                ///< 符号的名称
+    char* name;                ///< 符号的名称（驻留后的规范指针）
     Type* type;                ///< 符号的类型
     bool is_func;              ///< 如果是函数符号，则为 true
     bool is_const;             ///< 如果是 const 变量或函数，则为 true
     bool is_evaluated;         ///< (仅用于常量) 如果其值已被计算，则为 true
     ConstValueUnion const_val; ///< (仅用于常量) 如果是已求值的常量，则为其编译时值
-    struct Symbol* next;       ///< 用于哈希表链地址法的指针，指向下一个符号
+    struct SymbolTable* scope; ///< 声明该符号的作用域
+    uint32_t order;            ///< 在所属作用域中的声明序号（从 0 开始）
+    struct Symbol* shadowed;   ///< 被本符号遮蔽的同名外层绑定（压入名字表时记录）
+    struct Symbol* next;       ///< 同一作用域中下一个声明的符号
 } Symbol;
 
 /**
@@ -32,53 +55,101 @@ typedef struct Symbol {
  * @brief 表示一个单独的作用域。
  */
 typedef struct SymbolTable {
-    Symbol** buckets;           ///< 哈希表的桶数组，每个元素是指向 Symbol 链表头的指针
-    size_t capacity;            ///< 哈希表的容量
-    size_t count;               ///< 当前作用域中的符号数量
+    NameTable* names;           ///< 本作用域的绑定所在的名字表
     struct SymbolTable* parent; ///< 指向外层作用域（父作用域）的链接
+    Symbol* symbols;            ///< 本作用域声明的符号链表（最新的在前）
+    size_t count;               ///< 当前作用域中的符号数量
+    size_t undo_mark;           ///< 进入作用域时撤销日志的长度
+    uint32_t depth;             ///< 嵌套深度，全局作用域为 0
 } SymbolTable;
 
 // --- API 函数 ---
 
 /**
  * @brief 创建一个新的符号表，并指定其父作用域。
- * @param ctx 用于内存分配的 AST 上下文。
+ * @details 全局作用域（parent 为 NULL）会同时创建共享的名字表并立即激活；
+ *          其他作用域沿用父作用域的名字表，只分配一条作用域记录，需要调用
+ *          `enter_scope` 激活。
+ * @param pool 分配作用域记录的内存池。
  * @param parent 父作用域，对于全局作用域则为 NULL。
  * @return 指向新创建的符号表的指针。
  */
-SymbolTable* create_symbol_table(ASTContext* ctx, SymbolTable* parent);
+SymbolTable* create_symbol_table(MemoryPool* pool, SymbolTable* parent);
+
+/**
+ * @brief 在指定的名字表上创建一个作用域。
+ * @details 用于把函数作用域挂到工作线程的私有名字表上；其后代作用域通过
+ *          `create_symbol_table` 自动沿用同一张表。
+ * @param pool 分配作用域记录的内存池。
+ * @param parent 父作用域，必须是 `names` 回退到的全局作用域。
+ * @param names 由 `create_name_table` 创建的私有名字表。
+ * @return 指向新创建的符号表的指针，需要调用 `enter_scope` 激活。
+ */
+SymbolTable* create_symbol_table_in(MemoryPool* pool, SymbolTable* parent, NameTable* names);
+
+/**
+ * @brief 创建一张私有名字表，查找未命中时回退到全局作用域的名字表。
+ * @details 私有表只记录局部绑定，不修改全局名字表，因此多个线程可以各持一张
+ *          私有表，同时分析不同的函数体。
+ * @param global 全局作用域。
+ * @return 新名字表，使用完毕后由 `destroy_name_table` 释放。
+ */
+NameTable* create_name_table(SymbolTable* global);
+
+/**
+ * @brief 释放由 `create_name_table` 创建的私有名字表。
+ * @param names 要释放的名字表，其上的作用域必须都已退出。
+ */
+void destroy_name_table(NameTable* names);
 
 /**
  * @brief 销毁一个符号表并释放所有相关内存。
+ * @details 作用域记录与符号都来自内存池；对全局作用域调用时释放共享名字表
+ *          及撤销日志占用的堆内存。
  * @param table 要销毁的符号表。
  * @param ctx 用于内存管理的 AST 上下文。
  */
 void destroy_symbol_table(SymbolTable* table, ASTContext* ctx);
 
+/**
+ * @brief 进入（激活）一个作用域，使其成为最内层作用域。
+ * @details 作用域可以在后续遍历中被再次进入：此前已加入该作用域的符号会被
+ *          重新压入名字表。
+ * @param table 要进入的作用域，其父作用域必须是当前最内层作用域。
+ */
+void enter_scope(SymbolTable* table);
+
+/**
+ * @brief 退出当前最内层作用域，恢复被其遮蔽的外层绑定。
+ * @param table 要退出的作用域，必须是当前最内层作用域。
+ */
+void exit_scope(SymbolTable* table);
+
 /**
  * @brief 向指定的符号表中添加一个新符号。
- * @param table 要添加符号的符号表。
- * @param name 符号的名称。
+ * @param table 要添加符号的符号表，必须是当前最内层作用域。
+ * @param name 符号的名称，必须是驻留后的规范指针。
  * @param type 符号的类型。
  * @param is_func 如果符号代表一个函数，则为 true。
  * @param is_const 如果符号是常量，则为 true。
- * @param ctx 用于内存分配的 AST 上下文。
+ * @param pool 分配符号的内存池。
  * @return 如果符号已在此作用域中存在，则返回 false，否则返回 true。
  */
-bool add_symbol(SymbolTable* table, const char* name, Type* type, bool is_func, bool is_const, ASTContext* ctx);
+bool add_symbol(SymbolTable* table, const char* name, Type* type, bool is_func, bool is_const, MemoryPool* pool);
 
 /**
  * @brief 仅在给定作用域中查找符号，不检查父作用域。
- * @param table 要搜索的符号表。
- * @param name 要查找的符号的名称。
+ * @param table 要搜索的符号表，必须处于激活状态。
+ * @param name 要查找的符号的名称，必须是驻留后的规范指针。
  * @return 如果找到，则返回指向符号的指针，否则返回 NULL。
  */
 Symbol* find_symbol_in_scope(SymbolTable* table, const char* name);
 
 /**
  * @brief 通过搜索给定作用域及其所有父作用域来查找符号。
- * @param table 开始搜索的符号表。
- * @param name 要查找的符号的名称。
+ * @details 私有名字表上没有可见绑定时，继续在其回退的全局名字表中查找。
+ * @param table 开始搜索的符号表，必须处于激活状态。
+ * @param name 要查找的符号的名称，必须是驻留后的规范指针。
  * @return 如果找到，则返回指向符号的指针，否则返回 NULL。
  */
 Symbol* find_symbol(SymbolTable* table, const char* name);
@@ -1,83 +1,497 @@
 #include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
 #include<stdarg.h>
-#include<sys/time.h>
+#include<math.h>
+#include<errno.h>
+#include<unistd.h>
+#include<time.h>
+#include<pthread.h>
 #include"sylib.h"
-/* Input & output functions */
-int getint(){int t; scanf("%d",&t); return t; }
-int getch(){char c; scanf("%c",&c); return (int)c; }
-float getfloat(){
-    float n;
-    scanf("%a", &n);
-    return n;
+
+/* Buffered I/O
+ * 所有输入经由一块大缓冲区按块 read(0)，整数与十六进制浮点数手写解析；
+ * 所有输出先写入输出缓冲区，满了、putf 前以及程序退出时统一刷入 stdout。
+ * 对外可观察的字节流与原先逐元素 scanf/printf 的实现完全一致。 */
+#define _SYSY_IBUF_SIZE (1 << 16)
+#define _SYSY_OBUF_SIZE (1 << 16)
+static char _sysy_ibuf[_SYSY_IBUF_SIZE];
+static size_t _sysy_ipos, _sysy_ilen;
+static char _sysy_obuf[_SYSY_OBUF_SIZE];
+static size_t _sysy_opos;
+
+static int _sysy_peek(){
+  if(_sysy_ipos==_sysy_ilen){
+    ssize_t n;
+    do n=read(0,_sysy_ibuf,_SYSY_IBUF_SIZE); while(n<0 && errno==EINTR);
+    _sysy_ipos=0; _sysy_ilen= n>0 ? (size_t)n : 0;
+    if(_sysy_ilen==0) return EOF;
+  }
+  return (unsigned char)_sysy_ibuf[_sysy_ipos];
+}
+static int _sysy_getc(){ int c=_sysy_peek(); if(c!=EOF) _sysy_ipos++; return c; }
+/* 与 scanf 的空白定义一致 */
+static int _sysy_isspace(int c){ return c==' '||(c>='\t'&&c<='\r'); }
+static void _sysy_skip_space(){ while(_sysy_isspace(_sysy_peek())) _sysy_ipos++; }
+
+static void _sysy_flush(){
+  if(_sysy_opos){ fwrite(_sysy_obuf,1,_sysy_opos,stdout); _sysy_opos=0; }
+}
+static void _sysy_write(const char *s,size_t n){
+  if(_sysy_opos+n>_SYSY_OBUF_SIZE) _sysy_flush();
+  if(n>_SYSY_OBUF_SIZE){ fwrite(s,1,n,stdout); return; }
+  memcpy(_sysy_obuf+_sysy_opos,s,n); _sysy_opos+=n;
+}
+static void _sysy_putc(char c){
+  if(_sysy_opos==_SYSY_OBUF_SIZE) _sysy_flush();
+  _sysy_obuf[_sysy_opos++]=c;
 }
 
+/* 等价于 scanf("%d")：跳过空白，可选符号，十进制数字 */
+static int _sysy_read_int(){
+  _sysy_skip_space();
+  int c=_sysy_peek(), neg=0;
+  if(c=='-'||c=='+'){ neg= c=='-'; _sysy_ipos++; c=_sysy_peek(); }
+  unsigned int v=0;
+  while(c>='0'&&c<='9'){ v=v*10u+(unsigned)(c-'0'); _sysy_ipos++; c=_sysy_peek(); }
+  return neg ? (int)(0u-v) : (int)v;
+}
+
+static int _sysy_hexval(int c){
+  if(c>='0'&&c<='9') return c-'0';
+  if(c>='a'&&c<='f') return c-'a'+10;
+  if(c>='A'&&c<='F') return c-'A'+10;
+  return -1;
+}
+/* 解析形如 [+-]0x<hex>[.<hex>][p[+-]<dec>] 的十六进制浮点数。
+ * 有效位超过 53 位时无法保证单次舍入，返回 0 交由 strtof 处理。 */
+static int _sysy_parse_hexfloat(const char *s,float *out){
+  int neg=0;
+  if(*s=='-'||*s=='+') neg= *s++=='-';
+  if(s[0]!='0'||(s[1]!='x'&&s[1]!='X')) return 0;
+  s+=2;
+  uint64_t m=0; int bits=0, exp=0, any=0, d;
+  for(;(d=_sysy_hexval(*s))>=0;s++){ any=1; if(m||d){ if(bits>49) return 0; m=m<<4|(uint64_t)d; bits+=4; } }
+  if(*s=='.') for(s++;(d=_sysy_hexval(*s))>=0;s++){ any=1; if(m||d){ if(bits>49) return 0; m=m<<4|(uint64_t)d; bits+=4; } exp-=4; }
+  if(!any) return 0;
+  if(*s=='p'||*s=='P'){
+    int eneg=0, e=0; s++;
+    if(*s=='-'||*s=='+') eneg= *s++=='-';
+    if(*s<'0'||*s>'9') return 0;
+    for(;*s>='0'&&*s<='9';s++) if(e<100000) e=e*10+(*s-'0');
+    exp+= eneg ? -e : e;
+  }
+  if(*s) return 0;
+  /* m 至多 53 位，按 2 的幂逐段缩放在 double 中是精确的，只在转 float 时舍入一次 */
+  double v=(double)m;
+  while(v!=0&&exp!=0){
+    int step= exp>1000 ? 1000 : exp<-1000 ? -1000 : exp;
+    uint64_t pb=(uint64_t)(step+1023)<<52; double p2; memcpy(&p2,&pb,sizeof(p2));
+    v*=p2; exp-=step;
+    if(isinf(v)) break;
+  }
+  float f=(float)v;
+  *out= neg ? -f : f;
+  return 1;
+}
+/* 浮点记号的扫描状态：只接受 scanf("%a") 会接受的字符 */
+typedef struct {
+  int n, sign_end, hex, dot, exp, exp_digits, digits;
+  const char *special; /* 正在匹配的 "infinity" 或 "nan"，否则为 NULL */
+} _sysy_float_scan;
+static int _sysy_ieq(int a,int b){ return (a|0x20)==b; }
+/* c 能否接在当前记号之后；能则更新状态 */
+static int _sysy_float_accept(_sysy_float_scan *st,const char *tok,int c){
+  int n=st->n;
+  if(n==0&&(c=='-'||c=='+')){ st->sign_end=1; return 1; }
+  if(st->special){
+    int k=n-st->sign_end;
+    return st->special[k]&&_sysy_ieq(c,st->special[k]);
+  }
+  if(n==st->sign_end&&(_sysy_ieq(c,'i')||_sysy_ieq(c,'n'))){
+    st->special= _sysy_ieq(c,'i') ? "infinity" : "nan"; return 1;
+  }
+  if(st->exp){
+    if(n==st->exp&&(c=='-'||c=='+')) return 1;
+    if(c>='0'&&c<='9'){ st->exp_digits=1; return 1; }
+    return 0;
+  }
+  if(!st->hex&&n==st->sign_end+1&&tok[st->sign_end]=='0'&&_sysy_ieq(c,'x')&&!st->dot){
+    st->hex=1; st->digits=0; return 1;
+  }
+  if(st->hex ? _sysy_hexval(c)>=0 : (c>='0'&&c<='9')){ st->digits=1; return 1; }
+  if(c=='.'&&!st->dot){ st->dot=1; return 1; }
+  if(st->digits&&_sysy_ieq(c, st->hex ? 'p' : 'e')){ st->exp=n+1; return 1; }
+  return 0;
+}
+/* 等价于 scanf("%a")：收集一个浮点记号，第一个不能接受的字符留在输入中；
+ * 优先走手写十六进制解析 */
+static float _sysy_read_float(){
+  char small[128], *tok=small; int cap=(int)sizeof(small), c;
+  _sysy_float_scan st={0};
+  _sysy_skip_space();
+  while((c=_sysy_peek())!=EOF&&_sysy_float_accept(&st,tok,c)){
+    if(st.n+1==cap){ /* 记号很长时换到堆上，不截断 */
+      char *grown= tok==small ? malloc((size_t)cap*2) : realloc(tok,(size_t)cap*2);
+      if(!grown) break;
+      if(tok==small) memcpy(grown,small,sizeof(small));
+      tok=grown; cap*=2;
+    }
+    tok[st.n++]=(char)c; _sysy_ipos++;
+  }
+  tok[st.n]='\0';
+  float f;
+  if(!_sysy_parse_hexfloat(tok,&f)) f=strtof(tok,NULL);
+  if(tok!=small) free(tok);
+  return f;
+}
+
+static void _sysy_write_int(int a){
+  char buf[12]; int n=sizeof(buf);
+  unsigned int v= a<0 ? 0u-(unsigned)a : (unsigned)a;
+  do buf[--n]=(char)('0'+v%10u); while(v/=10u);
+  if(a<0) buf[--n]='-';
+  _sysy_write(buf+n,sizeof(buf)-n);
+}
+/* 与 glibc printf("%a", (double)a) 逐字节一致 */
+static void _sysy_write_float(float a){
+  double d=a;
+  if(isnan(d)){ _sysy_write(signbit(d)?"-nan":"nan",signbit(d)?4:3); return; }
+  if(isinf(d)){ _sysy_write(d<0?"-inf":"inf",d<0?4:3); return; }
+  uint64_t bits; memcpy(&bits,&d,sizeof(bits));
+  char buf[32]; int n=0;
+  if(bits>>63) buf[n++]='-';
+  buf[n++]='0'; buf[n++]='x';
+  uint64_t frac=bits&((1ULL<<52)-1);
+  int exp=(int)((bits>>52)&0x7ff);
+  if(exp==0&&frac==0){ buf[n++]='0'; exp=0; }
+  else{
+    buf[n++]='1'; exp-=1023;
+    if(frac){
+      buf[n++]='.';
+      for(int sh=48;frac;sh-=4){ buf[n++]="0123456789abcdef"[(frac>>sh)&0xf]; frac&=(1ULL<<sh)-1; }
+    }
+  }
+  buf[n++]='p'; buf[n++]= exp<0 ? '-' : '+';
+  unsigned int ue= exp<0 ? (unsigned)-exp : (unsigned)exp;
+  char eb[8]; int en=0;
+  do eb[en++]=(char)('0'+ue%10u); while(ue/=10u);
+  while(en) buf[n++]=eb[--en];
+  _sysy_write(buf,n);
+}
+
+/* Input & output functions */
+int getint(){ return _sysy_read_int(); }
+int getch(){ return (int)(char)_sysy_getc(); }
+float getfloat(){ return _sysy_read_float(); }
+
 int getarray(int a[]){
-  int n;
-  scanf("%d",&n);
-  for(int i=0;i<n;i++)scanf("%d",&a[i]);
+  int n=_sysy_read_int();
+  for(int i=0;i<n;i++)a[i]=_sysy_read_int();
   return n;
 }
 
 int getfarray(float a[]) {
-    int n;
-    scanf("%d", &n);
+    int n=_sysy_read_int();
     for (int i = 0; i < n; i++) {
-        scanf("%a", &a[i]);
+        a[i]=_sysy_read_float();
     }
     return n;
 }
-void putint(int a){ printf("%d",a);}
-void putch(int a){ printf("%c",a); }
+void putint(int a){ _sysy_write_int(a);}
+void putch(int a){ _sysy_putc((char)a); }
 void putarray(int n,int a[]){
-  printf("%d:",n);
-  for(int i=0;i<n;i++)printf(" %d",a[i]);
-  printf("\n");
+  _sysy_write_int(n); _sysy_putc(':');
+  for(int i=0;i<n;i++){ _sysy_putc(' '); _sysy_write_int(a[i]); }
+  _sysy_putc('\n');
 }
 void putfloat(float a) {
-  printf("%a", a);
+  _sysy_write_float(a);
 }
 void putfarray(int n, float a[]) {
-    printf("%d:", n);
+    _sysy_write_int(n); _sysy_putc(':');
     for (int i = 0; i < n; i++) {
-        printf(" %a", a[i]);
+        _sysy_putc(' '); _sysy_write_float(a[i]);
     }
-    printf("\n");
+    _sysy_putc('\n');
 }
 
 void putf(char a[], ...) {
     va_list args;
     va_start(args, a);
+    _sysy_flush();
     vfprintf(stdout, a, args);
     va_end(args);
 }
 
-/* Timing function implementation */
+/* Timing function implementation
+ * 计时使用 clock_gettime(CLOCK_MONOTONIC_RAW)，纳秒精度且不受 NTP 调整影响。
+ * starttime/stoptime 可以嵌套：未闭合的区域保存在一个栈里，每对 start/stop
+ * 产生一条记录，记录数组按需扩容。TOTAL 只累加最外层区域，避免重复计时。
+ *
+ * 环境变量：
+ *   SYSY_TIMER_FORMAT=text|csv|json  输出格式（默认 text，与原格式一致）
+ *   SYSY_TIMER_CYCLES=1              同时读取 rdcycle / rdtsc 周期计数器
+ *                                    （部分内核禁止用户态 rdcycle，故默认关闭） */
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+enum { _SYSY_FMT_TEXT, _SYSY_FMT_CSV, _SYSY_FMT_JSON };
+typedef struct { int l1, l2, depth; long long ns; unsigned long long cycles; } _sysy_timer_rec;
+typedef struct { int rec; long long ns; unsigned long long cycles; } _sysy_timer_open;
+static _sysy_timer_rec *_sysy_recs; static int _sysy_nrec, _sysy_caprec;
+static _sysy_timer_open *_sysy_open; static int _sysy_nopen, _sysy_capopen;
+static int _sysy_fmt, _sysy_use_cycles;
+
+static long long _sysy_now_ns(){
+  struct timespec ts; clock_gettime(CLOCK_MONOTONIC_RAW,&ts);
+  return (long long)ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+static unsigned long long _sysy_cycles(){
+  if(!_sysy_use_cycles) return 0;
+#if defined(__riscv) && __riscv_xlen == 64
+  unsigned long long c; __asm__ volatile("rdcycle %0" : "=r"(c)); return c;
+#elif defined(__x86_64__) || defined(__i386__)
+  unsigned int lo, hi; __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((unsigned long long)hi<<32)|lo;
+#else
+  return 0;
+#endif
+}
+static void _sysy_prof_report();
+static void _sysy_par_stop();
+static void *_sysy_grow(void *p,int *cap,size_t elem){
+  int ncap= *cap ? *cap*2 : 64;
+  void *np=realloc(p,(size_t)ncap*elem);
+  if(!np){ fprintf(stderr,"sylib: out of memory for timer records\n"); exit(1); }
+  *cap=ncap; return np;
+}
+
 __attribute((constructor)) void before_main(){
-  for(int i=0;i<_SYSY_N;i++)
-    _sysy_h[i] = _sysy_m[i]= _sysy_s[i] = _sysy_us[i] =0;
-  _sysy_idx=1;
+  const char *f=getenv("SYSY_TIMER_FORMAT"), *c=getenv("SYSY_TIMER_CYCLES");
+  _sysy_fmt= !f ? _SYSY_FMT_TEXT : !strcmp(f,"json") ? _SYSY_FMT_JSON : !strcmp(f,"csv") ? _SYSY_FMT_CSV : _SYSY_FMT_TEXT;
+  _sysy_use_cycles= c && c[0] && strcmp(c,"0");
 }  
 __attribute((destructor)) void after_main(){
-  for(int i=1;i<_sysy_idx;i++){
-    fprintf(stderr,"Timer@%04d-%04d: %dH-%dM-%dS-%dus\n",\
-      _sysy_l1[i],_sysy_l2[i],_sysy_h[i],_sysy_m[i],_sysy_s[i],_sysy_us[i]);
-    _sysy_us[0]+= _sysy_us[i]; 
-    _sysy_s[0] += _sysy_s[i]; _sysy_us[0] %= 1000000;
-    _sysy_m[0] += _sysy_m[i]; _sysy_s[0] %= 60;
-    _sysy_h[0] += _sysy_h[i]; _sysy_m[0] %= 60;
+  _sysy_flush();
+  /* 丢弃到退出时仍未 stoptime 的区域 */
+  int n=0;
+  for(int i=0;i<_sysy_nrec;i++) if(_sysy_recs[i].l2>=0) _sysy_recs[n++]=_sysy_recs[i];
+  _sysy_nrec=n;
+  long long total=0; unsigned long long total_cycles=0;
+  for(int i=0;i<_sysy_nrec;i++) if(_sysy_recs[i].depth==0){ total+=_sysy_recs[i].ns; total_cycles+=_sysy_recs[i].cycles; }
+  if(_sysy_fmt==_SYSY_FMT_JSON){
+    fprintf(stderr,"{\"timers\":[");
+    for(int i=0;i<_sysy_nrec;i++){
+      _sysy_timer_rec *r=&_sysy_recs[i];
+      fprintf(stderr,"%s{\"start_line\":%d,\"stop_line\":%d,\"depth\":%d,\"ns\":%lld,\"cycles\":%llu}",
+        i?",":"",r->l1,r->l2,r->depth,r->ns,r->cycles);
+    }
+    fprintf(stderr,"],\"total_ns\":%lld,\"total_cycles\":%llu}\n",total,total_cycles);
+  }else if(_sysy_fmt==_SYSY_FMT_CSV){
+    fprintf(stderr,"start_line,stop_line,depth,ns,cycles\n");
+    for(int i=0;i<_sysy_nrec;i++){
+      _sysy_timer_rec *r=&_sysy_recs[i];
+      fprintf(stderr,"%d,%d,%d,%lld,%llu\n",r->l1,r->l2,r->depth,r->ns,r->cycles);
+    }
+    fprintf(stderr,"TOTAL,,,%lld,%llu\n",total,total_cycles);
+  }else{
+    for(int i=0;i<_sysy_nrec;i++){
+      _sysy_timer_rec *r=&_sysy_recs[i]; long long us=r->ns/1000;
+      fprintf(stderr,"%*sTimer@%04d-%04d: %dH-%dM-%dS-%dus\n",2*r->depth,"",
+        r->l1,r->l2,(int)(us/3600000000LL),(int)(us/60000000LL%60),(int)(us/1000000LL%60),(int)(us%1000000LL));
+    }
+    long long us=total/1000;
+    fprintf(stderr,"TOTAL: %dH-%dM-%dS-%dus\n",
+      (int)(us/3600000000LL),(int)(us/60000000LL%60),(int)(us/1000000LL%60),(int)(us%1000000LL));
   }
-  fprintf(stderr,"TOTAL: %dH-%dM-%dS-%dus\n",_sysy_h[0],_sysy_m[0],_sysy_s[0],_sysy_us[0]);
+  free(_sysy_recs); free(_sysy_open);
+  _sysy_prof_report();
+  _sysy_par_stop();
 }  
 void _sysy_starttime(int lineno){
-  _sysy_l1[_sysy_idx] = lineno;
-  gettimeofday(&_sysy_start,NULL);
+  if(_sysy_nopen==_sysy_capopen) _sysy_open=_sysy_grow(_sysy_open,&_sysy_capopen,sizeof(*_sysy_open));
+  if(_sysy_nrec==_sysy_caprec) _sysy_recs=_sysy_grow(_sysy_recs,&_sysy_caprec,sizeof(*_sysy_recs));
+  /* 记录按 start 的先后顺序排列，外层区域排在其内层区域之前 */
+  _sysy_timer_rec *r=&_sysy_recs[_sysy_nrec];
+  r->l1=lineno; r->l2=-1; r->depth=_sysy_nopen; r->ns=0; r->cycles=0;
+  _sysy_timer_open *o=&_sysy_open[_sysy_nopen++];
+  o->rec=_sysy_nrec++;
+  o->cycles=_sysy_cycles();
+  o->ns=_sysy_now_ns();
 }
 void _sysy_stoptime(int lineno){
-  gettimeofday(&_sysy_end,NULL);
-  _sysy_l2[_sysy_idx] = lineno;
-  _sysy_us[_sysy_idx] += 1000000 * ( _sysy_end.tv_sec - _sysy_start.tv_sec ) + _sysy_end.tv_usec - _sysy_start.tv_usec;
-  _sysy_s[_sysy_idx] += _sysy_us[_sysy_idx] / 1000000 ; _sysy_us[_sysy_idx] %= 1000000;
-  _sysy_m[_sysy_idx] += _sysy_s[_sysy_idx] / 60 ; _sysy_s[_sysy_idx] %= 60;
-  _sysy_h[_sysy_idx] += _sysy_m[_sysy_idx] / 60 ; _sysy_m[_sysy_idx] %= 60;
-  _sysy_idx ++;
+  long long ns=_sysy_now_ns();
+  unsigned long long cy=_sysy_cycles();
+  if(_sysy_nopen==0) return; /* 没有匹配的 starttime */
+  _sysy_timer_open *o=&_sysy_open[--_sysy_nopen];
+  _sysy_timer_rec *r=&_sysy_recs[o->rec];
+  r->l2=lineno; r->ns=ns-o->ns; r->cycles=cy-o->cycles;
+}
+
+/* Function profiler hooks
+ * 由 sysyc --instrument-functions 在每个函数入口/返回点插入调用。函数编号是
+ * 稠密的，直接索引统计表；调用栈记录每个活动帧的起始时间与子调用耗时，
+ * 以区分包含时间与独占时间。递归函数的包含时间只在最外层活动帧退出时累加。
+ * 计时单位与计时器一致：SYSY_TIMER_CYCLES=1 时为周期数，否则为纳秒。 */
+typedef struct { const char *name; long long calls; unsigned long long incl, excl; int active; } _sysy_prof_fn;
+typedef struct { int id; unsigned long long start, child; } _sysy_prof_frame;
+static _sysy_prof_fn *_sysy_prof_fns; static int _sysy_prof_nfn, _sysy_prof_capfn;
+static _sysy_prof_frame *_sysy_prof_stack; static int _sysy_prof_depth, _sysy_prof_capstack;
+
+static unsigned long long _sysy_prof_now(){
+  return _sysy_use_cycles ? _sysy_cycles() : (unsigned long long)_sysy_now_ns();
+}
+void _sysy_prof_enter(int id,char name[]){
+  if(id<0) return;
+  if(id>=_sysy_prof_nfn){
+    while(id>=_sysy_prof_capfn) _sysy_prof_fns=_sysy_grow(_sysy_prof_fns,&_sysy_prof_capfn,sizeof(*_sysy_prof_fns));
+    memset(_sysy_prof_fns+_sysy_prof_nfn,0,sizeof(*_sysy_prof_fns)*(size_t)(id+1-_sysy_prof_nfn));
+    _sysy_prof_nfn=id+1;
+  }
+  _sysy_prof_fn *f=&_sysy_prof_fns[id];
+  if(!f->name) f->name=name;
+  f->calls++; f->active++;
+  if(_sysy_prof_depth==_sysy_prof_capstack) _sysy_prof_stack=_sysy_grow(_sysy_prof_stack,&_sysy_prof_capstack,sizeof(*_sysy_prof_stack));
+  _sysy_prof_frame *fr=&_sysy_prof_stack[_sysy_prof_depth++];
+  fr->id=id; fr->child=0;
+  fr->start=_sysy_prof_now();
+}
+void _sysy_prof_exit(int id){
+  unsigned long long now=_sysy_prof_now();
+  if(_sysy_prof_depth==0||_sysy_prof_stack[_sysy_prof_depth-1].id!=id) return; /* 不匹配的出口 */
+  _sysy_prof_frame *fr=&_sysy_prof_stack[--_sysy_prof_depth];
+  _sysy_prof_fn *f=&_sysy_prof_fns[id];
+  unsigned long long elapsed=now-fr->start;
+  f->excl+=elapsed-fr->child;
+  if(--f->active==0) f->incl+=elapsed;
+  if(_sysy_prof_depth) _sysy_prof_stack[_sysy_prof_depth-1].child+=elapsed;
+}
+static int _sysy_prof_cmp(const void *a,const void *b){
+  const _sysy_prof_fn *x=&_sysy_prof_fns[*(const int*)a], *y=&_sysy_prof_fns[*(const int*)b];
+  if(x->excl!=y->excl) return x->excl<y->excl ? 1 : -1;
+  return *(const int*)a-*(const int*)b;
+}
+static void _sysy_prof_report(){
+  if(_sysy_prof_nfn==0) return;
+  int *order=malloc(sizeof(int)*(size_t)_sysy_prof_nfn), n=0;
+  unsigned long long total=0;
+  if(!order) return;
+  for(int i=0;i<_sysy_prof_nfn;i++) if(_sysy_prof_fns[i].calls){ order[n++]=i; total+=_sysy_prof_fns[i].excl; }
+  qsort(order,(size_t)n,sizeof(int),_sysy_prof_cmp);
+  const char *unit= _sysy_use_cycles ? "cycles" : "ns";
+  if(_sysy_fmt==_SYSY_FMT_JSON){
+    fprintf(stderr,"{\"profile\":{\"unit\":\"%s\",\"functions\":[",unit);
+    for(int k=0;k<n;k++){
+      _sysy_prof_fn *f=&_sysy_prof_fns[order[k]];
+      fprintf(stderr,"%s{\"name\":\"%s\",\"calls\":%lld,\"inclusive\":%llu,\"exclusive\":%llu}",
+        k?",":"",f->name?f->name:"?",f->calls,f->incl,f->excl);
+    }
+    fprintf(stderr,"]}}\n");
+  }else if(_sysy_fmt==_SYSY_FMT_CSV){
+    fprintf(stderr,"function,calls,inclusive_%s,exclusive_%s\n",unit,unit);
+    for(int k=0;k<n;k++){
+      _sysy_prof_fn *f=&_sysy_prof_fns[order[k]];
+      fprintf(stderr,"%s,%lld,%llu,%llu\n",f->name?f->name:"?",f->calls,f->incl,f->excl);
+    }
+  }else{
+    fprintf(stderr,"Profile (%s):\n%-24s %12s %18s %18s %7s\n",unit,"function","calls","inclusive","exclusive","excl%");
+    for(int k=0;k<n;k++){
+      _sysy_prof_fn *f=&_sysy_prof_fns[order[k]];
+      fprintf(stderr,"%-24s %12lld %18llu %18llu %6.2f%%\n",f->name?f->name:"?",f->calls,f->incl,f->excl,
+        total ? 100.0*(double)f->excl/(double)total : 0.0);
+    }
+  }
+  free(order); free(_sysy_prof_fns); free(_sysy_prof_stack);
+}
+
+/* Parallel loop runtime
+ * 由 sysyc --auto-parallel 外提的 DOALL 循环调用。body(lo,hi) 执行区间 [lo,hi)
+ * 上的迭代并返回部分归约值。线程池在首次调用时创建并常驻，线程数取环境变量
+ * SYSY_NUM_THREADS，缺省为在线 CPU 数。迭代空间按线程数切成连续区间，主线程
+ * 执行第 0 块；部分结果按区间顺序合并，整数加/乘满足结合律，结果与串行一致。 */
+#define _SYSY_PAR_MAX_THREADS 64
+#define _SYSY_PAR_MIN_ITERS 1024 /* 每个线程至少分到的迭代数，过小的循环串行执行 */
+enum { _SYSY_REDUCE_NONE, _SYSY_REDUCE_ADD, _SYSY_REDUCE_MUL };
+static pthread_mutex_t _sysy_par_mu=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _sysy_par_start=PTHREAD_COND_INITIALIZER, _sysy_par_done=PTHREAD_COND_INITIALIZER;
+static int _sysy_par_nthreads; /* 0 表示尚未初始化 */
+static unsigned long _sysy_par_gen;
+static int _sysy_par_pending, _sysy_par_active, _sysy_par_shutdown;
+static int (*_sysy_par_body)(int,int);
+static int _sysy_par_lo, _sysy_par_hi;
+static int _sysy_par_partial[_SYSY_PAR_MAX_THREADS];
+static pthread_t _sysy_par_threads[_SYSY_PAR_MAX_THREADS];
+
+static int _sysy_par_chunk_lo(int k,int n){
+  return _sysy_par_lo+(int)(((long long)_sysy_par_hi-_sysy_par_lo)*k/n);
+}
+static void *_sysy_par_worker(void *arg){
+  int k=(int)(intptr_t)arg;
+  unsigned long seen=0;
+  pthread_mutex_lock(&_sysy_par_mu);
+  for(;;){
+    while(_sysy_par_gen==seen&&!_sysy_par_shutdown) pthread_cond_wait(&_sysy_par_start,&_sysy_par_mu);
+    if(_sysy_par_shutdown) break;
+    seen=_sysy_par_gen;
+    if(k>=_sysy_par_active) continue; /* 本轮未分配区间 */
+    pthread_mutex_unlock(&_sysy_par_mu);
+    int r=_sysy_par_body(_sysy_par_chunk_lo(k,_sysy_par_active),_sysy_par_chunk_lo(k+1,_sysy_par_active));
+    pthread_mutex_lock(&_sysy_par_mu);
+    _sysy_par_partial[k]=r;
+    if(--_sysy_par_pending==0) pthread_cond_signal(&_sysy_par_done);
+  }
+  pthread_mutex_unlock(&_sysy_par_mu);
+  return NULL;
+}
+static void _sysy_par_init(){
+  const char *env=getenv("SYSY_NUM_THREADS");
+  long n=env&&*env ? strtol(env,NULL,10) : sysconf(_SC_NPROCESSORS_ONLN);
+  if(n<1) n=1;
+  if(n>_SYSY_PAR_MAX_THREADS) n=_SYSY_PAR_MAX_THREADS;
+  _sysy_par_nthreads=1;
+  for(int k=1;k<n;k++){
+    if(pthread_create(&_sysy_par_threads[k],NULL,_sysy_par_worker,(void*)(intptr_t)k)!=0) break;
+    _sysy_par_nthreads=k+1;
+  }
+}
+static void _sysy_par_stop(){
+  if(_sysy_par_nthreads<=1) return;
+  pthread_mutex_lock(&_sysy_par_mu);
+  _sysy_par_shutdown=1;
+  pthread_cond_broadcast(&_sysy_par_start);
+  pthread_mutex_unlock(&_sysy_par_mu);
+  for(int k=1;k<_sysy_par_nthreads;k++) pthread_join(_sysy_par_threads[k],NULL);
+  _sysy_par_nthreads=0;
+}
+static int _sysy_par_combine(int op,int acc,int x){
+  if(op==_SYSY_REDUCE_ADD) return (int)((unsigned)acc+(unsigned)x);
+  if(op==_SYSY_REDUCE_MUL) return (int)((unsigned)acc*(unsigned)x);
+  return 0;
+}
+int _sysy_parallel_for(int lo,int hi,int (*body)(int,int),int reduce_op,int reduce_init){
+  if(lo>=hi) return reduce_op==_SYSY_REDUCE_NONE ? 0 : reduce_init;
+  if(_sysy_par_nthreads==0) _sysy_par_init();
+  long long iters=(long long)hi-lo;
+  int n=_sysy_par_nthreads;
+  if(iters/_SYSY_PAR_MIN_ITERS<n) n=(int)(iters/_SYSY_PAR_MIN_ITERS);
+  if(n<=1) return _sysy_par_combine(reduce_op,reduce_init,body(lo,hi));
+
+  pthread_mutex_lock(&_sysy_par_mu);
+  _sysy_par_body=body; _sysy_par_lo=lo; _sysy_par_hi=hi;
+  _sysy_par_active=n; _sysy_par_pending=n-1;
+  _sysy_par_gen++;
+  pthread_cond_broadcast(&_sysy_par_start);
+  pthread_mutex_unlock(&_sysy_par_mu);
+
+  _sysy_par_partial[0]=body(_sysy_par_chunk_lo(0,n),_sysy_par_chunk_lo(1,n));
+
+  pthread_mutex_lock(&_sysy_par_mu);
+  while(_sysy_par_pending>0) pthread_cond_wait(&_sysy_par_done,&_sysy_par_mu);
+  pthread_mutex_unlock(&_sysy_par_mu);
+
+  int acc=reduce_init;
+  for(int k=0;k<n;k++) acc=_sysy_par_combine(reduce_op,acc,_sysy_par_partial[k]);
+  return acc;
 }
@@ -3,7 +3,7 @@
 
 #include<stdio.h>
 #include<stdarg.h>
-#include<sys/time.h>
+#include<time.h>
 /* Input & output functions */
 int getint(),getch(),getarray(int a[]);
 float getfloat();
@@ -16,16 +16,19 @@ void putfarray(int n, float a[]);
 void putf(char a[], ...);
 
 /* Timing function implementation */
-struct timeval _sysy_start,_sysy_end;
 #define starttime() _sysy_starttime(__LINE__)
 #define stoptime()  _sysy_stoptime(__LINE__)
-#define _SYSY_N 1024
-int _sysy_l1[_SYSY_N],_sysy_l2[_SYSY_N];
-int _sysy_h[_SYSY_N], _sysy_m[_SYSY_N],_sysy_s[_SYSY_N],_sysy_us[_SYSY_N];
-int _sysy_idx;
 __attribute((constructor)) void before_main(); 
 __attribute((destructor)) void after_main();
 void _sysy_starttime(int lineno);
 void _sysy_stoptime(int lineno);
 
+/* Function profiler hooks (inserted by sysyc --instrument-functions) */
+void _sysy_prof_enter(int id,char name[]);
+void _sysy_prof_exit(int id);
+
+/* Parallel loop runtime (called by sysyc --auto-parallel, threads: SYSY_NUM_THREADS)
+ * reduce_op: 0 = none, 1 = add, 2 = mul */
+int _sysy_parallel_for(int lo,int hi,int (*body)(int,int),int reduce_op,int reduce_init);
+
 #endif
@@ -6,10 +6,12 @@
  * 主要功能包括：
  * 1.  **内存池管理**：实现了一个高效的区域内存分配器（Arena Allocator），
  *     用于快速分配AST节点、类型等对象，并在编译结束后一次性释放所有内存。
+ *     每个函数体另有一个子内存池，降级为 IR 后即可单独释放。
  * 2.  **类型创建**：实现了创建基础类型、数组、函数等类型对象的工厂函数。
  * 3.  **AST节点创建**：实现了为各种语法结构创建AST节点的工厂函数。
- *     所有节点都通过内存池进行分配，并自动设置父节点指针。
- * 4.  **调试支持**：提供了打印AST结构和类型信息的函数，便于开发和调试。
+ *     所有节点都通过内存池进行分配。
+ * 4.  **紧凑布局**：按前序为节点编号，把类型、父子关系和子树范围存入连续数组。
+ * 5.  **调试支持**：提供了打印AST结构和类型信息的函数，便于开发和调试。
  */
 
 #include "ast.h"
@@ -24,14 +26,11 @@
 
 /** @brief 创建一个通用的AST节点，并进行基本初始化。*/
 static ASTNode* create_node(ASTContext* ctx, ASTNodeType type, SourceLocation loc);
-/** @brief 设置子节点的父节点指针。*/
-static void set_parent(ASTNode* parent, ASTNode* child);
-/** @brief 批量为列表中的所有子节点设置父节点指针。*/
-static void set_parent_for_list(ASTNode* parent, ASTNode** list, size_t count);
 /** @brief 将操作符类型枚举转换为可读的字符串，用于调试打印。*/
 const char* operator_type_to_string(OperatorType op);
 
 #define BLOCK_SIZE 4096  ///< 内存池每次分配新内存块的默认大小
+#define INTERNER_INITIAL_CAPACITY 1024 ///< 字符串驻留表的初始槽位数（2 的幂）
 
 // ================================
 // 1. 内存池实现 (Memory Pool Implementation)
@@ -57,6 +56,8 @@ typedef struct Block {
 struct MemoryPool {
     Block* first;           ///< 指向第一个内存块
     Block* current;         ///< 指向当前正在进行分配的内存块
+    MemoryPool* prev_arena; ///< 作为函数子内存池时，在 ASTContext 拥有链表中的前驱
+    MemoryPool* next_arena; ///< 作为函数子内存池时，在 ASTContext 拥有链表中的后继
 };
 
 /**
@@ -72,6 +73,8 @@ MemoryPool* create_memory_pool() {
     }
     pool->first = NULL;
     pool->current = NULL;
+    pool->prev_arena = NULL;
+    pool->next_arena = NULL;
     return pool;
 }
 
@@ -142,6 +145,24 @@ void destroy_memory_pool(MemoryPool* pool) {
     free(pool);
 }
 
+/**
+ * @brief 把 src 的全部内存块移交给 dest，并释放 src 本身。
+ * @details src 的块链表整体接到 dest 块链表的前端，dest 的当前块保持不变，
+ *          因此只需 O(1) 时间，src 中已分配的对象原地保持有效。
+ * @param dest 接收内存块的内存池。
+ * @param src 被合并的内存池，调用后不可再使用。
+ */
+void pool_merge(MemoryPool* dest, MemoryPool* src) {
+    if (!src) return;
+    if (src->first) {
+        // 新块总是追加在链表末尾，src 的当前块就是其最后一块
+        src->current->next = dest->first;
+        dest->first = src->first;
+        if (!dest->current) dest->current = src->current;
+    }
+    free(src);
+}
+
 /**
  * @brief 在内存池中分配空间并复制一个字符串。
  * @param pool 内存池指针。
@@ -240,9 +261,13 @@ Type* create_void_type(MemoryPool* pool) {
 ASTContext* create_ast_context() {
     ASTContext* ctx = (ASTContext*)calloc(1, sizeof(ASTContext));
     ctx->pool = create_memory_pool();
+    ctx->node_pool = ctx->pool;
+    // 驻留表需在全局符号表之前就绪
+    ctx->interner.capacity = INTERNER_INITIAL_CAPACITY;
+    ctx->interner.slots = (InternedHeader**)calloc(ctx->interner.capacity, sizeof(InternedHeader*));
     // 直接初始化 ErrorContext
     init_error_context(&ctx->errors, 32);
-    ctx->global_scope = create_symbol_table(ctx, NULL); // 创建全局符号表
+    ctx->global_scope = create_symbol_table(ctx->pool, NULL); // 创建全局符号表
     // 初始化日志配置为默认值
     logger_config_init_default(&ctx->log_config);
     return ctx;
@@ -252,12 +277,128 @@ void destroy_ast_context(ASTContext* ctx) {
     if (!ctx) return;
     // 释放 ErrorContext 的内部数组
     free_error_context(&ctx->errors);
-    // 销毁内存池（会释放符号表、AST节点等）
+    // 释放全局作用域持有的名字表（作用域记录本身在内存池中）
+    destroy_symbol_table(ctx->global_scope, ctx);
+    // 紧凑布局的各数组随节点数增长，独立于内存池分配
+    free(ctx->layout.nodes);
+    free(ctx->layout.kinds);
+    free(ctx->layout.flags);
+    free(ctx->layout.parents);
+    free(ctx->layout.subtree_end);
+    // 驻留表的槽位数组独立于内存池分配（扩容时需要释放旧数组）
+    free(ctx->interner.slots);
+    // 销毁尚未提前释放的函数子内存池，再销毁主内存池（会释放符号表、AST节点等）
+    while (ctx->function_arenas) {
+        MemoryPool* arena = ctx->function_arenas;
+        ctx->function_arenas = arena->next_arena;
+        destroy_memory_pool(arena);
+    }
     destroy_memory_pool(ctx->pool);
     // 最后释放 ASTContext 本身
     free(ctx);
 }
 
+// --- 函数子内存池 (Function Arenas) ---
+
+void ast_begin_function_arena(ASTContext* ctx) {
+    // 语法错误恢复可能跳过上一个函数体的结束动作，此时直接沿用其子内存池
+    if (ctx->node_pool != ctx->pool) return;
+    MemoryPool* arena = create_memory_pool();
+    arena->next_arena = ctx->function_arenas;
+    if (ctx->function_arenas) ctx->function_arenas->prev_arena = arena;
+    ctx->function_arenas = arena;
+    ctx->node_pool = arena;
+}
+
+MemoryPool* ast_end_function_arena(ASTContext* ctx) {
+    MemoryPool* arena = ctx->node_pool != ctx->pool ? ctx->node_pool : NULL;
+    ctx->node_pool = ctx->pool;
+    return arena;
+}
+
+void ast_release_function_body(ASTContext* ctx, ASTNode* func) {
+    assert(func && func->node_type == AST_FUNC_DECL);
+    MemoryPool* arena = ast_function_arena(func);
+    if (!arena) return;
+    assert(ctx->node_pool != arena && "不能释放正在使用的函数子内存池");
+
+    // 参数节点在顶层内存池中，但它们的符号与函数作用域都在子内存池里
+    for (size_t i = 0; i < func->func_decl.param_count; ++i) {
+        func->func_decl.params[i]->sym = NULL;
+    }
+    func->func_decl.body = NULL;
+    func->func_decl.scope = NULL;
+
+    if (arena->prev_arena) {
+        arena->prev_arena->next_arena = arena->next_arena;
+    } else {
+        ctx->function_arenas = arena->next_arena;
+    }
+    if (arena->next_arena) arena->next_arena->prev_arena = arena->prev_arena;
+    destroy_memory_pool(arena);
+}
+
+// --- 字符串驻留 (String Interning) ---
+
+/** @brief 计算字节序列的 32 位 FNV-1a 哈希值。*/
+static uint32_t intern_hash_bytes(const char* s, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** @brief 将驻留表扩容为原来的两倍并重新放置所有条目（使用已存储的哈希值）。*/
+static void interner_grow(StringInterner* interner) {
+    size_t new_capacity = interner->capacity * 2;
+    InternedHeader** slots = (InternedHeader**)calloc(new_capacity, sizeof(InternedHeader*));
+    if (!slots) {
+        fprintf(stderr, "Fatal: failed to grow string interner.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < interner->capacity; ++i) {
+        InternedHeader* entry = interner->slots[i];
+        if (!entry) continue;
+        size_t j = entry->hash & (new_capacity - 1);
+        while (slots[j]) j = (j + 1) & (new_capacity - 1);
+        slots[j] = entry;
+    }
+    free(interner->slots);
+    interner->slots = slots;
+    interner->capacity = new_capacity;
+}
+
+const char* ast_intern(ASTContext* ctx, const char* s, size_t len) {
+    assert(ctx && s);
+    StringInterner* interner = &ctx->interner;
+    uint32_t hash = intern_hash_bytes(s, len);
+    size_t mask = interner->capacity - 1;
+    size_t i = hash & mask;
+    for (InternedHeader* entry; (entry = interner->slots[i]) != NULL; i = (i + 1) & mask) {
+        if (entry->hash == hash && entry->length == len && memcmp(entry->chars, s, len) == 0) {
+            return entry->chars;
+        }
+    }
+
+    InternedHeader* entry = (InternedHeader*)pool_alloc(ctx->pool, sizeof(InternedHeader) + len + 1);
+    entry->hash = hash;
+    entry->length = (uint32_t)len;
+    memcpy(entry->chars, s, len);
+    entry->chars[len] = '\0';
+    interner->slots[i] = entry;
+    // 负载因子保持在 1/2 以下，线性探测的平均探测长度接近 1
+    if (++interner->count * 2 > interner->capacity) {
+        interner_grow(interner);
+    }
+    return entry->chars;
+}
+
+const char* ast_intern_cstr(ASTContext* ctx, const char* s) {
+    return ast_intern(ctx, s, strlen(s));
+}
+
 // ================================
 // 4. AST节点工厂函数 (AST Node Factory Functions)
 // ================================
@@ -272,11 +413,11 @@ void destroy_ast_context(ASTContext* ctx) {
  * @return 指向新创建的ASTNode的指针。
  */
 static ASTNode* create_node(ASTContext* ctx, ASTNodeType type, SourceLocation loc) {
-    ASTNode* node = (ASTNode*)pool_alloc(ctx->pool, sizeof(ASTNode));
+    ASTNode* node = (ASTNode*)pool_alloc(ctx->node_pool, sizeof(ASTNode));
     memset(node, 0, sizeof(ASTNode));
     node->node_type = type;
     node->loc = loc;
-    node->parent = NULL; // 默认父指针为NULL
+    node->id = AST_INVALID_NODE_ID; // 由 ast_build_layout 编号
     return node;
 }
 
@@ -284,10 +425,9 @@ ASTNode* create_var_decl(ASTContext* ctx, const char* name, const Type* type, co
     assert(ctx && "Context must not be null");
     assert(name && strlen(name) > 0 && "Name must not be null or empty");
     ASTNode* node = create_node(ctx, AST_VAR_DECL, loc);
-    node->var_decl.name = pool_strdup(ctx->pool, name);
+    node->var_decl.name = (char*)name;
     node->var_decl.var_type = (Type*)type;
     node->var_decl.init_value = (ASTNode*)init;
-    set_parent(node, (ASTNode*)init);
     return node;
 }
 
@@ -295,17 +435,16 @@ ASTNode* create_const_decl(ASTContext* ctx, const char* name, const Type* type,
     assert(ctx && "Context must not be null");
     assert(name && strlen(name) > 0 && "Name must not be null or empty");
     ASTNode* node = create_node(ctx, AST_CONST_DECL, loc);
-    node->const_decl.name = pool_strdup(ctx->pool, name);
+    node->const_decl.name = (char*)name;
     node->const_decl.const_type = (Type*)type;
     node->const_decl.value = (ASTNode*)value;
-    set_parent(node, (ASTNode*)value);
     return node;
 }
 
 ASTNode* create_func_param(ASTContext* ctx, const char* name, const Type* type, SourceLocation loc) {
     assert(ctx && name);
     ASTNode* node = create_node(ctx, AST_FUNC_PARAM, loc);
-    node->func_param.name = pool_strdup(ctx->pool, name);
+    node->func_param.name = (char*)name;
     node->func_param.param_type = (Type*)type;
     return node;
 }
@@ -316,13 +455,11 @@ ASTNode* create_func_decl(ASTContext* ctx, const char* name, const Type* return_
         ctx->has_main = true;
     }
     ASTNode* node = create_node(ctx, AST_FUNC_DECL, loc);
-    node->func_decl.func_name = pool_strdup(ctx->pool, name);
+    node->func_decl.func_name = (char*)name;
     node->func_decl.return_type = (Type*)return_type;
     node->func_decl.params = params;
     node->func_decl.param_count = param_count;
     node->func_decl.body = body;
-    set_parent_for_list(node, params, param_count);
-    set_parent(node, body);
     return node;
 }
 
@@ -332,7 +469,6 @@ ASTNode* create_compound_stmt(ASTContext* ctx, ASTNode** items, size_t count, So
     node->compound_stmt.items = items;
     node->compound_stmt.item_count = count;
     node->compound_stmt.scope = NULL;
-    set_parent_for_list(node, items, count);
     return node;
 }
 
@@ -342,9 +478,6 @@ ASTNode* create_if_stmt(ASTContext* ctx, const ASTNode* cond, const ASTNode* the
     node->if_stmt.cond = (ASTNode*)cond;
     node->if_stmt.then_stmt = (ASTNode*)then_stmt;
     node->if_stmt.else_stmt = (ASTNode*)else_stmt;
-    set_parent(node, (ASTNode*)cond);
-    set_parent(node, (ASTNode*)then_stmt);
-    set_parent(node, (ASTNode*)else_stmt);
     return node;
 }
 
@@ -353,8 +486,6 @@ ASTNode* create_while_stmt(ASTContext* ctx, const ASTNode* cond, const ASTNode*
     ASTNode* node = create_node(ctx, AST_WHILE_STMT, loc);
     node->while_stmt.cond = (ASTNode*)cond;
     node->while_stmt.body = (ASTNode*)body;
-    set_parent(node, (ASTNode*)cond);
-    set_parent(node, (ASTNode*)body);
     return node;
 }
 
@@ -362,7 +493,6 @@ ASTNode* create_return_stmt(ASTContext* ctx, const ASTNode* value, SourceLocatio
     assert(ctx);
     ASTNode* node = create_node(ctx, AST_RETURN_STMT, loc);
     node->return_stmt.value = (ASTNode*)value;
-    set_parent(node, (ASTNode*)value);
     return node;
 }
 
@@ -380,7 +510,6 @@ ASTNode* create_expr_stmt(ASTContext* ctx, const ASTNode* expr, SourceLocation l
     assert(ctx);
     ASTNode* node = create_node(ctx, AST_EXPR_STMT, loc);
     node->expr_stmt.expr = (ASTNode*)expr;
-    set_parent(node, (ASTNode*)expr);
     return node;
 }
 
@@ -389,8 +518,6 @@ ASTNode* create_assign_stmt(ASTContext* ctx, const ASTNode* lval, const ASTNode*
     ASTNode* node = create_node(ctx, AST_ASSIGN_STMT, loc);
     node->assign_stmt.lval = (ASTNode*)lval;
     node->assign_stmt.expr = (ASTNode*)expr;
-    set_parent(node, (ASTNode*)lval);
-    set_parent(node, (ASTNode*)expr);
     return node;
 }
 
@@ -400,8 +527,6 @@ ASTNode* create_binary_expr(ASTContext* ctx, OperatorType op, const ASTNode* lef
     node->binary_expr.op = op;
     node->binary_expr.left = (ASTNode*)left;
     node->binary_expr.right = (ASTNode*)right;
-    set_parent(node, (ASTNode*)left);
-    set_parent(node, (ASTNode*)right);
     return node;
 }
 
@@ -411,7 +536,6 @@ ASTNode* create_unary_expr(ASTContext* ctx, OperatorType op, const ASTNode* oper
     ASTNode* node = create_node(ctx, AST_UNARY_EXPR, loc);
     node->unary_expr.op = op;
     node->unary_expr.operand = (ASTNode*)operand;
-    set_parent(node, (ASTNode*)operand);
     return node;
 }
 
@@ -421,8 +545,6 @@ ASTNode* create_call_expr(ASTContext* ctx, ASTNode* callee_expr, ASTNode** args,
     node->call_expr.callee_expr = callee_expr;
     node->call_expr.args = args;
     node->call_expr.arg_count = arg_count;
-    set_parent(node, callee_expr);
-    set_parent_for_list(node, args, arg_count);
     return node;
 }
 
@@ -431,15 +553,25 @@ ASTNode* create_array_access(ASTContext* ctx, const ASTNode* array, const ASTNod
     ASTNode* node = create_node(ctx, AST_ARRAY_ACCESS, loc);
     node->array_access.array = (ASTNode*)array;
     node->array_access.index = (ASTNode*)index;
-    set_parent(node, (ASTNode*)array);
-    set_parent(node, (ASTNode*)index);
     return node;
 }
 
 ASTNode* create_identifier(ASTContext* ctx, const char* name, SourceLocation loc) {
     assert(ctx && name);
     ASTNode* node = create_node(ctx, AST_IDENTIFIER, loc);
-    node->identifier.name = pool_strdup(ctx->pool, name);
+    node->identifier.name = (char*)ast_intern_cstr(ctx, name);
+    return node;
+}
+
+ASTNode* create_identifier_from_source(ASTContext* ctx, SourceSpan span, SourceLocation loc) {
+    assert(ctx && ctx->source_text && span.length > 0);
+    const char* text = ast_span_text(ctx, span);
+    assert(text && "Identifier span is outside the source buffer");
+    ASTNode* node = create_node(ctx, AST_IDENTIFIER, loc);
+    // 直接从映射的源文本驻留：同名标识符的所有出现共享一个规范指针，
+    // 只有第一次出现时才复制文本
+    node->identifier.name = (char*)ast_intern(ctx, text, span.length);
+    node->identifier.span = span;
     return node;
 }
 
@@ -468,18 +600,24 @@ ASTNode* create_array_init(ASTContext* ctx, ASTNode** elements, size_t elem_coun
     ASTNode* node = create_node(ctx, AST_ARRAY_INIT, loc);
     node->array_init.elements = elements;
     node->array_init.elem_count = elem_count;
-    set_parent_for_list(node, elements, elem_count);
     return node;
 }
 
-ASTNode* create_string_literal(ASTContext* ctx, const char* value, size_t length, SourceLocation loc) {
+ASTNode* create_string_literal(ASTContext* ctx, const char* value, size_t length, SourceSpan span, SourceLocation loc) {
     assert(ctx && value);
     ASTNode* node = create_node(ctx, AST_STRING_LITERAL, loc);
-    node->string_literal.value = pool_strdup(ctx->pool, value);
+    node->string_literal.value = pool_strdup(ctx->node_pool, value);
     node->string_literal.length = length;
+    node->string_literal.span = span;
     return node;
 }
 
+const char* ast_span_text(const ASTContext* ctx, SourceSpan span) {
+    if (!ctx || !ctx->source_text) return NULL;
+    if ((size_t)span.offset + span.length > ctx->source_size) return NULL;
+    return ctx->source_text + span.offset;
+}
+
 // ================================
 // 5. 运行时库函数支持 (Library Function Support)
 // ================================
@@ -705,33 +843,180 @@ void print_type(Type* type) {
 }
 
 // ================================
-// 7. 辅助函数 (Helper Functions)
+// 7. 紧凑布局 (Compact Layout)
 // ================================
 
+#define LAYOUT_INITIAL_CAPACITY 256 ///< 布局数组的初始容量
+
+/** @brief 确保布局数组至少还能容纳一个节点。*/
+static void layout_reserve(ASTLayout* layout) {
+    if (layout->count < layout->capacity) return;
+    uint32_t cap = layout->capacity ? layout->capacity * 2 : LAYOUT_INITIAL_CAPACITY;
+    ASTNode** nodes = (ASTNode**)realloc(layout->nodes, cap * sizeof(ASTNode*));
+    if (nodes) layout->nodes = nodes;
+    uint8_t* kinds = (uint8_t*)realloc(layout->kinds, cap);
+    if (kinds) layout->kinds = kinds;
+    uint8_t* flags = (uint8_t*)realloc(layout->flags, cap);
+    if (flags) layout->flags = flags;
+    ASTNodeId* parents = (ASTNodeId*)realloc(layout->parents, cap * sizeof(ASTNodeId));
+    if (parents) layout->parents = parents;
+    ASTNodeId* ends = (ASTNodeId*)realloc(layout->subtree_end, cap * sizeof(ASTNodeId));
+    if (ends) layout->subtree_end = ends;
+    if (!nodes || !kinds || !flags || !parents || !ends) {
+        fprintf(stderr, "Fatal: failed to grow AST layout.\n");
+        exit(1);
+    }
+    layout->capacity = cap;
+}
+
 /**
- * @brief 设置子节点的父节点指针。
- * @details 建立父子关系对于AST的向上遍历（例如，在语义分析中查找上下文信息）至关重要。
- * @param parent 父节点。
- * @param child 子节点，可以为NULL。
+ * @brief 构建布局时的一项待办：为一个节点编号，或者（`node` 为 NULL 时）
+ *        在其所有子节点编号完毕之后填写节点 `id` 的子树末尾。
  */
-static void set_parent(ASTNode* parent, ASTNode* child) {
-    if (child) {
-        child->parent = parent;
+typedef struct {
+    ASTNode* node;
+    ASTNodeId id;     ///< 父节点下标；收尾项中为要收尾的节点下标
+    uint8_t flags;
+    uint32_t depth;
+} LayoutTask;
+
+typedef struct {
+    LayoutTask* items;
+    size_t count;
+    size_t capacity;
+} LayoutStack;
+
+static void layout_push(LayoutStack* stack, ASTNode* node, ASTNodeId id, uint8_t flags, uint32_t depth) {
+    if (stack->count == stack->capacity) {
+        size_t cap = stack->capacity ? stack->capacity * 2 : 64;
+        LayoutTask* items = (LayoutTask*)realloc(stack->items, cap * sizeof(LayoutTask));
+        if (!items) {
+            fprintf(stderr, "Fatal: failed to grow AST layout stack.\n");
+            exit(1);
+        }
+        stack->items = items;
+        stack->capacity = cap;
+    }
+    stack->items[stack->count++] = (LayoutTask){node, id, flags, depth};
+}
+
+/** @brief 逆序压入数组类型中的各维度表达式（标记为 AST_LAYOUT_TYPE_DIM）。*/
+static void layout_push_dims(LayoutStack* stack, Type* type, ASTNodeId parent, uint32_t depth) {
+    if (!type || type->kind != TYPE_ARRAY) return;
+    for (size_t i = type->array.dim_count; i-- > 0;) {
+        ASTNode* dim = type->array.dimensions[i].dim_expr;
+        if (dim) layout_push(stack, dim, parent, AST_LAYOUT_TYPE_DIM, depth);
+    }
+}
+
+/** @brief 逆序压入一个子节点数组。*/
+static void layout_push_list(LayoutStack* stack, ASTNode** list, size_t count, ASTNodeId parent, uint32_t depth) {
+    for (size_t i = count; i-- > 0;) {
+        if (list[i]) layout_push(stack, list[i], parent, 0, depth);
     }
 }
 
 /**
- * @brief 为一个节点列表中的所有节点设置父节点。
- * @param parent 父节点。
- * @param list 节点指针数组，可以为NULL。
- * @param count 列表中的节点数量。
+ * @brief 逆序压入一个节点的全部子节点，使它们按前序依次出栈。
+ * @details 子节点顺序与语义分析的遍历顺序一致：声明类节点先访问类型中的维度表达式，
+ *          再访问初始化表达式。
  */
-static void set_parent_for_list(ASTNode* parent, ASTNode** list, size_t count) {
-    if (list) {
-        for (size_t i = 0; i < count; i++) {
-            if (list[i]) {
-                list[i]->parent = parent;
-            }
+static void layout_push_children(LayoutStack* stack, ASTNode* node, ASTNodeId id, uint32_t depth) {
+#define PUSH(child) do { if (child) layout_push(stack, (child), id, 0, depth); } while (0)
+    switch (node->node_type) {
+        case AST_COMPOUND_STMT:
+            layout_push_list(stack, node->compound_stmt.items, node->compound_stmt.item_count, id, depth);
+            break;
+        case AST_FUNC_DECL:
+            PUSH(node->func_decl.body);
+            layout_push_list(stack, node->func_decl.params, node->func_decl.param_count, id, depth);
+            break;
+        case AST_FUNC_PARAM:
+            layout_push_dims(stack, node->func_param.param_type, id, depth);
+            break;
+        case AST_VAR_DECL:
+            PUSH(node->var_decl.init_value);
+            layout_push_dims(stack, node->var_decl.var_type, id, depth);
+            break;
+        case AST_CONST_DECL:
+            PUSH(node->const_decl.value);
+            layout_push_dims(stack, node->const_decl.const_type, id, depth);
+            break;
+        case AST_IF_STMT:
+            PUSH(node->if_stmt.else_stmt);
+            PUSH(node->if_stmt.then_stmt);
+            PUSH(node->if_stmt.cond);
+            break;
+        case AST_WHILE_STMT:
+            PUSH(node->while_stmt.body);
+            PUSH(node->while_stmt.cond);
+            break;
+        case AST_RETURN_STMT:
+            PUSH(node->return_stmt.value);
+            break;
+        case AST_EXPR_STMT:
+            PUSH(node->expr_stmt.expr);
+            break;
+        case AST_ASSIGN_STMT:
+            PUSH(node->assign_stmt.expr);
+            PUSH(node->assign_stmt.lval);
+            break;
+        case AST_BINARY_EXPR:
+            PUSH(node->binary_expr.right);
+            PUSH(node->binary_expr.left);
+            break;
+        case AST_UNARY_EXPR:
+            PUSH(node->unary_expr.operand);
+            break;
+        case AST_CALL_EXPR:
+            layout_push_list(stack, node->call_expr.args, node->call_expr.arg_count, id, depth);
+            PUSH(node->call_expr.callee_expr);
+            break;
+        case AST_ARRAY_ACCESS:
+            PUSH(node->array_access.index);
+            PUSH(node->array_access.array);
+            break;
+        case AST_ARRAY_INIT:
+            layout_push_list(stack, node->array_init.elements, node->array_init.elem_count, id, depth);
+            break;
+        default:
+            break;
+    }
+#undef PUSH
+}
+
+/**
+ * @brief 按前序为整棵树编号。
+ * @details 用显式栈代替递归，深层嵌套的表达式不会耗尽调用栈：取出一个节点时先为它
+ *          编号，再压入它的收尾项和全部子节点；收尾项在整棵子树编号完毕后出栈。
+ */
+void ast_build_layout(ASTContext* ctx) {
+    assert(ctx);
+    ASTLayout* layout = &ctx->layout;
+    layout->count = 0;
+    layout->max_depth = 0;
+    if (!ctx->root) return;
+
+    LayoutStack stack = {0};
+    layout_push(&stack, ctx->root, AST_INVALID_NODE_ID, 0, 0);
+    while (stack.count > 0) {
+        LayoutTask task = stack.items[--stack.count];
+        if (!task.node) {
+            layout->subtree_end[task.id] = layout->count;
+            continue;
         }
+        layout_reserve(layout);
+        ASTNodeId id = layout->count++;
+        ASTNode* node = task.node;
+        node->id = id;
+        layout->nodes[id] = node;
+        layout->kinds[id] = (uint8_t)node->node_type;
+        layout->flags[id] = task.flags;
+        layout->parents[id] = task.id;
+        if (task.depth + 1 > layout->max_depth) layout->max_depth = task.depth + 1;
+
+        layout_push(&stack, NULL, id, 0, task.depth);
+        layout_push_children(&stack, node, id, task.depth + 1);
     }
-}
\ No newline at end of file
+    free(stack.items);
+}
@@ -8,15 +8,16 @@
 #include <stdio.h>
 #include <stdbool.h>                // for true, false, bool
 #include <string.h>
+#include <errno.h>
 #include <libgen.h> // For basename
+#include <stdlib.h>
+#include <ctype.h>  // For isdigit
+#include <time.h>   // For clock_gettime
 #include "ir/ir_data_structures.h"  // for IRModule
+#include "ir/transforms/func_instrument.h"
+#include "parallel.h"
+#include "perf_counters.h"
 #include "scanner_context.h"
-typedef void* yyscan_t;
-int yylex_init(yyscan_t* scanner);
-void yyset_in(FILE* in_str, yyscan_t scanner);
-
-// Defined in lexer.l, used for parser to access input file handle
-extern FILE* yyin;
 
 // Global AST Context, accessible by parser and lexer
 ASTContext* parser_ctx_g = NULL;
@@ -30,6 +31,65 @@ typedef enum {
     STAGE_ASM
 } CompilerStage;
 
+// --- Buffered logging (--log-buffer) ---
+// 缓冲 sink 的配置副本：阶段结束与进程退出时由主线程统一输出缓冲的日志
+static LogConfig buffered_log_config;
+
+static void drain_log_buffer(void) {
+    if (buffered_log_config.ring) {
+        logger_ring_drain(&buffered_log_config, buffered_log_config.ring, stderr);
+    }
+}
+
+static void release_log_buffer(void) {
+    drain_log_buffer();
+    logger_ring_destroy(buffered_log_config.ring);
+    buffered_log_config.ring = NULL;
+}
+
+// --- Phase timing (--time-phases) ---
+#define MAX_TIMED_PHASES 8
+
+typedef struct {
+    const char* name;
+    double ms;
+} PhaseTime;
+
+static PhaseTime phase_times[MAX_TIMED_PHASES];
+static int phase_count = 0;
+static double phase_start_ms = 0.0;
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void phase_begin(void) {
+    phase_start_ms = monotonic_ms();
+    perf_region_begin();
+}
+
+static void phase_end(const char* name) {
+    if (phase_count < MAX_TIMED_PHASES) {
+        phase_times[phase_count++] = (PhaseTime){name, monotonic_ms() - phase_start_ms};
+    }
+    perf_region_end(PERF_REGION_PHASE, name);
+    // 阶段之间没有工作线程在写日志，是输出缓冲日志的时机
+    drain_log_buffer();
+}
+
+static void print_phase_times(void) {
+    double total = 0.0;
+    for (int i = 0; i < phase_count; ++i) total += phase_times[i].ms;
+    fprintf(stderr, "Phase timing:\n");
+    for (int i = 0; i < phase_count; ++i) {
+        fprintf(stderr, "  %-12s %10.3f ms  %5.1f%%\n", phase_times[i].name, phase_times[i].ms,
+                total > 0.0 ? 100.0 * phase_times[i].ms / total : 0.0);
+    }
+    fprintf(stderr, "  %-12s %10.3f ms\n", "total", total);
+}
+
 // --- Missing function declarations ---
 static bool has_errors(const ErrorContext* errors) {
     return errors && errors->count > 0;
@@ -40,12 +100,20 @@ void print_usage(const char* prog_name) {
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  -o <output_file>  Specify output file name (default: a.s)\n");
     fprintf(stderr, "  -S                Emit optimized LLVM IR (.ll) instead of assembly\n");
+    fprintf(stderr, "  -O<n>             Optimization level: 0 (none), 1 (default), 2 (also unroll loops)\n");
     fprintf(stderr, "  -v, --verbose     Enable verbose logging (DEBUG level)\n");
     fprintf(stderr, "  -t, --trace       Enable trace logging (TRACE level)\n");
     fprintf(stderr, "  --log-level <level>  Set specific log level (none|error|warning|info|debug|trace)\n");
     fprintf(stderr, "  --log-category <cat> Enable specific log category\n");
     fprintf(stderr, "  --no-timestamps   Disable timestamps in log output\n");
     fprintf(stderr, "  --no-categories   Disable category prefixes in log output\n");
+    fprintf(stderr, "  --log-buffer <n>  Queue log messages in a lock-free ring of <n> entries, flushed between phases and when 3/4 full (0: default size)\n");
+    fprintf(stderr, "  --instrument-functions  Insert sylib profiler hooks at function entry/exit\n");
+    fprintf(stderr, "  --auto-parallel   Run DOALL loops on the sylib thread pool (threads: SYSY_NUM_THREADS)\n");
+    fprintf(stderr, "  --direct-ssa      Build SSA for scalars during IR generation instead of running mem2reg\n");
+    fprintf(stderr, "  --time-phases     Print wall-clock time spent in each compiler phase\n");
+    fprintf(stderr, "  --perf-counters   Report hardware counters (cycles, instructions, cache/branch misses) per phase and per pass\n");
+    fprintf(stderr, "  -j, --jobs <n>    Check, lower and print function bodies on <n> threads (0: one per CPU; default 1)\n");
     fprintf(stderr, "  -h, --help        Display this help message\n");
 }
 
@@ -102,6 +170,15 @@ int main(int argc, char** argv) {
     char* output_filename = "a.s";
     char* stage_str = NULL;
     bool emit_llvm = false;
+    bool instrument_functions = false;
+    bool auto_parallel = false;
+    bool direct_ssa = false;
+    bool time_phases = false;
+    bool perf_counters = false;
+    unsigned num_jobs = 1;
+    int opt_level = 1;
+    bool log_buffer = false;
+    size_t log_buffer_size = 0;
     LogLevel log_level = LOG_LEVEL_INFO;
     LogConfig log_config = {0};
 
@@ -127,6 +204,10 @@ int main(int argc, char** argv) {
         } else if (strcmp(argv[i], "-S") == 0) {
             emit_llvm = true;
             argv[i] = NULL;
+        } else if (argv[i][0] == '-' && argv[i][1] == 'O' && isdigit((unsigned char)argv[i][2]) &&
+                   argv[i][3] == '\0') {
+            opt_level = argv[i][2] - '0';
+            argv[i] = NULL;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             log_level = LOG_LEVEL_DEBUG;
             argv[i] = NULL;
@@ -173,6 +254,52 @@ int main(int argc, char** argv) {
         } else if (strcmp(argv[i], "--no-categories") == 0) {
             log_config.enable_categories = false;
             argv[i] = NULL;
+        } else if (strcmp(argv[i], "--log-buffer") == 0) {
+            if (++i < argc) {
+                char* end = NULL;
+                long entries = strtol(argv[i], &end, 10);
+                if (end == argv[i] || *end != '\0' || entries < 0) {
+                    LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "Error: Invalid log buffer size '%s'", argv[i]);
+                    return 1;
+                }
+                log_buffer = true;
+                log_buffer_size = (size_t)entries;
+                argv[i] = NULL;
+            } else {
+                LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "Error: --log-buffer option requires an argument.");
+                return 1;
+            }
+            argv[i-1] = NULL;
+        } else if (strcmp(argv[i], "--instrument-functions") == 0) {
+            instrument_functions = true;
+            argv[i] = NULL;
+        } else if (strcmp(argv[i], "--auto-parallel") == 0) {
+            auto_parallel = true;
+            argv[i] = NULL;
+        } else if (strcmp(argv[i], "--direct-ssa") == 0) {
+            direct_ssa = true;
+            argv[i] = NULL;
+        } else if (strcmp(argv[i], "--time-phases") == 0) {
+            time_phases = true;
+            argv[i] = NULL;
+        } else if (strcmp(argv[i], "--perf-counters") == 0) {
+            perf_counters = true;
+            argv[i] = NULL;
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            if (++i < argc) {
+                char* end = NULL;
+                long jobs = strtol(argv[i], &end, 10);
+                if (end == argv[i] || *end != '\0' || jobs < 0) {
+                    LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "Error: Invalid job count '%s'", argv[i]);
+                    return 1;
+                }
+                num_jobs = jobs == 0 ? parallel_default_workers() : (unsigned)jobs;
+                argv[i] = NULL;
+            } else {
+                LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "Error: --jobs option requires an argument.");
+                return 1;
+            }
+            argv[i-1] = NULL;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(basename(argv[0]));
             return 0;
@@ -208,6 +335,16 @@ int main(int argc, char** argv) {
     // Set the log level in the config
     log_config.level = log_level;
 
+    if (log_buffer) {
+        log_config.ring = logger_ring_create(log_buffer_size);
+        if (!log_config.ring) {
+            LOG_ERROR(&log_config, LOG_CATEGORY_MEMORY, "FATAL: Failed to allocate log buffer");
+            return 1;
+        }
+        buffered_log_config = log_config;
+        atexit(release_log_buffer);
+    }
+
     // --- Stage Selection ---
     if (strcmp(stage_str, "lexer") == 0) {
         // stage = STAGE_LEXER;
@@ -224,49 +361,76 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    // 在第一个阶段之前打开计数器：之后创建的 -j 工作线程会继承它们
+    if (perf_counters && !perf_counters_enable()) {
+        LOG_WARN(&log_config, LOG_CATEGORY_PERFORMANCE, "Hardware performance counters unavailable; --perf-counters reports time only.");
+    }
+
     // --- Phase 1: Parsing ---
     LOG_INFO(&log_config, LOG_CATEGORY_PARSER, "Starting Phase 1: Parsing '%s'", input_filename);
-    yyin = fopen(input_filename, "r");
-    if (!yyin) {
-        LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "FATAL: Could not open input file: %s", input_filename);
+    phase_begin();
+    // 源文件整体映射进内存，由 Flex 直接在其上扫描；AST 中的 SourceSpan
+    // 引用这块内存，因此它要一直保留到 AST 销毁之后
+    SourceBuffer source;
+    if (!source_buffer_open(&source, input_filename)) {
+        LOG_ERROR(&log_config, LOG_CATEGORY_GENERAL, "FATAL: Could not open input file: %s: %s", input_filename,
+                  strerror(errno));
         return 1;
     }
 
     parser_ctx_g = create_ast_context();
     if (!parser_ctx_g) {
         LOG_ERROR(&log_config, LOG_CATEGORY_MEMORY, "FATAL: Failed to create AST context");
-        fclose(yyin);
+        source_buffer_close(&source);
         return 1;
     }
+    // 各编译阶段（包括并行的工作线程）沿用命令行给出的日志级别、类别与 sink
+    parser_ctx_g->log_config = log_config;
+    parser_ctx_g->source_text = source.data;
+    parser_ctx_g->source_size = source.size;
     
     // ErrorContext 由 create_ast_context 自动初始化，无需手动调用
     
     yyscan_t scanner;
     yylex_init(&scanner);
-    yyset_in(yyin, scanner);
-
     ScannerContext scanner_ctx = {0};
     scanner_ctx.ast_ctx = parser_ctx_g;
+    yyset_extra(&scanner_ctx, scanner);
+    struct yy_buffer_state* scan_buf =
+        yy_scan_buffer(source.data, source.size + SOURCE_BUFFER_PADDING, scanner);
+    if (!scan_buf) {
+        LOG_ERROR(&log_config, LOG_CATEGORY_PARSER, "FATAL: Failed to set up scanner buffer for %s", input_filename);
+        yylex_destroy(scanner);
+        destroy_ast_context(parser_ctx_g);
+        source_buffer_close(&source);
+        return 1;
+    }
     int pres = yyparse(scanner, &scanner_ctx);
 
+    yy_delete_buffer(scan_buf, scanner);
     yylex_destroy(scanner);
-    fclose(yyin);
+    free(scanner_ctx.string_buffer);
 
     if (pres != 0 || has_errors(&parser_ctx_g->errors)) {
         LOG_ERROR(&log_config, LOG_CATEGORY_PARSER, "Compilation failed during parsing phase.");
         print_errors(&parser_ctx_g->errors, input_filename);
         destroy_ast_context(parser_ctx_g);
+        source_buffer_close(&source);
         return 1;
     }
+    phase_end("parse");
     LOG_INFO(&log_config, LOG_CATEGORY_PARSER, "Parsing completed successfully. AST generated.");
 
     // --- Phase 2: Semantic Analysis ---
     LOG_INFO(&log_config, LOG_CATEGORY_SEMANTIC, "Starting Phase 2: Semantic Analysis");
-    perform_semantic_analysis(parser_ctx_g);
+    phase_begin();
+    perform_semantic_analysis_with_threads(parser_ctx_g, num_jobs);
+    phase_end("semantic");
     if (parser_ctx_g->errors.count > 0) {
         LOG_ERROR(&log_config, LOG_CATEGORY_SEMANTIC, "Compilation failed during semantic analysis.");
         print_errors(&parser_ctx_g->errors, input_filename);
         destroy_ast_context(parser_ctx_g);
+        source_buffer_close(&source);
         return 1;
     }
     LOG_INFO(&log_config, LOG_CATEGORY_SEMANTIC, "Semantic analysis successful. No errors found.");
@@ -274,23 +438,48 @@ int main(int argc, char** argv) {
     // --- Intermediate File Naming ---
     char optimized_ir_file[] = "temp.opt.ll";
 
-    // --- Phase 3: Manual IR Generation ---
-    LOG_INFO(&log_config, LOG_CATEGORY_IR_GEN, "Starting Phase 3: Manual IR Generation");
-    IRModule* module = generate_ir(parser_ctx_g);
+    // --- Phase 3 + 4: Streaming IR Generation and Optimization ---
+    // 逐个顶层函数降级为 IR；每个函数生成后立即运行函数级优化，并释放其函数体的
+    // AST，使 AST 的峰值内存只取决于最大的单个函数。插桩需要在优化之前看到所有
+    // 原始函数边界，因此启用插桩时只流式生成，优化留到插桩之后整体进行。
+    OptimizationConfig opt_config;
+    init_optimization_config_for_level(&opt_config, opt_level);
+    opt_config.enable_auto_parallel = auto_parallel;
+    opt_config.num_threads = num_jobs;
+    bool stream_optimize = !instrument_functions;
+    IRGenOptions gen_options = {.direct_ssa = direct_ssa, .num_threads = num_jobs};
+
+    LOG_INFO(&log_config, LOG_CATEGORY_IR_GEN, "Starting Phase 3: Streaming IR Generation");
+    phase_begin();
+    IRModule* module = generate_ir_streaming(parser_ctx_g, &gen_options,
+                                             stream_optimize ? &opt_config : NULL);
+    phase_end(stream_optimize ? "ir_gen+opt" : "ir_gen");
     if (!module) {
         LOG_ERROR(&log_config, LOG_CATEGORY_IR_GEN, "Error: Manual IR generation failed.");
         print_errors(&parser_ctx_g->errors, input_filename);
         destroy_ast_context(parser_ctx_g);
+        source_buffer_close(&source);
         return 1;
     }
     LOG_INFO(&log_config, LOG_CATEGORY_IR_GEN, "Manual IR generation completed.");
 
-    // --- Phase 4: Manual IR Optimization ---
+    if (instrument_functions) {
+        // 在优化之前插桩，使钩子与源程序中的函数边界一一对应
+        run_func_instrument(module);
+        LOG_INFO(&log_config, LOG_CATEGORY_IR_GEN, "Function entry/exit profiling hooks inserted.");
+    }
+
     LOG_INFO(&log_config, LOG_CATEGORY_IR_OPT, "Starting Phase 4: Manual IR Optimization");
-    if (!optimize_ir(module, optimized_ir_file)) {
+    phase_begin();
+    bool optimized = stream_optimize
+        ? optimize_streamed_ir_with_config(module, optimized_ir_file, &opt_config)
+        : optimize_ir_with_config(module, optimized_ir_file, &opt_config);
+    phase_end(stream_optimize ? "ipo" : "optimize");
+    if (!optimized) {
         LOG_ERROR(&log_config, LOG_CATEGORY_IR_OPT, "Error: Manual IR optimization failed.");
         destroy_ir_module(module);
         destroy_ast_context(parser_ctx_g);
+        source_buffer_close(&source);
         return 1;
     }
     LOG_INFO(&log_config, LOG_CATEGORY_IR_OPT, "Manual IR optimization completed -> '%s'", optimized_ir_file);
@@ -307,10 +496,14 @@ int main(int argc, char** argv) {
     } else {
         // Otherwise, generate final assembly from the optimized IR
         LOG_INFO(&log_config, LOG_CATEGORY_BACKEND, "Starting Phase 5: Backend Assembly Generation");
-        if (generate_riscv_assembly(module, output_filename) != 0) {
+        phase_begin();
+        int codegen_status = generate_riscv_assembly(module, output_filename);
+        phase_end("codegen");
+        if (codegen_status != 0) {
             LOG_ERROR(&log_config, LOG_CATEGORY_BACKEND, "Error: Backend assembly generation failed.");
             destroy_ir_module(module);
             destroy_ast_context(parser_ctx_g);
+            source_buffer_close(&source);
             remove(optimized_ir_file);
             return 1;
         }
@@ -320,10 +513,18 @@ int main(int argc, char** argv) {
     // --- Cleanup ---
     destroy_ir_module(module);
     destroy_ast_context(parser_ctx_g);
+    source_buffer_close(&source);
     if (!emit_llvm) {
         remove(optimized_ir_file);
     }
     
+    if (time_phases) {
+        print_phase_times();
+    }
+    if (perf_counters) {
+        perf_counters_report(stderr);
+        perf_counters_disable();
+    }
     LOG_INFO(&log_config, LOG_CATEGORY_GENERAL, "Compilation finished successfully.");
     return 0;
 }
\ No newline at end of file
@@ -39,8 +39,10 @@ void build_cfg(IRFunction* func) {
     for (IRBasicBlock* block = func->blocks; block; block = block->next_in_func) {
         block->num_successors = 0;
         block->successors = NULL;
+        block->capacity_successors = 0;
         block->num_predecessors = 0; // 重置计数器
         block->predecessors = NULL;
+        block->capacity_predecessors = 0;
     }
 
     // 这个循环计算后继列表，并为每个块的前驱数量计数。
@@ -54,6 +56,7 @@ void build_cfg(IRFunction* func) {
         if (term->opcode == IR_OP_BR) {
             if (term->num_operands > 1) { // 条件分支 (cond, true_dest, false_dest)
                 block->num_successors = 2;
+                block->capacity_successors = 2;
                 block->successors = pool_alloc(pool, 2 * sizeof(IRBasicBlock*));
                 
                 // 正确访问基本块指针
@@ -69,6 +72,7 @@ void build_cfg(IRFunction* func) {
                 false_succ->num_predecessors++;
             } else { // 无条件分支 (dest)
                 block->num_successors = 1;
+                block->capacity_successors = 1;
                 block->successors = pool_alloc(pool, sizeof(IRBasicBlock*));
                 
                 IRBasicBlock* succ = term->operand_head->data.bb;
@@ -85,6 +89,7 @@ void build_cfg(IRFunction* func) {
     for (IRBasicBlock* block = func->blocks; block; block = block->next_in_func) {
         if (block->num_predecessors > 0) {
             block->predecessors = pool_alloc(pool, block->num_predecessors * sizeof(IRBasicBlock*));
+            block->capacity_predecessors = block->num_predecessors;
             block->num_predecessors = 0; // 重置计数器，以便在下一遍中作为填充索引使用
         }
     }
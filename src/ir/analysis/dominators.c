@@ -39,7 +39,21 @@ static void compute_dominance_frontiers(DominatorContext *ctx);
 static void build_dominator_tree(DominatorContext *ctx);
 
 // --- 主驱动函数 ---
+static void compute_dominators_impl(IRFunction *func, bool with_frontiers);
+
 void compute_dominators(IRFunction *func) {
+  compute_dominators_impl(func, true);
+}
+
+void compute_dominator_tree(IRFunction *func) {
+  compute_dominators_impl(func, false);
+}
+
+/**
+ * @brief 支配分析的公共实现。
+ * @param with_frontiers 为 false 时跳过支配边界，并清空各块残留的边界。
+ */
+static void compute_dominators_impl(IRFunction *func, bool with_frontiers) {
   if (!func || !func->entry) {
     return;
   }
@@ -81,7 +95,14 @@ void compute_dominators(IRFunction *func) {
   compute_dominator_sets(&ctx);       // 计算每个块的支配集
   compute_immediate_dominators(&ctx); // 根据支配集计算直接支配者
   build_dominator_tree(&ctx);         // 根据直接支配者关系构建支配树
-  compute_dominance_frontiers(&ctx);  // 根据支配树计算支配边界
+  if (with_frontiers) {
+    compute_dominance_frontiers(&ctx); // 根据支配树计算支配边界
+  } else {
+    for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+      bb->dom_frontier = NULL;
+      bb->dom_frontier_count = 0;
+    }
+  }
 
   // 计算时间戳以支持 O(1) 的支配查询
   compute_dom_tree_timestamps(func);
@@ -205,14 +226,15 @@ static void compute_immediate_dominators(DominatorContext *ctx) {
     BitSet *b_doms = ctx->dom_sets[b_id];
     int idom_id = -1;
 
-    // 直接支配者是严格支配 b 的所有块中，后序遍历序号最高的那一个。
+    // 直接支配者是严格支配 b 的所有块中离 b 最近的那一个。支配者在后序中
+    // 排在被支配块之后（入口块序号最高），因此取后序序号最低的严格支配者。
     for (int dom_candidate_id = 0; dom_candidate_id < ctx->block_count;
          ++dom_candidate_id) {
       if (dom_candidate_id == b_id)
         continue;
 
       if (bitset_contains(b_doms, dom_candidate_id)) {
-        if (idom_id == -1 || dom_candidate_id > idom_id) {
+        if (idom_id == -1 || dom_candidate_id < idom_id) {
           idom_id = dom_candidate_id;
         }
       }
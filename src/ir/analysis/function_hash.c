@@ -0,0 +1,223 @@
+/**
+ * @file function_hash.c
+ * @brief 函数结构哈希的实现。
+ * @details
+ * 计算分两步：
+ * 1.  **编号**: 按布局顺序遍历一次函数，为每个基本块和每条指令分配一个
+ *     位置编号，记录在一张以对象地址为键的开放寻址表中。
+ * 2.  **折叠**: 再遍历一次，把每条指令的操作码、类型与操作数（以编号、
+ *     参数下标、常量值或全局名的形式）折叠进所在块的哈希，最后按布局
+ *     顺序把块哈希组合成函数哈希。
+ * 由于寄存器和基本块都按位置编号，哈希与虚拟寄存器的命名和对象地址
+ * 无关：一个遍删掉再重建出一模一样的指令，哈希不会变化。
+ */
+#include "ir/analysis/function_hash.h"
+#include "ast.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- 哈希原语 ---
+
+// splitmix64 的终结函数，用作 64 位混合器。
+static uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// 顺序相关的组合：combine(combine(h, a), b) != combine(combine(h, b), a)。
+static uint64_t combine(uint64_t h, uint64_t v) {
+  return mix64(h + 0x9e3779b97f4a7c15ULL + v);
+}
+
+static uint64_t hash_string(const char *s) {
+  uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+  if (!s)
+    return 0;
+  for (; *s; s++) {
+    h ^= (unsigned char)*s;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// 操作数种类标签，防止不同种类的编号相互混淆。
+enum {
+  TAG_NULL = 1,
+  TAG_INSTR,
+  TAG_ARG,
+  TAG_CONST,
+  TAG_GLOBAL,
+  TAG_BLOCK,
+  TAG_OTHER,
+};
+
+// --- 地址 -> 位置编号表 ---
+
+typedef struct {
+  const void **keys;
+  int *values;
+  int mask; // 容量 - 1，容量为 2 的幂
+} PositionMap;
+
+// 表只在一次哈希计算中使用，用 malloc 分配并在计算结束时释放：流水线在每轮
+// 不动点迭代中都会对每个函数求哈希，从模块内存池分配会让内存池一直增长。
+static bool position_map_init(PositionMap *map, int expected) {
+  int capacity = 16;
+  while (capacity < expected * 2)
+    capacity <<= 1;
+  map->keys = (const void **)calloc((size_t)capacity, sizeof(void *));
+  map->values = (int *)malloc((size_t)capacity * sizeof(int));
+  map->mask = capacity - 1;
+  return map->keys && map->values;
+}
+
+static void position_map_free(PositionMap *map) {
+  free(map->keys);
+  free(map->values);
+}
+
+static int position_map_slot(const PositionMap *map, const void *key) {
+  int slot = (int)(mix64((uint64_t)(uintptr_t)key) & (uint64_t)map->mask);
+  while (map->keys[slot] && map->keys[slot] != key)
+    slot = (slot + 1) & map->mask;
+  return slot;
+}
+
+static void position_map_put(PositionMap *map, const void *key, int value) {
+  int slot = position_map_slot(map, key);
+  map->keys[slot] = key;
+  map->values[slot] = value;
+}
+
+// 返回 key 的编号；不在表中时返回 -1。
+static int position_map_get(const PositionMap *map, const void *key) {
+  int slot = position_map_slot(map, key);
+  return map->keys[slot] ? map->values[slot] : -1;
+}
+
+// --- 折叠 ---
+
+static uint64_t hash_type(uint64_t h, const Type *type, int depth) {
+  if (!type)
+    return combine(h, TAG_NULL);
+  h = combine(h, (uint64_t)type->kind);
+  switch (type->kind) {
+  case TYPE_BASIC:
+    return combine(h, (uint64_t)type->basic);
+  case TYPE_ARRAY:
+    for (size_t i = 0; i < type->array.dim_count; i++)
+      h = combine(h, (uint64_t)type->array.dimensions[i].static_size);
+    return depth > 0 ? hash_type(h, type->array.element_type, depth - 1) : h;
+  case TYPE_POINTER:
+    return depth > 0 ? hash_type(h, type->pointer.element_type, depth - 1) : h;
+  default:
+    return h;
+  }
+}
+
+static uint64_t hash_constant(uint64_t h, const IRValue *val) {
+  h = hash_type(combine(h, TAG_CONST), val->type, 2);
+  if (!val->type || val->type->kind != TYPE_BASIC) {
+    // 聚合常量只会被整体引用（全局初始化、memcpy 源），不会被标量遍改写，
+    // 按对象身份区分即可。
+    return combine(h, (uint64_t)(uintptr_t)val);
+  }
+  switch (val->type->basic) {
+  case BASIC_I64:
+    return combine(h, (uint64_t)val->i64_val);
+  case BASIC_FLOAT: {
+    uint32_t bits;
+    memcpy(&bits, &val->float_val, sizeof(bits));
+    return combine(h, bits);
+  }
+  case BASIC_DOUBLE: {
+    uint64_t bits;
+    memcpy(&bits, &val->double_val, sizeof(bits));
+    return combine(h, bits);
+  }
+  default:
+    return combine(h, (uint64_t)(int64_t)val->int_val);
+  }
+}
+
+static uint64_t hash_value(uint64_t h, const IRValue *val, IRFunction *func,
+                           const PositionMap *positions) {
+  if (!val)
+    return combine(h, TAG_NULL);
+  if (val->is_constant)
+    return hash_constant(h, val);
+  if (val->def_instr) {
+    int pos = position_map_get(positions, val->def_instr);
+    if (pos >= 0)
+      return combine(combine(h, TAG_INSTR), (uint64_t)pos);
+  }
+  for (int i = 0; i < func->num_args; i++) {
+    if (func->args[i] == val)
+      return combine(combine(h, TAG_ARG), (uint64_t)i);
+  }
+  if (val->is_global || (val->type && val->type->kind == TYPE_FUNCTION))
+    return combine(combine(h, TAG_GLOBAL), hash_string(val->name));
+  // 不属于本函数的寄存器（悬空引用），只能按身份区分
+  return combine(combine(h, TAG_OTHER), (uint64_t)(uintptr_t)val);
+}
+
+static uint64_t hash_instruction(IRInstruction *instr, IRFunction *func,
+                                 const PositionMap *positions) {
+  uint64_t h = combine(0, (uint64_t)instr->opcode);
+  h = combine(h, hash_string(instr->opcode_cond));
+  h = combine(h, (uint64_t)instr->align);
+  h = combine(h, instr->is_inbounds);
+  h = instr->dest ? hash_type(combine(h, 1), instr->dest->type, 2)
+                  : combine(h, 0);
+  h = combine(h, (uint64_t)instr->num_operands);
+  for (IROperand *op = instr->operand_head; op; op = op->next_in_instr) {
+    if (op->kind == IR_OP_KIND_BASIC_BLOCK) {
+      int pos = op->data.bb ? position_map_get(positions, op->data.bb) : -1;
+      h = combine(combine(h, TAG_BLOCK), (uint64_t)(int64_t)pos);
+    } else {
+      h = hash_value(h, op->data.value, func, positions);
+    }
+  }
+  return h;
+}
+
+uint64_t compute_function_hash(IRFunction *func) {
+  if (!func)
+    return 0;
+
+  int count = 0;
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    count++;
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next)
+      count++;
+  }
+
+  // 块与指令共用一张表，各自按布局顺序编号。
+  PositionMap positions;
+  if (!position_map_init(&positions, count)) {
+    position_map_free(&positions);
+    return 0;
+  }
+  int block_pos = 0;
+  int instr_pos = 0;
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    position_map_put(&positions, bb, block_pos++);
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next)
+      position_map_put(&positions, instr, instr_pos++);
+  }
+
+  uint64_t h = combine(hash_string(func->name), (uint64_t)func->num_args);
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    uint64_t block_hash = combine(0, bb == func->entry);
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next)
+      block_hash =
+          combine(block_hash, hash_instruction(instr, func, &positions));
+    h = combine(h, block_hash);
+  }
+  position_map_free(&positions);
+  return h;
+}
@@ -0,0 +1,630 @@
+/**
+ * @file known_bits.c
+ * @brief 已知位与需求位分析的实现。
+ * @details
+ * - **已知位**按操作码逐条推导：位运算逐位组合，加减法模拟进位链（与 LLVM
+ *   `KnownBits::computeForAddSub` 相同的做法），乘法保留末尾零与前导零，
+ *   常量移位整体平移，扩展/截断按位宽调整，PHI 取所有入边的交集。
+ * - **需求位**从值的每个使用者出发：先求使用者结果的需求位，再按使用者的
+ *   操作码换算到这个操作数上，所有使用者取并集。
+ *
+ * 两种分析都递归进行，深度超过 `KNOWN_BITS_MAX_DEPTH` 时给出保守答案，
+ * 因此循环中的 PHI 也会终止。为了不让深层递归中被截断的结果污染缓存，
+ * 只有最外层查询的结果写入缓存；递归过程中命中缓存则直接使用。
+ * 缓存是一张以值地址为键的开放寻址表，每个表项带有代次，失效只需把
+ * 缓存的代次加一。
+ */
+#include "ir/analysis/known_bits.h"
+#include "ast.h"
+#include "ir/ir_utils.h" // For pool_alloc_z
+#include <string.h>
+
+#define KNOWN_BITS_MAX_DEPTH 6
+
+// --- 缓存 ---
+
+typedef struct {
+  const IRValue *key;
+  KnownBits known;
+  uint64_t demanded;
+  unsigned known_generation;    // 与缓存代次相等时 known 有效
+  unsigned demanded_generation; // 与缓存代次相等时 demanded 有效
+} KnownBitsEntry;
+
+struct KnownBitsCache {
+  KnownBitsEntry *entries;
+  int mask; // 容量 - 1，容量为 2 的幂
+  int count;
+  unsigned known_generation;
+  unsigned demanded_generation;
+  MemoryPool *pool;
+};
+
+static uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static KnownBitsEntry *cache_slot(KnownBitsCache *cache, const IRValue *key) {
+  int slot = (int)(mix64((uint64_t)(uintptr_t)key) & (uint64_t)cache->mask);
+  while (cache->entries[slot].key && cache->entries[slot].key != key)
+    slot = (slot + 1) & cache->mask;
+  return &cache->entries[slot];
+}
+
+static void cache_grow(KnownBitsCache *cache) {
+  KnownBitsEntry *old = cache->entries;
+  int old_capacity = cache->mask + 1;
+  cache->mask = old_capacity * 2 - 1;
+  cache->entries = (KnownBitsEntry *)pool_alloc_z(
+      cache->pool, (size_t)(cache->mask + 1) * sizeof(KnownBitsEntry));
+  for (int i = 0; i < old_capacity; i++) {
+    if (old[i].key)
+      *cache_slot(cache, old[i].key) = old[i];
+  }
+}
+
+// 返回 key 的表项，不存在时插入一个两种结果都无效的新表项。
+static KnownBitsEntry *cache_entry(KnownBitsCache *cache, const IRValue *key) {
+  KnownBitsEntry *entry = cache_slot(cache, key);
+  if (entry->key)
+    return entry;
+  if ((cache->count + 1) * 2 > cache->mask + 1) {
+    cache_grow(cache);
+    entry = cache_slot(cache, key);
+  }
+  entry->key = key;
+  cache->count++;
+  return entry;
+}
+
+KnownBitsCache *create_known_bits_cache(IRFunction *func) {
+  MemoryPool *pool = func->module->pool;
+  int count = 0;
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next)
+      count++;
+  }
+  int capacity = 64;
+  while (capacity < count)
+    capacity <<= 1;
+
+  KnownBitsCache *cache =
+      (KnownBitsCache *)pool_alloc_z(pool, sizeof(KnownBitsCache));
+  cache->entries = (KnownBitsEntry *)pool_alloc_z(
+      pool, (size_t)capacity * sizeof(KnownBitsEntry));
+  cache->mask = capacity - 1;
+  cache->known_generation = 1;
+  cache->demanded_generation = 1;
+  cache->pool = pool;
+  return cache;
+}
+
+void invalidate_known_bits(KnownBitsCache *cache) {
+  cache->known_generation++;
+  cache->demanded_generation++;
+}
+
+void invalidate_demanded_bits(KnownBitsCache *cache) {
+  cache->demanded_generation++;
+}
+
+// --- 位运算辅助 ---
+
+uint64_t known_bits_mask(unsigned width) {
+  return width >= 64 ? ~0ULL : (1ULL << width) - 1;
+}
+
+static uint64_t sign_bit(unsigned width) { return 1ULL << (width - 1); }
+
+// 从最低位开始连续为 1 的位数。
+static unsigned count_trailing_ones(uint64_t x, unsigned width) {
+  unsigned n = 0;
+  while (n < width && (x >> n & 1))
+    n++;
+  return n;
+}
+
+// 从第 width-1 位开始向下连续为 1 的位数。
+static unsigned count_leading_ones(uint64_t x, unsigned width) {
+  unsigned n = 0;
+  while (n < width && (x >> (width - 1 - n) & 1))
+    n++;
+  return n;
+}
+
+// 低 n 位全为 1 的掩码。
+static uint64_t low_bits(unsigned n) { return known_bits_mask(n); }
+
+// 高 n 位（在 width 位之内）全为 1 的掩码。
+static uint64_t high_bits(unsigned n, unsigned width) {
+  return known_bits_mask(width) & ~low_bits(width - n);
+}
+
+// 从最低位到 demanded 的最高位为止的所有位：加、减、乘的结果第 i 位只取决于
+// 操作数的第 0..i 位。
+static uint64_t bits_up_to_highest(uint64_t demanded) {
+  uint64_t mask = 0;
+  while (mask < demanded)
+    mask = mask << 1 | 1;
+  return mask;
+}
+
+static KnownBits unknown_bits(unsigned width) {
+  return (KnownBits){0, 0, width};
+}
+
+static KnownBits constant_bits(uint64_t value, unsigned width) {
+  uint64_t mask = known_bits_mask(width);
+  return (KnownBits){~value & mask, value & mask, width};
+}
+
+unsigned known_bits_type_width(const Type *type) {
+  if (!type || type->kind != TYPE_BASIC)
+    return 0;
+  switch (type->basic) {
+  case BASIC_I1:
+    return 1;
+  case BASIC_I8:
+    return 8;
+  case BASIC_INT:
+    return 32;
+  case BASIC_I64:
+    return 64;
+  default:
+    return 0;
+  }
+}
+
+bool known_bits_is_constant(KnownBits known) {
+  return known.width > 0 &&
+         (known.zero | known.one) == known_bits_mask(known.width);
+}
+
+bool known_bits_is_non_negative(KnownBits known) {
+  return known.width > 0 && (known.zero & sign_bit(known.width));
+}
+
+int64_t known_bits_signed_value(KnownBits known) {
+  uint64_t value = known.one;
+  if (known.width < 64 && (value & sign_bit(known.width)))
+    value |= ~known_bits_mask(known.width);
+  return (int64_t)value;
+}
+
+// 可能取到的最小/最大有符号值。
+static int64_t signed_min(KnownBits k) {
+  uint64_t sign = sign_bit(k.width);
+  return known_bits_signed_value(
+      (KnownBits){0, k.one | (sign & ~k.zero), k.width});
+}
+
+static int64_t signed_max(KnownBits k) {
+  uint64_t sign = sign_bit(k.width);
+  uint64_t bits = ~k.zero & known_bits_mask(k.width);
+  return known_bits_signed_value(
+      (KnownBits){0, bits & ~(sign & ~k.one), k.width});
+}
+
+// --- 已知位的逐操作码推导 ---
+
+// 加法/减法：模拟进位链。减法按 a + ~b + 1 处理。
+static KnownBits known_add_sub(KnownBits a, KnownBits b, bool is_sub) {
+  uint64_t mask = known_bits_mask(a.width);
+  if (is_sub) {
+    uint64_t t = b.zero;
+    b.zero = b.one;
+    b.one = t;
+  }
+  uint64_t carry_in = is_sub ? 1 : 0;
+  uint64_t possible_sum_zero = (~a.zero + ~b.zero + carry_in) & mask;
+  uint64_t possible_sum_one = (a.one + b.one + carry_in) & mask;
+  uint64_t carry_known_zero = ~(possible_sum_zero ^ a.zero ^ b.zero);
+  uint64_t carry_known_one = possible_sum_one ^ a.one ^ b.one;
+  uint64_t known = (a.zero | a.one) & (b.zero | b.one) &
+                   (carry_known_zero | carry_known_one) & mask;
+  return (KnownBits){~possible_sum_one & known, possible_sum_one & known,
+                     a.width};
+}
+
+static KnownBits known_mul(KnownBits a, KnownBits b) {
+  unsigned width = a.width;
+  KnownBits r = unknown_bits(width);
+  // 末尾零相加
+  unsigned trailing = count_trailing_ones(a.zero, width) +
+                      count_trailing_ones(b.zero, width);
+  r.zero |= low_bits(trailing < width ? trailing : width);
+  // 乘积（无符号）小于 2^(2w - lz(a) - lz(b))，不超过 2^w 时没有回绕
+  unsigned leading = count_leading_ones(a.zero, width) +
+                     count_leading_ones(b.zero, width);
+  if (leading > width)
+    r.zero |= high_bits(leading - width, width);
+  return r;
+}
+
+static KnownBits known_shift(Opcode opcode, KnownBits a, KnownBits amount) {
+  unsigned width = a.width;
+  uint64_t mask = known_bits_mask(width);
+  KnownBits r = unknown_bits(width);
+  if (known_bits_is_constant(amount)) {
+    uint64_t s = amount.one;
+    if (s >= width)
+      return r; // 结果未定义
+    switch (opcode) {
+    case IR_OP_SHL:
+      r.zero = (a.zero << s | low_bits((unsigned)s)) & mask;
+      r.one = a.one << s & mask;
+      break;
+    case IR_OP_LSHR:
+      r.zero = a.zero >> s | high_bits((unsigned)s, width);
+      r.one = a.one >> s;
+      break;
+    default: // IR_OP_ASHR：移入的位与符号位相同
+      r.zero = a.zero >> s;
+      r.one = a.one >> s;
+      if (a.zero & sign_bit(width))
+        r.zero |= high_bits((unsigned)s, width);
+      else if (a.one & sign_bit(width))
+        r.one |= high_bits((unsigned)s, width);
+      break;
+    }
+    return r;
+  }
+  // 移位量未知：左移保留末尾零，右移保留前导零（算术右移还保留前导一）
+  switch (opcode) {
+  case IR_OP_SHL:
+    r.zero = low_bits(count_trailing_ones(a.zero, width));
+    break;
+  case IR_OP_LSHR:
+    r.zero = high_bits(count_leading_ones(a.zero, width), width);
+    break;
+  default:
+    r.zero = high_bits(count_leading_ones(a.zero, width), width);
+    r.one = high_bits(count_leading_ones(a.one, width), width);
+    break;
+  }
+  return r;
+}
+
+static KnownBits known_sdiv(KnownBits a, KnownBits b) {
+  // 两个操作数都非负时，商在 [0, a] 之内，至少保留 a 的前导零
+  if (known_bits_is_non_negative(a) && known_bits_is_non_negative(b))
+    return (KnownBits){
+        high_bits(count_leading_ones(a.zero, a.width), a.width), 0, a.width};
+  return unknown_bits(a.width);
+}
+
+static KnownBits known_srem(KnownBits a, KnownBits b) {
+  unsigned width = a.width;
+  KnownBits r = unknown_bits(width);
+  if (known_bits_is_constant(b)) {
+    int64_t divisor = known_bits_signed_value(b);
+    uint64_t magnitude = divisor < 0 ? (uint64_t)0 - (uint64_t)divisor
+                                     : (uint64_t)divisor;
+    if (magnitude == 0)
+      return r;
+    // 除数是 2 的幂：余数与被除数模 2^k 同余，低 k 位与被除数相同
+    if ((magnitude & (magnitude - 1)) == 0) {
+      uint64_t low = magnitude - 1;
+      r.zero |= a.zero & low;
+      r.one |= a.one & low;
+    }
+    // 被除数非负：余数在 [0, |b| - 1] 之内
+    if (known_bits_is_non_negative(a))
+      r.zero |= known_bits_mask(width) & ~bits_up_to_highest(magnitude - 1);
+    return r;
+  }
+  // 被除数非负：余数在 [0, a] 之内
+  if (known_bits_is_non_negative(a))
+    r.zero = high_bits(count_leading_ones(a.zero, width), width);
+  return r;
+}
+
+static KnownBits known_extend(KnownBits a, unsigned width, bool is_signed) {
+  KnownBits r = {a.zero, a.one, width};
+  uint64_t extension = known_bits_mask(width) & ~known_bits_mask(a.width);
+  if (!is_signed || (a.zero & sign_bit(a.width)))
+    r.zero |= extension;
+  else if (a.one & sign_bit(a.width))
+    r.one |= extension;
+  return r;
+}
+
+static KnownBits known_bits_rec(KnownBitsCache *cache, IRValue *val,
+                                int depth);
+
+static IRValue *operand_value(IRInstruction *instr, int index) {
+  IROperand *op = instr->operand_head;
+  for (int i = 0; i < index && op; i++)
+    op = op->next_in_instr;
+  return op && op->kind == IR_OP_KIND_VALUE ? op->data.value : NULL;
+}
+
+static KnownBits known_operand(KnownBitsCache *cache, IRInstruction *instr,
+                               int index, int depth) {
+  IRValue *val = operand_value(instr, index);
+  return val ? known_bits_rec(cache, val, depth + 1) : unknown_bits(0);
+}
+
+static KnownBits known_phi(KnownBitsCache *cache, IRInstruction *phi,
+                           unsigned width, int depth) {
+  KnownBits r = {known_bits_mask(width), known_bits_mask(width), width};
+  bool any = false;
+  for (IROperand *op = phi->operand_head; op; op = op->next_in_instr) {
+    if (op->kind != IR_OP_KIND_VALUE || op->data.value == phi->dest)
+      continue;
+    KnownBits in = known_bits_rec(cache, op->data.value, depth + 1);
+    if (in.width != width)
+      return unknown_bits(width);
+    r.zero &= in.zero;
+    r.one &= in.one;
+    any = true;
+    if (!(r.zero | r.one))
+      break;
+  }
+  return any ? r : unknown_bits(width);
+}
+
+static KnownBits known_instruction(KnownBitsCache *cache, IRInstruction *instr,
+                                   unsigned width, int depth) {
+  if (instr->opcode == IR_OP_PHI)
+    return known_phi(cache, instr, width, depth);
+  if (instr->num_operands < 1)
+    return unknown_bits(width);
+
+  KnownBits a = known_operand(cache, instr, 0, depth);
+  if (a.width == 0)
+    return unknown_bits(width);
+  switch (instr->opcode) {
+  case IR_OP_ZEXT:
+  case IR_OP_SEXT:
+    if (a.width >= width)
+      return unknown_bits(width);
+    return known_extend(a, width, instr->opcode == IR_OP_SEXT);
+  case IR_OP_TRUNC:
+    if (a.width < width)
+      return unknown_bits(width);
+    return (KnownBits){a.zero & known_bits_mask(width),
+                       a.one & known_bits_mask(width), width};
+  default:
+    break;
+  }
+
+  if (instr->num_operands < 2)
+    return unknown_bits(width);
+  KnownBits b = known_operand(cache, instr, 1, depth);
+  if (b.width != a.width)
+    return unknown_bits(width);
+  if (instr->opcode == IR_OP_ICMP) {
+    int result = known_bits_evaluate_icmp(instr->opcode_cond, a, b);
+    return result < 0 ? unknown_bits(width) : constant_bits(result, width);
+  }
+  if (a.width != width)
+    return unknown_bits(width);
+
+  switch (instr->opcode) {
+  case IR_OP_AND:
+    return (KnownBits){a.zero | b.zero, a.one & b.one, width};
+  case IR_OP_OR:
+    return (KnownBits){a.zero & b.zero, a.one | b.one, width};
+  case IR_OP_XOR:
+    return (KnownBits){(a.zero & b.zero) | (a.one & b.one),
+                       (a.zero & b.one) | (a.one & b.zero), width};
+  case IR_OP_ADD:
+    return known_add_sub(a, b, false);
+  case IR_OP_SUB:
+    return known_add_sub(a, b, true);
+  case IR_OP_MUL:
+    return known_mul(a, b);
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR:
+    return known_shift(instr->opcode, a, b);
+  case IR_OP_SDIV:
+    return known_sdiv(a, b);
+  case IR_OP_SREM:
+    return known_srem(a, b);
+  default:
+    return unknown_bits(width);
+  }
+}
+
+static uint64_t constant_value(const IRValue *val) {
+  if (val->type->basic == BASIC_I64)
+    return (uint64_t)val->i64_val;
+  return (uint64_t)(int64_t)val->int_val;
+}
+
+static KnownBits known_bits_rec(KnownBitsCache *cache, IRValue *val,
+                                int depth) {
+  unsigned width = known_bits_type_width(val->type);
+  if (width == 0)
+    return unknown_bits(0);
+  if (val->is_constant)
+    return constant_bits(constant_value(val), width);
+
+  KnownBitsEntry *entry = cache_slot(cache, val);
+  if (entry->key && entry->known_generation == cache->known_generation)
+    return entry->known;
+  // 参数、全局变量与已删除指令的结果没有可推导的定义
+  IRInstruction *def = val->def_instr;
+  if (depth >= KNOWN_BITS_MAX_DEPTH || !def || !def->parent)
+    return unknown_bits(width);
+
+  KnownBits known = known_instruction(cache, def, width, depth);
+  if (depth == 0) {
+    entry = cache_entry(cache, val);
+    entry->known = known;
+    entry->known_generation = cache->known_generation;
+  }
+  return known;
+}
+
+KnownBits compute_known_bits(KnownBitsCache *cache, IRValue *val) {
+  return val ? known_bits_rec(cache, val, 0) : unknown_bits(0);
+}
+
+// --- 比较 ---
+
+int known_bits_evaluate_icmp(const char *pred, KnownBits lhs, KnownBits rhs) {
+  if (!pred || lhs.width == 0 || lhs.width != rhs.width)
+    return -1;
+
+  bool differ = (lhs.one & rhs.zero) || (lhs.zero & rhs.one);
+  bool same = known_bits_is_constant(lhs) && known_bits_is_constant(rhs) &&
+              lhs.one == rhs.one;
+  if (strcmp(pred, "eq") == 0 || strcmp(pred, "ne") == 0) {
+    if (!differ && !same)
+      return -1;
+    return (strcmp(pred, "eq") == 0) == same;
+  }
+
+  int64_t lmin, lmax, rmin, rmax;
+  if (pred[0] == 's') {
+    lmin = signed_min(lhs);
+    lmax = signed_max(lhs);
+    rmin = signed_min(rhs);
+    rmax = signed_max(rhs);
+  } else if (pred[0] == 'u' && lhs.width < 64) {
+    uint64_t mask = known_bits_mask(lhs.width);
+    lmin = (int64_t)lhs.one;
+    lmax = (int64_t)(~lhs.zero & mask);
+    rmin = (int64_t)rhs.one;
+    rmax = (int64_t)(~rhs.zero & mask);
+  } else {
+    return -1;
+  }
+
+  const char *rel = pred + 1;
+  if (strcmp(rel, "lt") == 0) {
+    if (lmax < rmin)
+      return 1;
+    if (lmin >= rmax)
+      return 0;
+  } else if (strcmp(rel, "le") == 0) {
+    if (lmax <= rmin)
+      return 1;
+    if (lmin > rmax)
+      return 0;
+  } else if (strcmp(rel, "gt") == 0) {
+    if (lmin > rmax)
+      return 1;
+    if (lmax <= rmin)
+      return 0;
+  } else if (strcmp(rel, "ge") == 0) {
+    if (lmin >= rmax)
+      return 1;
+    if (lmax < rmin)
+      return 0;
+  }
+  return -1;
+}
+
+// --- 需求位 ---
+
+uint64_t demanded_bits_of_operand(KnownBitsCache *cache, IRInstruction *user,
+                                  int index, uint64_t demanded) {
+  IRValue *operand = operand_value(user, index);
+  unsigned width = operand ? known_bits_type_width(operand->type) : 0;
+  uint64_t mask = known_bits_mask(width);
+  if (width == 0)
+    return 0;
+
+  switch (user->opcode) {
+  case IR_OP_AND:
+  case IR_OP_OR: {
+    // 另一个操作数已知为 0（and）或已知为 1（or）的位，结果与本操作数无关
+    IRValue *other = operand_value(user, 1 - index);
+    KnownBits k = other ? compute_known_bits(cache, other) : unknown_bits(0);
+    if (k.width != width)
+      return demanded & mask;
+    return demanded & ~(user->opcode == IR_OP_AND ? k.zero : k.one) & mask;
+  }
+  case IR_OP_XOR:
+  case IR_OP_PHI:
+  case IR_OP_TRUNC:
+    return demanded & mask;
+  case IR_OP_ADD:
+  case IR_OP_SUB:
+  case IR_OP_MUL:
+    return bits_up_to_highest(demanded) & mask;
+  case IR_OP_ZEXT:
+    return demanded & mask;
+  case IR_OP_SEXT:
+    return (demanded & mask) | ((demanded & ~mask) ? sign_bit(width) : 0);
+  case IR_OP_SHL:
+  case IR_OP_LSHR:
+  case IR_OP_ASHR: {
+    if (index != 0)
+      return mask; // 移位量的每一位都影响结果
+    KnownBits amount = compute_known_bits(cache, operand_value(user, 1));
+    if (!known_bits_is_constant(amount) || amount.one >= width) {
+      // 移位量未知：左移时结果第 i 位取决于第 0..i 位，
+      // 右移时取决于第 i 位及以上
+      if (user->opcode == IR_OP_SHL)
+        return bits_up_to_highest(demanded) & mask;
+      return demanded ? mask & ~((demanded & (0 - demanded)) - 1) : 0;
+    }
+    unsigned s = (unsigned)amount.one;
+    if (user->opcode == IR_OP_SHL)
+      return demanded >> s & mask;
+    uint64_t r = demanded << s & mask;
+    if (user->opcode == IR_OP_ASHR && (demanded & high_bits(s, width)))
+      r |= sign_bit(width);
+    return r;
+  }
+  default:
+    return mask;
+  }
+}
+
+static uint64_t demanded_bits_rec(KnownBitsCache *cache, IRValue *val,
+                                  int depth) {
+  unsigned width = known_bits_type_width(val->type);
+  uint64_t mask = known_bits_mask(width);
+  if (width == 0)
+    return 0;
+
+  KnownBitsEntry *entry = cache_slot(cache, val);
+  if (entry->key && entry->demanded_generation == cache->demanded_generation)
+    return entry->demanded;
+  if (depth >= KNOWN_BITS_MAX_DEPTH)
+    return mask;
+
+  uint64_t demanded = 0;
+  for (IROperand *use = val->use_list_head; use && demanded != mask;
+       use = use->next_use) {
+    IRInstruction *user = use->user;
+    if (!user || !user->parent)
+      continue;
+    unsigned user_width = user->dest ? known_bits_type_width(user->dest->type)
+                                     : 0;
+    if (user_width == 0 || user->opcode == IR_OP_ICMP) {
+      demanded = mask; // 被 ret、store、call、比较等观察到全部位
+      break;
+    }
+    int index = 0;
+    for (IROperand *op = user->operand_head; op && op != use;
+         op = op->next_in_instr)
+      index++;
+    uint64_t user_demanded =
+        user->dest == val ? 0
+                          : demanded_bits_rec(cache, user->dest, depth + 1);
+    demanded |= demanded_bits_of_operand(cache, user, index, user_demanded);
+  }
+
+  if (depth == 0) {
+    entry = cache_entry(cache, val);
+    entry->demanded = demanded;
+    entry->demanded_generation = cache->demanded_generation;
+  }
+  return demanded;
+}
+
+uint64_t compute_demanded_bits(KnownBitsCache *cache, IRValue *val) {
+  return val ? demanded_bits_rec(cache, val, 0) : 0;
+}
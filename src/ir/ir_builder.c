@@ -90,6 +90,7 @@ void ir_builder_set_insertion_block(IRBuilder *builder, IRBasicBlock *bb) {
 }
 
 // --- 内部辅助函数，用于在当前 Builder 位置插入指令 ---
+// 各创建函数都先插入指令再添加操作数：add_operand 通过所在基本块找到内存池
 static void insert_instruction_at_point(IRBuilder *builder,
                                         IRInstruction *instr) {
   assert(builder->current_bb &&
@@ -117,9 +118,9 @@ static IRInstruction *create_binary_op(IRBuilder *builder, Opcode op,
   // 二元操作的结果类型通常与操作数类型相同。
   instr->dest = ir_builder_create_reg(builder, lhs->type, name);
   instr->dest->def_instr = instr;
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, lhs);
   add_value_operand(instr, rhs);
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
@@ -150,6 +151,10 @@ IRInstruction *ir_builder_create_shl(IRBuilder *builder, IRValue *lhs,
                                      IRValue *rhs, const char *name) {
   return create_binary_op(builder, IR_OP_SHL, lhs, rhs, name);
 }
+IRInstruction *ir_builder_create_lshr(IRBuilder *builder, IRValue *lhs,
+                                      IRValue *rhs, const char *name) {
+  return create_binary_op(builder, IR_OP_LSHR, lhs, rhs, name);
+}
 IRInstruction *ir_builder_create_ashr(IRBuilder *builder, IRValue *lhs,
                                       IRValue *rhs, const char *name) {
   return create_binary_op(builder, IR_OP_ASHR, lhs, rhs, name);
@@ -273,8 +278,8 @@ IRInstruction *ir_builder_create_load(IRBuilder *builder, IRValue *ptr,
       ir_builder_create_reg(builder, ptr->type->pointer.element_type, name);
   instr->dest->def_instr = instr;
   instr->align = 4;
-  add_value_operand(instr, ptr);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, ptr);
   return instr;
 }
 
@@ -290,9 +295,9 @@ IRInstruction *ir_builder_create_store(IRBuilder *builder, IRValue *val,
   IRInstruction *instr =
       create_ir_instruction(IR_OP_STORE, builder->module->pool);
   instr->align = 4;
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, val);
   add_value_operand(instr, ptr);
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
@@ -335,12 +340,11 @@ IRInstruction *ir_builder_create_gep(IRBuilder *builder, IRValue *ptr,
   instr->dest->def_instr = instr;
   instr->is_inbounds = true; // 为简单起见，默认为 inbounds
 
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, ptr);
   for (int i = 0; i < num_indices; ++i) {
     add_value_operand(instr, indices[i]);
   }
-
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
@@ -356,9 +360,9 @@ IRInstruction *ir_builder_create_icmp(IRBuilder *builder, const char *cond,
   instr->dest = ir_builder_create_reg(
       builder, create_basic_type(BASIC_I1, false, builder->module->pool), name);
   instr->dest->def_instr = instr;
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, lhs);
   add_value_operand(instr, rhs);
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
@@ -371,9 +375,9 @@ IRInstruction *ir_builder_create_fcmp(IRBuilder *builder, const char *cond,
   instr->dest = ir_builder_create_reg(
       builder, create_basic_type(BASIC_I1, false, builder->module->pool), name);
   instr->dest->def_instr = instr;
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, lhs);
   add_value_operand(instr, rhs);
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
@@ -383,8 +387,8 @@ IRInstruction *ir_builder_create_zext(IRBuilder *builder, IRValue *operand,
       create_ir_instruction(IR_OP_ZEXT, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, operand);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, operand);
   return instr;
 }
 
@@ -394,8 +398,8 @@ IRInstruction *ir_builder_create_fpext(IRBuilder *builder, IRValue *operand,
       create_ir_instruction(IR_OP_FPEXT, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, operand);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, operand);
   return instr;
 }
 
@@ -405,8 +409,8 @@ IRInstruction *ir_builder_create_sitofp(IRBuilder *builder, IRValue *operand,
       create_ir_instruction(IR_OP_SITOFP, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, operand);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, operand);
   return instr;
 }
 
@@ -416,8 +420,8 @@ IRInstruction *ir_builder_create_fptosi(IRBuilder *builder, IRValue *operand,
       create_ir_instruction(IR_OP_FPTOSI, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, operand);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, operand);
   return instr;
 }
 
@@ -494,6 +498,7 @@ IRInstruction *ir_builder_create_call(IRBuilder *builder, IRValue *func_val,
                                       const char *name) {
   IRInstruction *instr =
       create_ir_instruction(IR_OP_CALL, builder->module->pool);
+  insert_instruction_at_point(builder, instr);
   add_value_operand(instr, func_val);
   for (int i = 0; i < num_args; ++i) {
     add_value_operand(instr, args[i]);
@@ -505,42 +510,44 @@ IRInstruction *ir_builder_create_call(IRBuilder *builder, IRValue *func_val,
         builder, func_type->function.return_type, name ? name : "calltmp");
     instr->dest->def_instr = instr;
   }
-  insert_instruction_at_point(builder, instr);
   return instr;
 }
 
 // --- 终结符指令 ---
 
 IRInstruction *ir_builder_create_br(IRBuilder *builder, IRBasicBlock *dest) {
-  assert(builder->current_bb->tail == NULL &&
+  assert((!builder->current_bb->tail ||
+          !is_terminator_instruction(builder->current_bb->tail)) &&
          "Block already has a terminator.");
   IRInstruction *instr = create_ir_instruction(IR_OP_BR, builder->module->pool);
-  add_bb_operand(instr, dest);
   add_instr_to_bb_end(builder->current_bb, instr);
+  add_bb_operand(instr, dest);
   return instr;
 }
 
 IRInstruction *ir_builder_create_cond_br(IRBuilder *builder, IRValue *cond,
                                          IRBasicBlock *true_dest,
                                          IRBasicBlock *false_dest) {
-  assert(builder->current_bb->tail == NULL &&
+  assert((!builder->current_bb->tail ||
+          !is_terminator_instruction(builder->current_bb->tail)) &&
          "Block already has a terminator.");
   IRInstruction *instr = create_ir_instruction(IR_OP_BR, builder->module->pool);
+  add_instr_to_bb_end(builder->current_bb, instr);
   add_value_operand(instr, cond);
   add_bb_operand(instr, true_dest);
   add_bb_operand(instr, false_dest);
-  add_instr_to_bb_end(builder->current_bb, instr);
   return instr;
 }
 
 IRInstruction *ir_builder_create_ret(IRBuilder *builder, IRValue *val) {
-  assert(builder->current_bb->tail == NULL &&
+  assert((!builder->current_bb->tail ||
+          !is_terminator_instruction(builder->current_bb->tail)) &&
          "Block already has a terminator.");
   IRInstruction *instr =
       create_ir_instruction(IR_OP_RET, builder->module->pool);
+  add_instr_to_bb_end(builder->current_bb, instr);
   if (val)
     add_value_operand(instr, val);
-  add_instr_to_bb_end(builder->current_bb, instr);
   return instr;
 }
 
@@ -616,8 +623,8 @@ IRInstruction *ir_builder_create_sext(IRBuilder *builder, IRValue *src,
       create_ir_instruction(IR_OP_SEXT, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, src);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, src);
   return instr;
 }
 
@@ -633,8 +640,8 @@ IRInstruction *ir_builder_create_trunc(IRBuilder *builder, IRValue *src,
       create_ir_instruction(IR_OP_TRUNC, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, src);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, src);
   return instr;
 }
 
@@ -648,7 +655,7 @@ IRInstruction *ir_builder_create_fptrunc(IRBuilder *builder, IRValue *src,
       create_ir_instruction(IR_OP_FPTRUNC, builder->module->pool);
   instr->dest = ir_builder_create_reg(builder, dest_type, name);
   instr->dest->def_instr = instr;
-  add_value_operand(instr, src);
   insert_instruction_at_point(builder, instr);
+  add_value_operand(instr, src);
   return instr;
 }
\ No newline at end of file
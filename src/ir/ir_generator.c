@@ -17,10 +17,13 @@
 #include "ir/ir_utils.h"
 #include "location.h" // for SourceLocation
 #include "logger.h"
+#include "parallel.h"
 #include "symbol_table.h"
 #include <assert.h>
 #include <stdbool.h> // for false, true, bool
+#include <stdint.h> // for uintptr_t
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // --- IR 生成上下文的类型定义 ---
@@ -30,11 +33,44 @@
  * @brief 用于管理字符串字面量的条目，避免在IR中生成重复的全局字符串。
  */
 typedef struct StringLiteralEntry {
-  const char *ast_value;           ///< AST中原始的字符串值
+  const char *ast_value;           ///< 字符串内容（复制到模块内存池，不依赖 AST）
   IRValue *global_var;             ///< 指向IR中对应的全局字符串变量
   struct StringLiteralEntry *next; ///< 指向下一个条目的链表指针
 } StringLiteralEntry;
 
+/**
+ * @struct SSASlot
+ * @brief 直接 SSA 构造所用哈希表的一个槽位，以一对指针为键。
+ * @details 同一张表存放三类映射（两个键都为 NULL 表示空槽）：
+ *          - (Symbol*, IRBasicBlock*)：变量在该块中的当前定义（IRValue*）
+ *          - (NULL, IRBasicBlock*)：块的构造状态（SSABlockState*）
+ *          - (IRValue*, NULL)：已删除的平凡 PHI 的替代值（IRValue*）
+ */
+typedef struct SSASlot {
+  const void *key_a;
+  const void *key_b;
+  void *value;
+} SSASlot;
+
+/**
+ * @struct IncompletePhi
+ * @brief 在未封闭的块中创建、等待该块封闭后再补齐入口的 PHI。
+ */
+typedef struct IncompletePhi {
+  Symbol *sym;                ///< PHI 所合并的变量
+  IRInstruction *phi;         ///< PHI 指令
+  struct IncompletePhi *next; ///< 同一块中的下一个不完整 PHI
+} IncompletePhi;
+
+/**
+ * @struct SSABlockState
+ * @brief 基本块在直接 SSA 构造期间的状态。
+ */
+typedef struct SSABlockState {
+  bool sealed; ///< 块的所有前驱都已确定，不会再增加新的前驱
+  IncompletePhi *incomplete; ///< 封闭前创建的不完整 PHI 列表
+} SSABlockState;
+
 /**
  * @struct IRGenContext
  * @brief 在IR生成期间维护所有状态的上下文结构。
@@ -48,26 +84,83 @@ typedef struct IRGenContext {
   IRBasicBlock *loop_cond_bb; ///< 当前循环的条件块（用于continue）
   IRBasicBlock *loop_exit_bb; ///< 当前循环的退出块（用于break）
   ValueMap value_map; ///< 核心数据结构：映射AST符号到其在IR中的地址（IRValue*）
+  ValueMap local_map; ///< 当前函数的参数与局部变量地址，每个函数重新建立
   StringLiteralEntry *string_literals; ///< 字符串字面量缓存列表
+  ErrorContext *errors; ///< 诊断写入的缓冲区（并行降级时每个函数一个）
   int error_count;                     ///< 生成过程中的错误计数
   int warning_count;                   ///< 生成过程中的警告计数
+  bool direct_ssa; ///< 标量是否直接构造为 SSA（见 `IRGenOptions`）
+  SSASlot *ssa_slots;  ///< 直接 SSA 构造的开放寻址哈希表，每个函数重新建立
+  size_t ssa_capacity; ///< 哈希表槽位数（2 的幂）
+  size_t ssa_count;    ///< 已占用的槽位数
+  Worklist *ssa_phi_users; ///< 删除平凡 PHI 时被改写、需要复查的指令
+  IRValue *putf_func; ///< 运行时函数 putf 的地址，全局阶段解析，降级函数时只读
+  StringLiteralEntry *bounds_msg; ///< 越界报错的格式串，预扫描遇到数组访问时创建
+  Symbol *starttime_sym; ///< 库函数 starttime 的符号，调用降级为 _sysy_starttime(行号)
+  Symbol *stoptime_sym;  ///< 库函数 stoptime 的符号，调用降级为 _sysy_stoptime(行号)
 } IRGenContext;
 
+/**
+ * @struct FunctionLowering
+ * @brief 并行降级时一个函数的输入与输出，按源码顺序存放。
+ */
+typedef struct FunctionLowering {
+  ASTNode *node;        ///< 函数定义节点
+  IRFunction *func;     ///< 生成的函数
+  ErrorContext errors;  ///< 降级该函数时产生的诊断
+  int error_count;      ///< 错误计数
+  int warning_count;    ///< 警告计数
+} FunctionLowering;
+
+/**
+ * @struct LoweringPhase
+ * @brief 并行降级阶段的共享状态。
+ */
+typedef struct LoweringPhase {
+  const IRGenContext *base; ///< 全局阶段结束后的上下文，工作线程只读
+  FunctionLowering *functions;
+  IRModule **shards; ///< 每个工作线程一个私有模块，只用于提供独立的内存池
+} LoweringPhase;
+
 // --- 静态函数前向声明 ---
 static void generate_globals(IRGenContext *ctx, ASTNode *root);
+static void generate_functions_parallel(IRGenContext *ctx, ASTNode *root,
+                                        unsigned num_threads,
+                                        IRFunctionCallback on_function,
+                                        void *user_data, bool release_bodies);
 static IRValue *generate_constant_initializer(IRGenContext *ctx, Type *type,
                                               ASTNode *init_node);
-static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node);
+static IRFunction *generate_function(IRGenContext *ctx,
+                                     ASTNode *func_decl_node);
 static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node);
 static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
                                     bool want_address);
 static void find_and_alloc_locals_visitor(ASTNode *node, void *user_data);
 static void prescan_string_literals_visitor(ASTNode *node, void *user_data);
-static void simple_ast_traverse(ASTNode *node,
+static StringLiteralEntry *intern_string_literal(IRGenContext *ctx,
+                                                 const char *text,
+                                                 size_t length);
+static IRValue *generate_string_pointer(IRGenContext *ctx,
+                                        StringLiteralEntry *entry);
+static void simple_ast_traverse(const ASTLayout *layout, ASTNode *node,
+                                uint32_t kind_mask,
                                 void (*visitor)(ASTNode *, void *),
                                 void *user_data);
 static void generate_local_array_init(IRGenContext *ctx, IRValue *array_addr,
                                       Type *array_type, ASTNode *init_list);
+static bool is_ssa_variable(const IRGenContext *ctx, const Symbol *sym);
+static void ssa_begin_function(IRGenContext *ctx);
+static void ssa_end_function(IRGenContext *ctx, IRFunction *func);
+static void ssa_seal_block(IRGenContext *ctx, IRBasicBlock *bb);
+static void ssa_write_variable(IRGenContext *ctx, Symbol *sym,
+                               IRBasicBlock *bb, IRValue *val);
+static IRValue *ssa_read_variable(IRGenContext *ctx, Symbol *sym,
+                                  IRBasicBlock *bb);
+static IRBasicBlock *create_block(IRGenContext *ctx, const char *name_prefix);
+static bool block_is_open(const IRBasicBlock *bb);
+static void emit_br(IRGenContext *ctx, IRBasicBlock *dest);
+static void emit_cond_br(IRGenContext *ctx, IRValue *cond,
+                         IRBasicBlock *true_dest, IRBasicBlock *false_dest);
 static void init_value_map(IRGenContext *ctx);
 static void map_addr(IRGenContext *ctx, Symbol *sym, IRValue *addr);
 static IRValue *find_addr(IRGenContext *ctx, Symbol *sym);
@@ -86,19 +179,21 @@ IRModule *create_ir_module(const char *filename, LogConfig *log_config);
 // --- 主驱动函数 ---
 
 /**
- * @brief 从 AST 生成内存中的 IR 模块。
- * @param ast_ctx 包含完整前端信息的上下文。
- * @return 成功则返回指向新创建的 IRModule 的指针，否则返回 NULL。
+ * @brief IR 生成的公共实现。
+ * @param on_function 每个函数生成完毕后的回调，可以为 NULL。
+ * @param release_bodies 为 true 时，每个函数降级（并经过回调）后立即释放其
+ *        函数体的 AST 子内存池。
  */
-IRModule *generate_ir_module(ASTContext *ast_ctx) {
-  LOG_INFO(&ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
-           "Starting optimized IR generation...");
-
+static IRModule *generate_ir_module_impl(ASTContext *ast_ctx,
+                                         const IRGenOptions *options,
+                                         IRFunctionCallback on_function,
+                                         void *user_data,
+                                         bool release_bodies) {
   if (!ast_ctx || !ast_ctx->root) {
-    LOG_ERROR(&ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
-              "Invalid AST context or root node");
     return NULL;
   }
+  LOG_INFO(&ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
+           "Starting optimized IR generation...");
 
   // 创建顶层 IR 模块，传递日志配置
   IRModule *module =
@@ -117,24 +212,43 @@ IRModule *generate_ir_module(ASTContext *ast_ctx) {
                       .loop_cond_bb = NULL,
                       .loop_exit_bb = NULL,
                       .string_literals = NULL,
+                      .errors = &ast_ctx->errors,
                       .error_count = 0,
-                      .warning_count = 0};
+                      .warning_count = 0,
+                      .direct_ssa = options && options->direct_ssa};
 
   init_value_map(&ctx);
 
-  // 第一遍预扫描：遍历整个 AST，找到所有字符串字面量并为它们创建全局变量。
-  simple_ast_traverse(ast_ctx->root, prescan_string_literals_visitor, &ctx);
+  // 布局通常已由语义分析建立；单独调用 IR 生成时在此补建
+  if (ast_ctx->layout.count == 0)
+    ast_build_layout(ast_ctx);
 
   ASTNode *root = ast_ctx->root;
   if (root && root->node_type == AST_COMPOUND_STMT) {
-    // 第二遍：生成全局变量的定义。
+    // 第一遍：生成全局变量的定义。
     generate_globals(&ctx, root);
 
-    // 第三遍：遍历顶层项，为每个函数生成代码。
-    for (size_t i = 0; i < root->compound_stmt.item_count; i++) {
-      ASTNode *item = root->compound_stmt.items[i];
-      if (item->node_type == AST_FUNC_DECL) {
-        generate_function(&ctx, item);
+    unsigned num_threads = options ? options->num_threads : 1;
+    if (num_threads > 1) {
+      generate_functions_parallel(&ctx, root, num_threads, on_function,
+                                  user_data, release_bodies);
+    } else {
+      // 第二遍：逐个降级顶层函数。字符串字面量只出现在函数体内，
+      // 因此在生成每个函数之前只预扫描该函数，为其中的字面量创建全局变量。
+      for (size_t i = 0; i < root->compound_stmt.item_count; i++) {
+        ASTNode *item = root->compound_stmt.items[i];
+        if (item->node_type != AST_FUNC_DECL)
+          continue;
+        simple_ast_traverse(&ast_ctx->layout, item,
+                            AST_KIND_BIT(AST_STRING_LITERAL) |
+                                AST_KIND_BIT(AST_ARRAY_ACCESS),
+                            prescan_string_literals_visitor, &ctx);
+        IRFunction *func = generate_function(&ctx, item);
+        if (on_function && ctx.error_count == 0)
+          on_function(func, user_data);
+        ctx.current_scope = ast_ctx->global_scope;
+        if (release_bodies)
+          ast_release_function_body(ast_ctx, item);
       }
     }
   }
@@ -152,11 +266,131 @@ IRModule *generate_ir_module(ASTContext *ast_ctx) {
   return module;
 }
 
+/**
+ * @brief 从 AST 生成内存中的 IR 模块。
+ * @param ast_ctx 包含完整前端信息的上下文。
+ * @return 成功则返回指向新创建的 IRModule 的指针，否则返回 NULL。
+ */
+IRModule *generate_ir_module(ASTContext *ast_ctx) {
+  return generate_ir_module_impl(ast_ctx, NULL, NULL, NULL, false);
+}
+
+/**
+ * @brief 逐函数流式生成 IR，并在每个函数降级后释放其函数体的 AST。
+ */
+IRModule *generate_ir_module_streaming(ASTContext *ast_ctx,
+                                       const IRGenOptions *options,
+                                       IRFunctionCallback on_function,
+                                       void *user_data) {
+  return generate_ir_module_impl(ast_ctx, options, on_function, user_data,
+                                 true);
+}
+
+/**
+ * @brief 并行降级的任务：在工作线程的私有模块中生成一个函数。
+ * @details 以全局阶段结束后的上下文为模板，只重置与单个函数相关的状态；
+ *          全局变量的地址映射与字符串字面量缓存此后只读。
+ */
+static void lower_function_task(size_t index, unsigned worker,
+                                void *user_data) {
+  LoweringPhase *phase = (LoweringPhase *)user_data;
+  FunctionLowering *out = &phase->functions[index];
+  IRGenContext ctx = *phase->base;
+  ctx.module = phase->shards[worker];
+  ctx.builder = (IRBuilder){0};
+  ctx.loop_cond_bb = NULL;
+  ctx.loop_exit_bb = NULL;
+  ctx.errors = &out->errors;
+  ctx.error_count = 0;
+  ctx.warning_count = 0;
+  ctx.ssa_slots = NULL;
+  ctx.ssa_capacity = 0;
+  ctx.ssa_count = 0;
+  ctx.ssa_phi_users = NULL;
+  out->func = generate_function(&ctx, out->node);
+  out->error_count = ctx.error_count;
+  out->warning_count = ctx.warning_count;
+}
+
+/**
+ * @brief 在线程池上并行降级所有函数体。
+ * @details 字符串字面量先按源码顺序预扫描，全局部分从此不再改变。每个工作
+ *          线程在一个只提供内存池的私有模块中生成函数，诊断按函数分别缓存。
+ *          全部完成后，私有内存池并入模块的内存池，函数按源码顺序挂回模块，
+ *          再依次调用回调、释放函数体，因此结果与串行生成一致。代价是所有
+ *          函数体的 AST 要保留到降级全部完成。
+ */
+static void generate_functions_parallel(IRGenContext *ctx, ASTNode *root,
+                                        unsigned num_threads,
+                                        IRFunctionCallback on_function,
+                                        void *user_data, bool release_bodies) {
+  ASTContext *ast_ctx = ctx->ast_ctx;
+  IRModule *module = ctx->module;
+  size_t item_count = root->compound_stmt.item_count;
+  FunctionLowering *functions = (FunctionLowering *)calloc(
+      item_count ? item_count : 1, sizeof(FunctionLowering));
+  if (!functions) {
+    fprintf(stderr, "Fatal: out of memory in IR generator.\n");
+    exit(1);
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < item_count; i++) {
+    ASTNode *item = root->compound_stmt.items[i];
+    if (item->node_type != AST_FUNC_DECL)
+      continue;
+    simple_ast_traverse(&ast_ctx->layout, item,
+                        AST_KIND_BIT(AST_STRING_LITERAL) |
+                            AST_KIND_BIT(AST_ARRAY_ACCESS),
+                        prescan_string_literals_visitor, ctx);
+    functions[count++].node = item;
+  }
+
+  if (num_threads > count)
+    num_threads = count ? (unsigned)count : 1;
+  LOG_DEBUG(&ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
+            "Lowering %zu functions on %u thread(s)", count, num_threads);
+  IRModule **shards = (IRModule **)malloc(num_threads * sizeof(IRModule *));
+  if (!shards) {
+    fprintf(stderr, "Fatal: out of memory in IR generator.\n");
+    exit(1);
+  }
+  for (unsigned w = 0; w < num_threads; ++w) {
+    MemoryPool *pool = create_memory_pool();
+    shards[w] = (IRModule *)pool_alloc_z(pool, sizeof(IRModule));
+    shards[w]->pool = pool;
+    shards[w]->source_filename = module->source_filename;
+    shards[w]->log_config = module->log_config;
+  }
+  LoweringPhase phase = {.base = ctx, .functions = functions, .shards = shards};
+  parallel_for(count, num_threads, lower_function_task, &phase);
+
+  for (unsigned w = 0; w < num_threads; ++w)
+    pool_merge(module->pool, shards[w]->pool);
+  free(shards);
+
+  for (size_t i = 0; i < count; i++) {
+    FunctionLowering *out = &functions[i];
+    IRFunction *func = out->func;
+    func->module = module;
+    func->next = module->functions;
+    module->functions = func;
+    merge_error_context(ctx->errors, &out->errors);
+    free_error_context(&out->errors);
+    ctx->error_count += out->error_count;
+    ctx->warning_count += out->warning_count;
+    if (on_function && ctx->error_count == 0)
+      on_function(func, user_data);
+    if (release_bodies)
+      ast_release_function_body(ast_ctx, out->node);
+  }
+  free(functions);
+}
+
 // --- 错误报告函数 ---
 static void report_generation_error(IRGenContext *ctx, const char *message,
                                     SourceLocation loc) {
   ctx->error_count++;
-  add_error(&ctx->ast_ctx->errors, ERROR_SEMANTIC, message, loc);
+  add_error(ctx->errors, ERROR_SEMANTIC, message, loc);
   LOG_ERROR(&ctx->ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
             "IR Generation Error: %s at %d:%d", message, loc.first_line,
             loc.first_column);
@@ -165,57 +399,189 @@ static void report_generation_error(IRGenContext *ctx, const char *message,
 // --- 常量初始化器生成 ---
 
 /**
- * @brief 递归地为全局变量或常量生成初始化器的 IRValue。
- * @param ctx IR生成上下文。
- * @param type 目标类型。
- * @param init_node 指向 AST 初始化表达式的节点。
- * @return 代表常量初始化器的 IRValue。
+ * @brief 常量初始化列表的读取游标，与语义分析中的 `InitContext` 一致，
+ *        用于处理嵌套与扁平化两种写法。
  */
-static IRValue *generate_constant_initializer(IRGenContext *ctx, Type *type,
-                                              ASTNode *init_node) {
-  MemoryPool *pool = ctx->module->pool;
-  IRValue *const_val = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+typedef struct ConstInitCursor {
+  ASTNode *list; ///< 当前正在读取的 `AST_ARRAY_INIT` 节点
+  size_t idx;    ///< 下一个待消耗的元素下标
+} ConstInitCursor;
+
+/**
+ * @brief 生成标量常量初始化值；非常量或缺省的初始化器按零处理。
+ */
+static IRValue *generate_constant_scalar(IRGenContext *ctx, Type *type,
+                                         ASTNode *init_node) {
+  IRValue *const_val =
+      (IRValue *)pool_alloc_z(ctx->module->pool, sizeof(IRValue));
   const_val->is_constant = true;
   const_val->type = type;
-
-  if (type->kind == TYPE_ARRAY) {
-    size_t size = type->array.dimensions[0].static_size;
-    const_val->aggregate.elements =
-        (IRValue **)pool_alloc(pool, size * sizeof(IRValue *));
-    const_val->aggregate.count = size;
-
-    size_t init_count = (init_node && init_node->node_type == AST_ARRAY_INIT)
-                            ? init_node->array_init.elem_count
-                            : 0;
-
-    // 递归地为数组的每个元素生成初始化器
-    for (size_t i = 0; i < size; ++i) {
-      ASTNode *elem_init =
-          (i < init_count) ? init_node->array_init.elements[i] : NULL;
-      const_val->aggregate.elements[i] = generate_constant_initializer(
-          ctx, type->array.element_type, elem_init);
-    }
+  if (!init_node || !init_node->is_constant ||
+      init_node->node_type == AST_ARRAY_INIT)
+    return const_val;
+
+  // 语义分析已把求值结果缓存在 const_val 上；按源类型读取后转换到目标类型
+  bool src_is_float = init_node->eval_type &&
+                      init_node->eval_type->kind == TYPE_BASIC &&
+                      init_node->eval_type->basic == BASIC_FLOAT;
+  if (type->basic == BASIC_FLOAT) {
+    const_val->float_val = src_is_float
+                               ? init_node->const_val.float_val
+                               : (float)init_node->const_val.int_val;
   } else {
-    if (init_node && init_node->is_constant) {
-      if (type->basic == BASIC_INT) {
-        const_val->int_val = init_node->constant.value.int_val;
-      } else {
-        const_val->float_val = init_node->constant.value.float_val;
-      }
+    const_val->int_val = src_is_float ? (int)init_node->const_val.float_val
+                                      : init_node->const_val.int_val;
+  }
+  return const_val;
+}
+
+/**
+ * @brief 为数组类型的每一层预先构造类型：`levels[d]` 是去掉前 d 维后的类型，
+ *        `levels[dim_count]` 为元素类型。同一层的所有子数组共用一个 Type。
+ */
+static Type **build_subarray_types(IRGenContext *ctx, Type *type) {
+  MemoryPool *pool = ctx->module->pool;
+  int dims = type->array.dim_count;
+  Type **levels = (Type **)pool_alloc(pool, (dims + 1) * sizeof(Type *));
+  levels[0] = type;
+  for (int d = 1; d < dims; ++d) {
+    levels[d] = create_array_type(type->array.element_type,
+                                  type->array.dimensions + d, dims - d,
+                                  type->is_const, pool);
+  }
+  levels[dims] = type->array.element_type;
+  return levels;
+}
+
+/**
+ * @brief 从游标处读取元素，生成一个数组类型的聚合常量。
+ * @details 只记录非零元素：全零的子数组与标量都不占用条目，整个初始化器
+ *          为空时得到 `zeroinitializer`。若非零元素恰好从下标 0 连续排列，
+ *          则省略下标数组（前缀形式）。
+ * @param levels 由 `build_subarray_types` 构造，`levels[0]` 为当前层的类型。
+ */
+static IRValue *generate_constant_array(IRGenContext *ctx, Type **levels,
+                                        ConstInitCursor *cur) {
+  MemoryPool *pool = ctx->module->pool;
+  IRValue *const_val = create_zero_aggregate(levels[0], pool);
+  size_t size = const_val->aggregate.count;
+  size_t remaining = cur->list->array_init.elem_count - cur->idx;
+  size_t capacity = remaining < size ? remaining : size;
+  if (capacity == 0)
+    return const_val;
+
+  Type *sub_type = levels[1];
+
+  IRValue **elements =
+      (IRValue **)pool_alloc(pool, capacity * sizeof(IRValue *));
+  uint32_t *indices =
+      (uint32_t *)pool_alloc(pool, capacity * sizeof(uint32_t));
+  size_t n = 0;
+  bool is_prefix = true;
+
+  for (size_t i = 0; i < size && cur->idx < cur->list->array_init.elem_count;
+       ++i) {
+    ASTNode *elem = cur->list->array_init.elements[cur->idx];
+    IRValue *elem_val;
+    if (sub_type->kind != TYPE_ARRAY) {
+      cur->idx++;
+      elem_val = generate_constant_scalar(ctx, sub_type, elem);
+    } else if (elem->node_type == AST_ARRAY_INIT) {
+      cur->idx++; // 消耗子列表 `{...}`
+      ConstInitCursor sub = {.list = elem, .idx = 0};
+      elem_val = generate_constant_array(ctx, levels + 1, &sub);
     } else {
-      // 默认初始化为零。
-      if (type->basic == BASIC_INT) {
-        const_val->int_val = 0;
-      } else {
-        const_val->float_val = 0.0f;
-      }
+      // 扁平化初始化：子数组从当前列表中继续读取
+      elem_val = generate_constant_array(ctx, levels + 1, cur);
     }
+
+    if (is_zero_constant(elem_val))
+      continue;
+    if (n != i)
+      is_prefix = false;
+    elements[n] = elem_val;
+    indices[n] = (uint32_t)i;
+    n++;
   }
+
+  const_val->aggregate.elements = elements;
+  const_val->aggregate.indices = is_prefix ? NULL : indices;
+  const_val->aggregate.num_elements = n;
   return const_val;
 }
 
+/**
+ * @brief 为全局变量或常量生成初始化器的 IRValue。
+ * @param ctx IR生成上下文。
+ * @param type 目标类型。
+ * @param init_node 指向 AST 初始化表达式的节点，可以为 NULL。
+ * @return 代表常量初始化器的 IRValue；未初始化的数组得到全零聚合常量。
+ */
+static IRValue *generate_constant_initializer(IRGenContext *ctx, Type *type,
+                                              ASTNode *init_node) {
+  if (type->kind != TYPE_ARRAY)
+    return generate_constant_scalar(ctx, type, init_node);
+  if (!init_node || init_node->node_type != AST_ARRAY_INIT)
+    return create_zero_aggregate(type, ctx->module->pool);
+  ConstInitCursor cur = {.list = init_node, .idx = 0};
+  return generate_constant_array(ctx, build_subarray_types(ctx, type), &cur);
+}
+
 // --- 全局变量生成 ---
+
+/**
+ * @brief 把计时库函数的地址改为 sylib 中真正的入口 `void runtime_name(int)`。
+ * @details sylib.h 中 starttime()/stoptime() 是把 __LINE__ 传给
+ *          _sysy_starttime/_sysy_stoptime 的宏，运行时库没有同名函数。
+ * @return 该库函数的符号，调用处据此补上行号参数。
+ */
+static Symbol *map_timer_function(IRGenContext *ctx, const char *name,
+                                  const char *runtime_name) {
+  Symbol *sym = find_symbol(ctx->ast_ctx->global_scope,
+                            ast_intern_cstr(ctx->ast_ctx, name));
+  if (!sym)
+    return NULL;
+  MemoryPool *pool = ctx->module->pool;
+  Type *params[] = {create_basic_type(BASIC_INT, false, pool)};
+  Type *func_type =
+      create_function_type(create_void_type(pool), params, 1, false, pool);
+  IRValue *func_addr = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+  func_addr->type = get_ir_pointer_type(ctx, func_type);
+  func_addr->is_global = true;
+  func_addr->name = pool_strdup(pool, runtime_name);
+  map_addr(ctx, sym, func_addr);
+  return sym;
+}
+
+/**
+ * @brief 为全局作用域中的每个函数（含运行时库函数）建立代表其地址的 IRValue。
+ * @details 调用指令通过 `find_addr` 取得被调函数，因此必须在降级任何函数体
+ *          之前、在串行的全局阶段完成映射。降级时自行插入调用的运行时函数
+ *          （目前只有边界检查用的 putf）也在这里解析好存入上下文。
+ */
+static void generate_function_addresses(IRGenContext *ctx) {
+  for (Symbol *sym = ctx->ast_ctx->global_scope->symbols; sym;
+       sym = sym->next) {
+    if (!sym->is_func)
+      continue;
+    IRValue *func_addr =
+        (IRValue *)pool_alloc_z(ctx->module->pool, sizeof(IRValue));
+    func_addr->type = get_ir_pointer_type(ctx, sym->type);
+    func_addr->is_global = true;
+    func_addr->name = sym->name;
+    map_addr(ctx, sym, func_addr);
+  }
+  // 运行时函数名在这里（串行阶段）解析一次：并行降级的工作线程不能访问
+  // AST 上下文的字符串驻留表
+  Symbol *putf_sym = find_symbol(ctx->ast_ctx->global_scope,
+                                 ast_intern_cstr(ctx->ast_ctx, "putf"));
+  ctx->putf_func = find_addr(ctx, putf_sym);
+  ctx->starttime_sym = map_timer_function(ctx, "starttime", "_sysy_starttime");
+  ctx->stoptime_sym = map_timer_function(ctx, "stoptime", "_sysy_stoptime");
+}
+
 static void generate_globals(IRGenContext *ctx, ASTNode *root) {
+  generate_function_addresses(ctx);
   for (size_t i = 0; i < root->compound_stmt.item_count; ++i) {
     ASTNode *item = root->compound_stmt.items[i];
     if (item->node_type == AST_VAR_DECL || item->node_type == AST_CONST_DECL) {
@@ -264,21 +630,15 @@ static void generate_globals(IRGenContext *ctx, ASTNode *root) {
 // --- 字符串字面量处理 ---
 
 /**
- * @brief 一个AST访问者，用于预扫描并创建所有字符串字面量的全局定义。
- * @details 采用缓存机制，确保相同的字符串字面量只在IR中生成一次。
+ * @brief 返回字符串常量的缓存条目，首次出现时创建其全局定义。
+ * @details 相同内容的字符串只在 IR 中生成一次。只能在串行阶段调用。
  */
-static void prescan_string_literals_visitor(ASTNode *node, void *user_data) {
-  if (node->node_type != AST_STRING_LITERAL)
-    return;
-
-  IRGenContext *ctx = (IRGenContext *)user_data;
-
-  // 检查此字符串是否已经处理过
+static StringLiteralEntry *intern_string_literal(IRGenContext *ctx,
+                                                 const char *text,
+                                                 size_t length) {
   for (StringLiteralEntry *s = ctx->string_literals; s; s = s->next) {
-    if (strcmp(s->ast_value, node->string_literal.value) == 0) {
-      node->sym = (Symbol *)s; // 使用 sym 字段来存储指向缓存条目的指针
-      return;
-    }
+    if (strcmp(s->ast_value, text) == 0)
+      return s;
   }
 
   MemoryPool *pool = ctx->module->pool;
@@ -292,16 +652,19 @@ static void prescan_string_literals_visitor(ASTNode *node, void *user_data) {
   global_str->name = global_name_buf;
   global_str->is_const = true;
 
-  size_t len_with_null = node->string_literal.length + 1;
-  ArrayDimension dim = {.is_dynamic = false, .static_size = len_with_null};
+  // create_array_type 保存维度指针而不复制，维度必须分配在内存池中
+  ArrayDimension *dim =
+      (ArrayDimension *)pool_alloc_z(pool, sizeof(ArrayDimension));
+  dim->static_size = (int)length + 1;
   global_str->type = create_array_type(create_basic_type(BASIC_I8, true, pool),
-                                       &dim, 1, true, pool);
+                                       dim, 1, true, pool);
 
   global_str->initializer = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
   global_str->initializer->is_constant = true;
   global_str->initializer->type = global_str->type;
-  global_str->initializer->name =
-      node->string_literal.value; // 在打印时会处理为字符串内容
+  // 函数体的 AST 可能在降级后被释放，字符串内容需复制到模块内存池
+  char *value = pool_strdup(pool, text);
+  global_str->initializer->name = value; // 在打印时会处理为字符串内容
   global_str->next = ctx->module->globals;
   ctx->module->globals = global_str;
 
@@ -314,11 +677,359 @@ static void prescan_string_literals_visitor(ASTNode *node, void *user_data) {
   // 添加到缓存中
   StringLiteralEntry *new_entry =
       (StringLiteralEntry *)pool_alloc(pool, sizeof(StringLiteralEntry));
-  new_entry->ast_value = node->string_literal.value;
+  new_entry->ast_value = value;
   new_entry->global_var = global_addr;
   new_entry->next = ctx->string_literals;
   ctx->string_literals = new_entry;
-  node->sym = (Symbol *)new_entry;
+  return new_entry;
+}
+
+/**
+ * @brief 一个AST访问者，用于预扫描并创建所有字符串字面量的全局定义。
+ * @details 缓存条目记录在节点的 sym 字段上，降级时直接读取。数组访问的
+ *          边界检查会调用 putf 打印格式串，第一次遇到数组访问时一并创建。
+ */
+static void prescan_string_literals_visitor(ASTNode *node, void *user_data) {
+  IRGenContext *ctx = (IRGenContext *)user_data;
+  if (node->node_type == AST_ARRAY_ACCESS) {
+    static const char bounds_msg[] = "Array index out of bounds at line %d\n";
+    if (!ctx->bounds_msg)
+      ctx->bounds_msg =
+          intern_string_literal(ctx, bounds_msg, sizeof(bounds_msg) - 1);
+    return;
+  }
+  node->sym = (Symbol *)intern_string_literal(
+      ctx, node->string_literal.value, node->string_literal.length);
+}
+
+/**
+ * @brief 生成字符串常量首字符的指针（`i8*`），作为 putf 等函数的实参。
+ */
+static IRValue *generate_string_pointer(IRGenContext *ctx,
+                                        StringLiteralEntry *entry) {
+  MemoryPool *pool = ctx->module->pool;
+  IRValue *indices[] = {create_constant_i64(0, pool),
+                        create_constant_i64(0, pool)};
+  return ir_builder_create_gep(&ctx->builder, entry->global_var, indices, 2,
+                               "strptr")
+      ->dest;
+}
+
+// --- 直接 SSA 构造 ---
+//
+// 实现 Braun 等人的 "Simple and Efficient SSA Construction"：标量变量的每次
+// 赋值都记录为其所在块中的当前定义；读取时若本块没有定义，则沿前驱递归查找，
+// 在汇合点插入 PHI。前驱尚未全部确定（未封闭）的块先放置不完整的 PHI，
+// 封闭时再补齐入口。只有单一入口值（或只引用自身）的平凡 PHI 会被立即删除。
+// 生成器在每个块的全部前驱都已生成后封闭它：分支目标在条件跳转之后立即封闭，
+// 汇合块在两侧都生成之后封闭，循环条件块与结束块在循环体结束之后封闭。
+
+/** @brief 判断符号是否以 SSA 值而非 `alloca` 表示：启用直接构造时的局部标量与参数。*/
+static bool is_ssa_variable(const IRGenContext *ctx, const Symbol *sym) {
+  return ctx->direct_ssa && sym && !sym->is_func && sym->type &&
+         sym->type->kind == TYPE_BASIC && sym->scope && sym->scope->parent;
+}
+
+/** @brief 分配失败时直接终止：SSA 构造无法在缺失定义的情况下继续。*/
+static SSASlot *ssa_alloc_slots(size_t capacity) {
+  SSASlot *slots = (SSASlot *)calloc(capacity, sizeof(SSASlot));
+  if (!slots) {
+    fprintf(stderr, "Fatal: out of memory in IR generator.\n");
+    exit(1);
+  }
+  return slots;
+}
+
+/** @brief 对一对指针做乘法哈希。*/
+static size_t ssa_hash(const void *a, const void *b) {
+  uint64_t h = (uint64_t)(uintptr_t)a * 0x9E3779B97F4A7C15ULL;
+  h ^= (uint64_t)(uintptr_t)b * 0xC2B2AE3D27D4EB4FULL;
+  return (size_t)(h ^ (h >> 31));
+}
+
+static SSASlot *ssa_slot(IRGenContext *ctx, const void *a, const void *b,
+                         bool create);
+
+/** @brief 将哈希表扩容为原来的两倍并重新放置所有槽位。*/
+static void ssa_grow(IRGenContext *ctx) {
+  SSASlot *old = ctx->ssa_slots;
+  size_t old_capacity = ctx->ssa_capacity;
+  ctx->ssa_capacity *= 2;
+  ctx->ssa_slots = ssa_alloc_slots(ctx->ssa_capacity);
+  ctx->ssa_count = 0;
+  for (size_t i = 0; i < old_capacity; ++i) {
+    if (old[i].key_a || old[i].key_b)
+      ssa_slot(ctx, old[i].key_a, old[i].key_b, true)->value = old[i].value;
+  }
+  free(old);
+}
+
+/**
+ * @brief 查找键 (a, b) 对应的槽位。
+ * @param create 为 true 时，键不存在则占用一个新槽位；否则返回 NULL。
+ * @note 返回的指针在下一次插入前有效。
+ */
+static SSASlot *ssa_slot(IRGenContext *ctx, const void *a, const void *b,
+                         bool create) {
+  size_t mask = ctx->ssa_capacity - 1;
+  size_t i = ssa_hash(a, b) & mask;
+  while (ctx->ssa_slots[i].key_a || ctx->ssa_slots[i].key_b) {
+    if (ctx->ssa_slots[i].key_a == a && ctx->ssa_slots[i].key_b == b)
+      return &ctx->ssa_slots[i];
+    i = (i + 1) & mask;
+  }
+  if (!create)
+    return NULL;
+  if ((ctx->ssa_count + 1) * 2 > ctx->ssa_capacity) {
+    ssa_grow(ctx);
+    return ssa_slot(ctx, a, b, true);
+  }
+  ctx->ssa_slots[i].key_a = a;
+  ctx->ssa_slots[i].key_b = b;
+  ctx->ssa_slots[i].value = NULL;
+  ctx->ssa_count++;
+  return &ctx->ssa_slots[i];
+}
+
+/** @brief 为一个新函数建立 SSA 构造状态。*/
+static void ssa_begin_function(IRGenContext *ctx) {
+  if (!ctx->direct_ssa)
+    return;
+  ctx->ssa_capacity = 64;
+  ctx->ssa_count = 0;
+  ctx->ssa_slots = ssa_alloc_slots(ctx->ssa_capacity);
+  ctx->ssa_phi_users = create_worklist(ctx->module->pool, 16);
+}
+
+/**
+ * @brief 结束当前函数的 SSA 构造。
+ * @details 构造期间记录的前驱只服务于 PHI 的放置，优化器会用 `build_cfg`
+ *          重新建立；这里清空它们，避免残留的容量与新数组不一致。
+ */
+static void ssa_end_function(IRGenContext *ctx, IRFunction *func) {
+  if (!ctx->direct_ssa)
+    return;
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    SSASlot *state = ssa_slot(ctx, NULL, bb, false);
+    (void)state;
+    assert(state && ((SSABlockState *)state->value)->sealed &&
+           "every block must be sealed by the end of the function");
+    bb->predecessors = NULL;
+    bb->num_predecessors = 0;
+    bb->capacity_predecessors = 0;
+  }
+  free(ctx->ssa_slots);
+  ctx->ssa_slots = NULL;
+  ctx->ssa_capacity = 0;
+  ctx->ssa_count = 0;
+  func->scalars_in_ssa = true;
+}
+
+/** @brief 获取（必要时创建）块的构造状态。新块默认未封闭。*/
+static SSABlockState *ssa_block_state(IRGenContext *ctx, IRBasicBlock *bb) {
+  SSASlot *slot = ssa_slot(ctx, NULL, bb, true);
+  if (!slot->value)
+    slot->value = pool_alloc_z(ctx->module->pool, sizeof(SSABlockState));
+  return (SSABlockState *)slot->value;
+}
+
+/** @brief 记录变量在块中的当前定义。*/
+static void ssa_write_variable(IRGenContext *ctx, Symbol *sym,
+                               IRBasicBlock *bb, IRValue *val) {
+  ssa_slot(ctx, sym, bb, true)->value = val;
+}
+
+/** @brief 沿平凡 PHI 的替代链找到最终的值（定义表中可能仍记录着已删除的 PHI）。*/
+static IRValue *ssa_resolve(IRGenContext *ctx, IRValue *val) {
+  while (val->def_instr && val->def_instr->opcode == IR_OP_UNKNOWN) {
+    SSASlot *forward = ssa_slot(ctx, val, NULL, false);
+    if (!forward)
+      break;
+    val = (IRValue *)forward->value;
+  }
+  return val;
+}
+
+/**
+ * @brief 判断块是否不可达：已封闭、没有前驱且不是入口块。
+ * @details break/continue/return 之后的代码放在这样的块中，它们流向汇合点的
+ *          边永远不会执行，因此 PHI 来自这些边的入口值可以任取。
+ */
+static bool ssa_is_dead_block(IRGenContext *ctx, IRBasicBlock *bb) {
+  if (bb->num_predecessors != 0 || bb == ctx->builder.current_func->entry)
+    return false;
+  SSASlot *slot = ssa_slot(ctx, NULL, bb, false);
+  return slot && ((SSABlockState *)slot->value)->sealed;
+}
+
+/** @brief 在块的开头为变量创建一个（尚无入口的）PHI，不移动构建器的插入点。*/
+static IRInstruction *ssa_create_phi(IRGenContext *ctx, Symbol *sym,
+                                     IRBasicBlock *bb) {
+  IRBuilder *builder = &ctx->builder;
+  IRBasicBlock *saved_bb = builder->current_bb;
+  IRInstruction *saved_point = builder->insert_point;
+  builder->current_bb = bb;
+  IRInstruction *phi = ir_builder_create_phi(builder, sym->type, sym->name);
+  builder->current_bb = saved_bb;
+  builder->insert_point = saved_point;
+  return phi;
+}
+
+/**
+ * @brief 若 PHI 只有一个不同于自身的入口值，用该值替换它并删除之。
+ * @details 替换可能使使用它的其他 PHI 也变得平凡，因此对它们递归地重复检查。
+ * @return PHI 本身，或替代它的值。
+ */
+static IRValue *ssa_try_remove_trivial_phi(IRGenContext *ctx,
+                                           IRInstruction *phi) {
+  IRValue *same = NULL;
+  for (IROperand *op = phi->operand_head; op; op = op->next_in_instr) {
+    if (op->kind != IR_OP_KIND_VALUE)
+      continue;
+    IRValue *val = op->data.value;
+    // 入口值与其前驱块成对出现；来自不可达块的入口不影响 PHI 的取值
+    IROperand *pred = op->next_in_instr;
+    if (pred && pred->kind == IR_OP_KIND_BASIC_BLOCK &&
+        ssa_is_dead_block(ctx, pred->data.bb))
+      continue;
+    if (val == same || val == phi->dest)
+      continue;
+    if (same)
+      return phi->dest; // 合并了至少两个不同的值
+    same = val;
+  }
+  if (!same) // 只引用自身或没有入口：位于不可达代码中，或变量未初始化
+    same = get_undef_value(phi->dest->type, ctx->module->pool);
+
+  Worklist *users = ctx->ssa_phi_users;
+  replace_all_uses_with(users, phi->dest, same);
+  ssa_slot(ctx, phi->dest, NULL, true)->value = same;
+  erase_instruction(phi);
+
+  while (!worklist_empty(users)) {
+    IRInstruction *user = (IRInstruction *)worklist_pop(users);
+    user->in_worklist = false;
+    if (user->opcode == IR_OP_PHI)
+      ssa_try_remove_trivial_phi(ctx, user);
+  }
+  // same 本身可能是在上面的级联中被删除的 PHI
+  return ssa_resolve(ctx, same);
+}
+
+/** @brief 为 PHI 从其所在块的每个前驱读取变量，补齐入口。*/
+static IRValue *ssa_add_phi_operands(IRGenContext *ctx, Symbol *sym,
+                                     IRInstruction *phi) {
+  IRBasicBlock *bb = phi->parent;
+  for (int i = 0; i < bb->num_predecessors; ++i) {
+    IRBasicBlock *pred = bb->predecessors[i];
+    IRValue *val = ssa_is_dead_block(ctx, pred)
+                       ? get_undef_value(sym->type, ctx->module->pool)
+                       : ssa_read_variable(ctx, sym, pred);
+    ir_phi_add_incoming(phi, val, pred);
+  }
+  return ssa_try_remove_trivial_phi(ctx, phi);
+}
+
+/** @brief 本块中没有定义时，沿前驱查找变量的值。*/
+static IRValue *ssa_read_variable_recursive(IRGenContext *ctx, Symbol *sym,
+                                            IRBasicBlock *bb) {
+  SSABlockState *state = ssa_block_state(ctx, bb);
+  IRValue *val;
+  if (!state->sealed) {
+    // 前驱还会增加：先放一个不完整的 PHI，封闭时再补齐
+    IRInstruction *phi = ssa_create_phi(ctx, sym, bb);
+    IncompletePhi *entry =
+        (IncompletePhi *)pool_alloc(ctx->module->pool, sizeof(IncompletePhi));
+    entry->sym = sym;
+    entry->phi = phi;
+    entry->next = state->incomplete;
+    state->incomplete = entry;
+    val = phi->dest;
+  } else if (bb->num_predecessors == 0) {
+    // 入口块或不可达块：变量在此之前未被赋值
+    val = get_undef_value(sym->type, ctx->module->pool);
+  } else if (bb->num_predecessors == 1) {
+    val = ssa_read_variable(ctx, sym, bb->predecessors[0]);
+  } else {
+    // 先记录 PHI 再读取前驱，以打断循环中的递归
+    IRInstruction *phi = ssa_create_phi(ctx, sym, bb);
+    ssa_write_variable(ctx, sym, bb, phi->dest);
+    val = ssa_add_phi_operands(ctx, sym, phi);
+  }
+  ssa_write_variable(ctx, sym, bb, val);
+  return val;
+}
+
+/** @brief 读取变量在块中的当前值。*/
+static IRValue *ssa_read_variable(IRGenContext *ctx, Symbol *sym,
+                                  IRBasicBlock *bb) {
+  SSASlot *slot = ssa_slot(ctx, sym, bb, false);
+  if (slot)
+    return ssa_resolve(ctx, (IRValue *)slot->value);
+  return ssa_read_variable_recursive(ctx, sym, bb);
+}
+
+/** @brief 封闭一个块：它的前驱已全部确定，补齐其中所有不完整的 PHI。*/
+static void ssa_seal_block(IRGenContext *ctx, IRBasicBlock *bb) {
+  if (!ctx->direct_ssa)
+    return;
+  SSABlockState *state = ssa_block_state(ctx, bb);
+  assert(!state->sealed && "block sealed twice");
+  for (IncompletePhi *entry = state->incomplete; entry; entry = entry->next)
+    ssa_add_phi_operands(ctx, entry->sym, entry->phi);
+  state->incomplete = NULL;
+  state->sealed = true;
+}
+
+/**
+ * @brief 创建一个基本块并按创建顺序追加到当前函数的块链表末尾。
+ * @details `ir_builder_create_block` 只创建块而不链接（各优化遍自行决定插入位置），
+ *          生成器创建的每个块都属于正在生成的函数，在这里统一链接。
+ */
+static IRBasicBlock *create_block(IRGenContext *ctx, const char *name_prefix) {
+  IRBasicBlock *bb = ir_builder_create_block(&ctx->builder, name_prefix);
+  IRFunction *func = ctx->builder.current_func;
+  if (func->tail) {
+    insert_block_after(bb, func->tail);
+  } else {
+    func->blocks = func->tail = bb;
+    func->block_count++;
+  }
+  return bb;
+}
+
+/**
+ * @brief 判断块是否还没有终结指令。
+ * @details 控制流汇合处要据此补上跳转：块非空但未终结时同样需要，
+ *          否则循环的回边或 if 的汇合边会丢失，已封闭块上的 PHI 缺少操作数。
+ */
+static bool block_is_open(const IRBasicBlock *bb) {
+  return bb->tail == NULL || !is_terminator_instruction(bb->tail);
+}
+
+/** @brief 生成无条件跳转；直接构造 SSA 时同时记录目标块的前驱。*/
+static void emit_br(IRGenContext *ctx, IRBasicBlock *dest) {
+  IRBasicBlock *from = ctx->builder.current_bb;
+  ir_builder_create_br(&ctx->builder, dest);
+  if (ctx->direct_ssa) {
+    assert(!ssa_block_state(ctx, dest)->sealed &&
+           "cannot add a predecessor to a sealed block");
+    add_predecessor(dest, from);
+  }
+}
+
+/** @brief 生成条件跳转；直接构造 SSA 时同时记录两个目标块的前驱。*/
+static void emit_cond_br(IRGenContext *ctx, IRValue *cond,
+                         IRBasicBlock *true_dest, IRBasicBlock *false_dest) {
+  IRBasicBlock *from = ctx->builder.current_bb;
+  ir_builder_create_cond_br(&ctx->builder, cond, true_dest, false_dest);
+  if (ctx->direct_ssa) {
+    assert(!ssa_block_state(ctx, true_dest)->sealed &&
+           !ssa_block_state(ctx, false_dest)->sealed &&
+           "cannot add a predecessor to a sealed block");
+    add_predecessor(true_dest, from);
+    add_predecessor(false_dest, from);
+  }
 }
 
 // --- 函数生成 ---
@@ -328,9 +1039,12 @@ static void prescan_string_literals_visitor(ASTNode *node, void *user_data) {
  * @param ctx IR生成上下文。
  * @param func_decl_node 指向 `AST_FUNC_DECL` 节点的指针。
  */
-static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node) {
+static IRFunction *generate_function(IRGenContext *ctx,
+                                     ASTNode *func_decl_node) {
   FuncDeclNode *ast_func = &func_decl_node->func_decl;
   ctx->current_scope = ast_func->scope;
+  // 局部符号只在本函数内有效（其内存可能随函数体一起释放），单独建表
+  value_map_init_opaque(&ctx->local_map, ctx->module->pool);
 
   // 创建 IRFunction 对象
   IRFunction *func =
@@ -350,11 +1064,13 @@ static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node) {
 
   // 初始化 IRBuilder 并创建入口块
   ir_builder_init(&ctx->builder, func);
-  IRBasicBlock *entry_bb = ir_builder_create_block(&ctx->builder, "entry");
+  IRBasicBlock *entry_bb = create_block(ctx, "entry");
   func->entry = entry_bb;
   ir_builder_set_insertion_block(&ctx->builder, entry_bb);
+  ssa_begin_function(ctx);
+  ssa_seal_block(ctx, entry_bb); // 入口块没有前驱
 
-  // 生成参数 IRValue、alloca、store
+  // 生成参数 IRValue、alloca、store（直接构造 SSA 时，标量参数只记录为定义）
   for (size_t i = 0; i < ast_func->param_count; ++i) {
     Symbol *param_sym = ast_func->params[i]->sym;
     if (!param_sym) {
@@ -369,6 +1085,10 @@ static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node) {
     param_val->type = param_sym->type;
     param_val->is_global = false;
     func->args[i] = param_val;
+    if (is_ssa_variable(ctx, param_sym)) {
+      ssa_write_variable(ctx, param_sym, entry_bb, param_val);
+      continue;
+    }
     // 2. alloca
     IRInstruction *alloca_instr = ir_builder_create_alloca(
         &ctx->builder, param_sym->type, param_sym->name);
@@ -379,16 +1099,15 @@ static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node) {
   }
 
   // 预扫描函数体，为所有局部变量创建 `alloca` 指令
-  simple_ast_traverse(ast_func->body, find_and_alloc_locals_visitor, ctx);
+  simple_ast_traverse(&ctx->ast_ctx->layout, ast_func->body,
+                      AST_KIND_BIT(AST_VAR_DECL) | AST_KIND_BIT(AST_CONST_DECL),
+                      find_and_alloc_locals_visitor, ctx);
 
   // 生成函数体的所有语句
   generate_statement(ctx, ast_func->body);
 
   // 确保函数末尾有正确的返回指令
-  if (ctx->builder.current_bb &&
-      (ctx->builder.current_bb->tail == NULL ||
-       (ctx->builder.current_bb->tail->opcode != IR_OP_RET &&
-        ctx->builder.current_bb->tail->opcode != IR_OP_BR))) {
+  if (ctx->builder.current_bb && block_is_open(ctx->builder.current_bb)) {
 
     if (func->return_type->kind == TYPE_VOID) {
       ir_builder_create_ret_void(&ctx->builder);
@@ -401,6 +1120,8 @@ static void generate_function(IRGenContext *ctx, ASTNode *func_decl_node) {
       ir_builder_create_ret(&ctx->builder, zero_ret);
     }
   }
+  ssa_end_function(ctx, func);
+  return func;
 }
 
 /**
@@ -415,8 +1136,8 @@ static void find_and_alloc_locals_visitor(ASTNode *node, void *user_data) {
   IRGenContext *ctx = (IRGenContext *)user_data;
   Symbol *sym = node->sym;
   assert(sym != NULL);
-  // 如果已经为其分配了地址（例如，作为函数参数），则跳过
-  if (find_addr(ctx, sym))
+  // 如果已经为其分配了地址（例如，作为函数参数），或者它直接以 SSA 值表示，则跳过
+  if (is_ssa_variable(ctx, sym) || find_addr(ctx, sym))
     return;
   IRInstruction *alloca_instr =
       ir_builder_create_alloca(&ctx->builder, sym->type, sym->name);
@@ -442,7 +1163,7 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
     if (stmt_node->var_decl.init_value) {
       Symbol *sym = stmt_node->sym;
       IRValue *addr = find_addr(ctx, sym);
-      assert(addr);
+      assert(addr || is_ssa_variable(ctx, sym));
       if (sym->type->kind == TYPE_ARRAY) {
         generate_local_array_init(ctx, addr, sym->type,
                                   stmt_node->var_decl.init_value);
@@ -452,18 +1173,26 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
         init_val = create_type_conversion(
             ctx, init_val, stmt_node->var_decl.init_value->eval_type,
             sym->type);
-        ir_builder_create_store(&ctx->builder, init_val, addr);
+        if (is_ssa_variable(ctx, sym))
+          ssa_write_variable(ctx, sym, ctx->builder.current_bb, init_val);
+        else
+          ir_builder_create_store(&ctx->builder, init_val, addr);
       }
     }
     break;
   case AST_ASSIGN_STMT: {
-    IRValue *addr = generate_expression(ctx, stmt_node->assign_stmt.lval, true);
+    ASTNode *lval = stmt_node->assign_stmt.lval;
+    Symbol *lval_sym = lval->node_type == AST_IDENTIFIER ? lval->sym : NULL;
+    bool to_ssa = is_ssa_variable(ctx, lval_sym);
+    IRValue *addr = to_ssa ? NULL : generate_expression(ctx, lval, true);
     IRValue *rval =
         generate_expression(ctx, stmt_node->assign_stmt.expr, false);
-    rval = create_type_conversion(ctx, rval,
-                                  stmt_node->assign_stmt.expr->eval_type,
-                                  stmt_node->assign_stmt.lval->eval_type);
-    ir_builder_create_store(&ctx->builder, rval, addr);
+    rval = create_type_conversion(
+        ctx, rval, stmt_node->assign_stmt.expr->eval_type, lval->eval_type);
+    if (to_ssa)
+      ssa_write_variable(ctx, lval_sym, ctx->builder.current_bb, rval);
+    else
+      ir_builder_create_store(&ctx->builder, rval, addr);
     break;
   }
   case AST_EXPR_STMT:
@@ -482,47 +1211,45 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
                        ir_builder_create_const_int(&ctx->builder, 0), "ifcond")
                        ->dest;
 
-    IRBasicBlock *then_bb = ir_builder_create_block(&ctx->builder, "if.then");
+    IRBasicBlock *then_bb = create_block(ctx, "if.then");
     IRBasicBlock *else_bb =
-        stmt_node->if_stmt.else_stmt
-            ? ir_builder_create_block(&ctx->builder, "if.else")
-            : NULL;
-    IRBasicBlock *end_bb = ir_builder_create_block(&ctx->builder, "if.end");
+        stmt_node->if_stmt.else_stmt ? create_block(ctx, "if.else") : NULL;
+    IRBasicBlock *end_bb = create_block(ctx, "if.end");
 
     // 创建条件分支
-    ir_builder_create_cond_br(&ctx->builder, cmp, then_bb,
-                              else_bb ? else_bb : end_bb);
+    emit_cond_br(ctx, cmp, then_bb, else_bb ? else_bb : end_bb);
 
     // 生成 'then' 分支的代码
+    ssa_seal_block(ctx, then_bb);
     ir_builder_set_insertion_block(&ctx->builder, then_bb);
     generate_statement(ctx, stmt_node->if_stmt.then_stmt);
-    if (ctx->builder.current_bb->tail == NULL)
-      ir_builder_create_br(&ctx->builder, end_bb);
+    if (block_is_open(ctx->builder.current_bb))
+      emit_br(ctx, end_bb);
 
     // 如果有 'else' 分支，生成其代码
     if (else_bb) {
+      ssa_seal_block(ctx, else_bb);
       ir_builder_set_insertion_block(&ctx->builder, else_bb);
       generate_statement(ctx, stmt_node->if_stmt.else_stmt);
-      if (ctx->builder.current_bb->tail == NULL)
-        ir_builder_create_br(&ctx->builder, end_bb);
+      if (block_is_open(ctx->builder.current_bb))
+        emit_br(ctx, end_bb);
     }
     // 将插入点移动到 'end' 块，继续生成后续代码
+    ssa_seal_block(ctx, end_bb);
     ir_builder_set_insertion_block(&ctx->builder, end_bb);
     break;
   }
   case AST_WHILE_STMT: {
-    IRBasicBlock *cond_bb =
-        ir_builder_create_block(&ctx->builder, "while.cond");
-    IRBasicBlock *body_bb =
-        ir_builder_create_block(&ctx->builder, "while.body");
-    IRBasicBlock *end_bb = ir_builder_create_block(&ctx->builder, "while.end");
+    IRBasicBlock *cond_bb = create_block(ctx, "while.cond");
+    IRBasicBlock *body_bb = create_block(ctx, "while.body");
+    IRBasicBlock *end_bb = create_block(ctx, "while.end");
     // 保存并更新当前的循环上下文（用于处理嵌套循环中的 break/continue）
     IRBasicBlock *prev_cond = ctx->loop_cond_bb, *prev_exit = ctx->loop_exit_bb;
     ctx->loop_cond_bb = cond_bb;
     ctx->loop_exit_bb = end_bb;
 
-    // 跳转到条件检查块
-    ir_builder_create_br(&ctx->builder, cond_bb);
+    // 跳转到条件检查块。回边与 continue 尚未生成，条件块要到循环体结束后才能封闭
+    emit_br(ctx, cond_bb);
     // 生成条件检查块的代码
     ir_builder_set_insertion_block(&ctx->builder, cond_bb);
     IRValue *cond = generate_expression(ctx, stmt_node->while_stmt.cond, false);
@@ -531,14 +1258,18 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
                                ir_builder_create_const_int(&ctx->builder, 0),
                                "loopcond")
             ->dest;
-    ir_builder_create_cond_br(&ctx->builder, cmp, body_bb, end_bb);
+    emit_cond_br(ctx, cmp, body_bb, end_bb);
 
     // 生成循环体代码
+    ssa_seal_block(ctx, body_bb);
     ir_builder_set_insertion_block(&ctx->builder, body_bb);
     generate_statement(ctx, stmt_node->while_stmt.body);
-    if (ctx->builder.current_bb->tail == NULL)
-      ir_builder_create_br(&ctx->builder, cond_bb); // 循环体末尾跳回条件检查
+    if (block_is_open(ctx->builder.current_bb))
+      emit_br(ctx, cond_bb); // 循环体末尾跳回条件检查
 
+    // 回边、continue 与 break 都已生成，条件块与结束块的前驱至此确定
+    ssa_seal_block(ctx, cond_bb);
+    ssa_seal_block(ctx, end_bb);
     // 将插入点移动到循环结束块
     ir_builder_set_insertion_block(&ctx->builder, end_bb);
     // 恢复外层循环的上下文
@@ -548,19 +1279,19 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
   }
   case AST_BREAK_STMT:
     assert(ctx->loop_exit_bb);
-    ir_builder_create_br(&ctx->builder, ctx->loop_exit_bb);
+    emit_br(ctx, ctx->loop_exit_bb);
     // break 之后是不可达代码，创建一个新块
-    ir_builder_set_insertion_block(
-        &ctx->builder,
-        ir_builder_create_block(&ctx->builder, "unreachable.br"));
+    ir_builder_set_insertion_block(&ctx->builder,
+                                   create_block(ctx, "unreachable.br"));
+    ssa_seal_block(ctx, ctx->builder.current_bb);
     break;
   case AST_CONTINUE_STMT:
     assert(ctx->loop_cond_bb);
-    ir_builder_create_br(&ctx->builder, ctx->loop_cond_bb);
+    emit_br(ctx, ctx->loop_cond_bb);
     // continue 之后是不可达代码，创建一个新块
-    ir_builder_set_insertion_block(
-        &ctx->builder,
-        ir_builder_create_block(&ctx->builder, "unreachable.cont"));
+    ir_builder_set_insertion_block(&ctx->builder,
+                                   create_block(ctx, "unreachable.cont"));
+    ssa_seal_block(ctx, ctx->builder.current_bb);
     break;
   case AST_RETURN_STMT:
     if (stmt_node->return_stmt.value) {
@@ -574,9 +1305,9 @@ static void generate_statement(IRGenContext *ctx, ASTNode *stmt_node) {
       ir_builder_create_ret_void(&ctx->builder);
     }
     // return 之后是不可达代码，创建一个新块
-    ir_builder_set_insertion_block(
-        &ctx->builder,
-        ir_builder_create_block(&ctx->builder, "unreachable.ret"));
+    ir_builder_set_insertion_block(&ctx->builder,
+                                   create_block(ctx, "unreachable.ret"));
+    ssa_seal_block(ctx, ctx->builder.current_bb);
     break;
   default:
     LOG_WARN(&ctx->ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
@@ -609,9 +1340,8 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
        operator_type_to_ir_opcode(expr_node->binary_expr.op, false) ==
            IR_OP_OR)) {
     assert(!want_address);
-    IRBasicBlock *start_bb = builder->current_bb;
-    IRBasicBlock *rhs_bb = ir_builder_create_block(builder, "sc.rhs");
-    IRBasicBlock *end_bb = ir_builder_create_block(builder, "sc.end");
+    IRBasicBlock *rhs_bb = create_block(ctx, "sc.rhs");
+    IRBasicBlock *end_bb = create_block(ctx, "sc.end");
 
     IRValue *lhs_val =
         generate_expression(ctx, expr_node->binary_expr.left, false);
@@ -619,14 +1349,17 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
                            builder, "ne", lhs_val,
                            ir_builder_create_const_int(builder, 0), "lhs.cmp")
                            ->dest;
+    // 左操作数本身可能含有短路求值，跳转到 end_bb 的是求值结束时所在的块
+    IRBasicBlock *lhs_bb_final = builder->current_bb;
 
     if (operator_type_to_ir_opcode(expr_node->binary_expr.op, false) ==
         IR_OP_AND) {
-      ir_builder_create_cond_br(builder, lhs_cmp, rhs_bb, end_bb);
+      emit_cond_br(ctx, lhs_cmp, rhs_bb, end_bb);
     } else {
-      ir_builder_create_cond_br(builder, lhs_cmp, end_bb, rhs_bb);
+      emit_cond_br(ctx, lhs_cmp, end_bb, rhs_bb);
     }
 
+    ssa_seal_block(ctx, rhs_bb);
     ir_builder_set_insertion_block(builder, rhs_bb);
     IRValue *rhs_val =
         generate_expression(ctx, expr_node->binary_expr.right, false);
@@ -635,20 +1368,21 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
                            ir_builder_create_const_int(builder, 0), "rhs.cmp")
                            ->dest;
     IRBasicBlock *rhs_bb_final = builder->current_bb;
-    if (builder->current_bb->tail == NULL)
-      ir_builder_create_br(builder, end_bb);
+    if (block_is_open(builder->current_bb))
+      emit_br(ctx, end_bb);
 
+    ssa_seal_block(ctx, end_bb);
     ir_builder_set_insertion_block(builder, end_bb);
     Type *i1_type = create_basic_type(BASIC_I1, false, builder->module->pool);
     IRInstruction *phi = ir_builder_create_phi(builder, i1_type, "sc.phi");
     if (operator_type_to_ir_opcode(expr_node->binary_expr.op, false) ==
         IR_OP_AND) {
       ir_phi_add_incoming(phi, create_constant_i1(false, builder->module->pool),
-                          start_bb);
+                          lhs_bb_final);
       ir_phi_add_incoming(phi, rhs_cmp, rhs_bb_final);
     } else {
       ir_phi_add_incoming(phi, create_constant_i1(true, builder->module->pool),
-                          start_bb);
+                          lhs_bb_final);
       ir_phi_add_incoming(phi, rhs_cmp, rhs_bb_final);
     }
     return ir_builder_create_zext(
@@ -668,8 +1402,10 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
   case AST_IDENTIFIER: {
     Symbol *sym = expr_node->sym;
     IRValue *addr = find_addr(ctx, sym);
-    if (want_address)
+    if (want_address) {
+      assert(!is_ssa_variable(ctx, sym) && "SSA variables have no address");
       return addr;
+    }
     if (sym->type->kind == TYPE_ARRAY) {
       report_generation_error(
           ctx, "Internal: Attempt to evaluate an array identifier as a value",
@@ -692,6 +1428,8 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
       }
     }
 
+    if (is_ssa_variable(ctx, sym))
+      return ssa_read_variable(ctx, sym, builder->current_bb);
     return ir_builder_create_load(builder, addr, sym->name)->dest;
   }
   case AST_BINARY_EXPR: {
@@ -788,13 +1526,24 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
   }
   case AST_CALL_EXPR: {
     Symbol *func_sym = expr_node->sym;
-    IRValue *args[expr_node->call_expr.arg_count];
+    // 变长数组的长度必须为正，无参调用也至少留一个元素
+    IRValue *args[expr_node->call_expr.arg_count ? expr_node->call_expr.arg_count
+                                                 : 1];
 
     // 记录函数调用
     LOG_DEBUG(&ctx->ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
               "Generating function call: %s with %zu arguments", func_sym->name,
               expr_node->call_expr.arg_count);
 
+    // starttime()/stoptime() 在 sylib 中是宏，按宏展开的样子传入调用所在行号
+    if (func_sym == ctx->starttime_sym || func_sym == ctx->stoptime_sym) {
+      IRValue *line_num =
+          ir_builder_create_const_int(builder, expr_node->loc.first_line);
+      return ir_builder_create_call(builder, find_addr(ctx, func_sym),
+                                    &line_num, 1, NULL)
+          ->dest;
+    }
+
     for (size_t i = 0; i < expr_node->call_expr.arg_count; ++i) {
       ASTNode *arg_node = expr_node->call_expr.args[i];
       args[i] = generate_expression(ctx, arg_node, false);
@@ -885,34 +1634,24 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
               ->dest;
 
       // 创建边界检查的基本块
-      IRBasicBlock *bounds_ok_bb =
-          ir_builder_create_block(builder, "bounds_ok");
-      IRBasicBlock *bounds_fail_bb =
-          ir_builder_create_block(builder, "bounds_fail");
-      IRBasicBlock *continue_bb =
-          ir_builder_create_block(builder, "array_continue");
+      IRBasicBlock *bounds_ok_bb = create_block(ctx, "bounds_ok");
+      IRBasicBlock *bounds_fail_bb = create_block(ctx, "bounds_fail");
+      IRBasicBlock *continue_bb = create_block(ctx, "array_continue");
 
       // 条件分支
-      ir_builder_create_cond_br(builder, out_of_bounds, bounds_fail_bb,
-                                bounds_ok_bb);
+      emit_cond_br(ctx, out_of_bounds, bounds_fail_bb, bounds_ok_bb);
 
       // 边界检查失败块 - 调用运行时错误处理
+      ssa_seal_block(ctx, bounds_fail_bb);
+      ssa_seal_block(ctx, bounds_ok_bb);
       ir_builder_set_insertion_block(builder, bounds_fail_bb);
 
-      // 1. 查找 putf 函数的 IRValue
-      Symbol *putf_sym = find_symbol(ctx->ast_ctx->global_scope, "putf");
-      IRValue *putf_func = find_addr(ctx, putf_sym);
+      // 1. putf 的地址已在全局阶段解析
+      IRValue *putf_func = ctx->putf_func;
       assert(putf_func && "putf function not found in IR generation");
 
-      // 2. 创建错误信息字符串常量
-      IRValue *error_msg =
-          (IRValue *)pool_alloc(builder->module->pool, sizeof(IRValue));
-      error_msg->is_constant = true;
-      error_msg->type = create_basic_type(
-          BASIC_INT, false,
-          builder->module->pool); // 使用 int 类型作为字符串指针
-      error_msg->name = pool_strdup(builder->module->pool,
-                                    "Array index out of bounds at line %d\n");
+      // 2. 错误信息格式串（全局阶段已创建）
+      IRValue *error_msg = generate_string_pointer(ctx, ctx->bounds_msg);
 
       // 3. 创建行号常量
       IRValue *line_num =
@@ -924,13 +1663,14 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
 
       // 5. 在错误处理后，应该有一个终结符，比如调用 exit() 或进入一个无限循环。
       // 为了简单，可以先跳转到 continue_bb。
-      ir_builder_create_br(builder, continue_bb);
+      emit_br(ctx, continue_bb);
 
       // 边界检查成功块
       ir_builder_set_insertion_block(builder, bounds_ok_bb);
-      ir_builder_create_br(builder, continue_bb);
+      emit_br(ctx, continue_bb);
 
       // 继续正常的数组访问
+      ssa_seal_block(ctx, continue_bb);
       ir_builder_set_insertion_block(builder, continue_bb);
     }
 
@@ -941,15 +1681,9 @@ static IRValue *generate_expression(IRGenContext *ctx, ASTNode *expr_node,
       return elem_ptr;
     return ir_builder_create_load(builder, elem_ptr, "elem")->dest;
   }
-  case AST_STRING_LITERAL: {
+  case AST_STRING_LITERAL:
     assert(!want_address);
-    StringLiteralEntry *entry = (StringLiteralEntry *)expr_node->sym;
-    IRValue *indices[] = {create_constant_i64(0, builder->module->pool),
-                          create_constant_i64(0, builder->module->pool)};
-    return ir_builder_create_gep(builder, entry->global_var, indices, 2,
-                                 "strptr")
-        ->dest;
-  }
+    return generate_string_pointer(ctx, (StringLiteralEntry *)expr_node->sym);
   default:
     LOG_WARN(&ctx->ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
              "IR generation for expression type %d not implemented.",
@@ -1042,7 +1776,16 @@ static void generate_local_array_init(IRGenContext *ctx, IRValue *array_addr,
  * @param ctx IR生成上下文。
  */
 static void init_value_map(IRGenContext *ctx) {
-  value_map_init(&ctx->value_map, ctx->module->pool);
+  value_map_init_opaque(&ctx->value_map, ctx->module->pool);
+}
+
+/**
+ * @brief 选择符号所属的映射表：全局符号放在模块级表中，参数与局部变量放在
+ *        当前函数的表中。
+ */
+static ValueMap *symbol_map(IRGenContext *ctx, Symbol *sym) {
+  return (sym->scope && sym->scope->parent) ? &ctx->local_map
+                                            : &ctx->value_map;
 }
 
 /**
@@ -1064,7 +1807,7 @@ static void map_addr(IRGenContext *ctx, Symbol *sym, IRValue *addr) {
   }
 
   // 使用 Symbol 指针本身作为 Key，因为它是唯一的
-  value_map_put(&ctx->value_map, (IRValue *)sym, addr,
+  value_map_put(symbol_map(ctx, sym), (IRValue *)sym, addr,
                 &ctx->ast_ctx->log_config);
 }
 
@@ -1075,7 +1818,7 @@ static void map_addr(IRGenContext *ctx, Symbol *sym, IRValue *addr) {
  * @return 找到则返回对应的 `IRValue*`，否则返回 `NULL`。
  */
 static IRValue *find_addr(IRGenContext *ctx, Symbol *sym) {
-  return value_map_get(&ctx->value_map, (IRValue *)sym,
+  return value_map_get(symbol_map(ctx, sym), (IRValue *)sym,
                        &ctx->ast_ctx->log_config);
 }
 
@@ -1087,6 +1830,11 @@ static IRValue *find_addr(IRGenContext *ctx, Symbol *sym) {
  * @return 找到则返回对应的 `Symbol*`，否则返回 `NULL`。
  */
 static Symbol *find_symbol_for_addr(IRGenContext *ctx, IRValue *addr) {
+  for (int i = 0; i < ctx->local_map.count; ++i) {
+    if (ctx->local_map.entries[i].new_val == addr) {
+      return (Symbol *)ctx->local_map.entries[i].old_val;
+    }
+  }
   for (int i = 0; i < ctx->value_map.count; ++i) {
     if (ctx->value_map.entries[i].new_val == addr) {
       return (Symbol *)ctx->value_map.entries[i].old_val;
@@ -1125,6 +1873,11 @@ static IRValue *create_type_conversion(IRGenContext *ctx, IRValue *src_val,
             dest_type->kind == TYPE_BASIC ? "basic_type" : "complex_type");
 
   if (src_type->kind != TYPE_BASIC || dest_type->kind != TYPE_BASIC) {
+    // 数组求值时已经退化为首元素指针；指针之间只差 const 限定（例如字符串
+    // 常量传给 putf），IR 中没有限定符，无需转换
+    if (dest_type->kind == TYPE_POINTER &&
+        (src_type->kind == TYPE_ARRAY || src_type->kind == TYPE_POINTER))
+      return src_val;
     if (!is_type_same(src_type, dest_type, true)) {
       LOG_WARN(&ctx->ast_ctx->log_config, LOG_CATEGORY_IR_GEN,
                "Unsupported type conversion attempted.");
@@ -1188,72 +1941,26 @@ static IRValue *create_type_conversion(IRGenContext *ctx, IRValue *src_val,
   return src_val;
 }
 
-// --- 用 traverse_ast 作为 simple_ast_traverse 的实现
-static void simple_ast_traverse(ASTNode *node,
+/**
+ * @brief 前序遍历以 node 为根的子树，只对类型在 kind_mask 中的节点调用 visitor。
+ * @details 顺序扫描 `ASTLayout` 的连续数组：只读取 `kinds` 即可跳过无关节点，
+ *          并整段跳过声明类型中的数组维度表达式（它们在语义分析中已求值）。
+ */
+static void simple_ast_traverse(const ASTLayout *layout, ASTNode *node,
+                                uint32_t kind_mask,
                                 void (*visitor)(ASTNode *, void *),
                                 void *user_data) {
-  // 只做前序遍历
   if (!node)
     return;
-  visitor(node, user_data);
-  switch (node->node_type) {
-  case AST_COMPOUND_STMT:
-    for (size_t i = 0; i < node->compound_stmt.item_count; i++)
-      simple_ast_traverse(node->compound_stmt.items[i], visitor, user_data);
-    break;
-  case AST_FUNC_DECL:
-    for (size_t i = 0; i < node->func_decl.param_count; ++i)
-      simple_ast_traverse(node->func_decl.params[i], visitor, user_data);
-    simple_ast_traverse(node->func_decl.body, visitor, user_data);
-    break;
-  case AST_VAR_DECL:
-    simple_ast_traverse(node->var_decl.init_value, visitor, user_data);
-    break;
-  case AST_CONST_DECL:
-    simple_ast_traverse(node->const_decl.value, visitor, user_data);
-    break;
-  case AST_IF_STMT:
-    simple_ast_traverse(node->if_stmt.cond, visitor, user_data);
-    simple_ast_traverse(node->if_stmt.then_stmt, visitor, user_data);
-    if (node->if_stmt.else_stmt)
-      simple_ast_traverse(node->if_stmt.else_stmt, visitor, user_data);
-    break;
-  case AST_WHILE_STMT:
-    simple_ast_traverse(node->while_stmt.cond, visitor, user_data);
-    simple_ast_traverse(node->while_stmt.body, visitor, user_data);
-    break;
-  case AST_RETURN_STMT:
-    simple_ast_traverse(node->return_stmt.value, visitor, user_data);
-    break;
-  case AST_EXPR_STMT:
-    simple_ast_traverse(node->expr_stmt.expr, visitor, user_data);
-    break;
-  case AST_ASSIGN_STMT:
-    simple_ast_traverse(node->assign_stmt.lval, visitor, user_data);
-    simple_ast_traverse(node->assign_stmt.expr, visitor, user_data);
-    break;
-  case AST_BINARY_EXPR:
-    simple_ast_traverse(node->binary_expr.left, visitor, user_data);
-    simple_ast_traverse(node->binary_expr.right, visitor, user_data);
-    break;
-  case AST_UNARY_EXPR:
-    simple_ast_traverse(node->unary_expr.operand, visitor, user_data);
-    break;
-  case AST_CALL_EXPR:
-    simple_ast_traverse(node->call_expr.callee_expr, visitor, user_data);
-    for (size_t i = 0; i < node->call_expr.arg_count; ++i)
-      simple_ast_traverse(node->call_expr.args[i], visitor, user_data);
-    break;
-  case AST_ARRAY_ACCESS:
-    simple_ast_traverse(node->array_access.array, visitor, user_data);
-    simple_ast_traverse(node->array_access.index, visitor, user_data);
-    break;
-  case AST_ARRAY_INIT:
-    for (size_t i = 0; i < node->array_init.elem_count; ++i)
-      simple_ast_traverse(node->array_init.elements[i], visitor, user_data);
-    break;
-  default:
-    break;
+  assert(node->id < layout->count && layout->nodes[node->id] == node);
+  ASTNodeId end = layout->subtree_end[node->id];
+  for (ASTNodeId id = node->id; id < end; ++id) {
+    if (layout->flags[id] & AST_LAYOUT_TYPE_DIM) {
+      id = layout->subtree_end[id] - 1;
+      continue;
+    }
+    if (kind_mask & AST_KIND_BIT(layout->kinds[id]))
+      visitor(layout->nodes[id], user_data);
   }
 }
 
@@ -18,17 +18,23 @@
  * TCE）。
  * 6.  **持续清理**: 在关键阶段后运行 CFG 简化，以清理冗余代码，为后续优化
  *     提供更干净的输入。
+ * 7.  **自动并行化（可选）**: 最后把 DOALL 循环外提为由 sylib 线程池执行的
+ *     工作函数。
  */
 #include "ir/ir_optimizer.h"
 #include "ir/ir_data_structures.h"
+#include "ir/ir_utils.h"
 #include "logger.h"
+#include "perf_counters.h"
 #include <string.h>
 
 // --- 包含所有分析遍和优化遍的头文件 ---
 #include "ir/analysis/cfg_builder.h"
 #include "ir/analysis/dominators.h"
+#include "ir/analysis/function_hash.h"
 #include "ir/analysis/loop_analysis.h"
 #include "ir/transforms/adce.h"
+#include "ir/transforms/auto_parallel.h"
 #include "ir/transforms/cse.h"
 #include "ir/transforms/ind_var_simplify.h"
 #include "ir/transforms/inliner.h"
@@ -41,6 +47,9 @@
 #include "ir/transforms/sroa.h"
 #include "ir/transforms/tail_call_elim.h"
 
+// 核心迭代循环中记住的最近若干轮的函数哈希数，决定能检测到的最长循环周期
+#define HASH_HISTORY_SIZE 8
+
 // --- 函数级优化流水线的前向声明 ---
 static void optimize_function(IRFunction *func,
                               const OptimizationConfig *config);
@@ -59,8 +68,10 @@ static const OptimizationConfig DEFAULT_CONFIG = {
     .enable_simplify_cfg = true,
     .enable_ind_var_simplify = true,
     .enable_inliner = true,
-    .max_iterations = 10,      // 迭代优化的最大次数
-    .max_loop_unroll_count = 4 // 循环展开因子
+    .enable_auto_parallel = false, // 需要链接带线程池的 sylib，默认关闭
+    .max_iterations = 10,       // 迭代优化的最大次数
+    .max_loop_unroll_count = 4, // 循环展开因子
+    .num_threads = 1            // 顺序输出 IR
 };
 
 // --- 主优化流水线 ---
@@ -72,6 +83,39 @@ void run_optimization_pipeline(IRModule *module) {
   run_optimization_pipeline_with_config(module, &DEFAULT_CONFIG);
 }
 
+/**
+ * @brief 用默认优化配置初始化调用者提供的配置结构体。
+ */
+void init_default_optimization_config(OptimizationConfig *config) {
+  if (config)
+    *config = DEFAULT_CONFIG;
+}
+
+/**
+ * @brief 按优化级别初始化配置：-O0 关闭所有变换，-O1 为默认配置，-O2 再加循环展开。
+ */
+void init_optimization_config_for_level(OptimizationConfig *config,
+                                        int level) {
+  if (!config)
+    return;
+  *config = DEFAULT_CONFIG;
+  if (level <= 0) {
+    config->enable_mem2reg = false;
+    config->enable_cse = false;
+    config->enable_adce = false;
+    config->enable_sroa = false;
+    config->enable_licm = false;
+    config->enable_sccp = false;
+    config->enable_tail_call_elim = false;
+    config->enable_inst_combine = false;
+    config->enable_simplify_cfg = false;
+    config->enable_ind_var_simplify = false;
+    config->enable_inliner = false;
+  } else if (level >= 2) {
+    config->enable_loop_unroll = true;
+  }
+}
+
 /**
  * @brief 使用指定配置运行优化流水线。
  * @details
@@ -96,17 +140,41 @@ void run_optimization_pipeline_with_config(IRModule *module,
 
   // --- 阶段 1: 迭代的函数内优化 ---
   for (IRFunction *func = module->functions; func; func = func->next) {
-    if (!func->entry)
-      continue; // 跳过外部函数声明
-    LOG_DEBUG(module->log_config, LOG_CATEGORY_IR_GEN,
+    optimize_ir_function(func, config);
+  }
+
+  run_module_optimization_pipeline(module, config);
+}
+
+/**
+ * @brief 对单个函数运行函数级优化。
+ */
+void optimize_ir_function(IRFunction *func, const OptimizationConfig *config) {
+  if (!func || !func->entry)
+    return; // 跳过外部函数声明
+  if (!config)
+    config = &DEFAULT_CONFIG;
+  if (func->module && func->module->log_config) {
+    LOG_DEBUG(func->module->log_config, LOG_CATEGORY_IR_GEN,
               "Optimizing function @%s", func->name);
-    optimize_function(func, config);
   }
+  optimize_function(func, config);
+}
+
+/**
+ * @brief 运行流水线的模块级部分（阶段 2 与阶段 3）。
+ */
+void run_module_optimization_pipeline(IRModule *module,
+                                      const OptimizationConfig *config) {
+  if (!module || !module->log_config)
+    return;
+  if (!config)
+    config = &DEFAULT_CONFIG;
 
   // --- 阶段 2: 过程间优化 (IPO) ---
   // IPO 可能会改变函数，甚至删除函数，所以在一个独立的循环中进行
   if (config->enable_inliner) {
-    if (run_inliner(module->functions)) {
+    if (PERF_PASS("inliner", run_inliner(module->functions))) {
       // 内联后，需要对被修改过的函数再次运行优化
       for (IRFunction *func = module->functions; func; func = func->next) {
         if (!func->entry)
@@ -120,14 +188,36 @@ void run_optimization_pipeline_with_config(IRModule *module,
     for (IRFunction *func = module->functions; func; func = func->next) {
       if (!func->entry)
         continue;
-      run_tail_call_elim(func);
+      PERF_PASS("tail_call_elim", run_tail_call_elim(func));
     }
   }
 
+  // --- 阶段 3: 自动并行化 ---
+  // 放在最后：此时循环形状已稳定，外提出的工作函数不会再被内联回去
+  if (config->enable_auto_parallel) {
+    PERF_PASS("auto_parallel", run_auto_parallel(module));
+  }
+
   LOG_INFO(module->log_config, LOG_CATEGORY_IR_GEN,
            "Optimization pipeline completed.");
 }
 
+/**
+ * @brief 运行一个由变更日志驱动的遍。
+ * @details
+ * 遍从日志的 `*seed` 位置（它上次结束时的位置）开始处理其他遍做出的修改，
+ * 结束后 `*seed` 更新为当前的日志位置。它自己做出的修改已在本次运行中
+ * 处理完毕，不会在下次运行时再交给它。
+ */
+static bool run_seeded_pass(IRFunction *func, const char *name,
+                            bool (*pass)(IRFunction *), int *seed) {
+  set_modification_seed(func, *seed);
+  bool changed = PERF_PASS(name, pass(func));
+  *seed = checkpoint_modifications(func);
+  set_modification_seed(func, -1);
+  return changed;
+}
+
 /**
  * @brief 对单个函数执行迭代式优化。
  * @details
@@ -137,9 +227,11 @@ void run_optimization_pipeline_with_config(IRModule *module,
  *
  * 阶段1: 初始分析和预处理
  *   1. build_cfg()           - 构建控制流图（必须最先执行）
- *   2. compute_dominators()  - 计算支配关系（依赖CFG）
- *   3. run_sroa()           - 标量替换聚合（可选）
+ *   2. run_sroa()           - 标量替换聚合（可选）
+ *   3. compute_dominators()  - 计算支配关系（依赖CFG）
  *   4. run_mem2reg()        - 内存到寄存器提升（依赖支配信息）
+ *   若标量已由 IR 生成器直接构造为 SSA 且 SROA 没有拆出新的 alloca，
+ *   则跳过 3、4，只用 compute_dominator_tree() 计算后续遍所需的支配树。
  *
  * 阶段2: 核心标量优化迭代循环
  *   5. run_inst_combine()   - 指令合并（最先执行，为其他优化创造机会）
@@ -175,18 +267,46 @@ static void optimize_function(IRFunction *func,
   }
 
   // --- 初始分析 ---
+  perf_region_begin();
   build_cfg(func);
-  compute_dominators(func);
+  // 生成器在 return/break/continue 之后开启的块不可达，支配分析要求 CFG 连通
+  remove_unreachable_blocks(func);
+  perf_region_end(PERF_REGION_PASS, "cfg");
 
   // --- 第一次清理和规范化 ---
+  bool split_aggregates = false;
   if (config->enable_sroa) {
-    run_sroa(func);
+    split_aggregates = PERF_PASS("sroa", run_sroa(func));
   }
-  if (config->enable_mem2reg) {
-    run_mem2reg(func);
+  // SROA 不依赖支配信息，也不改变 CFG。标量已直接构造为 SSA 时，
+  // 只有 SROA 新拆出的元素 alloca 还需要 mem2reg（及其依赖的支配边界）。
+  if (config->enable_mem2reg && (!func->scalars_in_ssa || split_aggregates)) {
+    perf_region_begin();
+    compute_dominators(func);
+    perf_region_end(PERF_REGION_PASS, "dominators");
+    PERF_PASS("mem2reg", run_mem2reg(func));
+  } else {
+    perf_region_begin();
+    compute_dominator_tree(func);
+    perf_region_end(PERF_REGION_PASS, "dominators");
   }
 
   // --- 核心优化迭代循环 ---
+  // 遍报告的 "changed" 只说明它动过 IR，不代表一轮下来 IR 真的变了：
+  // 两个遍可能互相撤销对方的改写，使流水线在几个状态之间来回往复直到
+  // max_iterations。因此每轮结束后比较函数的结构哈希，与最近若干轮中的
+  // 某一轮相同就立即停止。
+  uint64_t seen_hashes[HASH_HISTORY_SIZE];
+  int num_seen = 0;
+  perf_region_begin();
+  seen_hashes[num_seen++] = compute_function_hash(func);
+  perf_region_end(PERF_REGION_PASS, "function_hash");
+  // 第一轮之后，InstCombine 只从其他遍在它上次运行后修改过的指令出发，
+  // SCCP 与 CSE 在这期间没有任何修改时直接跳过。
+  int inst_combine_seed = -1;
+  int sccp_seed = -1;
+  int cse_seed = -1;
+  begin_modification_tracking(func);
   int iteration = 0;
   bool changed_in_iteration;
   do {
@@ -194,51 +314,94 @@ static void optimize_function(IRFunction *func,
 
     // 核心标量优化
     if (config->enable_inst_combine) {
-      changed_in_iteration |= run_inst_combine(func);
+      changed_in_iteration |= run_seeded_pass(func, "inst_combine",
+                                              run_inst_combine,
+                                              &inst_combine_seed);
     }
     if (config->enable_sccp) {
-      changed_in_iteration |= run_sccp(func);
+      changed_in_iteration |=
+          run_seeded_pass(func, "sccp", run_sccp, &sccp_seed);
     }
     if (config->enable_cse) {
-      changed_in_iteration |= run_cse(func);
+      changed_in_iteration |=
+          run_seeded_pass(func, "cse", run_cse, &cse_seed);
     }
 
     // 清理遍
     if (config->enable_adce) {
-      changed_in_iteration |= run_adce(func);
+      changed_in_iteration |= PERF_PASS("adce", run_adce(func));
     }
     if (config->enable_simplify_cfg) {
-      changed_in_iteration |= run_simplify_cfg(func);
+      changed_in_iteration |=
+          PERF_PASS("simplify_cfg", run_simplify_cfg(func));
     }
 
     // 如果CFG被简化，后续优化的效果会更好，所以重新计算分析
     if (changed_in_iteration) {
+      perf_region_begin();
       build_cfg(func);
+      perf_region_end(PERF_REGION_PASS, "cfg");
+      perf_region_begin();
       compute_dominators(func);
+      perf_region_end(PERF_REGION_PASS, "dominators");
     }
     iteration++;
+
+    if (changed_in_iteration) {
+      perf_region_begin();
+      uint64_t hash = compute_function_hash(func);
+      perf_region_end(PERF_REGION_PASS, "function_hash");
+      int history =
+          num_seen < HASH_HISTORY_SIZE ? num_seen : HASH_HISTORY_SIZE;
+      for (int back = 1; back <= history; back++) {
+        if (seen_hashes[(num_seen - back) % HASH_HISTORY_SIZE] != hash) {
+          continue;
+        }
+        if (back == 1) {
+          LOG_DEBUG(func->module->log_config, LOG_CATEGORY_IR_GEN,
+                    "Function @%s reached a fixed point after %d iterations "
+                    "(passes reported changes but the IR is unchanged)",
+                    func->name, iteration);
+        } else {
+          LOG_WARN(func->module->log_config, LOG_CATEGORY_IR_GEN,
+                   "Function @%s: optimization cycle of period %d detected "
+                   "at iteration %d, stopping",
+                   func->name, back, iteration);
+        }
+        changed_in_iteration = false;
+        break;
+      }
+      seen_hashes[num_seen++ % HASH_HISTORY_SIZE] = hash;
+    }
   } while (changed_in_iteration && iteration < config->max_iterations);
+  end_modification_tracking(func);
 
   // --- 循环优化 (在标量优化稳定后进行) ---
+  perf_region_begin();
   find_loops(func);
+  perf_region_end(PERF_REGION_PASS, "loops");
   if (func->top_level_loops) {
     if (config->enable_licm) {
-      run_licm(func);
+      PERF_PASS("licm", run_licm(func));
     }
     if (config->enable_ind_var_simplify) {
-      run_ind_var_simplify(func);
+      PERF_PASS("ind_var_simplify", run_ind_var_simplify(func));
     }
     if (config->enable_loop_unroll) {
-      run_loop_unroll(func);
+      PERF_PASS("loop_unroll", run_loop_unroll(func));
     }
 
     // 循环优化后可能产生大量冗余，进行最后一轮清理
-    if (run_inst_combine(func) || run_adce(func) || run_simplify_cfg(func)) {
+    if ((config->enable_inst_combine &&
+         PERF_PASS("inst_combine", run_inst_combine(func))) ||
+        (config->enable_adce && PERF_PASS("adce", run_adce(func))) ||
+        (config->enable_simplify_cfg &&
+         PERF_PASS("simplify_cfg", run_simplify_cfg(func)))) {
       // 如果清理有效，可以考虑再进行一轮核心优化，但通常一轮就足够
     }
   }
 
-  if (iteration >= config->max_iterations) {
+  if (changed_in_iteration) {
     LOG_WARN(func->module->log_config, LOG_CATEGORY_IR_GEN,
              "Function @%s reached max optimization iterations (%d)",
              func->name, config->max_iterations);
@@ -1,12 +1,174 @@
 #include "ast.h"
 #include "ir/ir_data_structures.h"
+#include "ir/ir_printer.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * @file ir_printer.c
  * @brief 实现将内存中的IR结构打印为文本格式的功能，用于调试和输出。
+ * @details
+ * 所有输出先写入 `PrintBuffer`，整数与 `%f` 形式的浮点数由手写的格式化
+ * 例程直接转换进缓冲区，缓冲区攒满后一次 `fwrite` 到目标流，不再逐个记号
+ * 经过 stdio。并行打印时每个函数写入各自的内存缓冲区，再按函数顺序拼接，
+ * 输出与顺序打印逐字节相同。
  */
 
+// 写往文件的缓冲区攒到这么大时整块 fwrite 一次
+#define PRINT_BUFFER_FLUSH_SIZE (64 * 1024)
+// 内存缓冲区（单个函数的文本）的初始容量
+#define PRINT_BUFFER_INITIAL_SIZE 4096
+// 并行打印时每批处理的函数数，限制同时驻留在内存中的文本量
+#define PRINT_PARALLEL_BATCH 256
+
+/**
+ * @struct PrintBuffer
+ * @brief IR 文本的输出缓冲区。
+ * @details `sink` 非 NULL 时，缓冲区写满即刷新到该流；为 NULL 时缓冲区
+ *          在内存中不断增长，用于并行打印时收集单个函数的文本。
+ */
+typedef struct PrintBuffer {
+    char* data;
+    size_t len;
+    size_t cap;
+    FILE* sink;
+} PrintBuffer;
+
+static void pb_init(PrintBuffer* b, FILE* sink) {
+    b->cap = sink ? PRINT_BUFFER_FLUSH_SIZE : PRINT_BUFFER_INITIAL_SIZE;
+    b->data = (char*)malloc(b->cap);
+    b->len = 0;
+    b->sink = sink;
+    if (!b->data) {
+        fprintf(stderr, "Fatal: out of memory in IR printer.\n");
+        exit(1);
+    }
+}
+
+static void pb_flush(PrintBuffer* b) {
+    if (b->sink && b->len > 0) {
+        fwrite(b->data, 1, b->len, b->sink);
+        b->len = 0;
+    }
+}
+
+/** @brief 刷新（写往文件时）并释放缓冲区。*/
+static void pb_finish(PrintBuffer* b) {
+    pb_flush(b);
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+/** @brief 确保还能追加 n 个字节：写往文件时先刷新，否则扩容。*/
+static void pb_reserve(PrintBuffer* b, size_t n) {
+    if (b->len + n <= b->cap) return;
+    pb_flush(b);
+    if (b->len + n <= b->cap) return;
+    size_t cap = b->cap;
+    while (b->len + n > cap) cap *= 2;
+    char* data = (char*)realloc(b->data, cap);
+    if (!data) {
+        fprintf(stderr, "Fatal: out of memory in IR printer.\n");
+        exit(1);
+    }
+    b->data = data;
+    b->cap = cap;
+}
+
+static void pb_write(PrintBuffer* b, const char* s, size_t n) {
+    if (b->sink && n >= b->cap) {
+        // 大块数据（并行打印的函数文本）不再经过缓冲区复制
+        pb_flush(b);
+        fwrite(s, 1, n, b->sink);
+        return;
+    }
+    pb_reserve(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static void pb_putc(PrintBuffer* b, char c) {
+    pb_reserve(b, 1);
+    b->data[b->len++] = c;
+}
+
+/** @brief 追加字符串；与 printf 的 `%s` 一致，NULL 输出为 `(null)`。*/
+static void pb_puts(PrintBuffer* b, const char* s) {
+    if (!s) s = "(null)";
+    pb_write(b, s, strlen(s));
+}
+
+static void pb_u64(PrintBuffer* b, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    pb_reserve(b, n);
+    while (n) b->data[b->len++] = tmp[--n];
+}
+
+static void pb_i64(PrintBuffer* b, int64_t v) {
+    if (v < 0) {
+        pb_putc(b, '-');
+        pb_u64(b, (uint64_t)0 - (uint64_t)v);
+    } else {
+        pb_u64(b, (uint64_t)v);
+    }
+}
+
+/**
+ * @brief 以与 `printf("%f")` 完全相同的形式追加一个浮点数。
+ * @details 把 x 精确分解为 m * 2^e，用 128 位整数求 x * 10^6 并按
+ *          "四舍六入五成双" 舍入，即 glibc 在默认舍入模式下的结果。
+ *          非有限值与绝对值很大的数交给 snprintf 处理。
+ */
+static void pb_fixed6(PrintBuffer* b, double x) {
+    if (!isfinite(x) || fabs(x) >= 1e15) {
+        char tmp[400];
+        int n = snprintf(tmp, sizeof(tmp), "%f", x);
+        pb_write(b, tmp, (size_t)n);
+        return;
+    }
+    bool negative = signbit(x);
+    if (negative) x = -x;
+
+    unsigned __int128 scaled = 0;
+    if (x != 0.0) {
+        int e;
+        uint64_t m = (uint64_t)ldexp(frexp(x, &e), 53); // x = m * 2^(e - 53)，精确
+        e -= 53;
+        if (e >= 0) {
+            scaled = ((unsigned __int128)m << e) * 1000000u;
+        } else if (-e < 120) {
+            // m * 10^6 < 2^73；移位位数不小于 120 时结果必然舍入为 0
+            int k = -e;
+            unsigned __int128 p = (unsigned __int128)m * 1000000u;
+            unsigned __int128 q = p >> k;
+            unsigned __int128 r = p - (q << k);
+            unsigned __int128 half = (unsigned __int128)1 << (k - 1);
+            if (r > half || (r == half && (q & 1))) q++;
+            scaled = q;
+        }
+    }
+
+    if (negative) pb_putc(b, '-');
+    pb_u64(b, (uint64_t)(scaled / 1000000u));
+    uint32_t frac = (uint32_t)(scaled % 1000000u);
+    char digits[7] = {'.'};
+    for (int i = 6; i >= 1; --i) {
+        digits[i] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    pb_write(b, digits, sizeof(digits));
+}
+
 /**
  * @brief 将操作码枚举转换为对应的字符串表示。
  * @param opcode 要转换的操作码。
@@ -43,6 +205,9 @@ static const char* opcode_to_string(Opcode opcode) {
         case IR_OP_FPTOSI: return "fptosi";
         case IR_OP_ZEXT: return "zext";
         case IR_OP_FPEXT: return "fpext";
+        case IR_OP_SEXT: return "sext";
+        case IR_OP_TRUNC: return "trunc";
+        case IR_OP_FPTRUNC: return "fptrunc";
         case IR_OP_UNKNOWN: return "unknown";
         default: return "invalid";
     }
@@ -53,21 +218,28 @@ static const char* opcode_to_string(Opcode opcode) {
  * @param type 要打印的类型。
  * @param out 目标输出流。
  */
-static void print_type(Type* type, FILE* out) {
+static void print_type(Type* type, PrintBuffer* out) {
     if (!type) {
-        fprintf(out, "void");
+        pb_puts(out, "void");
         return;
     }
     
     switch (type->kind) {
+        case TYPE_VOID:
+            pb_puts(out, "void");
+            break;
+        case TYPE_POINTER:
+            print_type(type->pointer.element_type, out);
+            pb_putc(out, '*');
+            break;
         case TYPE_BASIC:
             switch (type->basic) {
-                case BASIC_INT: fprintf(out, "i32"); break;
-                case BASIC_FLOAT: fprintf(out, "float"); break;
-                case BASIC_I1: fprintf(out, "i1"); break;
-                case BASIC_I8: fprintf(out, "i8"); break;
-                case BASIC_I64: fprintf(out, "i64"); break;
-                case BASIC_DOUBLE: fprintf(out, "double"); break;
+                case BASIC_INT: pb_puts(out, "i32"); break;
+                case BASIC_FLOAT: pb_puts(out, "float"); break;
+                case BASIC_I1: pb_puts(out, "i1"); break;
+                case BASIC_I8: pb_puts(out, "i8"); break;
+                case BASIC_I64: pb_puts(out, "i64"); break;
+                case BASIC_DOUBLE: pb_puts(out, "double"); break;
             }
             break;
         case TYPE_ARRAY: {
@@ -96,50 +268,153 @@ static void print_type(Type* type, FILE* out) {
             }
             // 先打印所有外层维度
             for (size_t i = 0; i < dim_count; ++i) {
-                if (dim_stack[i] == (size_t)-1)
-                    fprintf(out, "[? x ");
-                else
-                    fprintf(out, "[%zu x ", dim_stack[i]);
+                if (dim_stack[i] == (size_t)-1) {
+                    pb_puts(out, "[? x ");
+                } else {
+                    pb_putc(out, '[');
+                    pb_u64(out, dim_stack[i]);
+                    pb_puts(out, " x ");
+                }
             }
             // 打印最内层元素类型
             print_type((Type*)t, out);
             // 关闭所有括号
-            for (size_t i = 0; i < dim_count; ++i) fprintf(out, "]");
+            for (size_t i = 0; i < dim_count; ++i) pb_putc(out, ']');
             break;
         }
         case TYPE_FUNCTION:
             print_type(type->function.return_type, out);
-            fprintf(out, "(");
+            pb_puts(out, " (");
             for (size_t i = 0; i < type->function.param_count; i++) {
-                if (i > 0) fprintf(out, ", ");
+                if (i > 0) pb_puts(out, ", ");
                 print_type(type->function.param_types[i], out);
             }
             if (type->function.is_variadic) {
-                fprintf(out, ", ...");
+                pb_puts(out, ", ...");
             }
-            fprintf(out, ")");
+            pb_putc(out, ')');
             break;
         default:
-            fprintf(out, "<unsupported type>");
+            pb_puts(out, "<unsupported type>");
             break;
     }
 }
 
 // 前向声明，供 print_constant_aggregate 调用
-static void print_value(IRValue* value, FILE* out);
+static void print_value(IRValue* value, PrintBuffer* out);
+
+/**
+ * @brief 打印浮点常量。
+ * @details LLVM 只接受能精确表示该值的十进制写法：二进制小数位不超过 6 位的值
+ *          `%f` 形式恰好精确，其余按 LLVM 的约定打印双精度位模式的十六进制。
+ */
+static void print_float_constant(double x, PrintBuffer* out) {
+    double scaled = ldexp(x, 6);
+    if (isfinite(x) && fabs(x) < 1e15 && scaled == floor(scaled)) {
+        pb_fixed6(out, x);
+        return;
+    }
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    static const char hex[] = "0123456789ABCDEF";
+    char text[18] = {'0', 'x'};
+    for (int i = 0; i < 16; ++i) {
+        text[2 + i] = hex[(bits >> (60 - 4 * i)) & 0xF];
+    }
+    pb_write(out, text, sizeof(text));
+}
+
+/**
+ * @brief 打印数组类型去掉最外层维度后的子类型（多维数组在 Type 中是扁平存放的）。
+ */
+static void print_subarray_type(Type* type, PrintBuffer* out) {
+    if (type->array.dim_count <= 1) {
+        print_type(type->array.element_type, out);
+        return;
+    }
+    Type sub = *type;
+    sub.array.dimensions = type->array.dimensions + 1;
+    sub.array.dim_count = type->array.dim_count - 1;
+    print_type(&sub, out);
+}
+
+/**
+ * @brief 打印某个元素类型的零值。
+ */
+static void print_zero_value(Type* type, PrintBuffer* out) {
+    if (type->kind == TYPE_ARRAY) {
+        pb_puts(out, "zeroinitializer");
+    } else if (type->basic == BASIC_FLOAT || type->basic == BASIC_DOUBLE) {
+        print_float_constant(0.0, out);
+    } else {
+        pb_putc(out, '0');
+    }
+}
+
+/**
+ * @brief 打印以 i8 数组表示的字符串常量（值保存在 `name` 中）。
+ */
+static void print_string_constant(IRValue* value, PrintBuffer* out) {
+    pb_puts(out, "c\"");
+    for (const unsigned char* p = (const unsigned char*)value->name; p && *p; ++p) {
+        if (*p >= 0x20 && *p < 0x7f && *p != '"' && *p != '\\') {
+            pb_putc(out, (char)*p);
+        } else {
+            static const char hex[] = "0123456789ABCDEF";
+            char escape[3] = {'\\', hex[*p >> 4], hex[*p & 0xF]};
+            pb_write(out, escape, sizeof(escape));
+        }
+    }
+    pb_puts(out, "\\00\"");
+}
+
+/**
+ * @brief 打印聚合常量中下标 [from, to) 的一段零值元素。
+ * @param item 预先渲染好的 `<元素类型> <零值>` 文本。
+ */
+static void print_zero_run(const PrintBuffer* item, size_t from, size_t to, PrintBuffer* out) {
+    for (size_t i = from; i < to; ++i) {
+        if (i > 0) pb_puts(out, ", ");
+        pb_write(out, item->data, item->len);
+    }
+}
 
 /**
  * @brief 递归打印聚合常量
+ * @details 全零聚合打印为 `zeroinitializer`。LLVM 的数组常量必须逐个写出
+ *          元素，因此按显式元素分段：元素类型与零元素的文本只渲染一次，
+ *          两个显式元素之间以及末尾的零值整段复制（子数组零值为 `zeroinitializer`）。
  * @param agg 要打印的聚合常量。
+ * @param type 聚合常量的数组类型。
  * @param out 目标输出流。
  */
-static void print_constant_aggregate(ConstantAggregate* agg, FILE* out) {
-    fprintf(out, "[");
-    for (size_t i = 0; i < agg->count; ++i) {
-        if (i > 0) fprintf(out, ", ");
-        print_value(agg->elements[i], out);
+static void print_constant_aggregate(ConstantAggregate* agg, Type* type, PrintBuffer* out) {
+    if (agg->num_elements == 0) {
+        pb_puts(out, "zeroinitializer");
+        return;
+    }
+    // 零值的打印形式只取决于元素是否为数组，不需要完整的子数组类型
+    Type* zero_type = type->array.dim_count > 1 ? type : type->array.element_type;
+    PrintBuffer item;
+    pb_init(&item, NULL);
+    print_subarray_type(type, &item);
+    pb_putc(&item, ' ');
+    size_t type_len = item.len;
+    print_zero_value(zero_type, &item);
+
+    size_t next = 0;
+    pb_putc(out, '[');
+    for (size_t k = 0; k < agg->num_elements; ++k) {
+        size_t index = agg->indices ? agg->indices[k] : k;
+        print_zero_run(&item, next, index, out);
+        if (index > 0) pb_puts(out, ", ");
+        pb_write(out, item.data, type_len);
+        print_value(agg->elements[k], out);
+        next = index + 1;
     }
-    fprintf(out, "]");
+    print_zero_run(&item, next, agg->count, out);
+    pb_putc(out, ']');
+    pb_finish(&item);
 }
 
 /**
@@ -148,9 +423,9 @@ static void print_constant_aggregate(ConstantAggregate* agg, FILE* out) {
  * @param value 要打印的值。
  * @param out 目标输出流。
  */
-static void print_value(IRValue* value, FILE* out) {
+static void print_value(IRValue* value, PrintBuffer* out) {
     if (!value) {
-        fprintf(out, "null");
+        pb_puts(out, "null");
         return;
     }
     
@@ -158,203 +433,428 @@ static void print_value(IRValue* value, FILE* out) {
         if (value->type && value->type->kind == TYPE_BASIC) {
             switch (value->type->basic) {
                 case BASIC_INT:
-                    fprintf(out, "%d", value->int_val);
+                    pb_i64(out, value->int_val);
                     break;
                 case BASIC_FLOAT:
-                    fprintf(out, "%f", value->float_val);
+                    print_float_constant(value->float_val, out);
                     break;
                 case BASIC_I1:
-                    fprintf(out, "%d", value->int_val ? 1 : 0);
+                    pb_putc(out, value->int_val ? '1' : '0');
                     break;
                 case BASIC_I8:
-                    fprintf(out, "%d", value->int_val);
+                    pb_i64(out, value->int_val);
                     break;
                 case BASIC_I64:
-                    fprintf(out, "%ld", value->i64_val);
+                    pb_i64(out, value->i64_val);
                     break;
                 case BASIC_DOUBLE:
-                    fprintf(out, "%f", value->double_val);
+                    print_float_constant(value->double_val, out);
                     break;
             }
         } else if (value->type && value->type->kind == TYPE_ARRAY) {
-            print_constant_aggregate(&value->aggregate, out);
+            Type* elem = value->type->array.element_type;
+            if (elem->kind == TYPE_BASIC && elem->basic == BASIC_I8) {
+                print_string_constant(value, out);
+            } else {
+                print_constant_aggregate(&value->aggregate, value->type, out);
+            }
         } else {
-            fprintf(out, "constant");
+            pb_puts(out, "constant");
         }
+    } else if (!value->name) {
+        // Mem2Reg 为未初始化的读取提供的占位值
+        pb_puts(out, "undef");
     } else {
         // 非常量（寄存器、函数、全局变量等）打印其名称，区分全局/局部
         if (value->is_global || (value->type && value->type->kind == TYPE_FUNCTION)) {
-            fprintf(out, "@%s", value->name);
+            pb_putc(out, '@');
+            pb_puts(out, value->name);
         } else {
-            fprintf(out, "%%%s", value->name);
+            pb_putc(out, '%');
+            pb_puts(out, value->name);
         }
     }
 }
 
+/** @brief 打印“类型 值”形式的操作数。*/
+static void print_typed_value(IRValue* value, PrintBuffer* out) {
+    print_type(value->type, out);
+    pb_putc(out, ' ');
+    print_value(value, out);
+}
+
 /**
  * @brief 将单条 IR 指令打印为文本格式。
  * @param instr 要打印的指令。
  * @param out 目标输出流。
  */
-static void print_instruction(IRInstruction* instr, FILE* out) {
+static void print_instruction(IRInstruction* instr, PrintBuffer* out) {
     if (!instr) return;
     
     // PHI 节点特殊打印
     if (instr->opcode == IR_OP_PHI) {
         if (instr->dest) {
             print_value(instr->dest, out);
-            fprintf(out, " = ");
+            pb_puts(out, " = ");
         }
-        fprintf(out, "phi ");
+        pb_puts(out, "phi ");
         print_type(instr->dest ? instr->dest->type : NULL, out);
         IROperand* op = instr->operand_head;
         int first = 1;
         while (op && op->next_in_instr) {
-            if (!first) fprintf(out, ",");
-            fprintf(out, " [");
+            if (!first) pb_putc(out, ',');
+            pb_puts(out, " [");
             print_value(op->data.value, out);
-            fprintf(out, ", %%");
+            pb_puts(out, ", %");
             IROperand* pred_op = op->next_in_instr;
-            fprintf(out, "%s", pred_op->data.bb->label);
-            fprintf(out, "]");
+            pb_puts(out, pred_op->data.bb->label);
+            pb_putc(out, ']');
             op = pred_op->next_in_instr;
             first = 0;
         }
-        fprintf(out, "\n");
+        pb_putc(out, '\n');
         return;
     }
     
     // 如果指令有返回值，先打印目标寄存器。
     if (instr->dest) {
         print_value(instr->dest, out);
-        fprintf(out, " = ");
+        pb_puts(out, " = ");
     }
     
     // 打印操作码。
-    fprintf(out, "%s", opcode_to_string(instr->opcode));
-    
-    // 如果是比较指令，打印条件码。
-    if (instr->opcode == IR_OP_ICMP || instr->opcode == IR_OP_FCMP) {
-        if (instr->opcode_cond) {
-            fprintf(out, " %s", instr->opcode_cond);
-        }
-    }
+    pb_puts(out, opcode_to_string(instr->opcode));
     
-    // 遍历并打印所有操作数。
     IROperand* op = instr->operand_head;
-    while (op) {
-        fprintf(out, " ");
-        if (op->kind == IR_OP_KIND_VALUE) {
+    switch (instr->opcode) {
+        case IR_OP_ICMP:
+        case IR_OP_FCMP:
+            // 比较指令：条件码后接一次操作数类型
+            pb_putc(out, ' ');
+            pb_puts(out, instr->opcode_cond);
+            pb_putc(out, ' ');
+            print_type(op->data.value->type, out);
+            pb_putc(out, ' ');
             print_value(op->data.value, out);
-        } else {
-            fprintf(out, "label %%%s", op->data.bb->label);
+            pb_puts(out, ", ");
+            print_value(op->next_in_instr->data.value, out);
+            break;
+        case IR_OP_ALLOCA:
+            pb_putc(out, ' ');
+            print_type(instr->dest->type->pointer.element_type, out);
+            break;
+        case IR_OP_LOAD:
+            pb_putc(out, ' ');
+            print_type(instr->dest->type, out);
+            pb_puts(out, ", ");
+            print_typed_value(op->data.value, out);
+            break;
+        case IR_OP_GETELEMENTPTR:
+            if (instr->is_inbounds) pb_puts(out, " inbounds");
+            pb_putc(out, ' ');
+            print_type(op->data.value->type->pointer.element_type, out);
+            for (; op; op = op->next_in_instr) {
+                pb_puts(out, ", ");
+                print_typed_value(op->data.value, out);
+            }
+            break;
+        case IR_OP_CALL: {
+            // 返回类型；可变参数函数需要给出完整的函数类型
+            Type* func_type = op->data.value->type->pointer.element_type;
+            pb_putc(out, ' ');
+            print_type(func_type->function.is_variadic ? func_type
+                                                       : func_type->function.return_type,
+                       out);
+            pb_putc(out, ' ');
+            print_value(op->data.value, out);
+            pb_putc(out, '(');
+            for (op = op->next_in_instr; op; op = op->next_in_instr) {
+                print_typed_value(op->data.value, out);
+                if (op->next_in_instr) pb_puts(out, ", ");
+            }
+            pb_putc(out, ')');
+            break;
         }
-        op = op->next_in_instr;
+        case IR_OP_RET:
+            pb_putc(out, ' ');
+            if (op) {
+                print_typed_value(op->data.value, out);
+            } else {
+                pb_puts(out, "void");
+            }
+            break;
+        case IR_OP_SITOFP:
+        case IR_OP_FPTOSI:
+        case IR_OP_ZEXT:
+        case IR_OP_FPEXT:
+        case IR_OP_SEXT:
+        case IR_OP_TRUNC:
+        case IR_OP_FPTRUNC:
+            pb_putc(out, ' ');
+            print_typed_value(op->data.value, out);
+            pb_puts(out, " to ");
+            print_type(instr->dest->type, out);
+            break;
+        case IR_OP_BR:
+        case IR_OP_STORE:
+            // 每个操作数各自带类型
+            for (; op; op = op->next_in_instr) {
+                pb_putc(out, ' ');
+                if (op->kind == IR_OP_KIND_VALUE) {
+                    print_typed_value(op->data.value, out);
+                } else {
+                    pb_puts(out, "label %");
+                    pb_puts(out, op->data.bb->label);
+                }
+                if (op->next_in_instr) pb_putc(out, ',');
+            }
+            break;
+        default:
+            // 二元运算：操作数类型只打印一次
+            if (op) {
+                pb_putc(out, ' ');
+                print_type(op->data.value->type, out);
+            }
+            for (; op; op = op->next_in_instr) {
+                pb_putc(out, ' ');
+                print_value(op->data.value, out);
+                if (op->next_in_instr) pb_putc(out, ',');
+            }
+            break;
     }
     
-    fprintf(out, "\n");
+    pb_putc(out, '\n');
 }
 
 /**
  * @brief 将单个基本块及其所有指令打印为文本格式。
  * @param bb 要打印的基本块。
- * @param out 目标输出流。
+ * @param out 目标缓冲区。
  */
-void print_basic_block(IRBasicBlock* bb, FILE* out) {
+static void emit_basic_block(IRBasicBlock* bb, PrintBuffer* out) {
     if (!bb) return;
     
     // 打印基本块的标签。
-    fprintf(out, "%s:\n", bb->label);
+    pb_puts(out, bb->label);
+    pb_puts(out, ":\n");
     
     // 遍历并打印块内的每一条指令。
     IRInstruction* instr = bb->head;
     while (instr) {
-        fprintf(out, "  "); // 缩进
+        pb_puts(out, "  "); // 缩进
         print_instruction(instr, out);
         instr = instr->next;
     }
-    fprintf(out, "\n");
+    pb_putc(out, '\n');
 }
 
 /**
  * @brief 将单个函数及其所有基本块打印为文本格式。
  * @param func 要打印的函数。
- * @param out 目标输出流。
+ * @param out 目标缓冲区。
  */
-void print_function(IRFunction* func, FILE* out) {
+static void emit_function(IRFunction* func, PrintBuffer* out) {
     if (!func) return;
-    fprintf(out, "define ");
+    pb_puts(out, "define ");
     print_type(func->return_type, out);
-    fprintf(out, " @%s(", func->name);
+    pb_puts(out, " @");
+    pb_puts(out, func->name);
+    pb_putc(out, '(');
     for (int i = 0; i < func->num_args; ++i) {
-        if (i > 0) fprintf(out, ", ");
+        if (i > 0) pb_puts(out, ", ");
         IRValue* arg = func->args[i];
         print_type(arg->type, out);
-        fprintf(out, " %%");
-        fprintf(out, "%s", arg->name ? arg->name : "arg");
+        pb_puts(out, " %");
+        pb_puts(out, arg->name ? arg->name : "arg");
     }
-    fprintf(out, ") {\n");
+    pb_puts(out, ") {\n");
     IRBasicBlock* bb = func->blocks;
     while (bb) {
-        print_basic_block(bb, out);
+        emit_basic_block(bb, out);
         bb = bb->next_in_func;
     }
-    fprintf(out, "}\n\n");
+    pb_puts(out, "}\n\n");
 }
 
+static void emit_declarations(IRModule* module, PrintBuffer* out);
+
 /**
- * @brief 将整个 IR 模块打印为文本格式。
+ * @brief 打印模块元信息、所有全局变量与外部函数声明。
  * @param module 要打印的模块。
- * @param out 目标输出流。
+ * @param out 目标缓冲区。
  */
-void print_module(IRModule* module, FILE* out) {
-    if (!module) return;
-    
+static void emit_module_header(IRModule* module, PrintBuffer* out) {
     // 打印模块元信息。
-    fprintf(out, "; ModuleID = '%s'\n", module->source_filename);
-    fprintf(out, "source_filename = \"%s\"\n\n", module->source_filename);
+    pb_puts(out, "; ModuleID = '");
+    pb_puts(out, module->source_filename);
+    pb_puts(out, "'\nsource_filename = \"");
+    pb_puts(out, module->source_filename);
+    pb_puts(out, "\"\n\n");
     
     // 打印所有全局变量。
     IRGlobalVariable* global = module->globals;
     while (global) {
-        fprintf(out, "@%s = ", global->name);
+        pb_putc(out, '@');
+        pb_puts(out, global->name);
+        pb_puts(out, " = ");
         if (global->is_const) {
-            fprintf(out, "constant ");
+            pb_puts(out, "constant ");
         } else {
-            fprintf(out, "global ");
+            pb_puts(out, "global ");
         }
         print_type(global->type, out);
         if (global->initializer) {
-            fprintf(out, " ");
+            pb_putc(out, ' ');
             print_value(global->initializer, out);
         } else {
-            fprintf(out, " zeroinitializer");
+            pb_puts(out, " zeroinitializer");
         }
-        fprintf(out, "\n");
+        pb_putc(out, '\n');
         global = global->next;
     }
-    if (module->globals) fprintf(out, "\n");
-    
-    // 打印所有函数。
-    IRFunction* func = module->functions;
-    while (func) {
-        print_function(func, out);
-        func = func->next;
+    if (module->globals) pb_putc(out, '\n');
+    emit_declarations(module, out);
+}
+
+/** @brief 模块中是否定义了（或已声明过）指定名字的函数。*/
+static bool is_name_in(const char* name, const char** names, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(names[i], name) == 0) return true;
     }
+    return false;
 }
 
 /**
- * @brief 将 IR 模块打印到指定的文件。
- * @param module 要打印的模块。
- * @param filename 目标文件名。
+ * @brief 为被调用但没有在模块中定义的函数（运行时库函数）打印 `declare`。
+ * @details 只声明实际被调用的函数；同名函数只声明一次。
  */
+static void emit_declarations(IRModule* module, PrintBuffer* out) {
+    size_t defined_count = 0;
+    for (IRFunction* func = module->functions; func; func = func->next) defined_count++;
+    size_t capacity = defined_count + 16;
+    const char** names = (const char**)malloc(capacity * sizeof(const char*));
+    if (!names) {
+        fprintf(stderr, "Fatal: out of memory in IR printer.\n");
+        exit(1);
+    }
+    size_t count = 0;
+    for (IRFunction* func = module->functions; func; func = func->next) names[count++] = func->name;
+
+    bool any = false;
+    for (IRFunction* func = module->functions; func; func = func->next) {
+        for (IRBasicBlock* bb = func->blocks; bb; bb = bb->next_in_func) {
+            for (IRInstruction* instr = bb->head; instr; instr = instr->next) {
+                if (instr->opcode != IR_OP_CALL) continue;
+                IRValue* callee = instr->operand_head->data.value;
+                if (is_name_in(callee->name, names, count)) continue;
+                if (count == capacity) {
+                    capacity *= 2;
+                    const char** grown = (const char**)realloc(names, capacity * sizeof(const char*));
+                    if (!grown) {
+                        fprintf(stderr, "Fatal: out of memory in IR printer.\n");
+                        exit(1);
+                    }
+                    names = grown;
+                }
+                names[count++] = callee->name;
+
+                Type* func_type = callee->type->pointer.element_type;
+                pb_puts(out, "declare ");
+                print_type(func_type->function.return_type, out);
+                pb_puts(out, " @");
+                pb_puts(out, callee->name);
+                pb_putc(out, '(');
+                for (size_t i = 0; i < func_type->function.param_count; ++i) {
+                    if (i > 0) pb_puts(out, ", ");
+                    print_type(func_type->function.param_types[i], out);
+                }
+                if (func_type->function.is_variadic) pb_puts(out, ", ...");
+                pb_puts(out, ")\n");
+                any = true;
+            }
+        }
+    }
+    if (any) pb_putc(out, '\n');
+    free(names);
+}
+
+void print_basic_block(IRBasicBlock* bb, FILE* out) {
+    PrintBuffer buffer;
+    pb_init(&buffer, out);
+    emit_basic_block(bb, &buffer);
+    pb_finish(&buffer);
+}
+
+void print_function(IRFunction* func, FILE* out) {
+    PrintBuffer buffer;
+    pb_init(&buffer, out);
+    emit_function(func, &buffer);
+    pb_finish(&buffer);
+}
+
+void print_ir_module(IRModule* module, FILE* out) {
+    print_ir_module_parallel(module, out, 1);
+}
+
+/** @brief 并行打印的一批函数及其各自的内存缓冲区。*/
+typedef struct PrintBatch {
+    IRFunction** functions;
+    PrintBuffer* buffers;
+} PrintBatch;
+
+static void print_function_task(size_t index, unsigned worker, void* user_data) {
+    (void)worker;
+    PrintBatch* batch = (PrintBatch*)user_data;
+    emit_function(batch->functions[index], &batch->buffers[index]);
+}
+
+void print_ir_module_parallel(IRModule* module, FILE* out, unsigned num_threads) {
+    if (!module) return;
+    PrintBuffer buffer;
+    pb_init(&buffer, out);
+    emit_module_header(module, &buffer);
+
+    if (num_threads <= 1) {
+        for (IRFunction* func = module->functions; func; func = func->next) {
+            emit_function(func, &buffer);
+        }
+        pb_finish(&buffer);
+        return;
+    }
+
+    // 每批函数各自打印进内存缓冲区，再按模块中的顺序拼接
+    IRFunction* batch_functions[PRINT_PARALLEL_BATCH];
+    PrintBuffer batch_buffers[PRINT_PARALLEL_BATCH];
+    PrintBatch batch = {batch_functions, batch_buffers};
+    IRFunction* func = module->functions;
+    while (func) {
+        size_t count = 0;
+        for (; func && count < PRINT_PARALLEL_BATCH; func = func->next) {
+            batch_functions[count] = func;
+            pb_init(&batch_buffers[count], NULL);
+            count++;
+        }
+        parallel_for(count, num_threads, print_function_task, &batch);
+        for (size_t i = 0; i < count; ++i) {
+            pb_write(&buffer, batch_buffers[i].data, batch_buffers[i].len);
+            pb_finish(&batch_buffers[i]);
+        }
+    }
+    pb_finish(&buffer);
+}
+
 void print_ir_to_file(IRModule* module, const char* filename) {
+    print_ir_to_file_parallel(module, filename, 1);
+}
+
+void print_ir_to_file_parallel(IRModule* module, const char* filename, unsigned num_threads) {
     FILE* out = fopen(filename, "w");
     if (!out) {
         fprintf(stderr, "Error: Could not open file '%s' for writing\n", filename);
         return;
     }
-    
-    print_module(module, out);
+    // 输出已经整块缓冲，关闭 stdio 自身的缓冲避免再复制一次
+    setvbuf(out, NULL, _IONBF, 0);
+    print_ir_module_parallel(module, out, num_threads);
     fclose(out);
-}
\ No newline at end of file
+}
@@ -24,6 +24,26 @@ IRModule* generate_ir(ASTContext* ast_ctx) {
     return generate_ir_module(ast_ctx);
 }
 
+/** @brief 流式生成时的回调：对刚降级的函数运行函数级优化。*/
+static void optimize_generated_function(IRFunction* func, void* user_data) {
+    optimize_ir_function(func, (const OptimizationConfig*)user_data);
+}
+
+/**
+ * @brief 逐函数生成 IR，并在每个函数降级后立即进行函数级优化。
+ * @param ast_ctx AST 上下文，调用后其函数体已被释放。
+ * @param gen_options IR 生成选项，为 NULL 时使用默认选项。
+ * @param config 函数级优化配置，为 NULL 时不做优化。
+ * @return 生成的 IRModule*，由调用者负责后续处理和销毁。
+ */
+IRModule* generate_ir_streaming(ASTContext* ast_ctx, const IRGenOptions* gen_options,
+                                const OptimizationConfig* config) {
+    if (!ast_ctx) return NULL;
+    return generate_ir_module_streaming(ast_ctx, gen_options,
+                                        config ? optimize_generated_function : NULL,
+                                        (void*)config);
+}
+
 /**
  * @brief 优化内存中的 IR 模块并写入文件。
  * @details
@@ -35,17 +55,48 @@ IRModule* generate_ir(ASTContext* ast_ctx) {
  * @return 成功返回 true，失败返回 false。
  */
 bool optimize_ir(IRModule* module, const char* output_filename) {
+    return optimize_ir_with_config(module, output_filename, NULL);
+}
+
+/**
+ * @brief 使用指定配置优化内存中的 IR 模块并写入文件。
+ *
+ * @param module 指向待优化的、内存中的 IR 模块。
+ * @param output_filename 优化后的 IR 文件的路径。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool optimize_ir_with_config(IRModule* module, const char* output_filename,
+                             const OptimizationConfig* config) {
     if (!module || !output_filename) {
         return false;
     }
     
     // 对模块进行就地（in-place）优化。
-    run_optimization_pipeline(module);
+    run_optimization_pipeline_with_config(module, config);
     
     // 将优化后的 IR 打印到文件。
-    print_ir_to_file(module, output_filename);
+    print_ir_to_file_parallel(module, output_filename, config ? config->num_threads : 1);
     
     return true;
 }
 
+/**
+ * @brief 对已完成函数级优化的模块运行模块级优化并写入文件。
+ *
+ * @param module 由 `generate_ir_streaming` 生成的 IR 模块。
+ * @param output_filename 优化后的 IR 文件的路径。
+ * @param config 优化配置，为 NULL 时使用默认配置。
+ * @return 成功返回 true，失败返回 false。
+ */
+bool optimize_streamed_ir_with_config(IRModule* module, const char* output_filename,
+                                      const OptimizationConfig* config) {
+    if (!module || !output_filename) {
+        return false;
+    }
+    run_module_optimization_pipeline(module, config);
+    print_ir_to_file_parallel(module, output_filename, config ? config->num_threads : 1);
+    return true;
+}
+
 // 删除 generate_riscv_assembly 的实现，只保留调用 backend_riscv.c 的实现。
\ No newline at end of file
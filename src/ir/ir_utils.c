@@ -2,6 +2,7 @@
 #include "ast.h"
 #include "ir/ir_builder.h"
 #include <assert.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,7 +27,7 @@ static void remove_operand_from_use_list(IROperand *op);
  * @param val 要计算哈希的 IRValue。
  * @return 计算出的哈希值。
  */
-static unsigned int hash_value(IRValue *val);
+static unsigned int hash_value(IRValue *val, bool opaque);
 
 /**
  * @brief (内部函数) 对支配树进行深度优先搜索，以计算时间戳。
@@ -137,6 +138,21 @@ void *worklist_pop(Worklist *wl) {
   return wl->items[--wl->count];
 }
 
+/**
+ * @brief 判断工作列表是否为空。
+ */
+bool worklist_empty(Worklist *wl) { return wl->count == 0; }
+
+/**
+ * @brief 结束工作列表的使用。
+ * @details 工作列表及其存储都从内存池分配，随内存池一并释放，这里只清空计数，
+ *          防止误用已结束的列表。
+ */
+void destroy_worklist(Worklist *wl) {
+  if (wl)
+    wl->count = 0;
+}
+
 // --- ValueMap 实现 (哈希映射表) ---
 
 /**
@@ -155,12 +171,24 @@ void value_map_init(ValueMap *map, MemoryPool *pool) {
   map->hash_capacity = map->capacity;
   map->hash_table = (ValueMapEntry **)pool_alloc_z(
       pool, sizeof(ValueMapEntry *) * map->hash_capacity);
+  map->opaque_keys = false;
+}
+
+/**
+ * @brief 初始化一个以任意对象指针为键的映射表。
+ * @details 键（如 `Symbol*`）只借用 `IRValue*` 的类型存放，映射表按地址散列，
+ *          从不读取键的内容。
+ */
+void value_map_init_opaque(ValueMap *map, MemoryPool *pool) {
+  value_map_init(map, pool);
+  map->opaque_keys = true;
 }
 
 /**
  * @brief (内部函数) 计算一个 IRValue 的哈希值。
+ * @param opaque 为 true 时键不是真正的 IRValue，只按地址散列。
  */
-static unsigned int hash_value(IRValue *val) {
+static unsigned int hash_value(IRValue *val, bool opaque) {
   if (!val)
     return 0;
 
@@ -168,7 +196,7 @@ static unsigned int hash_value(IRValue *val) {
   const unsigned int HASH_MULTIPLIER = 2654435761U; // (sqrt(5) - 1) / 2 * 2^32
 
   // 如果是常量，优先基于其值计算哈希
-  if (val->is_constant && val->type->kind == TYPE_BASIC) {
+  if (!opaque && val->is_constant && val->type->kind == TYPE_BASIC) {
     unsigned int content_hash = 0;
     switch (val->type->basic) {
     case BASIC_INT:
@@ -234,7 +262,7 @@ static unsigned int hash_value(IRValue *val) {
 void value_map_put(ValueMap *map, IRValue *old_val, IRValue *new_val,
                    LogConfig *log_config) {
   // 常量不应作为键被重映射
-  if (!old_val || old_val->is_constant)
+  if (!old_val || (!map->opaque_keys && old_val->is_constant))
     return;
 
   // 检查是否需要扩容，如果需要则对整个表进行 rehash
@@ -287,14 +315,16 @@ void value_map_put(ValueMap *map, IRValue *old_val, IRValue *new_val,
     // 重新构建哈希表
     for (int i = 0; i < map->count; ++i) {
       unsigned int hash =
-          hash_value(map->entries[i].old_val) % map->hash_capacity;
+          hash_value(map->entries[i].old_val, map->opaque_keys) %
+          map->hash_capacity;
       map->entries[i].next_in_hash = map->hash_table[hash];
       map->hash_table[hash] = &map->entries[i];
     }
   }
 
   // 检查键是否已存在，若存在则更新
-  unsigned int hash = hash_value(old_val) % map->hash_capacity;
+  unsigned int hash =
+      hash_value(old_val, map->opaque_keys) % map->hash_capacity;
   for (ValueMapEntry *entry = map->hash_table[hash]; entry;
        entry = entry->next_in_hash) {
     if (entry->old_val == old_val) {
@@ -328,14 +358,16 @@ IRValue *value_map_get(const ValueMap *map, IRValue *old_val,
     return NULL;
   }
 
-  unsigned int hash = hash_value(old_val) % map->hash_capacity;
+  unsigned int hash =
+      hash_value(old_val, map->opaque_keys) % map->hash_capacity;
   for (ValueMapEntry *entry = map->hash_table[hash]; entry;
        entry = entry->next_in_hash) {
     if (entry->old_val == old_val) {
       if (log_config) {
         LOG_DEBUG(log_config, LOG_CATEGORY_MEMORY,
                   "ValueMap lookup successful for value %s",
-                  old_val->name ? old_val->name : "unnamed");
+                  !map->opaque_keys && old_val->name ? old_val->name
+                                                     : "unnamed");
       }
       return entry->new_val;
     }
@@ -598,29 +630,168 @@ IRValue *create_constant_double(double val, MemoryPool *pool) {
   return v;
 }
 
+/**
+ * @brief 创建一个全零的聚合常量（`zeroinitializer`）。
+ */
+IRValue *create_zero_aggregate(Type *type, MemoryPool *pool) {
+  IRValue *v = create_ir_value(pool);
+  v->is_constant = true;
+  v->type = type;
+  v->aggregate.count =
+      type->array.dimensions[0].static_size > 0
+          ? (size_t)type->array.dimensions[0].static_size
+          : 0;
+  return v;
+}
+
+/**
+ * @brief 判断一个常量是否为全零值（可以放入 `.bss`）。
+ * @details 浮点数 `-0.0` 的位模式非零，不视为零值。
+ */
+bool is_zero_constant(IRValue *val) {
+  if (!val || !val->is_constant || !val->type)
+    return false;
+  if (val->type->kind == TYPE_ARRAY)
+    return val->type->array.element_type->kind == TYPE_BASIC &&
+           val->type->array.element_type->basic != BASIC_I8 &&
+           val->aggregate.num_elements == 0;
+  if (val->type->kind != TYPE_BASIC)
+    return false;
+  switch (val->type->basic) {
+  case BASIC_FLOAT:
+    return val->float_val == 0.0f && !signbit(val->float_val);
+  case BASIC_DOUBLE:
+    return val->double_val == 0.0 && !signbit(val->double_val);
+  case BASIC_I64:
+    return val->i64_val == 0;
+  default:
+    return val->int_val == 0;
+  }
+}
+
 /******************************************************************************
  *                                                                            *
  *              3. IR 修改与 Use-Def/Def-Use 链维护函数                       *
  *                                                                            *
  ******************************************************************************/
 
+// --- 指令级变更跟踪 ---
+
 /**
- * @brief 向指令添加一个操作数，并正确维护所有相关链表。
- * @details 这是一个核心的 IR 修改函数。它负责：
- *          1. 创建 IROperand 对象。
- *          2. 将操作数添加到指令的操作数双向链表的末尾（O(1) 效率）。
- *          3. 如果操作数是 IRValue，将其添加到该值的 Use 链的头部。
- * @param instr 目标指令。
- * @param kind 操作数的种类。
- * @param data_ptr 指向操作数数据的指针 (IRValue* 或 IRBasicBlock*)。
- * @return 新创建的 IROperand。
+ * @brief 为一个函数开启指令级变更跟踪。
+ * @details
+ * 开启后，本节的修改工具（改操作数、RAUW、插入/删除指令、改写分支目标等）
+ * 会把受影响的指令追加到函数的变更日志中。优化流水线在每个遍结束时用
+ * `checkpoint_modifications` 记下日志位置，下次运行该遍之前用
+ * `set_modification_seed` 把这个位置交给它：日志中此后的部分就是“这个遍
+ * 上次运行以来、由其他遍做出的全部修改”。
  */
-IROperand *add_operand(IRInstruction *instr, OperandKind kind, void *data_ptr) {
+void begin_modification_tracking(IRFunction *func) {
+  func->track_modifications = true;
+  func->modified_generation++;
+  func->modified_seed = -1;
+  func->modified_log.count = 0;
+}
+
+/**
+ * @brief 关闭变更跟踪并释放日志；此后的修改不再被记录。
+ */
+void end_modification_tracking(IRFunction *func) {
+  func->track_modifications = false;
+  func->modified_generation++;
+  func->modified_seed = -1;
+  free(func->modified_log.items);
+  func->modified_log.items = NULL;
+  func->modified_log.count = 0;
+  func->modified_log.capacity = 0;
+}
+
+/**
+ * @brief 在日志上设置一个检查点，返回当前的日志位置。
+ * @details
+ * 同一条指令在两个检查点之间只记录一次；检查点之后再被修改时会重新追加，
+ * 因此从任意检查点开始的日志后缀都包含了此后被修改的所有指令。
+ */
+int checkpoint_modifications(IRFunction *func) {
+  func->modified_generation++;
+  return func->modified_log.count;
+}
+
+/**
+ * @brief 设置接下来运行的遍从日志的哪个位置开始处理；-1 表示处理整个函数。
+ */
+void set_modification_seed(IRFunction *func, int position) {
+  func->modified_seed = func->track_modifications ? position : -1;
+}
+
+/**
+ * @brief 把一条指令记入其所在函数的变更日志。
+ * @details
+ * 不在任何函数中的指令，或所在函数没有开启跟踪时，什么也不做。
+ * 原地改写指令（例如改变操作码）的遍需要自己调用它。
+ */
+void mark_instruction_modified(IRInstruction *instr) {
+  if (!instr || !instr->parent || !instr->parent->parent)
+    return;
+  IRFunction *func = instr->parent->parent;
+  if (!func->track_modifications ||
+      instr->modified_generation == func->modified_generation)
+    return;
+  instr->modified_generation = func->modified_generation;
+
+  // 日志在堆上按倍增扩容，由 end_modification_tracking 释放：从内存池分配时
+  // 每次扩容留下的旧数组都要等到模块销毁才会回收
+  ModifiedInstrLog *log = &func->modified_log;
+  if (log->count >= log->capacity) {
+    int new_capacity = log->capacity ? log->capacity * 2 : 64;
+    IRInstruction **items = (IRInstruction **)realloc(
+        log->items, (size_t)new_capacity * sizeof(IRInstruction *));
+    if (!items) {
+      // 内存不足时放弃增量记录，让各个遍退回到处理整个函数
+      end_modification_tracking(func);
+      return;
+    }
+    log->items = items;
+    log->capacity = new_capacity;
+  }
+  log->items[log->count++] = instr;
+}
+
+/**
+ * @brief 访问当前遍上次运行以来被其他遍修改、且仍在函数中的所有指令。
+ * @details 同一条指令可能被访问多次（在多个检查点区间内都被修改过）。
+ * @param func 目标函数。
+ * @param visitor 访问函数，可为 NULL（只计数）。
+ * @param user_data 传给访问函数的上下文。
+ * @return 被访问的指令数；没有可用的记录（跟踪未开启、或该遍还没有在
+ *         跟踪下运行过）时返回 -1，此时调用者应当处理整个函数。
+ */
+int visit_modified_instructions(IRFunction *func, InstructionVisitor visitor,
+                                void *user_data) {
+  if (!func->track_modifications || func->modified_seed < 0)
+    return -1;
+  int visited = 0;
+  const ModifiedInstrLog *log = &func->modified_log;
+  for (int i = func->modified_seed; i < log->count; i++) {
+    IRInstruction *instr = log->items[i];
+    if (instr->opcode == IR_OP_UNKNOWN || instr->parent == NULL)
+      continue; // 之后已被删除
+    if (visitor)
+      visitor(instr, user_data);
+    visited++;
+  }
+  return visited;
+}
+
+/**
+ * @brief (内部函数) 从给定内存池分配一个操作数并追加到指令末尾。
+ * @details `add_operand` 的实现；克隆出的指令尚未插入基本块，由调用者提供内存池。
+ */
+static IROperand *append_operand(IRInstruction *instr, OperandKind kind,
+                                 void *data_ptr, MemoryPool *pool) {
   if (!data_ptr)
     return NULL;
 
-  // 从指令的父级结构中获取内存池
-  MemoryPool *pool = instr->parent->parent->module->pool;
   IROperand *op = create_ir_operand(kind, data_ptr, instr, pool);
 
   // 将操作数添加到指令的操作数链表尾部
@@ -633,6 +804,7 @@ IROperand *add_operand(IRInstruction *instr, OperandKind kind, void *data_ptr) {
     instr->operand_tail = op;
   }
   instr->num_operands++;
+  mark_instruction_modified(instr);
 
   // 如果是值操作数，更新其 Use 链
   if (kind == IR_OP_KIND_VALUE) {
@@ -645,6 +817,25 @@ IROperand *add_operand(IRInstruction *instr, OperandKind kind, void *data_ptr) {
   return op;
 }
 
+/**
+ * @brief 向指令添加一个操作数，并正确维护所有相关链表。
+ * @details 这是一个核心的 IR 修改函数。它负责：
+ *          1. 创建 IROperand 对象。
+ *          2. 将操作数添加到指令的操作数双向链表的末尾（O(1) 效率）。
+ *          3. 如果操作数是 IRValue，将其添加到该值的 Use 链的头部。
+ * @param instr 目标指令。
+ * @param kind 操作数的种类。
+ * @param data_ptr 指向操作数数据的指针 (IRValue* 或 IRBasicBlock*)。
+ * @return 新创建的 IROperand。
+ */
+IROperand *add_operand(IRInstruction *instr, OperandKind kind, void *data_ptr) {
+  assert(instr->parent && instr->parent->parent &&
+         "Insert the instruction before adding operands to it.");
+  // 从指令的父级结构中获取内存池
+  return append_operand(instr, kind, data_ptr,
+                        instr->parent->parent->module->pool);
+}
+
 /**
  * @brief (类型安全封装) 向指令添加一个值类型的操作数。
  */
@@ -710,6 +901,7 @@ void remove_operand(IROperand *op) {
   }
 
   instr->num_operands--;
+  mark_instruction_modified(instr);
 }
 
 /**
@@ -736,6 +928,7 @@ void change_operand_value(IROperand *op, IRValue *new_val) {
   } else {
     op->next_use = NULL;
   }
+  mark_instruction_modified(op->user);
 }
 
 /**
@@ -803,6 +996,7 @@ void insert_instr_after(IRInstruction *new_instr, IRInstruction *pos) {
     bb->tail = new_instr; // pos 是原尾部
   }
   pos->next = new_instr;
+  mark_instruction_modified(new_instr);
 }
 
 /**
@@ -825,6 +1019,7 @@ void insert_instr_before(IRInstruction *new_instr, IRInstruction *pos) {
     bb->head = new_instr; // pos 是原头部
   }
   pos->prev = new_instr;
+  mark_instruction_modified(new_instr);
 }
 
 /**
@@ -848,6 +1043,7 @@ void add_instr_to_bb_end(IRBasicBlock *bb, IRInstruction *instr) {
       bb->head = instr;
     }
     bb->tail = instr;
+    mark_instruction_modified(instr);
   }
 
   if (bb->parent) {
@@ -861,7 +1057,8 @@ void add_instr_to_bb_end(IRBasicBlock *bb, IRInstruction *instr) {
  * @param instr 要删除的指令。
  */
 void erase_instruction(IRInstruction *instr) {
-  if (!instr || instr->opcode == IR_OP_UNKNOWN)
+  // 已删除的指令没有所在块；仅被 mark_instruction_for_removal 标记的指令仍需删除
+  if (!instr || (instr->opcode == IR_OP_UNKNOWN && !instr->parent))
     return;
 
   // 记录指令删除操作
@@ -887,6 +1084,14 @@ void erase_instruction(IRInstruction *instr) {
     instr->parent->parent->instruction_count--;
   }
 
+  // 操作数的定义指令少了一个使用者（可能变为死代码或单使用），记为已修改
+  for (IROperand *op = instr->operand_head; op; op = op->next_in_instr) {
+    if (op->kind == IR_OP_KIND_VALUE && op->data.value &&
+        op->data.value->def_instr) {
+      mark_instruction_modified(op->data.value->def_instr);
+    }
+  }
+
   // 断开此指令与其所有操作数之间的Use-Def链接
   while (instr->operand_head) {
     remove_operand(instr->operand_head);
@@ -1070,6 +1275,7 @@ void change_terminator_target(IRInstruction *term, IRBasicBlock *from,
   for (IROperand *op = term->operand_head; op; op = op->next_in_instr) {
     if (op->kind == IR_OP_KIND_BASIC_BLOCK && op->data.bb == from) {
       op->data.bb = to;
+      mark_instruction_modified(term);
     }
   }
 }
@@ -1199,6 +1405,7 @@ void change_phi_predecessor(IRBasicBlock *block, IRBasicBlock *from,
       assert(block_op->kind == IR_OP_KIND_BASIC_BLOCK);
       if (block_op->data.bb == from) {
         block_op->data.bb = to;
+        mark_instruction_modified(instr);
       }
     }
   }
@@ -1434,9 +1641,10 @@ IRInstruction *clone_instruction(IRInstruction *instr, MemoryPool *pool) {
 
   // 深拷贝操作数链表，但不链接Use-Def链
   for (IROperand *op = instr->operand_head; op; op = op->next_in_instr) {
-    add_operand(new_instr, op->kind,
-                (op->kind == IR_OP_KIND_VALUE) ? (void *)op->data.value
-                                               : (void *)op->data.bb);
+    append_operand(new_instr, op->kind,
+                   (op->kind == IR_OP_KIND_VALUE) ? (void *)op->data.value
+                                                  : (void *)op->data.bb,
+                   pool);
   }
 
   // dest需要由调用者重新分配和设置
@@ -1484,11 +1692,11 @@ IRInstruction *clone_instruction_with_remap(IRInstruction *instr,
     if (op->kind == IR_OP_KIND_VALUE) {
       // 从重映射表中查找新值，如果找不到则使用原值
       IRValue *remapped_val = remap_value(remap, op->data.value);
-      add_value_operand(new_instr, remapped_val);
+      append_operand(new_instr, IR_OP_KIND_VALUE, remapped_val, pool);
     } else { // IR_OP_KIND_BASIC_BLOCK
       // 基本块通常不需要重映射，直接复制
       // (如果优化涉及到块的克隆，则也需要对块进行重映射)
-      add_bb_operand(new_instr, op->data.bb);
+      append_operand(new_instr, IR_OP_KIND_BASIC_BLOCK, op->data.bb, pool);
     }
   }
 
@@ -1624,6 +1832,7 @@ void replace_all_uses_with_block(IRBasicBlock *from, IRBasicBlock *to) {
       for (IROperand *op = instr->operand_head; op; op = op->next_in_instr) {
         if (op->kind == IR_OP_KIND_BASIC_BLOCK && op->data.bb == from) {
           op->data.bb = to;
+          mark_instruction_modified(instr);
         }
       }
     }
@@ -1712,9 +1921,10 @@ void move_instructions_to_block_end(IRBasicBlock *from, IRBasicBlock *to) {
     to->tail = from->tail;
   }
 
-  // 更新所有移动指令的 parent 指针
+  // 更新所有移动指令的 parent 指针；指令换了块，支配关系随之改变
   for (IRInstruction *instr = from->head; instr; instr = instr->next) {
     instr->parent = to;
+    mark_instruction_modified(instr);
   }
 
   // 清空 from 块
@@ -66,13 +66,10 @@ bool run_adce(IRFunction* func) {
     MemoryPool* pool = func->module->pool;
     bool changed = false;
     
-    // 使用缓存的指令计数，避免重复遍历
+    // 指令信息数组按指令下标访问，必须是准确的指令数：并非所有插入指令的
+    // 途径都维护 func->instruction_count（例如内联器直接追加克隆的指令）
+    recalculate_instruction_count(func);
     int total_instructions = func->instruction_count;
-    if (total_instructions == 0) {
-        // 如果缓存值为0，重新计算以确保准确性
-        recalculate_instruction_count(func);
-        total_instructions = func->instruction_count;
-    }
     
     Worklist* wl = create_worklist(pool, total_instructions);
     bool* live_blocks = (bool*)pool_alloc_z(pool, func->block_count * sizeof(bool));
@@ -126,6 +123,15 @@ bool run_adce(IRFunction* func) {
     }
     
     // --- 6. 清扫阶段：移除所有未被标记为活的指令 ---
+    // 死指令之间可能互相使用（例如循环中的 PHI 与其递增指令），
+    // 先断开所有死指令的操作数，再逐条删除，删除顺序就无关紧要了。
+    for (IRBasicBlock* bb = func->blocks; bb; bb = bb->next_in_func) {
+        for (IRInstruction* instr = bb->head; instr; instr = instr->next) {
+            if (!instr->is_live) {
+                while (instr->operand_head) remove_operand(instr->operand_head);
+            }
+        }
+    }
     int removed_count = 0;
     for (IRBasicBlock* bb = func->blocks; bb; bb = bb->next_in_func) {
         IRInstruction* instr = bb->head;
@@ -239,6 +245,7 @@ static void propagate_data_flow_liveness(IRInstruction* instr, Worklist* wl, boo
     } else {
         // Regular instruction: mark all operand definitions as live
         for (IROperand* op = instr->operand_head; op; op = op->next_in_instr) {
+            if (op->kind != IR_OP_KIND_VALUE) continue; // 分支目标不是值
             IRValue* val = op->data.value;
             if (val && !val->is_constant && val->def_instr) {
                 mark_instruction_live(val->def_instr, wl, live_blocks, block_info);
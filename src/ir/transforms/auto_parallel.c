@@ -0,0 +1,763 @@
+/**
+ * @file auto_parallel.c
+ * @brief 实现 DOALL 循环的自动并行化遍。
+ * @details
+ * 本遍识别迭代之间没有数据依赖、也不做 I/O 的计数循环，把循环体整体移动到
+ * 一个以迭代区间 `[lo, hi)` 为参数的工作函数中，并在原位置调用 sylib 的
+ * `_sysy_parallel_for`，由运行时线程池切分迭代空间。
+ *
+ * 合法性分析刻意保持保守：
+ * - 只处理 `for (i = start; i < limit; i++)` 形状（SysY 的 while 循环经
+ *   mem2reg 后的标准形式），循环头即唯一的退出点；
+ * - 依赖分析基于 GEP 下标路径：每次迭代的写入必须落在由 `iv` 下标选出的
+ *   互不相交切片上，读取已写数组只能读取本次迭代写入的同一切片；
+ * - 归约只支持 i32 的 `+` 与 `*`，二者在补码下满足结合律与交换律，
+ *   线程间按区间顺序合并即可得到与串行执行相同的结果。
+ *
+ * 工作函数与原函数之间没有闭包机制，循环外定义的活跃值通过模块级全局槽
+ * 传递：原函数在调用运行时前写入，工作函数在入口处读出。由于并行区域
+ * 不可重入（循环内没有调用），全局槽不会被并发覆盖。
+ */
+#include "ir/transforms/auto_parallel.h"
+#include "ast.h"
+#include "ir/analysis/cfg_builder.h"
+#include "ir/analysis/dominators.h"
+#include "ir/analysis/loop_analysis.h"
+#include "ir/ir_builder.h"
+#include "ir/ir_utils.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+
+/// 单个工作函数允许通过全局槽传递的活跃值上限
+#define MAX_LIVE_INS 32
+
+/**
+ * @brief 一个通过合法性检查的 DOALL 循环的描述。
+ */
+typedef struct {
+  Loop *loop;
+  IRBasicBlock *preheader;
+  IRBasicBlock *header;
+  IRBasicBlock *latch;
+  IRBasicBlock *exit;
+  IRInstruction *iv_phi;   ///< 归纳变量 PHI
+  IRInstruction *cmp;      ///< `icmp slt iv, limit`
+  IRInstruction *red_phi;  ///< 归约 PHI，可为 NULL
+  SysyReduceOp reduce_op;  ///< 归约操作
+  IRValue *start;          ///< 归纳变量初值
+  IRValue *limit;          ///< 循环上界（不含）
+  IRValue *red_init;       ///< 归约初值
+} DoallLoop;
+
+/**
+ * @brief 一条内存访问的地址路径：基址加上自外向内展开的 GEP 下标序列。
+ * @details 相邻 GEP 之间以 NULL 分隔，保证不同嵌套形状的路径不会被误判为相同。
+ */
+typedef struct {
+  IRValue *base;
+  IRValue *indices[32];
+  int count;
+} AccessPath;
+
+// --- 静态函数声明 ---
+static bool parallelize_function(IRFunction *func, IRValue *runtime_entry,
+                                 int *worker_id);
+static bool try_loop_recursively(Loop *loop, IRValue *runtime_entry,
+                                 int *worker_id);
+static bool analyze_loop(Loop *loop, DoallLoop *info);
+static bool analyze_header(DoallLoop *info);
+static bool analyze_body(DoallLoop *info);
+static bool analyze_memory(DoallLoop *info, Worklist *loads, Worklist *stores);
+static bool build_access_path(IRValue *ptr, AccessPath *path);
+static int find_iv_slice(DoallLoop *info, const AccessPath *path);
+static bool same_slice(const AccessPath *a, int a_slice, const AccessPath *b,
+                       int b_slice);
+static bool same_index(IRValue *a, IRValue *b);
+static void outline_loop(IRFunction *func, DoallLoop *info,
+                         IRValue *runtime_entry, int worker_id);
+static IRBasicBlock *append_block(IRFunction *func, const char *label);
+static IRValue *create_global_slot(IRModule *module, const char *name,
+                                   Type *type);
+static bool in_loop(Loop *loop, IRBasicBlock *bb);
+static bool defined_in_loop(Loop *loop, IRValue *val);
+static IRValue *get_operand_value(IRInstruction *instr, int index);
+static bool is_int_type(Type *type);
+
+// --- 主入口函数 ---
+bool run_auto_parallel(IRModule *module) {
+  if (!module)
+    return false;
+
+  MemoryPool *pool = module->pool;
+  Type *int_type = create_basic_type(BASIC_INT, false, pool);
+  Type *body_params[] = {int_type, int_type};
+  Type *body_type = create_function_type(int_type, body_params, 2, false, pool);
+  Type *entry_params[] = {int_type, int_type,
+                          create_pointer_type(body_type, false, pool),
+                          int_type, int_type};
+  Type *entry_type =
+      create_function_type(int_type, entry_params, 5, false, pool);
+
+  IRValue *runtime_entry = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+  runtime_entry->name = pool_strdup(pool, SYSY_PARALLEL_FOR_ENTRY);
+  runtime_entry->type = create_pointer_type(entry_type, false, pool);
+  runtime_entry->is_global = true;
+
+  // 先记录原有函数，新生成的工作函数会被插到模块函数链表头部，无需再处理
+  Worklist *functions = create_worklist(pool, 16);
+  for (IRFunction *func = module->functions; func; func = func->next) {
+    if (func->entry)
+      worklist_add(functions, func);
+  }
+
+  int worker_id = 0;
+  bool changed = false;
+  for (int i = 0; i < functions->count; ++i) {
+    changed |= parallelize_function((IRFunction *)functions->items[i],
+                                    runtime_entry, &worker_id);
+  }
+  destroy_worklist(functions);
+
+  if (module->log_config) {
+    LOG_INFO(module->log_config, LOG_CATEGORY_IR_OPT,
+             "Auto-parallelization: %d loops outlined", worker_id);
+  }
+  return changed;
+}
+
+// --- 函数与循环级驱动 ---
+
+/**
+ * @brief 反复对函数做循环分析并尝试并行化，直到没有可处理的循环。
+ * @details 每次变换都会改变 CFG，因此成功一次后需重新分析整个函数。
+ */
+static bool parallelize_function(IRFunction *func, IRValue *runtime_entry,
+                                 int *worker_id) {
+  bool changed = false;
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    build_cfg(func);
+    compute_dominators(func);
+    find_loops(func);
+    for (Loop *loop = func->top_level_loops; loop && !progress;
+         loop = loop->next) {
+      progress = try_loop_recursively(loop, runtime_entry, worker_id);
+    }
+    changed |= progress;
+  }
+  return changed;
+}
+
+/**
+ * @brief 自外向内尝试并行化循环。
+ * @details 外层循环并行化后内层循环随之进入工作函数，粒度最大；
+ *          外层不合法时再尝试各个子循环。
+ */
+static bool try_loop_recursively(Loop *loop, IRValue *runtime_entry,
+                                 int *worker_id) {
+  DoallLoop info;
+  if (analyze_loop(loop, &info)) {
+    outline_loop(info.header->parent, &info, runtime_entry, (*worker_id)++);
+    return true;
+  }
+  for (int i = 0; i < loop->num_sub_loops; ++i) {
+    if (try_loop_recursively(loop->sub_loops[i], runtime_entry, worker_id))
+      return true;
+  }
+  return false;
+}
+
+// --- 合法性分析 ---
+
+/**
+ * @brief 检查循环是否为可并行化的 DOALL 循环，并填充描述信息。
+ */
+static bool analyze_loop(Loop *loop, DoallLoop *info) {
+  memset(info, 0, sizeof(*info));
+  info->loop = loop;
+  info->header = loop->header;
+
+  if (loop->num_back_edges != 1 || loop->num_exit_blocks != 1)
+    return false;
+  info->latch = loop->back_edges[0];
+  info->exit = loop->exit_blocks[0];
+
+  // 前置头：循环头唯一的循环外前驱，且其唯一后继为循环头
+  IRBasicBlock *header = info->header;
+  for (int i = 0; i < header->num_predecessors; ++i) {
+    IRBasicBlock *pred = header->predecessors[i];
+    if (in_loop(loop, pred))
+      continue;
+    if (info->preheader)
+      return false;
+    info->preheader = pred;
+  }
+  if (!info->preheader || info->preheader->num_successors != 1)
+    return false;
+
+  // 只有循环头可以离开循环
+  for (int i = 0; i < loop->num_blocks; ++i) {
+    IRBasicBlock *bb = loop->blocks[i];
+    if (bb == header)
+      continue;
+    for (int j = 0; j < bb->num_successors; ++j) {
+      if (!in_loop(loop, bb->successors[j]))
+        return false;
+    }
+  }
+
+  return analyze_header(info) && analyze_body(info);
+}
+
+/**
+ * @brief 识别循环头中的归纳变量、退出条件与归约变量。
+ */
+static bool analyze_header(DoallLoop *info) {
+  Loop *loop = info->loop;
+  IRBasicBlock *header = info->header;
+  IRInstruction *br = header->tail;
+  if (!br || br->opcode != IR_OP_BR || br->num_operands != 3)
+    return false;
+
+  // 条件跳转的真分支必须留在循环内，假分支离开循环
+  IRBasicBlock *true_bb = br->operand_head->next_in_instr->data.bb;
+  IRBasicBlock *false_bb = br->operand_tail->data.bb;
+  if (!in_loop(loop, true_bb) || false_bb != info->exit)
+    return false;
+
+  // 剥离前端生成的 `icmp ne (zext cond), 0` 包装
+  IRValue *cond = get_operand_value(br, 0);
+  IRInstruction *def = cond ? cond->def_instr : NULL;
+  if (def && def->opcode == IR_OP_ICMP && def->opcode_cond &&
+      strcmp(def->opcode_cond, "ne") == 0) {
+    IRValue *rhs = get_operand_value(def, 1);
+    IRValue *lhs = get_operand_value(def, 0);
+    if (!rhs || !rhs->is_constant || rhs->int_val != 0 || !lhs ||
+        !lhs->def_instr || lhs->def_instr->opcode != IR_OP_ZEXT)
+      return false;
+    cond = get_operand_value(lhs->def_instr, 0);
+    def = cond ? cond->def_instr : NULL;
+  }
+  if (!def || def->opcode != IR_OP_ICMP || !def->opcode_cond ||
+      strcmp(def->opcode_cond, "slt") != 0 || def->parent != header)
+    return false;
+  info->cmp = def;
+
+  IRValue *iv = get_operand_value(def, 0);
+  info->limit = get_operand_value(def, 1);
+  if (!iv || !iv->def_instr || iv->def_instr->opcode != IR_OP_PHI ||
+      iv->def_instr->parent != header || !is_int_type(iv->type))
+    return false;
+  if (!info->limit || defined_in_loop(loop, info->limit))
+    return false;
+  info->iv_phi = iv->def_instr;
+
+  // 循环头只能包含 PHI、比较链和终结符，否则移动后语义会改变
+  for (IRInstruction *instr = header->head; instr; instr = instr->next) {
+    if (instr->opcode == IR_OP_PHI || instr == br)
+      continue;
+    if (instr->opcode != IR_OP_ICMP && instr->opcode != IR_OP_ZEXT)
+      return false;
+  }
+
+  // 归纳变量：前置头传入初值，回边传入 iv + 1
+  info->start = phi_get_incoming_value_for_block(info->iv_phi, info->preheader);
+  IRValue *next = phi_get_incoming_value_for_block(info->iv_phi, info->latch);
+  if (!info->start || !next || !next->def_instr ||
+      next->def_instr->opcode != IR_OP_ADD)
+    return false;
+  IRValue *a = get_operand_value(next->def_instr, 0);
+  IRValue *b = get_operand_value(next->def_instr, 1);
+  IRValue *step = (a == iv) ? b : (b == iv) ? a : NULL;
+  if (!step || !step->is_constant || step->int_val != 1)
+    return false;
+
+  // 其余 PHI 必须是可识别的归约变量，且至多一个
+  for (IRInstruction *phi = header->head; phi && phi->opcode == IR_OP_PHI;
+       phi = phi->next) {
+    if (phi == info->iv_phi)
+      continue;
+    if (info->red_phi || !is_int_type(phi->dest->type) ||
+        phi->num_operands != 4)
+      return false;
+
+    IRValue *init = phi_get_incoming_value_for_block(phi, info->preheader);
+    IRValue *update = phi_get_incoming_value_for_block(phi, info->latch);
+    if (!init || !update || !update->def_instr ||
+        !in_loop(loop, update->def_instr->parent))
+      return false;
+    IRInstruction *op = update->def_instr;
+    if (op->opcode == IR_OP_ADD) {
+      info->reduce_op = SYSY_REDUCE_ADD;
+    } else if (op->opcode == IR_OP_MUL) {
+      info->reduce_op = SYSY_REDUCE_MUL;
+    } else {
+      return false;
+    }
+    IRValue *x = get_operand_value(op, 0) == phi->dest
+                     ? get_operand_value(op, 1)
+                     : get_operand_value(op, 0);
+    if (x == phi->dest ||
+        (get_operand_value(op, 0) != phi->dest &&
+         get_operand_value(op, 1) != phi->dest))
+      return false;
+
+    // r 在循环内只能被归约运算使用，归约结果只能回流到 PHI
+    for (IROperand *use = phi->dest->use_list_head; use; use = use->next_use) {
+      if (in_loop(loop, use->user->parent) && use->user != op)
+        return false;
+    }
+    for (IROperand *use = update->use_list_head; use; use = use->next_use) {
+      if (use->user != phi)
+        return false;
+    }
+    info->red_phi = phi;
+    info->red_init = init;
+  }
+  return true;
+}
+
+/**
+ * @brief 检查循环体中的指令：无调用、无局部分配、无意外的循环外使用，
+ *        并收集访存指令用于依赖分析。
+ */
+static bool analyze_body(DoallLoop *info) {
+  Loop *loop = info->loop;
+  MemoryPool *pool = info->header->parent->module->pool;
+  Worklist *loads = create_worklist(pool, 16);
+  Worklist *stores = create_worklist(pool, 16);
+  IRValue *live_ins[MAX_LIVE_INS];
+  int num_live_ins = 0;
+  bool ok = true;
+
+  for (int i = 0; i < loop->num_blocks && ok; ++i) {
+    for (IRInstruction *instr = loop->blocks[i]->head; instr && ok;
+         instr = instr->next) {
+      switch (instr->opcode) {
+      case IR_OP_CALL:   // 可能产生 I/O 或任意副作用
+      case IR_OP_ALLOCA: // 栈分配无法跨函数移动
+      case IR_OP_RET:
+        ok = false;
+        break;
+      case IR_OP_LOAD:
+        worklist_add(loads, instr);
+        break;
+      case IR_OP_STORE:
+        worklist_add(stores, instr);
+        break;
+      default:
+        break;
+      }
+      if (!ok)
+        continue;
+
+      // 统计需要经全局槽传入工作函数的循环外值（略有高估，不影响正确性）
+      for (IROperand *op = instr->operand_head; op && ok;
+           op = op->next_in_instr) {
+        IRValue *val = op->kind == IR_OP_KIND_VALUE ? op->data.value : NULL;
+        if (!val || val->is_constant || val->is_global ||
+            defined_in_loop(loop, val))
+          continue;
+        int k = 0;
+        while (k < num_live_ins && live_ins[k] != val)
+          k++;
+        if (k < num_live_ins)
+          continue;
+        if (num_live_ins == MAX_LIVE_INS)
+          ok = false;
+        else
+          live_ins[num_live_ins++] = val;
+      }
+      if (!ok || !instr->dest)
+        continue;
+
+      // 循环内定义的值只有归约 PHI 可以在循环外使用
+      for (IROperand *use = instr->dest->use_list_head; use;
+           use = use->next_use) {
+        if (!in_loop(loop, use->user->parent) && instr != info->red_phi) {
+          ok = false;
+          break;
+        }
+      }
+    }
+  }
+
+  if (ok)
+    ok = analyze_memory(info, loads, stores);
+  destroy_worklist(loads);
+  destroy_worklist(stores);
+  return ok;
+}
+
+/**
+ * @brief 基于下标路径证明循环内的访存不存在跨迭代依赖。
+ */
+static bool analyze_memory(DoallLoop *info, Worklist *loads,
+                           Worklist *stores) {
+  AccessPath store_paths[16];
+  int store_slices[16];
+  if (stores->count > 16)
+    return false;
+
+  // 1. 每条 store 都写入由 iv 选出的、与其他迭代不相交的切片
+  for (int i = 0; i < stores->count; ++i) {
+    IRInstruction *store = (IRInstruction *)stores->items[i];
+    AccessPath *path = &store_paths[i];
+    if (!build_access_path(get_operand_value(store, 1), path))
+      return false;
+
+    // 基址必须是独立的内存对象：全局变量或循环外的局部数组。
+    // 指针参数之间可能互为别名，无法据此证明写入不相交。
+    IRValue *base = path->base;
+    bool is_object = base->is_global ||
+                     (base->def_instr &&
+                      base->def_instr->opcode == IR_OP_ALLOCA &&
+                      !defined_in_loop(info->loop, base));
+    if (!is_object)
+      return false;
+    store_slices[i] = find_iv_slice(info, path);
+    if (store_slices[i] < 0)
+      return false;
+
+    // 写同一对象的 store 必须选出同一种切片：iv 位置相同、之前的下标相等，
+    // 否则一次迭代写入的元素可能落在另一次迭代的切片中
+    for (int j = 0; j < i; ++j) {
+      if (store_paths[j].base != base)
+        continue;
+      if (!same_slice(path, store_slices[i], &store_paths[j], store_slices[j]))
+        return false;
+    }
+  }
+
+  // 2. 读取：未被写入的对象可任意读取；被写入的对象只能读取本次迭代的切片
+  for (int i = 0; i < loads->count; ++i) {
+    IRInstruction *load = (IRInstruction *)loads->items[i];
+    AccessPath path;
+    if (!build_access_path(get_operand_value(load, 0), &path))
+      return false;
+
+    IRValue *base = path.base;
+    bool is_object = base->is_global || (base->def_instr &&
+                                         base->def_instr->opcode == IR_OP_ALLOCA);
+    if (!is_object) {
+      if (stores->count > 0)
+        return false;
+      continue;
+    }
+
+    // 必须落在写同一对象的每一条 store 的切片中
+    for (int j = 0; j < stores->count; ++j) {
+      if (store_paths[j].base != base)
+        continue;
+      if (!same_slice(&path, store_slices[j], &store_paths[j],
+                      store_slices[j]))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 从一个地址值向上追溯 GEP 链，构造其访问路径。
+ * @return 路径过长时返回 false。
+ */
+static bool build_access_path(IRValue *ptr, AccessPath *path) {
+  IRInstruction *chain[16];
+  int depth = 0;
+  while (ptr && ptr->def_instr &&
+         ptr->def_instr->opcode == IR_OP_GETELEMENTPTR) {
+    if (depth == 16)
+      return false;
+    chain[depth++] = ptr->def_instr;
+    ptr = get_operand_value(ptr->def_instr, 0);
+  }
+  if (!ptr)
+    return false;
+
+  path->base = ptr;
+  path->count = 0;
+  for (int d = depth - 1; d >= 0; --d) {
+    IROperand *op = chain[d]->operand_head->next_in_instr;
+    // 后续 GEP 的首个下标是指针偏移，非零时地址可能移出前面选出的切片
+    if (d < depth - 1 && op) {
+      IRValue *offset = op->data.value;
+      if (!offset || !offset->is_constant || !is_int_type(offset->type) ||
+          offset->int_val != 0)
+        return false;
+    }
+    for (; op; op = op->next_in_instr) {
+      if (path->count == 31)
+        return false;
+      path->indices[path->count++] = op->data.value;
+    }
+    if (d > 0) {
+      if (path->count == 31)
+        return false;
+      path->indices[path->count++] = NULL;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 查找路径中第一个等于 iv 的下标，要求其之前的下标均为循环不变量。
+ * @return 下标位置；不满足条件时返回 -1。
+ */
+static int find_iv_slice(DoallLoop *info, const AccessPath *path) {
+  for (int k = 0; k < path->count; ++k) {
+    IRValue *idx = path->indices[k];
+    if (idx == info->iv_phi->dest)
+      return k;
+    if (idx && defined_in_loop(info->loop, idx))
+      return -1;
+  }
+  return -1;
+}
+
+/**
+ * @brief 判断路径 a 是否落在由 b 的第 b_slice 个下标（iv）选出的切片中：
+ *        iv 位置相同，且之前的下标两两相等。
+ */
+static bool same_slice(const AccessPath *a, int a_slice, const AccessPath *b,
+                       int b_slice) {
+  if (a_slice != b_slice || a->count <= a_slice)
+    return false;
+  for (int k = 0; k <= a_slice; ++k) {
+    if (!same_index(a->indices[k], b->indices[k]))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 判断两个下标是否必然相等（同一个值或相等的整型常量）。
+ */
+static bool same_index(IRValue *a, IRValue *b) {
+  if (a == b)
+    return true;
+  if (!a || !b)
+    return false;
+  return a->is_constant && b->is_constant && is_int_type(a->type) &&
+         is_int_type(b->type) && a->int_val == b->int_val;
+}
+
+// --- 变换 ---
+
+/**
+ * @brief 将循环外提为工作函数，并在原位置插入运行时调用。
+ */
+static void outline_loop(IRFunction *func, DoallLoop *info,
+                         IRValue *runtime_entry, int worker_id) {
+  IRModule *module = func->module;
+  MemoryPool *pool = module->pool;
+  Loop *loop = info->loop;
+  Type *int_type = create_basic_type(BASIC_INT, false, pool);
+  char name_buf[256];
+
+  // 1. 创建工作函数 i32 <func>.par.<k>(i32 lo, i32 hi)
+  snprintf(name_buf, sizeof(name_buf), "%s.par.%d", func->name, worker_id);
+  IRFunction *worker = create_ir_function(name_buf, int_type, module, pool);
+  worker->num_args = 2;
+  worker->args = (IRValue **)pool_alloc(pool, 2 * sizeof(IRValue *));
+  const char *arg_names[] = {"lo", "hi"};
+  for (int i = 0; i < 2; ++i) {
+    worker->args[i] = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+    worker->args[i]->name = pool_strdup(pool, arg_names[i]);
+    worker->args[i]->type = int_type;
+  }
+  IRValue *lo = worker->args[0];
+  IRValue *hi = worker->args[1];
+
+  IRValue *worker_val = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+  worker_val->name = worker->name;
+  worker_val->is_global = true;
+  worker_val->type = runtime_entry->type->pointer.element_type->function
+                         .param_types[2];
+
+  IRBasicBlock *entry = append_block(worker, "par.entry");
+  worker->entry = entry;
+
+  // 2. 把循环块按原布局顺序移入工作函数
+  Worklist *moved = create_worklist(pool, loop->num_blocks);
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    if (in_loop(loop, bb))
+      worklist_add(moved, bb);
+  }
+  for (int i = 0; i < moved->count; ++i) {
+    IRBasicBlock *bb = (IRBasicBlock *)moved->items[i];
+    remove_block_from_function(bb);
+    bb->parent = worker;
+    bb->prev_in_func = worker->tail;
+    bb->next_in_func = NULL;
+    worker->tail->next_in_func = bb;
+    worker->tail = bb;
+    worker->block_count++;
+  }
+  destroy_worklist(moved);
+  IRBasicBlock *ret_bb = append_block(worker, "par.exit");
+
+  // 3. 改写循环头：区间由参数给出，归约从单位元开始
+  IRValue *identity = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+  identity->is_constant = true;
+  identity->type = int_type;
+  identity->int_val = info->reduce_op == SYSY_REDUCE_MUL ? 1 : 0;
+  for (IRInstruction *phi = info->header->head; phi && phi->opcode == IR_OP_PHI;
+       phi = phi->next) {
+    for (IROperand *op = phi->operand_head; op && op->next_in_instr;
+         op = op->next_in_instr->next_in_instr) {
+      if (op->next_in_instr->data.bb != info->preheader)
+        continue;
+      change_operand_value(op, phi == info->iv_phi ? lo : identity);
+    }
+  }
+  change_phi_predecessor(info->header, info->preheader, entry);
+  change_operand_value(info->cmp->operand_head->next_in_instr, hi);
+  change_terminator_target(info->header->tail, info->exit, ret_bb);
+
+  // 4. 为循环外定义的活跃值分配全局槽，在工作函数入口处读出
+  IRBuilder worker_builder;
+  ir_builder_init(&worker_builder, worker);
+  ir_builder_set_insertion_block(&worker_builder, entry);
+  IRValue *live_ins[MAX_LIVE_INS];
+  IRValue *slots[MAX_LIVE_INS];
+  IRValue *reloads[MAX_LIVE_INS];
+  int num_live_ins = 0;
+  for (IRBasicBlock *bb = entry->next_in_func; bb != ret_bb;
+       bb = bb->next_in_func) {
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next) {
+      for (IROperand *op = instr->operand_head; op; op = op->next_in_instr) {
+        IRValue *val = op->kind == IR_OP_KIND_VALUE ? op->data.value : NULL;
+        if (!val || val->is_constant || val->is_global || val == lo ||
+            val == hi)
+          continue;
+        if (val->def_instr && val->def_instr->parent &&
+            val->def_instr->parent->parent == worker)
+          continue;
+
+        int slot = 0;
+        while (slot < num_live_ins && live_ins[slot] != val)
+          slot++;
+        if (slot == num_live_ins) {
+          // analyze_body 已保证活跃值数量不超过 MAX_LIVE_INS
+          snprintf(name_buf, sizeof(name_buf), "%s.env.%d", worker->name,
+                   slot);
+          slots[slot] = create_global_slot(module, name_buf, val->type);
+          reloads[slot] =
+              ir_builder_create_load(&worker_builder, slots[slot], "par.env")
+                  ->dest;
+          live_ins[slot] = val;
+          num_live_ins++;
+        }
+        change_operand_value(op, reloads[slot]);
+      }
+    }
+  }
+  ir_builder_create_br(&worker_builder, info->header);
+  ir_builder_set_insertion_block(&worker_builder, ret_bb);
+  ir_builder_create_ret(&worker_builder,
+                        info->red_phi ? info->red_phi->dest : identity);
+
+  // 5. 在原函数中用运行时调用替换循环
+  IRBuilder builder;
+  ir_builder_init(&builder, func);
+  IRBasicBlock *call_bb = ir_builder_create_block(&builder, "par.call");
+  insert_block_after(call_bb, info->preheader);
+  change_terminator_target(info->preheader->tail, info->header, call_bb);
+  ir_builder_set_insertion_block(&builder, call_bb);
+  for (int i = 0; i < num_live_ins; ++i)
+    ir_builder_create_store(&builder, live_ins[i], slots[i]);
+
+  IRValue *args[] = {
+      info->start, info->limit, worker_val,
+      ir_builder_create_const_int(&builder, info->reduce_op),
+      info->red_phi ? info->red_init : ir_builder_create_const_int(&builder, 0)};
+  IRInstruction *call =
+      ir_builder_create_call(&builder, runtime_entry, args, 5, "par.res");
+  ir_builder_create_br(&builder, info->exit);
+  change_phi_predecessor(info->exit, info->header, call_bb);
+
+  // 6. 循环外对归约变量的使用改为读取合并后的结果
+  if (info->red_phi) {
+    Worklist *outside_uses = create_worklist(pool, 8);
+    for (IROperand *use = info->red_phi->dest->use_list_head; use;
+         use = use->next_use) {
+      if (use->user->parent && use->user->parent->parent == func)
+        worklist_add(outside_uses, use);
+    }
+    for (int i = 0; i < outside_uses->count; ++i)
+      change_operand_value((IROperand *)outside_uses->items[i], call->dest);
+    destroy_worklist(outside_uses);
+  }
+
+  link_function_to_module(worker, module);
+  build_cfg(worker);
+  recalculate_instruction_count(worker);
+  recalculate_instruction_count(func);
+
+  if (module->log_config) {
+    LOG_DEBUG(module->log_config, LOG_CATEGORY_IR_OPT,
+              "Auto-parallel: outlined loop %s of @%s into @%s "
+              "(%d live-ins, reduce op %d)",
+              info->header->label, func->name, worker->name, num_live_ins,
+              (int)info->reduce_op);
+  }
+}
+
+// --- 辅助函数实现 ---
+
+/**
+ * @brief 创建一个基本块并追加到函数块链表的末尾。
+ */
+static IRBasicBlock *append_block(IRFunction *func, const char *label) {
+  IRBasicBlock *bb = create_ir_basic_block(label, func, func->module->pool);
+  if (func->tail) {
+    func->tail->next_in_func = bb;
+    bb->prev_in_func = func->tail;
+  } else {
+    func->blocks = bb;
+  }
+  func->tail = bb;
+  func->block_count++;
+  return bb;
+}
+
+/**
+ * @brief 创建一个零初始化的全局槽，并返回其地址值。
+ */
+static IRValue *create_global_slot(IRModule *module, const char *name,
+                                   Type *type) {
+  MemoryPool *pool = module->pool;
+  IRGlobalVariable *global = create_ir_global_variable(name, type, false, pool);
+  link_global_to_module(global, module);
+
+  IRValue *addr = (IRValue *)pool_alloc_z(pool, sizeof(IRValue));
+  addr->type = create_pointer_type(type, false, pool);
+  addr->is_global = true;
+  addr->name = global->name;
+  return addr;
+}
+
+static bool in_loop(Loop *loop, IRBasicBlock *bb) {
+  return bb && bitset_contains(loop->loop_blocks_bs, bb->post_order_id);
+}
+
+static bool defined_in_loop(Loop *loop, IRValue *val) {
+  return val && val->def_instr && val->def_instr->parent &&
+         in_loop(loop, val->def_instr->parent);
+}
+
+/**
+ * @brief 获取指令第 index 个值操作数，不存在时返回 NULL。
+ */
+static IRValue *get_operand_value(IRInstruction *instr, int index) {
+  IROperand *op = instr->operand_head;
+  for (int i = 0; op && i < index; ++i)
+    op = op->next_in_instr;
+  return (op && op->kind == IR_OP_KIND_VALUE) ? op->data.value : NULL;
+}
+
+static bool is_int_type(Type *type) {
+  return type && type->kind == TYPE_BASIC && type->basic == BASIC_INT;
+}
@@ -86,6 +86,13 @@ bool run_cse(IRFunction* func) {
     if (!func->blocks) {
         return false;
     }
+
+    // 本遍上次运行以来函数没有被其他遍修改过，不会出现新的公共子表达式。
+    // 新的冗余可能来自支配关系的变化而不只是被修改的指令，因此一旦有修改
+    // 仍然遍历整棵支配树。
+    if (visit_modified_instructions(func, NULL, NULL) == 0) {
+        return false;
+    }
     
     MemoryPool* pool = func->module->pool;
     bool changed = false;
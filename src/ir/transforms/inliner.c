@@ -65,6 +65,7 @@ static IRValue *get_callee_from_call(IRInstruction *call_instr);
 static IRFunction *find_function_in_module(IRModule *module,
                                            const char *func_name);
 static bool should_inline_function(InlinerContext *ctx, IRFunction *callee);
+static bool is_recursive_function(InlinerContext *ctx, IRFunction *callee);
 static void clone_and_remap_function_body(InlinerContext *ctx,
                                           IRInstruction *call_instr,
                                           IRFunction *callee,
@@ -83,9 +84,9 @@ bool run_inliner(IRFunction *func) {
     return false;
   }
   bool changed_overall = false;
+  // Builder 在每次内联时按调用者重新初始化
   InlinerContext ctx = {.module = func->module,
                         .call_stack = create_worklist(func->module->pool, 16)};
-  ir_builder_init(&ctx.builder, NULL); // Builder 将在每个函数内联时重新初始化
 
   // 使用不动点迭代，因为一次内联可能暴露新的内联机会
   while (true) {
@@ -179,7 +180,7 @@ static bool inline_call_site(InlinerContext *ctx, IRInstruction *call_instr) {
 
   ir_builder_init(&ctx->builder, caller);
   ValueMap val_map;
-  value_map_init(&val_map, ctx->module->pool);
+  value_map_init_opaque(&val_map, ctx->module->pool); // 键混合了基本块与值
 
   // 1. 克隆被调用函数的函数体，并重映射参数和指令
   clone_and_remap_function_body(ctx, call_instr, callee, &val_map);
@@ -218,17 +219,54 @@ static bool should_inline_function(InlinerContext *ctx, IRFunction *callee) {
   if (!callee || callee->entry == NULL)
     return false; // 不能内联外部函数或没有定义的函数
 
-  // 启发式规则 1：不内联递归调用
+  // 启发式规则 1：不内联递归调用。递归函数每内联一次都会带来新的自身调用，
+  // 不动点迭代将无法终止
   for (int i = 0; i < ctx->call_stack->count; ++i) {
     if (ctx->call_stack->items[i] == callee) {
       return false;
     }
   }
+  if (is_recursive_function(ctx, callee))
+    return false;
 
   // 启发式规则 2：只内联"小"函数
   return count_instructions(callee) <= INLINE_THRESHOLD;
 }
 
+// 判断 callee 是否能经由调用图（直接或间接）再次调用自身。
+static bool is_recursive_function(InlinerContext *ctx, IRFunction *callee) {
+  Worklist *pending = create_worklist(ctx->module->pool, 8);
+  Worklist *visited = create_worklist(ctx->module->pool, 8);
+  worklist_add(pending, callee);
+  while (!worklist_empty(pending)) {
+    IRFunction *func = (IRFunction *)worklist_pop(pending);
+    for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+      for (IRInstruction *instr = bb->head; instr; instr = instr->next) {
+        if (instr->opcode != IR_OP_CALL)
+          continue;
+        IRValue *callee_val = get_callee_from_call(instr);
+        if (!callee_val || !callee_val->name)
+          continue;
+        IRFunction *target =
+            find_function_in_module(ctx->module, callee_val->name);
+        if (!target || target->entry == NULL)
+          continue;
+        if (target == callee)
+          return true;
+        bool seen = false;
+        for (int i = 0; i < visited->count && !seen; ++i) {
+          seen = visited->items[i] == target;
+        }
+        if (!seen) {
+          worklist_add(visited, target);
+          worklist_add(pending, target);
+        }
+      }
+    }
+  }
+  return false;
+}
+
 // 克隆被调用函数的函数体，并建立值的映射关系。
 static void clone_and_remap_function_body(InlinerContext *ctx,
                                           IRInstruction *call_instr,
@@ -239,11 +277,14 @@ static void clone_and_remap_function_body(InlinerContext *ctx,
             "Inlining function %s with %d basic blocks", callee->name,
             callee->block_count);
 
-  // 步骤 A: 将被调用者的旧基本块映射到新创建的克隆块
+  // 步骤 A: 将被调用者的旧基本块映射到新创建的克隆块，克隆块依次链接在调用块之后
+  IRBasicBlock *insert_pos = call_instr->parent;
   for (IRBasicBlock *old_bb = callee->blocks; old_bb;
        old_bb = old_bb->next_in_func) {
     IRBasicBlock *new_bb =
         ir_builder_create_block(&ctx->builder, old_bb->label);
+    insert_block_after(new_bb, insert_pos);
+    insert_pos = new_bb;
 
     // 检查ValueMap是否需要扩容（在扩容前记录日志）
     if (val_map->count >= val_map->capacity) {
@@ -282,6 +323,7 @@ static void clone_and_remap_function_body(InlinerContext *ctx,
       if (old_instr->dest) {
         new_instr->dest = ir_builder_create_reg(
             &ctx->builder, old_instr->dest->type, old_instr->dest->name);
+        new_instr->dest->def_instr = new_instr;
         value_map_put(val_map, old_instr->dest, new_instr->dest, ctx->module->log_config);
       }
     }
@@ -296,7 +338,7 @@ static void clone_and_remap_function_body(InlinerContext *ctx,
       for (IROperand *op = new_instr->operand_head; op;
            op = op->next_in_instr) {
         if (op->kind == IR_OP_KIND_VALUE) {
-          op->data.value = remap_value(val_map, op->data.value);
+          change_operand_value(op, remap_value(val_map, op->data.value));
         } else if (op->kind == IR_OP_KIND_BASIC_BLOCK) {
           op->data.bb =
               (IRBasicBlock *)remap_value(val_map, (IRValue *)op->data.bb);
@@ -384,7 +426,7 @@ IRBasicBlock *split_block_after_instruction(IRBuilder *builder,
 
   // 创建新的基本块
   IRBasicBlock *new_block = ir_builder_create_block(builder, "split");
-  link_basic_block_to_function(new_block, func);
+  insert_block_after(new_block, old_block);
 
   // 找到instr之后的所有指令
   IRInstruction *first_moved_instr = instr->next;
@@ -399,6 +441,7 @@ IRBasicBlock *split_block_after_instruction(IRBuilder *builder,
   // 更新旧块的尾指针
   old_block->tail = instr;
   instr->next = NULL;
+  first_moved_instr->prev = NULL;
 
   // 更新新块的头尾指针
   new_block->head = first_moved_instr;
@@ -431,9 +474,16 @@ IRBasicBlock *split_block_after_instruction(IRBuilder *builder,
     }
   }
 
-  // 2. 断开旧块与所有原始后继的连接
+  // 2. 断开旧块与所有原始后继的连接。不能用 remove_predecessor：它会删掉后继
+  //    PHI 中来自旧块的入口值，而这些入口值应改为来自 new_block（见步骤 4）。
   for (int i = 0; i < num_old_succs; ++i) {
-    remove_predecessor(old_succs[i], old_block);
+    IRBasicBlock *succ = old_succs[i];
+    for (int j = 0; j < succ->num_predecessors; ++j) {
+      if (succ->predecessors[j] == old_block) {
+        succ->predecessors[j] = new_block;
+      }
+    }
+    change_phi_predecessor(succ, old_block, new_block);
   }
   old_block->num_successors = 0;
 
@@ -444,7 +494,6 @@ IRBasicBlock *split_block_after_instruction(IRBuilder *builder,
   // 4. 将原始后继转移给 new_block（因为终结符现在在new_block中）
   for (int i = 0; i < num_old_succs; ++i) {
     add_successor(new_block, old_succs[i]);
-    add_predecessor(old_succs[i], new_block);
   }
 
   return new_block;
@@ -5,13 +5,26 @@
  * 本文件实现了指令合并的核心逻辑。它采用一个工作列表（Worklist）来驱动优化，
  * 确保只有可能被简化的指令才会被处理，避免了对整个函数进行不必要的重复扫描。
  *
- * 对于每种可简化的指令操作码，都有一个对应的 `visit_...` 函数。这种设计（访问者模式）
- * 使得添加新的优化模式变得简单，只需实现一个新的 `visit` 函数并将其添加到跳转表中即可。
+ * 每条出队的整数指令（i1/i8/i32/i64）先交给声明式模式匹配器：`inst_combine.pat` 中的代数恒等式在构建时
+ * 由 `inst_combine_gen` 编译成一张决策树形式的匹配表（`inst_combine_patterns.inc`），
+ * 共享前缀的模式只检查一次，按根操作码一次跳转即可排除其他操作码的全部模式。
+ * 添加新的恒等式只需在 `.pat` 文件中写一行。
+ *
+ * 模式不适用的情况（常量折叠、规范化、浮点与比较指令、PHI）由对应操作码的
+ * `visit_...` 函数处理（访问者模式），通过跳转表按操作码索引。
+ *
+ * 两者都没有改动指令时，最后借助已知位与需求位分析（`analysis/known_bits.h`）化简：
+ * 结果的被需求位全部已知时替换为常量，去掉不影响被需求位的 `and`/`or`/`xor`，
+ * 消去多余的符号/零扩展，并把截断前的宽运算改为在窄类型上计算。
  */
 #include "ir/transforms/inst_combine.h"
+#include "ir/transforms/inst_combine_matcher.h"
+#include "ir/analysis/known_bits.h"
 #include "ir/ir_utils.h"
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
 #include "ast.h"          // for create_basic_type, pool_alloc, BASIC_FLOAT
 #include "logger.h"       // for LOG_CATEGORY_IR_OPT, LOG_DEBUG
 
@@ -32,6 +45,9 @@ typedef struct InstCombineContext {
     IRValue* op4;
     // 标记指令是否在原地被修改，并需要重新入队进行进一步处理
     bool re_queue; 
+    KnownBitsCache* known_bits; ///< 本遍共享的已知位/需求位缓存
+    bool bits_changed;          ///< 改写只保持了被需求的位，其余位的已知位缓存已不可信
+    IRFunction* func;           ///< 正在处理的函数，新建临时值从它的 temp_name_count 取编号
 } InstCombineContext;
 
 // 所有 visit 函数都将共享此函数签名。
@@ -70,7 +86,10 @@ static InstVisitFn visit_fn_table[IR_OP_UNKNOWN + 1] = {
 // --- 本地辅助函数的声明 ---
 static IRValue* create_const_int(MemoryPool* pool, int value);
 static IRValue* create_const_float(MemoryPool* pool, float value);
-static bool is_power_of_two(int n, int* log_val);
+static IRValue* create_const_from_known(MemoryPool* pool, Type* type, KnownBits known);
+static void seed_modified_instruction(IRInstruction* instr, void* user_data);
+static bool match_patterns(InstCombineContext* ctx, IRValue** result);
+static IRValue* simplify_with_known_bits(InstCombineContext* ctx);
 
 // --- 主入口函数 ---
 bool run_inst_combine(IRFunction* func) {
@@ -88,19 +107,25 @@ bool run_inst_combine(IRFunction* func) {
     bool changed_overall = false;
     MemoryPool* pool = func->module->pool;
     Worklist* wl = create_worklist(pool, func->block_count * 10);
+    KnownBitsCache* known_bits = create_known_bits_cache(func);
 
     assert(func->reverse_post_order != NULL && "Reverse Post-Order not available for InstCombine!");
     
-    // 初始填充工作列表：将函数中的所有指令加入
-    for (int i = 0; i < func->block_count; ++i) {
-        IRBasicBlock* bb = func->reverse_post_order[i];
-        for (IRInstruction* instr = bb->head; instr; instr = instr->next) {
-            worklist_add(wl, instr);
+    // 初始填充工作列表：流水线记录了本遍上次运行以来被其他遍修改的指令时，
+    // 只从这些指令及其使用者出发；否则将函数中的所有指令加入
+    if (visit_modified_instructions(func, seed_modified_instruction, wl) < 0) {
+        for (int i = 0; i < func->block_count; ++i) {
+            IRBasicBlock* bb = func->reverse_post_order[i];
+            for (IRInstruction* instr = bb->head; instr; instr = instr->next) {
+                worklist_add(wl, instr);
+                instr->in_worklist = true;
+            }
         }
     }
 
     while (wl->count > 0) {
         IRInstruction* instr = (IRInstruction*)worklist_pop(wl);
+        instr->in_worklist = false;
         if (instr->opcode == IR_OP_UNKNOWN) continue; // 已被处理和移除的指令
 
         InstVisitFn visit_fn = visit_fn_table[instr->opcode];
@@ -109,14 +134,31 @@ bool run_inst_combine(IRFunction* func) {
         }
 
         // 准备访问者上下文
-        InstCombineContext ctx = { .wl = wl, .instr = instr, .pool = pool, .re_queue = false };
+        InstCombineContext ctx = { .wl = wl, .instr = instr, .pool = pool, .re_queue = false, .known_bits = known_bits,
+                                   .func = func };
         if (instr->num_operands > 0) ctx.op1 = instr->operand_head->data.value;
         if (instr->num_operands > 1) ctx.op2 = instr->operand_head->next_in_instr->data.value;
         if (instr->num_operands > 2) ctx.op3 = instr->operand_head->next_in_instr->next_in_instr->data.value;
         if (instr->num_operands > 3) ctx.op4 = instr->operand_head->next_in_instr->next_in_instr->next_in_instr->data.value;
 
-        // 调用对应的 visit 函数进行处理
-        IRValue* new_val = visit_fn(&ctx);
+        // 先尝试声明式模式，没有模式适用时再调用对应的 visit 函数，最后借助已知位化简
+        IRValue* new_val = NULL;
+        if (!match_patterns(&ctx, &new_val)) {
+            new_val = visit_fn(&ctx);
+        }
+        if (!new_val && !ctx.re_queue) {
+            new_val = simplify_with_known_bits(&ctx);
+        }
+
+        // 任何改写都可能改变使用关系，需求位需要重新计算；已知位只在
+        // 改写改变了不被需求的位时才失效（等价替换不会让已知位出错）
+        if (new_val || ctx.re_queue) {
+            if (ctx.bits_changed) {
+                invalidate_known_bits(known_bits);
+            } else {
+                invalidate_demanded_bits(known_bits);
+            }
+        }
 
         if (new_val) {
             // 情况1：指令被简化为一个新的值（通常是常量）
@@ -129,7 +171,9 @@ bool run_inst_combine(IRFunction* func) {
             changed_overall = true;
         } else if (ctx.re_queue) {
             // 情况2：指令在原地被修改（例如 `x-c` 变为 `x+(-c)`），需要重新入队以进行进一步的合并
+            mark_instruction_modified(instr);
             worklist_add(wl, (IRValue*)instr);
+            instr->in_worklist = true;
             changed_overall = true;
         }
     }
@@ -141,6 +185,24 @@ bool run_inst_combine(IRFunction* func) {
     return changed_overall;
 }
 
+// 把一条被修改过的指令及其使用者加入工作列表：操作数或操作码的变化
+// 既可能让它自身可以简化，也可能让以它为操作数的指令可以简化。
+static void seed_modified_instruction(IRInstruction* instr, void* user_data) {
+    Worklist* wl = (Worklist*)user_data;
+    if (!instr->in_worklist) {
+        worklist_add(wl, instr);
+        instr->in_worklist = true;
+    }
+    if (!instr->dest) return;
+    for (IROperand* use = instr->dest->use_list_head; use; use = use->next_use) {
+        IRInstruction* user = use->user;
+        if (user && user->parent && !user->in_worklist) {
+            worklist_add(wl, user);
+            user->in_worklist = true;
+        }
+    }
+}
+
 // --- 访问者函数的实现 ---
 
 // 默认处理函数：对未特殊处理的指令不执行任何操作。
@@ -167,22 +229,7 @@ static IRValue* visit_add(InstCombineContext* ctx) {
         return NULL;
     }
     
-    // 模式3：代数化简 (e.g., x + 0 -> x)
-    if (rhs->is_constant && rhs->int_val == 0) return lhs;
-    
-    // 模式4：抵消运算 (e.g., (x - y) + y -> x)
-    if (lhs->def_instr && lhs->def_instr->opcode == IR_OP_SUB) {
-        if (lhs->def_instr->operand_head->next_in_instr->data.value == rhs) {
-            return lhs->def_instr->operand_head->data.value;
-        }
-    }
-    // 模式5：抵消运算（交换律） (e.g., y + (x - y) -> x)
-    if (rhs->def_instr && rhs->def_instr->opcode == IR_OP_SUB) {
-        if (rhs->def_instr->operand_head->next_in_instr->data.value == lhs) {
-             return rhs->def_instr->operand_head->data.value;
-        }
-    }
-
+    // 代数化简（x + 0、(x - y) + y 等）见 inst_combine.pat
     return NULL;
 }
 
@@ -195,13 +242,7 @@ static IRValue* visit_sub(InstCombineContext* ctx) {
         return create_const_int(ctx->pool, lhs->int_val - rhs->int_val);
     }
     
-    // 模式2：代数化简 (e.g., x - 0 -> x)
-    if (rhs->is_constant && rhs->int_val == 0) return lhs;
-
-    // 模式3：代数化简 (e.g., x - x -> 0)
-    if (lhs == rhs) return create_const_int(ctx->pool, 0);
-
-    // 模式4：将减法转换为加法 (e.g., x - c -> x + (-c))
+    // 模式2：将减法转换为加法 (e.g., x - c -> x + (-c))；x - 0、x - x 等见 inst_combine.pat
     if (rhs->is_constant) {
         IRValue* neg_const = create_const_int(ctx->pool, -rhs->int_val);
         ctx->instr->opcode = IR_OP_ADD;
@@ -231,34 +272,12 @@ static IRValue* visit_mul(InstCombineContext* ctx) {
         return NULL;
     }
 
-    // 模式3：代数化简
-    if (rhs->is_constant) {
-        int c = rhs->int_val;
-        if (c == 0) return create_const_int(ctx->pool, 0); // x * 0 -> 0
-        if (c == 1) return lhs; // x * 1 -> x
-        if (c == -1) { // x * -1 -> 0 - x
-            instr->opcode = IR_OP_SUB;
-            change_operand_value(instr->operand_head, create_const_int(ctx->pool, 0));
-            change_operand_value(instr->operand_head->next_in_instr, lhs);
-            ctx->re_queue = true;
-            return NULL;
-        }
-        
-        // 模式4：强度削减 (e.g., x * (2^N) -> x << N)
-        int log_val;
-        if (is_power_of_two(c, &log_val)) {
-            instr->opcode = IR_OP_SHL;
-            change_operand_value(instr->operand_head->next_in_instr, create_const_int(ctx->pool, log_val));
-            ctx->re_queue = true;
-            return NULL;
-        }
-    }
+    // 代数化简与强度削减（x * 1、x * 2^N -> x << N 等）见 inst_combine.pat
     return NULL;
 }
 
 // 处理 `sdiv` 指令。
 static IRValue* visit_sdiv(InstCombineContext* ctx) {
-    IRInstruction* instr = ctx->instr;
     IRValue *lhs = ctx->op1, *rhs = ctx->op2;
 
     // 除零是未定义行为，不进行折叠以避免改变程序语义
@@ -268,23 +287,7 @@ static IRValue* visit_sdiv(InstCombineContext* ctx) {
     if (lhs->is_constant && rhs->is_constant) {
         return create_const_int(ctx->pool, lhs->int_val / rhs->int_val);
     }
-    
-    // 模式2：代数化简 (e.g., x / 1 -> x)
-    if (rhs->is_constant && rhs->int_val == 1) return lhs;
-
-    // 模式3：代数化简 (e.g., x / -1 -> 0 - x)
-    if (rhs->is_constant && rhs->int_val == -1) {
-        instr->opcode = IR_OP_SUB;
-        change_operand_value(instr->operand_head, create_const_int(ctx->pool, 0));
-        change_operand_value(instr->operand_head->next_in_instr, lhs);
-        ctx->re_queue = true;
-        return NULL;
-    }
-    
-    // 模式4：代数化简 (e.g., 0 / x -> 0, if x != 0)
-    if (lhs->is_constant && lhs->int_val == 0) {
-        return create_const_int(ctx->pool, 0);
-    }
+    // 代数化简（x / 1、0 / x 等）见 inst_combine.pat
     return NULL;
 }
 
@@ -298,15 +301,7 @@ static IRValue* visit_srem(InstCombineContext* ctx) {
     if (lhs->is_constant && rhs->is_constant) {
         return create_const_int(ctx->pool, lhs->int_val % rhs->int_val);
     }
-    
-    // 模式2：代数化简 (e.g., x % 1 -> 0)
-    if (rhs->is_constant && (rhs->int_val == 1 || rhs->int_val == -1)) {
-        return create_const_int(ctx->pool, 0);
-    }
-    
-    // 模式3：代数化简 (e.g., x % x -> 0)
-    if (lhs == rhs) return create_const_int(ctx->pool, 0);
-
+    // 代数化简（x % 1、x % x 等）见 inst_combine.pat
     return NULL;
 }
 
@@ -537,21 +532,6 @@ static IRValue* create_const_int(MemoryPool* pool, int value) {
     return v;
 }
 
-// 检查一个数是否为2的幂，如果是，则通过指针返回其对数值。
-static bool is_power_of_two(int n, int* log_val) {
-    if (n <= 0) return false;
-    bool is_pow2 = (n & (n - 1)) == 0;
-    if (is_pow2) {
-        *log_val = 0;
-        int temp = n;
-        while ((temp & 1) == 0 && temp > 1) { // 修正循环条件
-            temp >>= 1;
-            (*log_val)++;
-        }
-    }
-    return is_pow2;
-}
-
 // 创建一个浮点型常量 IRValue。
 static IRValue* create_const_float(MemoryPool* pool, float value) {
     IRValue* v = (IRValue*)pool_alloc(pool, sizeof(IRValue));
@@ -560,4 +540,456 @@ static IRValue* create_const_float(MemoryPool* pool, float value) {
     v->type = create_basic_type(BASIC_FLOAT, false, pool);
     v->float_val = value;
     return v;
+}
+
+// --- 声明式模式的匹配器 ---
+
+// 生成的改写函数：返回 false 表示 if 条件不成立；返回 true 时要么通过 *result
+// 给出替换值，要么已经原地改写了根指令（并设置 re_queue）。
+typedef bool (*PatternRewriteFn)(InstCombineContext* ctx, IRValue** rec, IRValue** result);
+
+// 模式中的节点都与根指令同类型；常量按该类型的位宽解释。
+static bool is_int_constant(const IRValue* v) {
+    return v && v->is_constant && known_bits_type_width(v->type) != 0;
+}
+
+// 整数常量按其位宽符号扩展到 64 位后的值（i1 的 true 为 -1）。
+static int64_t pattern_const_value(const IRValue* v) {
+    unsigned width = known_bits_type_width(v->type);
+    uint64_t bits = v->type->basic == BASIC_I64 ? (uint64_t)v->i64_val : (uint64_t)(int64_t)v->int_val;
+    uint64_t mask = known_bits_mask(width);
+    return known_bits_signed_value((KnownBits){ ~bits & mask, bits & mask, width });
+}
+
+// 整数常量 v 截断到自身位宽后与 literal 的低位相同：i1 中 1 与 -1 都是 true。
+static bool pattern_const_matches(const IRValue* v, int64_t literal) {
+    uint64_t mask = known_bits_mask(known_bits_type_width(v->type));
+    return (((uint64_t)pattern_const_value(v) ^ (uint64_t)literal) & mask) == 0;
+}
+
+// RHS 中折叠出的常量：按根指令的类型截断到其位宽。
+static IRValue* pattern_const(InstCombineContext* ctx, int64_t value) {
+    Type* type = ctx->instr->dest->type;
+    unsigned width = known_bits_type_width(type);
+    uint64_t mask = known_bits_mask(width);
+    KnownBits known = { ~(uint64_t)value & mask, (uint64_t)value & mask, width };
+    return create_const_from_known(ctx->pool, type, known);
+}
+
+// 常量函数 (log2 C)：C 已由 pow2 谓词保证是 2 的幂。
+static int64_t pattern_fn_log2(int64_t c) {
+    int64_t log_val = 0;
+    while (c > 1) {
+        c >>= 1;
+        log_val++;
+    }
+    return log_val;
+}
+
+// 谓词 (pow2 C)：C 是正的 2 的幂（按位宽解释，i32 的 INT_MIN 是负数，不算）。
+static bool pattern_pred_pow2(InstCombineContext* ctx, const IRValue* c) {
+    (void)ctx;
+    int64_t v = pattern_const_value(c);
+    return v > 0 && (v & (v - 1)) == 0;
+}
+
+// 谓词 (not_zero x)：x 不是常量 0。除以 0 是未定义行为，这类指令保持原样。
+static bool pattern_pred_not_zero(InstCombineContext* ctx, const IRValue* x) {
+    (void)ctx;
+    return !(is_int_constant(x) && pattern_const_value(x) == 0);
+}
+
+// 谓词 (multi_bit x)：x 的位宽大于 1。i1 上移位 1 位已经越界（结果为 poison）。
+static bool pattern_pred_multi_bit(InstCombineContext* ctx, const IRValue* x) {
+    (void)ctx;
+    return known_bits_type_width(x->type) > 1;
+}
+
+// 谓词 (one_use a)：a 只有一个使用者，改写后它会变成死代码，指令数不会增加。
+static bool pattern_pred_one_use(InstCombineContext* ctx, const IRValue* a) {
+    (void)ctx;
+    return a->use_list_head && !a->use_list_head->next_use;
+}
+
+// 谓词 (shift_sum_in_range C1 C2)：两次移位量都合法，且合并后仍小于位宽。
+static bool pattern_pred_shift_sum_in_range(InstCombineContext* ctx, const IRValue* c1, const IRValue* c2) {
+    (void)ctx;
+    int64_t a = pattern_const_value(c1), b = pattern_const_value(c2);
+    return a >= 0 && b >= 0 && a + b < (int64_t)known_bits_type_width(c1->type);
+}
+
+// 谓词 (non_negative x)：x 的符号位已知为 0。
+static bool pattern_pred_non_negative(InstCombineContext* ctx, IRValue* x) {
+    return known_bits_is_non_negative(compute_known_bits(ctx->known_bits, x));
+}
+
+// 在当前指令之前新建一条结果类型为 type 的二元指令，并加入工作列表。
+static IRValue* build_binary_before(InstCombineContext* ctx, Opcode op, IRValue* lhs, IRValue* rhs, Type* type) {
+    IRInstruction* root = ctx->instr;
+    IRInstruction* instr = create_ir_instruction(op, ctx->pool);
+    char name[64];
+    snprintf(name, sizeof(name), "%s.ic%d", root->dest->name ? root->dest->name : "tmp", ctx->func->temp_name_count++);
+    instr->dest = create_ir_value(ctx->pool);
+    instr->dest->type = type;
+    instr->dest->name = pool_strdup(ctx->pool, name);
+    instr->dest->def_instr = instr;
+    // 先插入再添加操作数：add_value_operand 通过所在基本块找到内存池
+    insert_instr_before(instr, root);
+    add_value_operand(instr, lhs);
+    add_value_operand(instr, rhs);
+    worklist_add(ctx->wl, instr);
+    instr->in_worklist = true;
+    return instr->dest;
+}
+
+// RHS 中嵌套的 (op a b)：在根指令之前新建一条同类型的指令。
+static IRValue* pattern_build_binary(InstCombineContext* ctx, Opcode op, IRValue* lhs, IRValue* rhs) {
+    return build_binary_before(ctx, op, lhs, rhs, ctx->instr->dest->type);
+}
+
+// RHS 顶层的 (op a b)：根指令原地改写为新的操作码与操作数。
+static void pattern_rewrite_root(InstCombineContext* ctx, Opcode op, IRValue* lhs, IRValue* rhs) {
+    IRInstruction* instr = ctx->instr;
+    instr->opcode = op;
+    change_operand_value(instr->operand_head, lhs);
+    change_operand_value(instr->operand_head->next_in_instr, rhs);
+    ctx->re_queue = true;
+}
+
+#include "inst_combine_patterns.inc"
+
+typedef struct {
+    int pc;          ///< 下一个候选子表的 size 字段位置
+    int depth;       ///< 进入 SCOPE 时的节点栈深度
+    int num_records; ///< 进入 SCOPE 时的记录数
+    /// 进入 SCOPE 时的节点栈：子表可以先回到上层再进入兄弟节点，覆盖栈中的位置
+    IRValue* nodes[INST_COMBINE_MATCHER_MAX_DEPTH + 1];
+} MatcherFrame;
+
+// 匹配表中节点的定义指令。常量、参数和已被删除的指令都没有定义指令可供匹配。
+static IRInstruction* matcher_def(InstCombineContext* ctx, IRValue** nodes, int depth) {
+    if (depth == 0) return ctx->instr;
+    IRValue* v = nodes[depth];
+    if (v->is_constant || !v->def_instr || !v->def_instr->parent) return NULL;
+    return v->def_instr;
+}
+
+// 同一个值，或类型与值都相等的两个整数常量（常量没有被唯一化）。
+static bool matcher_same_value(const IRValue* a, const IRValue* b) {
+    return a == b || (is_int_constant(a) && is_int_constant(b) && a->type->basic == b->type->basic &&
+                      pattern_const_value(a) == pattern_const_value(b));
+}
+
+/**
+ * @brief 用 inst_combine.pat 编译出的匹配表匹配当前指令，匹配成功时执行改写。
+ * @details 表的格式见 inst_combine_matcher.h。SCOPE 压入回溯点，检查失败时
+ *          恢复到最近的回溯点并尝试它的下一个子表；SWITCH_OPCODE 的分支互斥，
+ *          不需要回溯点。
+ * @return 如果某个模式完成了改写，返回 true。
+ */
+static bool match_patterns(InstCombineContext* ctx, IRValue** result) {
+    IRInstruction* instr = ctx->instr;
+    if (!instr->dest || known_bits_type_width(instr->dest->type) == 0) {
+        return false; // 模式只描述整数运算
+    }
+
+    const int32_t* table = inst_combine_matcher_table;
+    IRValue* nodes[INST_COMBINE_MATCHER_MAX_DEPTH + 1];
+    IRValue* records[INST_COMBINE_MATCHER_MAX_RECORDS];
+    MatcherFrame scopes[INST_COMBINE_MATCHER_MAX_SCOPES];
+    int num_scopes = 0, depth = 0, num_records = 0, pc = 0;
+    nodes[0] = instr->dest;
+
+    for (;;) {
+        IRInstruction* def;
+        switch ((MatcherOpcode)table[pc++]) {
+            case MATCHER_SCOPE: {
+                MatcherFrame* frame = &scopes[num_scopes++];
+                frame->pc = pc + 1 + table[pc];
+                frame->depth = depth;
+                frame->num_records = num_records;
+                memcpy(frame->nodes, nodes, sizeof(nodes));
+                pc++;
+                continue;
+            }
+            case MATCHER_SWITCH_OPCODE:
+                def = matcher_def(ctx, nodes, depth);
+                if (!def) goto fail;
+                for (;;) {
+                    if (table[pc] == 0) goto fail;
+                    if (table[pc + 1] == (int32_t)def->opcode && table[pc + 2] == def->num_operands) break;
+                    pc += 3 + table[pc];
+                }
+                pc += 3;
+                continue;
+            case MATCHER_CHECK_OPCODE:
+                def = matcher_def(ctx, nodes, depth);
+                if (!def || table[pc] != (int32_t)def->opcode || table[pc + 1] != def->num_operands) goto fail;
+                pc += 2;
+                continue;
+            case MATCHER_MOVE_CHILD: {
+                def = matcher_def(ctx, nodes, depth);
+                IROperand* op = def ? def->operand_head : NULL;
+                for (int i = 0; i < table[pc] && op; ++i) op = op->next_in_instr;
+                pc++;
+                if (!op || op->kind != IR_OP_KIND_VALUE) goto fail;
+                nodes[++depth] = op->data.value;
+                continue;
+            }
+            case MATCHER_MOVE_PARENT:
+                depth--;
+                continue;
+            case MATCHER_RECORD:
+                records[num_records++] = nodes[depth];
+                continue;
+            case MATCHER_CHECK_SAME:
+                if (!matcher_same_value(nodes[depth], records[table[pc++]])) goto fail;
+                continue;
+            case MATCHER_CHECK_CONST:
+                if (!is_int_constant(nodes[depth])) goto fail;
+                continue;
+            case MATCHER_CHECK_INT:
+                if (!is_int_constant(nodes[depth]) || !pattern_const_matches(nodes[depth], table[pc])) goto fail;
+                pc++;
+                continue;
+            case MATCHER_COMPLETE:
+                if (inst_combine_rewrites[table[pc++]](ctx, records, result)) return true;
+                goto fail;
+        }
+        assert(false && "Unknown opcode in the inst_combine matcher table");
+        return false;
+
+    fail:
+        // 回溯到最近的 SCOPE，从它的下一个子表继续；子表用尽时继续向外回溯
+        for (;;) {
+            if (num_scopes == 0) return false;
+            MatcherFrame* frame = &scopes[num_scopes - 1];
+            pc = frame->pc;
+            if (table[pc] == 0) {
+                num_scopes--;
+                continue;
+            }
+            depth = frame->depth;
+            num_records = frame->num_records;
+            memcpy(nodes, frame->nodes, sizeof(nodes));
+            frame->pc = pc + 1 + table[pc];
+            pc++;
+            break;
+        }
+    }
+}
+
+// --- 借助已知位与需求位的化简 ---
+
+// 根据所有位都已知的 known 创建一个 type 类型的整数常量。
+static IRValue* create_const_from_known(MemoryPool* pool, Type* type, KnownBits known) {
+    switch (type->basic) {
+        case BASIC_I1:
+            return create_constant_i1(known.one != 0, pool);
+        case BASIC_I64:
+            return create_constant_i64(known_bits_signed_value(known), pool);
+        case BASIC_INT:
+            return create_const_int(pool, (int)known_bits_signed_value(known));
+        default: {
+            IRValue* v = create_ir_value(pool);
+            v->is_constant = true;
+            v->type = type;
+            v->int_val = (int)known_bits_signed_value(known);
+            return v;
+        }
+    }
+}
+
+// 在 demanded 位上，位运算指令 def 的结果总是等于它的某个操作数时，返回该操作数：
+// `and x y` 中 y 可能为 0 的被需求位上 x 已知为 0，`or x y` 中 y 可能为 1 的被需求位上
+// x 已知为 1，`xor x y` 中 y 的被需求位已知为 0。
+static IRValue* bitwise_passthrough(KnownBitsCache* cache, IRInstruction* def, uint64_t demanded) {
+    if (def->num_operands != 2) return NULL;
+    IRValue* ops[2] = { def->operand_head->data.value, def->operand_head->next_in_instr->data.value };
+    KnownBits known[2] = { compute_known_bits(cache, ops[0]), compute_known_bits(cache, ops[1]) };
+    if (known[0].width == 0 || known[0].width != known[1].width) return NULL;
+
+    for (int i = 0; i < 2; ++i) {
+        KnownBits self = known[i], other = known[1 - i];
+        uint64_t covered;
+        switch (def->opcode) {
+            case IR_OP_AND: covered = self.zero | other.one; break;
+            case IR_OP_OR:  covered = self.one | other.zero; break;
+            case IR_OP_XOR: covered = other.zero; break;
+            default: return NULL;
+        }
+        if ((demanded & ~covered) == 0) return ops[i];
+    }
+    return NULL;
+}
+
+#define NARROW_MAX_DEPTH 4
+
+// 加、减、乘与位运算结果的低位只取决于操作数的低位，可以直接在窄类型上计算。
+static bool is_narrowable_opcode(Opcode opcode) {
+    switch (opcode) {
+        case IR_OP_ADD: case IR_OP_SUB: case IR_OP_MUL:
+        case IR_OP_AND: case IR_OP_OR:  case IR_OP_XOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// v 能否在 width 位的窄类型上求值：常量、从窄类型扩展而来的值，或者操作数都能在
+// 窄类型上求值、且只有一个使用者（改写后原来的宽运算会变成死代码）的窄化友好运算。
+static bool can_evaluate_narrow(InstCombineContext* ctx, IRValue* v, unsigned width, int depth) {
+    if (v->is_constant) return true;
+    IRInstruction* def = v->def_instr;
+    if (!def || !def->parent) return false;
+    if ((def->opcode == IR_OP_ZEXT || def->opcode == IR_OP_SEXT) &&
+        known_bits_type_width(def->operand_head->data.value->type) == width) {
+        return true;
+    }
+    if (depth >= NARROW_MAX_DEPTH || !is_narrowable_opcode(def->opcode) || def->num_operands != 2 ||
+        !pattern_pred_one_use(ctx, v)) {
+        return false;
+    }
+    return can_evaluate_narrow(ctx, def->operand_head->data.value, width, depth + 1) &&
+           can_evaluate_narrow(ctx, def->operand_head->next_in_instr->data.value, width, depth + 1);
+}
+
+// 在窄类型 narrow 上重建 v（调用前已由 can_evaluate_narrow 确认可行）。
+static IRValue* evaluate_narrow(InstCombineContext* ctx, IRValue* v, Type* narrow) {
+    unsigned width = known_bits_type_width(narrow);
+    if (v->is_constant) {
+        KnownBits k = compute_known_bits(ctx->known_bits, v);
+        k.zero &= known_bits_mask(width);
+        k.one &= known_bits_mask(width);
+        k.width = width;
+        return create_const_from_known(ctx->pool, narrow, k);
+    }
+    IRInstruction* def = v->def_instr;
+    if (def->opcode == IR_OP_ZEXT || def->opcode == IR_OP_SEXT) return def->operand_head->data.value;
+    IRValue* lhs = evaluate_narrow(ctx, def->operand_head->data.value, narrow);
+    IRValue* rhs = evaluate_narrow(ctx, def->operand_head->next_in_instr->data.value, narrow);
+    return build_binary_before(ctx, def->opcode, lhs, rhs, narrow);
+}
+
+// trunc (op (ext a) (op (ext b) C)) -> op a (op b C')：截断前的整棵运算树都能在窄类型上
+// 求值时，直接在窄类型上计算，省掉扩展与截断。
+static IRValue* narrow_truncated_operation(InstCombineContext* ctx) {
+    IRValue* src = ctx->op1;
+    IRInstruction* def = src->is_constant ? NULL : src->def_instr;
+    if (!def || !def->parent || !is_narrowable_opcode(def->opcode)) return NULL;
+    unsigned width = known_bits_type_width(ctx->instr->dest->type);
+    if (!can_evaluate_narrow(ctx, src, width, 0)) return NULL;
+    return evaluate_narrow(ctx, src, ctx->instr->dest->type);
+}
+
+// 化简扩展与截断指令。
+static IRValue* simplify_cast_with_known_bits(InstCombineContext* ctx) {
+    IRInstruction* instr = ctx->instr;
+    IRValue* src = ctx->op1;
+    unsigned width = known_bits_type_width(instr->dest->type);
+    unsigned src_width = known_bits_type_width(src->type);
+    IRInstruction* def = src->is_constant ? NULL : src->def_instr;
+    if (def && !def->parent) def = NULL;
+    if (src_width == 0) return NULL;
+
+    switch (instr->opcode) {
+        case IR_OP_SEXT:
+            // 符号位已知为 0 的值，符号扩展与零扩展结果相同
+            if (known_bits_is_non_negative(compute_known_bits(ctx->known_bits, src))) {
+                instr->opcode = IR_OP_ZEXT;
+                ctx->re_queue = true;
+                return NULL;
+            }
+            /* fallthrough */
+        case IR_OP_ZEXT:
+            // ext (trunc y) -> y：y 被截掉的高位（符号扩展时还有截断后的符号位）已知为 0
+            if (def && def->opcode == IR_OP_TRUNC && def->num_operands == 1) {
+                IRValue* y = def->operand_head->data.value;
+                if (known_bits_type_width(y->type) != width) return NULL;
+                unsigned kept = instr->opcode == IR_OP_SEXT ? src_width - 1 : src_width;
+                uint64_t dropped = known_bits_mask(width) & ~known_bits_mask(kept);
+                if ((compute_known_bits(ctx->known_bits, y).zero & dropped) == dropped) return y;
+            }
+            return NULL;
+        case IR_OP_TRUNC:
+            // trunc (ext x) -> x
+            if (def && (def->opcode == IR_OP_ZEXT || def->opcode == IR_OP_SEXT) && def->num_operands == 1) {
+                IRValue* x = def->operand_head->data.value;
+                if (known_bits_type_width(x->type) == width) return x;
+            }
+            return narrow_truncated_operation(ctx);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief 借助已知位与需求位化简当前指令。模式与 visit 函数都没有改动指令时调用。
+ * @details 只要改写保持了结果中所有被需求的位，就不会改变程序的可观察行为；
+ *          当被需求的位不是全部位时，改写可能改变了其余的位，此时设置
+ *          `ctx->bits_changed`，由调用者使已知位缓存失效。
+ * @return 替换当前指令的值；原地改写时返回 NULL 并设置 `ctx->re_queue`。
+ */
+static IRValue* simplify_with_known_bits(InstCombineContext* ctx) {
+    IRInstruction* instr = ctx->instr;
+    if (!instr->dest || has_side_effects(instr)) return NULL;
+    unsigned width = known_bits_type_width(instr->dest->type);
+    if (width == 0) return NULL;
+    KnownBitsCache* cache = ctx->known_bits;
+    uint64_t all = known_bits_mask(width);
+
+    // 1. 结果的所有位都已知
+    KnownBits known = compute_known_bits(cache, instr->dest);
+    if (known_bits_is_constant(known)) {
+        return create_const_from_known(ctx->pool, instr->dest->type, known);
+    }
+
+    if (instr->opcode == IR_OP_ZEXT || instr->opcode == IR_OP_SEXT || instr->opcode == IR_OP_TRUNC) {
+        return simplify_cast_with_known_bits(ctx);
+    }
+
+    // 没有使用者的指令留给死代码消除
+    uint64_t demanded = compute_demanded_bits(cache, instr->dest);
+    if (demanded == 0) return NULL;
+    bool partial = demanded != all;
+
+    // 2. 被需求的位全部已知：其余位可以取任意值
+    if (partial && ((known.zero | known.one) & demanded) == demanded) {
+        ctx->bits_changed = true;
+        known.zero = all & ~known.one;
+        return create_const_from_known(ctx->pool, instr->dest->type, known);
+    }
+
+    // 3. 在被需求的位上，位运算的结果等于它的某个操作数
+    IRValue* operand = bitwise_passthrough(cache, instr, demanded);
+    if (operand) {
+        ctx->bits_changed = partial;
+        return operand;
+    }
+
+    // 4. 操作数是位运算，且它在本指令需要的位上等于自己的某个操作数：绕过它
+    //    （例如 (x & 255) & 15 中的内层 and，(x | 256) + 1 只需要低位时的 or）
+    switch (instr->opcode) {
+        case IR_OP_ADD: case IR_OP_SUB: case IR_OP_MUL:
+        case IR_OP_AND: case IR_OP_OR:  case IR_OP_XOR:
+        case IR_OP_SHL: case IR_OP_LSHR: case IR_OP_ASHR:
+            break;
+        default:
+            return NULL;
+    }
+    int index = 0;
+    for (IROperand* op = instr->operand_head; op; op = op->next_in_instr, ++index) {
+        IRValue* v = op->data.value;
+        IRInstruction* def = v->is_constant ? NULL : v->def_instr;
+        if (!def || !def->parent) continue;
+        uint64_t operand_demanded = demanded_bits_of_operand(cache, instr, index, demanded);
+        IRValue* replacement = bitwise_passthrough(cache, def, operand_demanded);
+        if (replacement) {
+            change_operand_value(op, replacement);
+            ctx->bits_changed = partial;
+            ctx->re_queue = true;
+            return NULL;
+        }
+    }
+    return NULL;
 }
\ No newline at end of file
@@ -188,6 +188,8 @@ static bool ensure_loop_preheader(Loop* loop, IRBuilder* builder) {
     // 创建新的前置头基本块
     IRBasicBlock* preheader = ir_builder_create_block(builder, "loop.preheader");
     loop->preheader = preheader;
+    // 循环头有外部前驱，因此不是入口块，前面一定还有块
+    insert_block_after(preheader, header->prev_in_func);
     
     // 注意：这里没有ASTContext，所以我们需要创建一个默认的LogConfig
     LogConfig default_log_config;
@@ -363,6 +365,7 @@ static bool is_loop_invariant(IRInstruction* instr, BitSet* loop_blocks_bs) {
 
     // 检查所有操作数
     for (IROperand* op = instr->operand_head; op; op = op->next_in_instr) {
+        if (op->kind != IR_OP_KIND_VALUE) continue;
         IRValue* val = op->data.value;
         if (val->is_constant) continue; // 常量总是不变的
         IRInstruction* def_instr = val->def_instr;
@@ -421,8 +424,9 @@ static bool is_instruction_safe_to_speculate(IRInstruction* instr) {
         case IR_OP_SHL: case IR_OP_ASHR: case IR_OP_LSHR:
         case IR_OP_AND: case IR_OP_OR: case IR_OP_XOR:
         case IR_OP_ICMP: case IR_OP_FCMP:
-        case IR_OP_GETELEMENTPTR: case IR_OP_PHI:
+        case IR_OP_GETELEMENTPTR:
             return instr->dest != NULL;
+        // PHI 的取值依赖所在块的前驱，不能移动到前置头
         // 除法/取余可能因除零而异常
         case IR_OP_SDIV: case IR_OP_SREM: case IR_OP_FDIV:
         // load 可能因空指针或非法地址而异常
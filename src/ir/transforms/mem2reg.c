@@ -172,6 +172,14 @@ bool run_mem2reg(IRFunction* func) {
 
 // --- 核心算法步骤的实现 ---
 
+/**
+ * @brief 按后序编号取基本块。
+ * @details 位集以 `post_order_id` 为下标，而函数只缓存了逆后序数组。
+ */
+static IRBasicBlock* block_at_post_order(IRFunction* func, int post_order_id) {
+    return func->reverse_post_order[func->block_count - 1 - post_order_id];
+}
+
 /**
  * @brief 检查一个 alloca 指令是否可以被提升到寄存器。
  * @details
@@ -255,7 +263,7 @@ static void compute_phi_placement(Mem2RegContext* ctx) {
         // 初始化工作列表，包含所有定义了该变量的块。
         for (int block_id = 0; block_id < ctx->func->block_count; ++block_id) {
             if (bitset_contains(pa->defining_blocks, block_id)) {
-                worklist_add(worklist, ctx->func->reverse_post_order[block_id]);
+                worklist_add(worklist, block_at_post_order(ctx->func, block_id));
             }
         }
 
@@ -289,7 +297,7 @@ static void insert_phi_nodes(Mem2RegContext* ctx) {
         
         for (int block_id = 0; block_id < ctx->func->block_count; ++block_id) {
             if (bitset_contains(pa->phi_placement_blocks, block_id)) {
-                IRBasicBlock* block = ctx->func->reverse_post_order[block_id];
+                IRBasicBlock* block = block_at_post_order(ctx->func, block_id);
                 // 设置 builder 的插入点到块的开头
                 ir_builder_set_insertion_block_start(&ctx->builder, block);
                 
@@ -16,8 +16,14 @@
  * 4.  **变换**：
  *     - 将所有状态为 Constant 的值替换为其对应的常量。
  *     - 移除所有最终状态为不可达的基本块。
+ *
+ * 格值只能表示"某个常量"或"不是常量"。一个整数结果被求值为 Bottom 时，再用已知位
+ * 分析（`analysis/known_bits.h`）检查一次：例如 `(x & 0xF0) & 0x0F` 的所有位都已知为 0，
+ * `icmp slt (and x 255), 0` 的符号位已知为 0 而一定不成立，它们仍然是常量，
+ * 后者还能让条件分支被折叠。
  */
 #include "ir/transforms/sccp.h"
+#include "ir/analysis/known_bits.h"
 #include "ir/ir_utils.h"
 #include <string.h>
 #include "ast.h"          // for Type::(anonymous), BASIC_INT, BASIC_FLOAT
@@ -76,6 +82,7 @@ typedef struct {
     int iteration_count;       ///< 迭代计数器，用于防止无限循环。
     int max_iterations;        ///< 最大迭代次数的安全限制。
     bool changed;              ///< 标记在分析过程中格值是否发生过变化。
+    KnownBitsCache* known_bits; ///< 已知位分析的缓存，用于细化 Bottom 的整数结果。
 } SCCPContext;
 
 // --- 静态函数前向声明 ---
@@ -85,12 +92,15 @@ static bool transform_based_on_sccp(SCCPContext* ctx);
 static void visit_block(SCCPContext* ctx, IRBasicBlock* bb);
 static void visit_instruction(SCCPContext* ctx, IRInstruction* instr);
 static void visit_phi_operands(SCCPContext* ctx, IRBasicBlock* from, IRBasicBlock* to);
+static void mark_edge_executable(SCCPContext* ctx, IRBasicBlock* from, IRBasicBlock* to);
 static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr);
+static LatticeValue refine_with_known_bits(SCCPContext* ctx, IRInstruction* instr, LatticeValue lval);
 static LatticeValue get_lattice_value(SCCPContext* ctx, IRValue* val);
 static void set_lattice_value(SCCPContext* ctx, IRValue* val, LatticeValue new_lval);
 static IRValue* create_constant_from_lattice(SCCPContext* ctx, const LatticeValue* lval);
 static bool are_lattice_values_equal(const LatticeValue* v1, const LatticeValue* v2);
 static LatticeValue merge_lattice_values(const LatticeValue* v1, const LatticeValue* v2);
+static LatticeValue binary_operand_state(const LatticeValue* v1, const LatticeValue* v2);
 static void assign_value_ids(SCCPContext* ctx);
 static int get_value_id(SCCPContext* ctx, IRValue* val);
 static int next_prime(int n);
@@ -104,6 +114,12 @@ bool run_sccp(IRFunction* func) {
         return false;
     }
     
+    // 本遍上次运行以来函数没有被其他遍修改过：上次的结果仍是不动点。
+    // 格值需要在整个函数上重新求解，因此不能只从修改处出发。
+    if (visit_modified_instructions(func, NULL, NULL) == 0) {
+        return false;
+    }
+
     if (func->module && func->module->log_config) {
         LOG_DEBUG(func->module->log_config, LOG_CATEGORY_IR_OPT, "Running SCCP on function @%s", func->name);
     }
@@ -111,10 +127,13 @@ bool run_sccp(IRFunction* func) {
     SCCPContext ctx = {0};
     ctx.func = func;
     ctx.pool = func->module->pool;
-    ctx.max_iterations = 1000; // 安全限制
     
     initialize_sccp(&ctx);
+    // 格是单调的：每个块至多入队一次，每个值至多下降两次，分析必然在此之前收敛
+    ctx.max_iterations = func->block_count + 2 * ctx.value_count + 1;
     run_sccp_analysis(&ctx);
+    // 未收敛时格值不可信，放弃变换
+    if (ctx.cfg_worklist->count > 0 || ctx.ssa_worklist->count > 0) return false;
     bool changed = transform_based_on_sccp(&ctx);
     
     if (changed && func->module && func->module->log_config) {
@@ -187,6 +206,7 @@ static void initialize_sccp(SCCPContext* ctx) {
     
     ctx->iteration_count = 0;
     ctx->changed = false;
+    ctx->known_bits = create_known_bits_cache(ctx->func);
 }
 
 // --- 增强的 SCCP 分析阶段 ---
@@ -238,6 +258,17 @@ static void visit_phi_operands(SCCPContext* ctx, IRBasicBlock* from, IRBasicBloc
     }
 }
 
+// 控制流边 from -> to 可达：目标块首次可达时加入工作列表。目标块已经可达时
+// （例如循环的回边），新边带来的入口值同样要合并进 PHI。
+static void mark_edge_executable(SCCPContext* ctx, IRBasicBlock* from, IRBasicBlock* to) {
+    if (!to) return;
+    if (!ctx->executable_blocks[to->post_order_id]) {
+        ctx->executable_blocks[to->post_order_id] = true;
+        worklist_add(ctx->cfg_worklist, to);
+    }
+    visit_phi_operands(ctx, from, to);
+}
+
 // "访问"一条指令：重新计算其结果的格值，并处理其控制流效应。
 static void visit_instruction(SCCPContext* ctx, IRInstruction* instr) {
     if (!instr || !ctx->executable_blocks[instr->parent->post_order_id]) return;
@@ -245,28 +276,23 @@ static void visit_instruction(SCCPContext* ctx, IRInstruction* instr) {
     if (instr->dest) {
         LatticeValue old_lval = get_lattice_value(ctx, instr->dest);
         if (old_lval.state == LATTICE_BOTTOM) return;
-        LatticeValue new_lval = evaluate_instruction(ctx, instr);
+        LatticeValue new_lval = refine_with_known_bits(ctx, instr, evaluate_instruction(ctx, instr));
         set_lattice_value(ctx, instr->dest, new_lval);
     } else if (instr->opcode == IR_OP_BR && instr->num_operands > 1) {
         LatticeValue cond_lval = get_lattice_value(ctx, instr->operand_head->data.value);
+        IROperand* op = instr->operand_head->next_in_instr;
+        IRBasicBlock* true_target = op->kind == IR_OP_KIND_BASIC_BLOCK ? op->data.bb : NULL;
+        IRBasicBlock* false_target = op->next_in_instr && op->next_in_instr->kind == IR_OP_KIND_BASIC_BLOCK ? op->next_in_instr->data.bb : NULL;
         if (cond_lval.state == LATTICE_CONSTANT) {
-            IROperand* op = instr->operand_head->next_in_instr;
-            IRBasicBlock* true_target = op->kind == IR_OP_KIND_BASIC_BLOCK ? op->data.bb : NULL;
-            IRBasicBlock* false_target = op->next_in_instr && op->next_in_instr->kind == IR_OP_KIND_BASIC_BLOCK ? op->next_in_instr->data.bb : NULL;
             IRBasicBlock* target = (cond_lval.const_val.int_val != 0) ? true_target : false_target;
-            if (target && !ctx->executable_blocks[target->post_order_id]) {
-                ctx->executable_blocks[target->post_order_id] = true;
-                worklist_add(ctx->cfg_worklist, target);
-                visit_phi_operands(ctx, instr->parent, target);
-            }
+            mark_edge_executable(ctx, instr->parent, target);
+        } else if (cond_lval.state == LATTICE_BOTTOM) {
+            // 条件不是常量：两个后继都可达
+            mark_edge_executable(ctx, instr->parent, true_target);
+            mark_edge_executable(ctx, instr->parent, false_target);
         }
     } else if (instr->opcode == IR_OP_BR) { // 无条件分支
-        IRBasicBlock* target = (IRBasicBlock*)instr->operand_head->data.bb;
-        if (!ctx->executable_blocks[target->post_order_id]) {
-            ctx->executable_blocks[target->post_order_id] = true;
-            worklist_add(ctx->cfg_worklist, target);
-            visit_phi_operands(ctx, instr->parent, target);
-        }
+        mark_edge_executable(ctx, instr->parent, (IRBasicBlock*)instr->operand_head->data.bb);
     }
 }
 
@@ -346,6 +372,15 @@ static LatticeValue merge_lattice_values(const LatticeValue* v1, const LatticeVa
     return (LatticeValue){.state = LATTICE_BOTTOM, .is_valid = true};
 }
 
+// 二元运算在操作数不全是常量时的结果：任一操作数为 Bottom 则为 Bottom，否则仍为 Top。
+// 不能用 merge_lattice_values：两个不同的常量合并为 Bottom，运算却可以折叠。
+static LatticeValue binary_operand_state(const LatticeValue* v1, const LatticeValue* v2) {
+    if (v1->state == LATTICE_BOTTOM || v2->state == LATTICE_BOTTOM) {
+        return (LatticeValue){.state = LATTICE_BOTTOM, .is_valid = true};
+    }
+    return (LatticeValue){.state = LATTICE_TIR_OP, .is_valid = true};
+}
+
 // --- 核心求值引擎 ---
 // 根据指令的操作码和其操作数的格值，计算该指令结果的格值。
 static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr) {
@@ -357,8 +392,8 @@ static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr)
             LatticeValue lval1 = get_lattice_value(ctx, op1 ? op1->data.value : NULL);
             LatticeValue lval2 = get_lattice_value(ctx, op2 ? op2->data.value : NULL);
             
-            // 使用 merge_lattice_values 处理 Bottom 和 Top 状态
-            LatticeValue merged = merge_lattice_values(&lval1, &lval2);
+            // 先处理 Bottom 和 Top 状态
+            LatticeValue merged = binary_operand_state(&lval1, &lval2);
             if (merged.state == LATTICE_BOTTOM) return merged;
             
             // 如果两个操作数都是常量，进行常量折叠
@@ -383,8 +418,8 @@ static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr)
             LatticeValue lval1 = get_lattice_value(ctx, op1 ? op1->data.value : NULL);
             LatticeValue lval2 = get_lattice_value(ctx, op2 ? op2->data.value : NULL);
             
-            // 使用 merge_lattice_values 处理 Bottom 和 Top 状态
-            LatticeValue merged = merge_lattice_values(&lval1, &lval2);
+            // 先处理 Bottom 和 Top 状态
+            LatticeValue merged = binary_operand_state(&lval1, &lval2);
             if (merged.state == LATTICE_BOTTOM) return merged;
             
             // 如果两个操作数都是常量，进行常量折叠
@@ -408,8 +443,8 @@ static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr)
             LatticeValue lval1 = get_lattice_value(ctx, op1 ? op1->data.value : NULL);
             LatticeValue lval2 = get_lattice_value(ctx, op2 ? op2->data.value : NULL);
             
-            // 使用 merge_lattice_values 处理 Bottom 和 Top 状态
-            LatticeValue merged = merge_lattice_values(&lval1, &lval2);
+            // 先处理 Bottom 和 Top 状态
+            LatticeValue merged = binary_operand_state(&lval1, &lval2);
             if (merged.state == LATTICE_BOTTOM) return merged;
             
             // 如果两个操作数都是常量，进行常量折叠
@@ -459,6 +494,20 @@ static LatticeValue evaluate_instruction(SCCPContext* ctx, IRInstruction* instr)
     }
 }
 
+// 整数结果被求值为 Bottom 时，如果它的所有位都已知，它仍然是一个常量。
+// 已知位只依据 IR 本身推导，对任何一次执行都成立，与格值的乐观假设不冲突。
+static LatticeValue refine_with_known_bits(SCCPContext* ctx, IRInstruction* instr, LatticeValue lval) {
+    if (lval.state != LATTICE_BOTTOM || !instr->dest || has_side_effects(instr)) return lval;
+    Type* type = instr->dest->type;
+    if (!type || type->kind != TYPE_BASIC || (type->basic != BASIC_INT && type->basic != BASIC_I1)) return lval;
+
+    KnownBits known = compute_known_bits(ctx->known_bits, instr->dest);
+    if (!known_bits_is_constant(known)) return lval;
+    LatticeValue out = {.state = LATTICE_CONSTANT, .type = type, .is_valid = true};
+    out.const_val.int_val = type->basic == BASIC_I1 ? (int)known.one : (int)known_bits_signed_value(known);
+    return out;
+}
+
 // --- SCCP 变换阶段 ---
 // 根据格值创建一个新的 IR 常量。
 static IRValue* create_constant_from_lattice(SCCPContext* ctx, const LatticeValue* lval) {
@@ -505,17 +554,12 @@ static bool transform_based_on_sccp(SCCPContext* ctx) {
                 // 从死分支的前驱列表中移除当前块
                 remove_predecessor(dead_succ, bb);
                 
-                // 创建新的无条件跳转指令
+                // 创建新的无条件跳转指令，插在旧的条件跳转之前
                 IRInstruction* new_br = create_ir_instruction(IR_OP_BR, ctx->pool);
-                new_br->parent = bb;
+                insert_instr_before(new_br, term);
                 add_bb_operand(new_br, final_target);
 
-                // 替换掉旧的条件跳转
-                if (term->prev) term->prev->next = new_br;
-                else bb->head = new_br;
-                new_br->prev = term->prev;
-                bb->tail = new_br;
-                
+                // 删除旧的条件跳转（erase_instruction 负责把它从链表中摘除）
                 erase_instruction(term);
                 changed = true;
             }
@@ -1,14 +1,23 @@
 /**
  * @file simplify_cfg.c
- * @brief 实现一个迭代式的控制流图（CFG）简化优化遍。
+ * @brief 实现一个由基本块工作列表驱动的控制流图（CFG）简化优化遍。
  * @details
- * 本文件实现了一系列经典的CFG清理和简化技术。它通过一个不动点迭代框架，
- * 反复执行多个子优化遍，直到CFG结构稳定为止。这些优化对于清理由前端生成
+ * 本文件实现了一系列经典的CFG清理和简化技术。这些优化对于清理由前端生成
  * 或由其他优化遍（如SCCP、循环展开）产生的冗余或复杂的控制流至关重要。
+ *
+ * 遍开始时构建一次CFG，之后所有变换都就地维护前驱/后继数组，不再重建。
+ * 每个块出队时依次尝试四种局部变换；一次变换只会影响它的邻居，因此只把
+ * 这些邻居重新入队：
+ * - 块失去最后一个前驱 → 删除它，它的后继各失去一个前驱，重新入队；
+ * - 条件为常量的分支被折叠 → 死目标失去一个前驱，重新入队；
+ * - 跳板块被绕过 → 它的前驱（出边改变）与目标（获得前驱）重新入队；
+ * - 两个块被合并 → 合并后的块重新入队。
+ * 每次入队都对应一次 CFG 编辑，总工作量与块数加编辑次数成线性关系。
+ * 只有从入口不可达的环（环上每个块都还有前驱）需要一次可达性扫描来发现，
+ * 该扫描只在删除过边之后、工作列表清空时进行。
  */
 #include "ir/transforms/simplify_cfg.h"
 #include "ir/ir_utils.h"
-#include "ir/ir_builder.h"
 #include "ir/analysis/cfg_builder.h"
 #include "ir/analysis/dominators.h"
 #include <string.h>
@@ -17,10 +26,8 @@
 
 
 // 缺失的外部函数声明（应在对应的头文件中提供）
-extern void ir_builder_set_insertion_block_end(IRBuilder* builder, IRBasicBlock* bb);
 extern IRValue* phi_get_incoming_value_for_block(IRInstruction* phi, IRBasicBlock* block);
 extern void move_instructions_to_block_end(IRBasicBlock* from, IRBasicBlock* to);
-extern void replace_all_uses_with_block(IRBasicBlock* from, IRBasicBlock* to);
 extern void remove_block_from_function(IRBasicBlock* bb);
 
 // --- 上下文结构体定义 ---
@@ -30,16 +37,38 @@ extern void remove_block_from_function(IRBasicBlock* bb);
  */
 typedef struct {
     IRFunction* func;              ///< 当前正在处理的函数
-    IRBuilder builder;             ///< 用于创建新指令（如无条件跳转）的构建器
-    bool changed_this_iteration;   ///< 标记当前一轮不动点迭代中是否发生了改变
+    MemoryPool* pool;              ///< 用于工作列表与 undef 值的内存池
+    Worklist* worklist;            ///< 待检查的基本块（可能含重复项和已删除的块）
+    bool may_have_dead_cycles;     ///< 自上次可达性扫描以来删除过边，可能留下不可达的环
     bool changed_overall;          ///< 标记整个优化过程中是否发生了任何改变
 } SimplifyCFGContext;
 
-// --- 各子优化遍的原型声明 ---
-static bool simplify_constant_branches(SimplifyCFGContext* ctx);
-static bool remove_unreachable_blocks(SimplifyCFGContext* ctx);
-static bool merge_sequential_blocks(SimplifyCFGContext* ctx);
-static bool thread_jumps(SimplifyCFGContext* ctx);
+// --- 各子优化的原型声明 ---
+static bool remove_dead_block(SimplifyCFGContext* ctx, IRBasicBlock* bb);
+static bool fold_constant_branch(SimplifyCFGContext* ctx, IRBasicBlock* bb);
+static bool thread_jump(SimplifyCFGContext* ctx, IRBasicBlock* bb_b);
+static bool merge_into_predecessor(SimplifyCFGContext* ctx, IRBasicBlock* bb_a);
+static bool remove_unreachable_cycles(SimplifyCFGContext* ctx);
+
+// --- 工作列表辅助函数 ---
+
+static void enqueue_block(SimplifyCFGContext* ctx, IRBasicBlock* bb) {
+    if (bb && bb->parent) {
+        worklist_add(ctx->worklist, bb);
+    }
+}
+
+// 从 block 的前驱数组中移除一个 pred 条目，不触碰 PHI（用于两条边指向同一目标时只去掉其中一条）。
+static void drop_predecessor_entry(IRBasicBlock* block, IRBasicBlock* pred) {
+    for (int i = 0; i < block->num_predecessors; ++i) {
+        if (block->predecessors[i] == pred) {
+            memmove(&block->predecessors[i], &block->predecessors[i + 1],
+                    (block->num_predecessors - i - 1) * sizeof(IRBasicBlock*));
+            block->num_predecessors--;
+            return;
+        }
+    }
+}
 
 // --- 主入口函数 ---
 bool run_simplify_cfg(IRFunction* func) {
@@ -49,37 +78,48 @@ bool run_simplify_cfg(IRFunction* func) {
         }
         return false;
     }
-    
+
     SimplifyCFGContext ctx = {0};
     ctx.func = func;
-    ir_builder_init(&ctx.builder, func);
-    ctx.changed_overall = false;
+    ctx.pool = func->module->pool;
+    ctx.worklist = create_worklist(ctx.pool, func->block_count > 0 ? func->block_count * 2 : 16);
 
-    // 使用不动点迭代框架，确保所有简化机会都被发掘
-    while (true) {
-        ctx.changed_this_iteration = false;
+    // 其他遍不一定维护前驱/后继数组，开始时重建一次；此后由各变换就地维护
+    build_cfg(func);
 
-        // 在每轮迭代开始时，重新构建CFG和支配树信息，确保后续遍在最新的数据上操作
-        build_cfg(func);
-        compute_dominators(func);
+    // 逆序入队，使出队顺序与布局顺序一致（func->tail 并非所有建块路径都维护，不能依赖）
+    for (IRBasicBlock* bb = func->blocks; bb; bb = bb->next_in_func) {
+        worklist_add(ctx.worklist, bb);
+    }
+    for (int i = 0, j = ctx.worklist->count - 1; i < j; ++i, --j) {
+        void* tmp = ctx.worklist->items[i];
+        ctx.worklist->items[i] = ctx.worklist->items[j];
+        ctx.worklist->items[j] = tmp;
+    }
 
-        // 按顺序执行各个子优化遍
-        if (simplify_constant_branches(&ctx)) {
-            // 如果常量折叠改变了CFG，立即重建CFG，以便后续遍能看到变化
-            build_cfg(func);
-            compute_dominators(func);
+    while (true) {
+        while (ctx.worklist->count > 0) {
+            IRBasicBlock* bb = (IRBasicBlock*)worklist_pop(ctx.worklist);
+            if (!bb->parent) continue; // 入队后已被删除或合并
+
+            if (remove_dead_block(&ctx, bb) ||
+                fold_constant_branch(&ctx, bb) ||
+                thread_jump(&ctx, bb) ||
+                merge_into_predecessor(&ctx, bb)) {
+                ctx.changed_overall = true;
+            }
         }
-        
-        thread_jumps(&ctx);
-        merge_sequential_blocks(&ctx);
-        remove_unreachable_blocks(&ctx);
-
-        if (ctx.changed_this_iteration) {
-            ctx.changed_overall = true;
-        } else {
-            // 如果在一整轮迭代中没有任何改变，说明已达到不动点，可以退出循环
+
+        // 工作列表清空后，只剩下“每个块都有前驱”的不可达环需要全局扫描发现
+        if (!ctx.may_have_dead_cycles || !remove_unreachable_cycles(&ctx)) {
             break;
         }
+        ctx.changed_overall = true;
+    }
+
+    // 变换过程中一直只维护前驱/后继数组，支配信息在这里统一重算一次
+    if (ctx.changed_overall) {
+        compute_dominators(func);
     }
 
     if (ctx.changed_overall && func->module && func->module->log_config) {
@@ -89,223 +129,252 @@ bool run_simplify_cfg(IRFunction* func) {
     return ctx.changed_overall;
 }
 
+bool remove_unreachable_blocks(IRFunction* func) {
+    if (!func || !func->entry) return false;
+
+    SimplifyCFGContext ctx = {0};
+    ctx.func = func;
+    ctx.pool = func->module->pool;
+    ctx.worklist = create_worklist(ctx.pool, 16); // 只承接 delete_block 的入队，不会被处理
+    return remove_unreachable_cycles(&ctx);
+}
+
 
-// --- 各子优化遍的实现 ---
+// --- 各子优化的实现 ---
 
 /**
- * @brief 子优化：常量分支折叠。
- * @details 查找所有条件为常量的 `br` 指令，并将其替换为指向相应目标的无条件 `br` 指令。
- *          同时，更新CFG中断开的边。
+ * @brief 删除一个基本块：断开它的所有出边，擦除其中的指令，并把它从函数中移除。
+ * @details 块中定义、但仍被其他（同样不可达的）块使用的值被替换为 undef。
  */
-static bool simplify_constant_branches(SimplifyCFGContext* ctx) {
-    bool changed_locally = false;
-    
-    // 遍历块列表的副本，因为原始列表可能在变换中被修改
-    Worklist* blocks_to_check = create_worklist(ctx->func->module->pool, ctx->func->block_count);
-    for (IRBasicBlock* bb = ctx->func->blocks; bb; bb = bb->next_in_func) {
-        worklist_add(blocks_to_check, bb);
+static void delete_block(SimplifyCFGContext* ctx, IRBasicBlock* bb) {
+    if (ctx->func->module && ctx->func->module->log_config) {
+        LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Removing unreachable block %s", bb->label);
+    }
+
+    // 断开出边；remove_predecessor 同时移除后继 PHI 中来自本块的入口
+    for (int i = 0; i < bb->num_successors; ++i) {
+        IRBasicBlock* succ = bb->successors[i];
+        if (succ == bb || !succ->parent) continue;
+        remove_predecessor(succ, bb);
+        if (succ->num_predecessors > 0) {
+            ctx->may_have_dead_cycles = true;
+        }
+        enqueue_block(ctx, succ);
     }
-    
-    while (blocks_to_check->count > 0) {
-        IRBasicBlock* bb = (IRBasicBlock*)worklist_pop(blocks_to_check);
-        // 只关心以条件分支结尾的块
-        if (!bb || !bb->tail || bb->tail->opcode != IR_OP_BR || bb->tail->num_operands <= 1) continue;
-
-        IROperand* term_cond_op = bb->tail->operand_head;
-        if (term_cond_op->kind != IR_OP_KIND_VALUE) continue;
-        IRValue* cond = term_cond_op->data.value;
-        if (!cond->is_constant) continue;
-
-        changed_locally = true;
-        ctx->changed_this_iteration = true;
-        
-        if (ctx->func->module && ctx->func->module->log_config) {
-            LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Folding branch in %s", bb->label);
+    bb->num_successors = 0;
+    bb->num_predecessors = 0;
+
+    // 从后往前擦除，块内的使用总在定义之后
+    for (IRInstruction* instr = bb->tail; instr; ) {
+        IRInstruction* prev = instr->prev;
+        if (instr->dest && instr->dest->use_list_head) {
+            replace_all_uses_with(NULL, instr->dest, get_undef_value(instr->dest->type, ctx->pool));
         }
+        erase_instruction(instr);
+        instr = prev;
+    }
+    remove_block_from_function(bb);
+}
+
+/**
+ * @brief 子优化：不可达块消除（局部部分）。
+ * @details 非入口块失去最后一个前驱时即不可达，直接删除。
+ */
+static bool remove_dead_block(SimplifyCFGContext* ctx, IRBasicBlock* bb) {
+    if (bb == ctx->func->entry || bb->num_predecessors > 0) return false;
+    delete_block(ctx, bb);
+    return true;
+}
 
-        // 确定保留的分支和要移除的分支
-        IRBasicBlock* true_dest = bb->tail->operand_head->next_in_instr->data.bb;
-        IRBasicBlock* false_dest = bb->tail->operand_head->next_in_instr->next_in_instr->data.bb;
-        
-        IRBasicBlock* kept_dest = (cond->int_val != 0) ? true_dest : false_dest;
-        IRBasicBlock* dead_dest = (cond->int_val != 0) ? false_dest : true_dest;
-        
-        // 更新CFG：从死分支的前驱中移除当前块，并从当前块的后继中移除死分支
+/**
+ * @brief 子优化：常量分支折叠。
+ * @details 把条件为常量的 `br` 原地改写为指向相应目标的无条件 `br`，
+ *          并断开通往死目标的边。
+ */
+static bool fold_constant_branch(SimplifyCFGContext* ctx, IRBasicBlock* bb) {
+    IRInstruction* br = bb->tail;
+    // 只关心以条件分支结尾的块
+    if (!br || br->opcode != IR_OP_BR || br->num_operands <= 1) return false;
+
+    IROperand* cond_op = br->operand_head;
+    if (cond_op->kind != IR_OP_KIND_VALUE) return false;
+    IRValue* cond = cond_op->data.value;
+    if (!cond->is_constant) return false;
+
+    if (ctx->func->module && ctx->func->module->log_config) {
+        LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Folding branch in %s", bb->label);
+    }
+
+    // 确定保留的分支和要移除的分支
+    IROperand* true_op = cond_op->next_in_instr;
+    IROperand* false_op = true_op->next_in_instr;
+    IRBasicBlock* kept_dest = (cond->int_val != 0) ? true_op->data.bb : false_op->data.bb;
+    IRBasicBlock* dead_dest = (cond->int_val != 0) ? false_op->data.bb : true_op->data.bb;
+
+    // `br c, K, D` -> `br K`：去掉条件与死目标两个操作数
+    remove_operand(cond_op);
+    remove_operand(cond->int_val != 0 ? false_op : true_op);
+
+    // 更新CFG：从死分支的前驱中移除当前块，并从当前块的后继中移除死分支
+    remove_successor(bb, dead_dest);
+    if (dead_dest == kept_dest) {
+        drop_predecessor_entry(dead_dest, bb); // 边仍然存在，PHI 入口保留
+    } else {
         remove_predecessor(dead_dest, bb);
-        remove_successor(bb, dead_dest);
-        
-        // 擦除旧的条件分支，并创建一个新的无条件分支
-        erase_instruction(bb->tail);
-        ir_builder_set_insertion_block_end(&ctx->builder, bb);
-        ir_builder_create_br(&ctx->builder, kept_dest);
+        if (dead_dest->num_predecessors > 0) {
+            ctx->may_have_dead_cycles = true;
+        }
     }
-    return changed_locally;
+
+    enqueue_block(ctx, dead_dest);
+    enqueue_block(ctx, bb); // 变为无条件跳转后可能可以合并或被绕过
+    return true;
 }
 
 /**
- * @brief 子优化：不可达块消除。
- * @details 从入口块开始进行图遍历，标记所有可达的块。然后遍历函数中的所有块，
- *          移除所有未被标记为可达的块。
+ * @brief 子优化：跳转线程化。
+ * @details 若 B 是只包含一个无条件跳转的"跳板"块 (`br %C`)，
+ *          则将所有指向 B 的块 A 的跳转目标直接修改为 C。
+ *          C 中的每个 PHI 为每个 A 增加一个入口，取值与原来来自 B 的入口相同；
+ *          若某个 A 本来就是 C 的前驱且 PHI 对 A、B 取值不同，则不能线程化。
  */
-static bool remove_unreachable_blocks(SimplifyCFGContext* ctx) {
-    if (!ctx->func->entry) return false;
-    
-    BitSet* reachable = bitset_create(ctx->func->block_count, ctx->func->module->pool);
-    Worklist* wl = create_worklist(ctx->func->module->pool, ctx->func->block_count);
-    
-    // 从入口块开始进行前向遍历
-    worklist_add(wl, ctx->func->entry);
-    bitset_add(reachable, ctx->func->entry->post_order_id, ctx->func->module->log_config);
-
-    while (wl->count > 0) {
-        IRBasicBlock* bb = (IRBasicBlock*)worklist_pop(wl);
-        for (int i = 0; i < bb->num_successors; ++i) {
-            IRBasicBlock* succ = bb->successors[i];
-            if (!bitset_contains(reachable, succ->post_order_id)) {
-                bitset_add(reachable, succ->post_order_id, ctx->func->module->log_config);
-                worklist_add(wl, succ);
+static bool thread_jump(SimplifyCFGContext* ctx, IRBasicBlock* bb_b) {
+    // 查找"跳板"块：只有一个无条件跳转指令
+    if (bb_b->head != bb_b->tail || !bb_b->head || bb_b->head->opcode != IR_OP_BR || bb_b->head->num_operands != 1) return false;
+    if (bb_b == ctx->func->entry || bb_b->num_predecessors == 0) return false;
+
+    IRBasicBlock* bb_c = bb_b->head->operand_head->data.bb;
+    if (bb_c == bb_b) return false; // 忽略到自身的循环
+
+    // 检查所有前驱是否可线程化
+    for (int i = 0; i < bb_b->num_predecessors; ++i) {
+        IRBasicBlock* pred_a = bb_b->predecessors[i];
+        if (pred_a == bb_c) return false; // C -> B -> C：redirect_edge 不处理自环
+        for (IRInstruction* phi = bb_c->head; phi && phi->opcode == IR_OP_PHI; phi = phi->next) {
+            IRValue* val_from_b = phi_get_incoming_value_for_block(phi, bb_b);
+            IRValue* val_from_a = phi_get_incoming_value_for_block(phi, pred_a);
+            if (val_from_b == NULL || (val_from_a != NULL && val_from_a != val_from_b)) {
+                return false;
             }
         }
     }
 
-    bool changed_locally = false;
-    // 反向遍历块链表，直接删除不可达块
-    for (IRBasicBlock* bb = ctx->func->tail; bb; ) {
-        IRBasicBlock* prev = bb->prev_in_func;
-        if (bb != ctx->func->entry && !bitset_contains(reachable, bb->post_order_id)) {
-            if (!changed_locally) {
-                changed_locally = true;
-                ctx->changed_this_iteration = true;
-                
-                if (ctx->func->module && ctx->func->module->log_config) {
-                    LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Removing unreachable block %s", bb->label);
-                }
+    if (ctx->func->module && ctx->func->module->log_config) {
+        LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Threading jump through %s to %s", bb_b->label, bb_c->label);
+    }
+
+    // 重定向所有 B 的前驱，让它们直接跳转到 C，并为 C 的 PHI 补上来自 A 的入口
+    while (bb_b->num_predecessors > 0) {
+        IRBasicBlock* pred_a = bb_b->predecessors[0];
+        redirect_edge(pred_a, bb_b, bb_c);
+        for (IRInstruction* phi = bb_c->head; phi && phi->opcode == IR_OP_PHI; phi = phi->next) {
+            if (phi_get_incoming_value_for_block(phi, pred_a) == NULL) {
+                add_value_operand(phi, phi_get_incoming_value_for_block(phi, bb_b));
+                add_bb_operand(phi, pred_a);
             }
-            remove_block_from_function(bb);
         }
-        bb = prev;
+        enqueue_block(ctx, pred_a);
     }
-    return changed_locally;
+
+    // B 已没有前驱，下次出队时被删除（同时移除 C 的 PHI 中来自 B 的入口）
+    enqueue_block(ctx, bb_c);
+    enqueue_block(ctx, bb_b);
+    return true;
 }
 
 /**
- * @brief 子优化：跳转线程化。
- * @details 查找只包含一个无条件跳转的"跳板"块 B (`br %C`)。
- *          然后将所有指向 B 的块 A 的跳转目标直接修改为 C。
- *          增强的PHI处理：对于C中的PHI节点，将来自B的入口重写为来自A的入口。
+ * @brief 子优化：合并顺序块。
+ * @details 若块 A 以无条件跳转结尾，其唯一后继 B 只有一个前驱 A，且 B 不包含
+ *          PHI 指令，则将 B 的所有指令移动到 A 的末尾，A 接管 B 的出边，并移除 B。
  */
-static bool thread_jumps(SimplifyCFGContext* ctx) {
-    bool changed_locally = false;
-    bool needs_restart = true;
-
-    while (needs_restart) {
-        needs_restart = false;
-        Worklist* blocks_to_check = create_worklist(ctx->func->module->pool, ctx->func->block_count);
-        for (IRBasicBlock* bb = ctx->func->blocks; bb; bb = bb->next_in_func) {
-            worklist_add(blocks_to_check, bb);
-        }
+static bool merge_into_predecessor(SimplifyCFGContext* ctx, IRBasicBlock* bb_a) {
+    // A 必须以无条件跳转结尾，且只有一个后继
+    if (!bb_a->tail || bb_a->tail->opcode != IR_OP_BR || bb_a->tail->num_operands != 1 || bb_a->num_successors != 1) return false;
 
-        while(blocks_to_check->count > 0) {
-            IRBasicBlock* bb_b = (IRBasicBlock*)worklist_pop(blocks_to_check);
-            // 查找"跳板"块：只有一个无条件跳转指令
-            if (bb_b->head != bb_b->tail || !bb_b->head || bb_b->head->opcode != IR_OP_BR || bb_b->head->num_operands != 1) continue;
-            if (bb_b == ctx->func->entry || bb_b->num_predecessors == 0) continue;
-
-            IRBasicBlock* bb_c = bb_b->head->operand_head->data.bb;
-            if (bb_c == bb_b) continue; // 忽略到自身的循环
-
-            // 检查所有前驱是否可线程化（保持原有 can_thread 逻辑）
-            bool can_thread = true;
-            for (int i = 0; i < bb_b->num_predecessors; ++i) {
-                IRBasicBlock* pred_a = bb_b->predecessors[i];
-                for (IRInstruction* phi = bb_c->head; phi && phi->opcode == IR_OP_PHI; phi = phi->next) {
-                    IRValue* val_from_b = phi_get_incoming_value_for_block(phi, bb_b);
-                    if (val_from_b == NULL) {
-                        IRValue* val_from_a = phi_get_incoming_value_for_block(phi, pred_a);
-                        if (val_from_a == NULL) {
-                            can_thread = false;
-                            break;
-                        }
-                    }
-                }
-                if (!can_thread) break;
-            }
-            if (!can_thread) continue;
+    IRBasicBlock* bb_b = bb_a->successors[0];
 
-            if (ctx->func->module && ctx->func->module->log_config) {
-                LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Threading jump through %s to %s", bb_b->label, bb_c->label);
-            }
+    // B 的唯一前驱必须是 A，且 B 不能是入口块
+    if (bb_b == bb_a || bb_b == ctx->func->entry || bb_b->num_predecessors != 1) return false;
 
-            // 重定向所有 B 的前驱，让它们直接跳转到 C，并用通用 PHI 修复函数修正 SSA 数据流
-            while (bb_b->num_predecessors > 0) {
-                IRBasicBlock* pred_a = bb_b->predecessors[0];
-                redirect_edge(pred_a, bb_b, bb_c);
-                // 通用 PHI 修复，保证 pred_a -> bb_c 的 SSA 正确性
-                repair_phi_nodes_after_edge_redirect(bb_c, pred_a, bb_b);
-            }
+    // B 不能有 PHI 指令，因为合并后 PHI 指令会变得无效
+    if (bb_b->head && bb_b->head->opcode == IR_OP_PHI) return false;
 
-            changed_locally = true;
-            ctx->changed_this_iteration = true;
-            needs_restart = true;
-            break;
+    if (ctx->func->module && ctx->func->module->log_config) {
+        LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Merging block %s into %s", bb_b->label, bb_a->label);
+    }
+
+    // 1. 移除 A 的终结符指令，并将 B 的所有指令移动到 A 的末尾
+    erase_instruction(bb_a->tail);
+    if (bb_b->head) {
+        move_instructions_to_block_end(bb_b, bb_a);
+    }
+
+    // 2. A 接管 B 的出边。B 只有 A 一个前驱，因此除 A 原来的终结符外，
+    //    对 B 的引用只可能出现在 B 的后继的 PHI 中
+    bb_a->successors = bb_b->successors;
+    bb_a->num_successors = bb_b->num_successors;
+    bb_a->capacity_successors = bb_b->capacity_successors;
+    for (int i = 0; i < bb_b->num_successors; ++i) {
+        IRBasicBlock* succ = bb_b->successors[i];
+        for (int j = 0; j < succ->num_predecessors; ++j) {
+            if (succ->predecessors[j] == bb_b) {
+                succ->predecessors[j] = bb_a;
+                break;
+            }
         }
+        change_phi_predecessor(succ, bb_b, bb_a);
     }
-    return changed_locally;
+
+    // 3. 从函数中彻底移除块 B
+    bb_b->successors = NULL;
+    bb_b->num_successors = 0;
+    bb_b->capacity_successors = 0;
+    bb_b->num_predecessors = 0;
+    remove_block_from_function(bb_b);
+
+    enqueue_block(ctx, bb_a); // 新的终结符可能带来新的折叠或合并机会
+    return true;
 }
 
 /**
- * @brief 子优化：合并顺序块。
- * @details 查找一个块 A，它只有一个后继 B，且 B 只有一个前驱 A。
- *          如果 B 不包含 PHI 指令，则可以将 B 的所有指令移动到 A 的末尾，并移除 B。
+ * @brief 子优化：不可达块消除（全局部分）。
+ * @details 从入口块开始进行图遍历，标记所有可达的块，然后删除所有未被标记的块。
+ *          只用于找出局部规则发现不了的不可达环。
+ *          块编号借用 `post_order_id`：它随后会被支配信息的重算覆盖。
  */
-static bool merge_sequential_blocks(SimplifyCFGContext* ctx) {
-    bool changed_locally = false;
-    bool needs_restart = true;
-    
-    while (needs_restart) {
-        needs_restart = false;
-        Worklist* blocks_to_check = create_worklist(ctx->func->module->pool, ctx->func->block_count);
-        for (IRBasicBlock* bb = ctx->func->blocks; bb; bb = bb->next_in_func) {
-            worklist_add(blocks_to_check, bb);
-        }
+static bool remove_unreachable_cycles(SimplifyCFGContext* ctx) {
+    int num_blocks = 0;
+    for (IRBasicBlock* bb = ctx->func->blocks; bb; bb = bb->next_in_func) {
+        bb->post_order_id = num_blocks++;
+    }
+    BitSet* reachable = bitset_create(num_blocks, ctx->pool);
+    Worklist* wl = create_worklist(ctx->pool, num_blocks);
 
-        while(blocks_to_check->count > 0) {
-            IRBasicBlock* bb_a = (IRBasicBlock*)worklist_pop(blocks_to_check);
-
-            // A 必须以无条件跳转结尾，且只有一个后继
-            if (!bb_a->tail || bb_a->tail->opcode != IR_OP_BR || bb_a->num_successors != 1) continue;
-            
-            IRBasicBlock* bb_b = bb_a->successors[0];
-            
-            // B 的唯一前驱必须是 A，且 B 不能是入口块
-            if (bb_b == ctx->func->entry || bb_b->num_predecessors != 1) continue;
-            
-            // B 不能有 PHI 指令，因为合并后 PHI 指令会变得无效
-            if (bb_b->head && bb_b->head->opcode == IR_OP_PHI) continue;
-
-            if (ctx->func->module && ctx->func->module->log_config) {
-                LOG_DEBUG(ctx->func->module->log_config, LOG_CATEGORY_IR_OPT, "SimplifyCFG: Merging block %s into %s", bb_b->label, bb_a->label);
-            }
-            
-            // 1. 移除 A 的终结符指令
-            erase_instruction(bb_a->tail);
-            bb_a->tail = NULL;
-
-            // 2. 将 B 的所有指令移动到 A 的末尾
-            if (bb_b->head) {
-                move_instructions_to_block_end(bb_b, bb_a);
+    // 从入口块开始进行前向遍历
+    worklist_add(wl, ctx->func->entry);
+    bitset_add(reachable, ctx->func->entry->post_order_id, ctx->func->module->log_config);
+    while (wl->count > 0) {
+        IRBasicBlock* bb = (IRBasicBlock*)worklist_pop(wl);
+        for (int i = 0; i < bb->num_successors; ++i) {
+            IRBasicBlock* succ = bb->successors[i];
+            if (!bitset_contains(reachable, succ->post_order_id)) {
+                bitset_add(reachable, succ->post_order_id, ctx->func->module->log_config);
+                worklist_add(wl, succ);
             }
+        }
+    }
 
-            // 3. 更新所有对 B 的引用，使其指向 A
-            replace_all_uses_with_block(bb_b, bb_a);
-            // 4. 从函数中彻底移除块 B
-            remove_block_from_function(bb_b);
-
-            changed_locally = true;
-            ctx->changed_this_iteration = true;
-            needs_restart = true;
-            break;
+    // 先收集再删除：删除会改动块链表与其他块的前驱
+    Worklist* dead = create_worklist(ctx->pool, 16);
+    for (IRBasicBlock* bb = ctx->func->blocks; bb; bb = bb->next_in_func) {
+        if (!bitset_contains(reachable, bb->post_order_id)) {
+            worklist_add(dead, bb);
         }
     }
-    return changed_locally;
+    for (int i = 0; i < dead->count; ++i) {
+        delete_block(ctx, (IRBasicBlock*)dead->items[i]);
+    }
+    // 删除时标记的“可能残留不可达环”都来自这批块之间的边，它们已全部删除
+    ctx->may_have_dead_cycles = false;
+    return dead->count > 0;
 }
\ No newline at end of file
@@ -32,12 +32,14 @@ typedef struct DefList {
 /*
  * All helper functions are adapted to receive the ScannerContext* ctx
  * to access the memory pool and other state in a reentrant-safe way.
+ * Temporary lists go to node_pool (the current function body's arena);
+ * types go to the long-lived pool because the IR keeps referring to them.
 */
 
 // --- Adapted C Helper Functions ---
 
 static DefItem* create_def_item(ScannerContext* ctx, char* name, ASTNodeList* dims, ASTNode* init, SourceLocation loc) {
-    DefItem* item = (DefItem*)pool_alloc(ctx->ast_ctx->pool, sizeof(DefItem));
+    DefItem* item = (DefItem*)pool_alloc(ctx->ast_ctx->node_pool, sizeof(DefItem));
     item->name = name;
     item->dims = dims;
     item->init = init;
@@ -46,7 +48,7 @@ static DefItem* create_def_item(ScannerContext* ctx, char* name, ASTNodeList* di
 }
 
 static DefList* create_def_list(ScannerContext* ctx) {
-    DefList* list = (DefList*)pool_alloc(ctx->ast_ctx->pool, sizeof(DefList));
+    DefList* list = (DefList*)pool_alloc(ctx->ast_ctx->node_pool, sizeof(DefList));
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
@@ -58,7 +60,7 @@ static void add_to_def_list(ScannerContext* ctx, DefList* list, DefItem* item) {
     if (list->count >= list->capacity) {
         size_t old_capacity_in_bytes = list->capacity * sizeof(DefItem*);
         list->capacity = (list->capacity == 0) ? 8 : list->capacity * 2;
-        DefItem** new_items = (DefItem**)pool_alloc(ctx->ast_ctx->pool, list->capacity * sizeof(DefItem*));
+        DefItem** new_items = (DefItem**)pool_alloc(ctx->ast_ctx->node_pool, list->capacity * sizeof(DefItem*));
         if (list->items) {
             memcpy(new_items, list->items, old_capacity_in_bytes);
         }
@@ -68,7 +70,7 @@ static void add_to_def_list(ScannerContext* ctx, DefList* list, DefItem* item) {
 }
 
 static ASTNodeList* create_node_list(ScannerContext* ctx) {
-    ASTNodeList* list = (ASTNodeList*)pool_alloc(ctx->ast_ctx->pool, sizeof(ASTNodeList));
+    ASTNodeList* list = (ASTNodeList*)pool_alloc(ctx->ast_ctx->node_pool, sizeof(ASTNodeList));
     list->items = NULL;
     list->count = 0;
     list->capacity = 0;
@@ -80,7 +82,7 @@ static void add_to_node_list(ScannerContext* ctx, ASTNodeList* list, ASTNode* no
     if (list->count >= list->capacity) {
         size_t old_capacity_in_bytes = list->capacity * sizeof(ASTNode*);
         list->capacity = (list->capacity == 0) ? 8 : list->capacity * 2;
-        ASTNode** new_items = (ASTNode**)pool_alloc(ctx->ast_ctx->pool, list->capacity * sizeof(ASTNode*));
+        ASTNode** new_items = (ASTNode**)pool_alloc(ctx->ast_ctx->node_pool, list->capacity * sizeof(ASTNode*));
         if (list->items) {
             memcpy(new_items, list->items, old_capacity_in_bytes);
         }
@@ -151,7 +153,7 @@ static Type* build_final_type(ScannerContext* ctx, Type* base_type, ASTNodeList*
 %token CONST INT FLOAT VOID RETURN IF ELSE WHILE BREAK CONTINUE
 %token ADD SUB MUL DIV MOD EQ NE LT LE GT GE AND OR NOT ASSIGN LPAREN RPAREN LBRACE RBRACE LBRACKET RBRACKET SEMICOLON COMMA
 
-%type <ast_node> comp_unit func_def block stmt exp_stmt if_stmt while_stmt return_stmt break_stmt continue_stmt assign_stmt exp const_init_val init_val lval primary_exp number const_exp cond mul_exp add_exp rel_exp eq_exp l_and_exp l_or_exp func_arg unary_exp postfix_exp param_decl
+%type <ast_node> comp_unit func_def func_body block stmt exp_stmt if_stmt while_stmt return_stmt break_stmt continue_stmt assign_stmt exp const_init_val init_val lval primary_exp number const_exp cond mul_exp add_exp rel_exp eq_exp l_and_exp l_or_exp func_arg unary_exp postfix_exp param_decl
 %type <node_list> comp_item_list decl func_fparams block_item_list func_rparams array_dims const_init_list init_list subsequent_dims const_decl var_decl
 %type <node_list> non_empty_const_init_list non_empty_init_list // 新增: 用于支持尾部逗号的非终结符
 %type <type> type_specifier
@@ -269,8 +271,18 @@ init_list: non_empty_init_list { $$ = $1; }
 non_empty_init_list: init_val { $$ = create_node_list(ctx); add_to_node_list(ctx, $$, $1); }
     | non_empty_init_list COMMA init_val { add_to_node_list(ctx, $1, $3); $$ = $1; };
 
-func_def: type_specifier IDENTIFIER LPAREN func_fparams RPAREN block { $$ = create_func_decl(ctx->ast_ctx, $2->identifier.name, $1, $4->items, $4->count, $6, @$); }
-    | type_specifier IDENTIFIER LPAREN RPAREN block { $$ = create_func_decl(ctx->ast_ctx, $2->identifier.name, $1, NULL, 0, $5, @$); };
+/* 函数头（含参数）分配在顶层内存池中；函数体分配在独立的子内存池中，
+   降级为 IR 后即可释放 */
+func_def: type_specifier IDENTIFIER LPAREN func_fparams RPAREN func_body {
+    $6->compound_stmt.arena = ast_end_function_arena(ctx->ast_ctx);
+    $$ = create_func_decl(ctx->ast_ctx, $2->identifier.name, $1, $4->items, $4->count, $6, @$);
+}
+    | type_specifier IDENTIFIER LPAREN RPAREN func_body {
+    $5->compound_stmt.arena = ast_end_function_arena(ctx->ast_ctx);
+    $$ = create_func_decl(ctx->ast_ctx, $2->identifier.name, $1, NULL, 0, $5, @$);
+};
+
+func_body: { ast_begin_function_arena(ctx->ast_ctx); } block { $$ = $2; };
 
 func_fparams: param_decl { $$ = create_node_list(ctx); add_to_node_list(ctx, $$, $1); }
     | func_fparams COMMA param_decl { add_to_node_list(ctx, $1, $3); $$ = $1; };
@@ -3,8 +3,10 @@
 #include "parser.tab.h"
 #include "scanner_context.h"
 #include "semantic_analyzer.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 static bool has_errors(const ErrorContext* errors) {
     return errors && errors->count > 0;
@@ -46,18 +48,29 @@ int main(int argc, char** argv) {
     }
     yyset_extra(ctx, scanner);
 
-    FILE* in = fopen(input_filename, "r");
-    if (!in) {
-        fprintf(stderr, "FATAL: Could not open input file: %s\n", input_filename);
+    SourceBuffer source;
+    if (!source_buffer_open(&source, input_filename)) {
+        fprintf(stderr, "FATAL: Could not open input file: %s: %s\n", input_filename,
+                strerror(errno));
+        destroy_scanner_context(ctx);
+        yylex_destroy(scanner);
+        return 1;
+    }
+    ctx->ast_ctx->source_text = source.data;
+    ctx->ast_ctx->source_size = source.size;
+    struct yy_buffer_state* scan_buf =
+        yy_scan_buffer(source.data, source.size + SOURCE_BUFFER_PADDING, scanner);
+    if (!scan_buf) {
+        fprintf(stderr, "FATAL: Failed to set up scanner buffer for %s\n", input_filename);
+        source_buffer_close(&source);
         destroy_scanner_context(ctx);
         yylex_destroy(scanner);
         return 1;
     }
-    yyset_in(in, scanner);
 
     int pres = yyparse(scanner, ctx);
 
-    fclose(in);
+    yy_delete_buffer(scan_buf, scanner);
     yylex_destroy(scanner);
 
     // 语法分析通过后，进行语义分析
@@ -71,5 +84,6 @@ int main(int argc, char** argv) {
         ret = 1;
     }
     destroy_scanner_context(ctx);
+    source_buffer_close(&source);
     return ret;
 } 
\ No newline at end of file
@@ -2,25 +2,36 @@
  * @file semantic_analyzer.c
  * @brief 实现 SysY 编译器的语义分析器。
  * @details
- * 本文件实现了语义分析的功能。它通过对抽象语法树（AST）进行两遍遍历来完成工作：
- * 1.
- * **符号表构建**：第一遍遍历AST，为每个作用域（全局、函数、代码块）构建符号表，
- *    并将所有声明（变量、常量、函数）添加到对应的作用域中，同时检查符号重定义错误。
- * 2. **语义检查**：第二遍遍历AST，执行详细的检查，包括：
+ * 本文件实现了语义分析的功能。除了提前登记函数签名外，只对抽象语法树（AST）
+ * 进行一遍遍历，在同一次遍历中完成：
+ * 1. **符号表构建**：进入函数和代码块时建立并激活作用域，遇到声明（变量、常量、
+ *    参数）时立即加入当前作用域，同时检查符号重定义错误。
+ * 2. **语义检查**：离开节点时执行详细的检查，包括：
  *    - 类型检查：验证赋值、运算符、函数调用等场景下的类型兼容性。
- *    - 符号解析：确保所有使用的标识符都已声明。
- *    -
- * 控制流分析：检查非void函数是否在所有执行路径上都有返回值，以及break/continue语句是否在循环内。
- *    - 常量折叠：在编译时计算常量表达式的值。
+ *    - 符号解析：确保所有使用的标识符都已在使用之前声明。
+ *    - 控制流分析：检查非void函数是否有返回值，以及break/continue语句是否在循环内。
+ *    - 常量求值：常量声明在离开节点时求值，之后的引用即可折叠。
+ *
+ * 遍历分为两个阶段：
+ * - **全局阶段**（顺序）：登记所有函数签名（函数是唯一允许先使用后定义的实体），
+ *   再按源码顺序分析全局声明并求值各函数形参类型中的数组维度。
+ * - **函数体阶段**（可并行）：此后全局符号与函数签名都不再改变，各函数体只读
+ *   全局状态，可以在线程池上相互独立地检查。每个工作线程持有私有的类型内存池
+ *   与名字表；诊断按顶层声明分别缓存，最后按源码顺序合并，因此输出与线程数无关。
+ *   函数体只能看到在它之前声明的全局变量与常量，由全局符号的声明序号判定。
  */
 #include "semantic_analyzer.h"
 #include "ast.h"
 #include "error.h"
 #include "location.h" // for SourceLocation
 #include "logger.h"
+#include "parallel.h"
 #include "symbol_table.h"
+#include <assert.h>
 #include <stdbool.h> // for false, true, bool
+#include <stdint.h>  // for SIZE_MAX
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 //==============================================================================
@@ -39,8 +50,45 @@ typedef struct {
   int warning_count;         ///< 语义警告计数
   bool has_return_statement; ///< 标记当前函数体是否已包含return语句
   bool is_in_constant_context; ///< 标记当前是否在常量表达式求值上下文中
+  MemoryPool *pool; ///< 新建类型所用的内存池（函数体阶段为工作线程私有）
+  MemoryPool *node_pool; ///< 作用域与符号所用的内存池，函数内为函数体子内存池
+  ErrorContext *errors;  ///< 诊断写入的缓冲区（当前顶层声明所属的缓冲区）
+  NameTable *names;      ///< 函数作用域所挂的私有名字表（仅函数体阶段）
+  size_t visible_globals; ///< 可见的全局符号数：声明序号不小于它的全局符号
+                          ///< 定义在当前函数之后，对其不可见
+  ASTNodeId *traverse_stack; ///< `traverse_ast` 的祖先栈，容量为布局的最大深度
 } AnalysisContext;
 
+/**
+ * @brief 函数体阶段中一个顶层声明的输入与输出，按声明下标存放。
+ */
+typedef struct {
+  ASTNode *node;          ///< 顶层声明节点
+  ErrorContext errors;    ///< 该声明产生的诊断
+  size_t visible_globals; ///< (仅函数) 函数定义处已声明的全局符号数
+  int error_count;        ///< 函数体阶段的错误计数
+  int warning_count;      ///< 函数体阶段的警告计数
+} TopLevelItem;
+
+/**
+ * @brief 函数体阶段一个工作线程的私有状态。
+ */
+typedef struct {
+  MemoryPool *pool; ///< 类型内存池，阶段结束后并入 `ASTContext::pool`
+  NameTable *names; ///< 私有名字表，查找未命中时回退到全局名字表
+  ASTNodeId *traverse_stack; ///< 本线程各函数体共用的 `traverse_ast` 祖先栈
+} AnalysisWorker;
+
+/**
+ * @brief 函数体阶段的共享输入。
+ */
+typedef struct {
+  ASTContext *ast_ctx;
+  TopLevelItem *items;     ///< 所有顶层声明
+  size_t *functions;       ///< 函数定义在 items 中的下标
+  AnalysisWorker *workers; ///< 每个工作线程一份私有状态
+} FunctionPhase;
+
 /**
  * @brief 用于存储常量表达式求值结果的结构体。
  */
@@ -76,9 +124,13 @@ static void traverse_ast(ASTNode *node,
                          void (*pre_visit)(ASTNode *, AnalysisContext *),
                          void (*post_visit)(ASTNode *, AnalysisContext *),
                          AnalysisContext *actx);
-// 符号表构建的访问函数
-static void build_symbols_pre(ASTNode *node, AnalysisContext *actx);
-static void build_symbols_post(ASTNode *node, AnalysisContext *actx);
+static ASTNodeId *create_traverse_stack(const ASTLayout *layout);
+// 符号声明辅助函数
+static void declare_functions(ASTNode *root, AnalysisContext *actx);
+static void declare_object(ASTNode *node, const char *name, Type *type,
+                           bool is_const, AnalysisContext *actx);
+static void analyze_function_body(size_t index, unsigned worker,
+                                  void *user_data);
 // 语义检查辅助函数
 static void check_array_initializer(ASTNode *init_node, Type *target_type,
                                     bool is_const_context,
@@ -116,22 +168,114 @@ static bool is_type_compatible(Type *target, Type *source,
 //==============================================================================
 
 void perform_semantic_analysis(ASTContext *ctx) {
+  perform_semantic_analysis_with_threads(ctx, 1);
+}
+
+void perform_semantic_analysis_with_threads(ASTContext *ctx,
+                                            unsigned num_threads) {
   if (!ctx || !ctx->root)
     return;
 
   LOG_INFO(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
            "Starting semantic analysis");
 
-  AnalysisContext actx = {.ast_ctx = ctx, .current_scope = ctx->global_scope};
+  // 为整棵树编号并建立紧凑布局，之后的遍历在连续数组上顺序扫描
+  ast_build_layout(ctx);
+
+  AnalysisContext actx = {.ast_ctx = ctx,
+                          .current_scope = ctx->global_scope,
+                          .pool = ctx->pool,
+                          .node_pool = ctx->pool,
+                          .errors = &ctx->errors,
+                          .visible_globals = SIZE_MAX,
+                          .traverse_stack = create_traverse_stack(&ctx->layout)};
   add_predefined_symbols(&actx);
 
-  // Pass 1: 构建全局符号表和函数作用域
+  // 先登记所有函数签名，使函数可以在定义之前被调用
+  declare_functions(ctx->root, &actx);
+
+  ASTNode *root = ctx->root;
+  bool is_list = root->node_type == AST_COMPOUND_STMT;
+  size_t item_count = is_list ? root->compound_stmt.item_count : 1;
+  if (is_list)
+    root->compound_stmt.scope = ctx->global_scope;
+  TopLevelItem *items =
+      (TopLevelItem *)calloc(item_count ? item_count : 1, sizeof(TopLevelItem));
+  size_t *functions =
+      (size_t *)malloc((item_count ? item_count : 1) * sizeof(size_t));
+  if (!items || !functions) {
+    fprintf(stderr, "Fatal: out of memory during semantic analysis.\n");
+    exit(1);
+  }
+
+  // 全局阶段：按源码顺序分析全局声明，并求值函数形参的数组维度，
+  // 使函数体阶段的调用检查无需等待被调函数的定义
   LOG_DEBUG(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
-            "Building symbol tables (pass 1)");
-  traverse_ast(ctx->root, build_symbols_pre, build_symbols_post, &actx);
+            "Analyzing global declarations");
+  size_t function_count = 0;
+  for (size_t i = 0; i < item_count; ++i) {
+    ASTNode *item = is_list ? root->compound_stmt.items[i] : root;
+    items[i].node = item;
+    actx.errors = &items[i].errors;
+    if (item->node_type != AST_FUNC_DECL) {
+      traverse_ast(item, check_semantics_pre, check_semantics_post, &actx);
+      continue;
+    }
+    for (size_t j = 0; j < item->func_decl.param_count; ++j) {
+      traverse_ast(item->func_decl.params[j], check_semantics_pre,
+                   check_semantics_post, &actx);
+    }
+    items[i].visible_globals = ctx->global_scope->count;
+    functions[function_count++] = i;
+  }
+
+  // 函数体阶段：全局状态此后只读，各函数体在线程池上独立检查
+  if (num_threads == 0)
+    num_threads = 1;
+  if (num_threads > function_count)
+    num_threads = function_count ? (unsigned)function_count : 1;
+  LOG_DEBUG(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
+            "Analyzing %zu function bodies on %u thread(s)", function_count,
+            num_threads);
+  AnalysisWorker *workers =
+      (AnalysisWorker *)malloc(num_threads * sizeof(AnalysisWorker));
+  if (!workers) {
+    fprintf(stderr, "Fatal: out of memory during semantic analysis.\n");
+    exit(1);
+  }
+  for (unsigned w = 0; w < num_threads; ++w) {
+    workers[w].pool = create_memory_pool();
+    workers[w].names = create_name_table(ctx->global_scope);
+    workers[w].traverse_stack = create_traverse_stack(&ctx->layout);
+  }
+  FunctionPhase phase = {.ast_ctx = ctx,
+                         .items = items,
+                         .functions = functions,
+                         .workers = workers};
+  parallel_for(function_count, num_threads, analyze_function_body, &phase);
+  // 函数体阶段新建的类型会被 IR 继续引用，交由 AST 的主内存池持有
+  for (unsigned w = 0; w < num_threads; ++w) {
+    pool_merge(ctx->pool, workers[w].pool);
+    destroy_name_table(workers[w].names);
+    free(workers[w].traverse_stack);
+  }
+  free(workers);
+
+  // 按源码顺序合并诊断：输出与线程数及调度顺序无关
+  actx.errors = &ctx->errors;
+  for (size_t i = 0; i < item_count; ++i) {
+    merge_error_context(&ctx->errors, &items[i].errors);
+    free_error_context(&items[i].errors);
+    actx.error_count += items[i].error_count;
+    actx.warning_count += items[i].warning_count;
+  }
+  free(items);
+  free(functions);
+  free(actx.traverse_stack);
 
-  // main 函数唯一性和签名检查 (保持不变)
-  Symbol *main_sym = find_symbol_in_scope(ctx->global_scope, "main");
+  // main 函数唯一性和签名检查
+  Symbol *main_sym =
+      find_symbol_in_scope(ctx->global_scope, ast_intern_cstr(ctx, "main"));
   if (!main_sym) {
     add_error(&ctx->errors, ERROR_UNDEFINED_VARIABLE,
               "Program must define a function 'main'",
@@ -158,23 +302,6 @@ void perform_semantic_analysis(ASTContext *ctx) {
     }
   }
 
-  // NEW: Pass 1.5: 在进行详细语义检查前，提前求值所有全局常量
-  LOG_DEBUG(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
-            "Evaluating global constants (pass 1.5)");
-  for (size_t i = 0; i < ctx->root->compound_stmt.item_count; ++i) {
-    ASTNode *item = ctx->root->compound_stmt.items[i];
-    if (item->node_type == AST_CONST_DECL) {
-      evaluate_single_const_decl(item, &actx);
-    }
-  }
-
-  // Pass 2: 统一的语义检查遍历
-  // check_semantics_pre: 添加局部符号，进入作用域
-  // check_semantics_post: 类型检查，求值常量，退出作用域
-  LOG_DEBUG(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
-            "Performing unified semantic checks (pass 2)");
-  traverse_ast(ctx->root, check_semantics_pre, check_semantics_post, &actx);
-
   LOG_INFO(&ctx->log_config, LOG_CATEGORY_SEMANTIC,
            "Semantic analysis completed with %d errors, %d warnings",
            ctx->errors.count, actx.warning_count);
@@ -184,109 +311,64 @@ void perform_semantic_analysis(ASTContext *ctx) {
 // 4. 增强的遍历实现 (Enhanced Traversal Implementation)
 //==============================================================================
 
-// 递归遍历AST节点
+/**
+ * @brief 以 node 为根遍历子树，依次触发前序与后序回调。
+ * @details 直接顺序扫描 `ASTLayout` 中的连续数组：子树恰好是区间
+ *          `[id, subtree_end[id])`，用一个显式栈记录尚未触发后序回调的祖先，
+ *          扫描位置越过某个祖先的子树末尾时即补发其后序回调。
+ *          访问顺序与按子节点指针递归遍历完全一致（含类型中的维度表达式）。
+ *          祖先栈取自 `actx->traverse_stack`，因此回调中不能再嵌套调用本函数。
+ */
 static void traverse_ast(ASTNode *node,
                          void (*pre_visit)(ASTNode *, AnalysisContext *),
                          void (*post_visit)(ASTNode *, AnalysisContext *),
                          AnalysisContext *actx) {
   if (!node)
     return;
-  if (pre_visit)
-    pre_visit(node, actx);
-  switch (node->node_type) {
-  case AST_COMPOUND_STMT:
-    for (size_t i = 0; i < node->compound_stmt.item_count; i++) {
-      traverse_ast(node->compound_stmt.items[i], pre_visit, post_visit, actx);
-    }
-    break;
-  case AST_FUNC_DECL:
-    for (size_t i = 0; i < node->func_decl.param_count; ++i) {
-      traverse_ast(node->func_decl.params[i], pre_visit, post_visit, actx);
-    }
-    traverse_ast(node->func_decl.body, pre_visit, post_visit, actx);
-    break;
-  case AST_FUNC_PARAM:
-    // 新增：遍历参数类型中的维度表达式
-    if (node->func_param.param_type &&
-        node->func_param.param_type->kind == TYPE_ARRAY) {
-      for (size_t i = 0; i < node->func_param.param_type->array.dim_count;
-           ++i) {
-        traverse_ast(node->func_param.param_type->array.dimensions[i].dim_expr,
-                     pre_visit, post_visit, actx);
-      }
-    }
-    break;
-  case AST_VAR_DECL:
-    if (node->var_decl.var_type &&
-        node->var_decl.var_type->kind == TYPE_ARRAY) {
-      for (size_t i = 0; i < node->var_decl.var_type->array.dim_count; ++i) {
-        traverse_ast(node->var_decl.var_type->array.dimensions[i].dim_expr,
-                     pre_visit, post_visit, actx);
-      }
-    }
-    traverse_ast(node->var_decl.init_value, pre_visit, post_visit, actx);
-    break;
-  case AST_CONST_DECL:
-    if (node->const_decl.const_type &&
-        node->const_decl.const_type->kind == TYPE_ARRAY) {
-      for (size_t i = 0; i < node->const_decl.const_type->array.dim_count;
-           ++i) {
-        traverse_ast(node->const_decl.const_type->array.dimensions[i].dim_expr,
-                     pre_visit, post_visit, actx);
-      }
-    }
-    traverse_ast(node->const_decl.value, pre_visit, post_visit, actx);
-    break;
-  case AST_IF_STMT:
-    traverse_ast(node->if_stmt.cond, pre_visit, post_visit, actx);
-    traverse_ast(node->if_stmt.then_stmt, pre_visit, post_visit, actx);
-    traverse_ast(node->if_stmt.else_stmt, pre_visit, post_visit, actx);
-    break;
-  case AST_WHILE_STMT:
-    traverse_ast(node->while_stmt.cond, pre_visit, post_visit, actx);
-    traverse_ast(node->while_stmt.body, pre_visit, post_visit, actx);
-    break;
-  case AST_RETURN_STMT:
-    traverse_ast(node->return_stmt.value, pre_visit, post_visit, actx);
-    break;
-  case AST_EXPR_STMT:
-    traverse_ast(node->expr_stmt.expr, pre_visit, post_visit, actx);
-    break;
-  case AST_ASSIGN_STMT:
-    traverse_ast(node->assign_stmt.lval, pre_visit, post_visit, actx);
-    traverse_ast(node->assign_stmt.expr, pre_visit, post_visit, actx);
-    break;
-  case AST_BINARY_EXPR:
-    traverse_ast(node->binary_expr.left, pre_visit, post_visit, actx);
-    traverse_ast(node->binary_expr.right, pre_visit, post_visit, actx);
-    break;
-  case AST_UNARY_EXPR:
-    traverse_ast(node->unary_expr.operand, pre_visit, post_visit, actx);
-    break;
-  case AST_CALL_EXPR:
-    traverse_ast(node->call_expr.callee_expr, pre_visit, post_visit, actx);
-    for (size_t i = 0; i < node->call_expr.arg_count; ++i) {
-      traverse_ast(node->call_expr.args[i], pre_visit, post_visit, actx);
-    }
-    break;
-  case AST_ARRAY_ACCESS:
-    traverse_ast(node->array_access.array, pre_visit, post_visit, actx);
-    traverse_ast(node->array_access.index, pre_visit, post_visit, actx);
-    break;
-  case AST_ARRAY_INIT:
-    for (size_t i = 0; i < node->array_init.elem_count; ++i) {
-      traverse_ast(node->array_init.elements[i], pre_visit, post_visit, actx);
-    }
-    break;
-  default:
-    break;
+  const ASTLayout *layout = &actx->ast_ctx->layout;
+  assert(node->id < layout->count && layout->nodes[node->id] == node &&
+         "traverse_ast requires ast_build_layout");
+  ASTNode *const *nodes = layout->nodes;
+  const ASTNodeId *subtree_end = layout->subtree_end;
+  ASTNodeId begin = node->id;
+  ASTNodeId end = subtree_end[begin];
+
+  ASTNodeId *open = actx->traverse_stack;
+  size_t top = 0;
+  for (ASTNodeId id = begin; id < end; ++id) {
+    while (top > 0 && subtree_end[open[top - 1]] <= id) {
+      ASTNodeId done = open[--top];
+      if (post_visit)
+        post_visit(nodes[done], actx);
+    }
+    if (pre_visit)
+      pre_visit(nodes[id], actx);
+    open[top++] = id;
+  }
+  while (top > 0) {
+    ASTNodeId done = open[--top];
+    if (post_visit)
+      post_visit(nodes[done], actx);
   }
-  if (post_visit)
-    post_visit(node, actx);
+}
+
+/**
+ * @brief 分配一个能容纳布局中最深祖先链的 `traverse_ast` 栈。
+ * @details 每个分析上下文（全局阶段一个、函数体阶段每个工作线程一个）只分配
+ *          一次，在所有 `traverse_ast` 调用之间复用。
+ */
+static ASTNodeId *create_traverse_stack(const ASTLayout *layout) {
+  size_t depth = layout->max_depth ? layout->max_depth : 1;
+  ASTNodeId *stack = (ASTNodeId *)malloc(depth * sizeof(ASTNodeId));
+  if (!stack) {
+    fprintf(stderr, "Fatal: out of memory during semantic analysis.\n");
+    exit(1);
+  }
+  return stack;
 }
 
 //==============================================================================
-// 5. 增强的符号表构建 (第一遍) (Enhanced Symbol Table Construction - Pass 1)
+// 5. 符号声明 (Symbol Declaration)
 //==============================================================================
 
 // 标准库函数名列表，用于防止用户重定义
@@ -303,55 +385,122 @@ static bool is_stdlib_name(const char *name) {
   return false;
 }
 
-// 在进入节点时构建符号
-static void build_symbols_pre(ASTNode *node, AnalysisContext *actx) {
-  if (!node)
+/**
+ * @brief 扫描顶层声明列表，为每个函数定义登记函数符号。
+ * @details 只访问根节点的直接子节点，不遍历函数体。形参类型中的数组维度
+ *          随后在全局阶段求值。
+ */
+static void declare_functions(ASTNode *root, AnalysisContext *actx) {
+  if (!root || root->node_type != AST_COMPOUND_STMT)
     return;
   char msg_buffer[256];
-
-  switch (node->node_type) {
-  case AST_FUNC_DECL: {
+  for (size_t i = 0; i < root->compound_stmt.item_count; ++i) {
+    ASTNode *node = root->compound_stmt.items[i];
+    if (!node || node->node_type != AST_FUNC_DECL)
+      continue;
     // 检查是否重定义标准库函数
     if (is_stdlib_name(node->func_decl.func_name)) {
       snprintf(msg_buffer, sizeof(msg_buffer),
                "Redefinition of standard library symbol '%s' is not allowed.",
                node->func_decl.func_name);
-      add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
+      add_error(actx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
                 node->loc);
       actx->error_count++;
       node->sym = NULL;
-      break;
+      continue;
     }
-    // 检查在当前作用域中是否重定义
+    // 检查在全局作用域中是否重定义
     Symbol *existing_sym =
         find_symbol_in_scope(actx->current_scope, node->func_decl.func_name);
     if (existing_sym) {
       snprintf(msg_buffer, sizeof(msg_buffer), "Redefinition of function '%s'.",
                node->func_decl.func_name);
-      add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
+      add_error(actx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
                 node->loc);
       actx->error_count++;
       node->sym = existing_sym;
+      continue;
+    }
+    // 创建函数类型 - 优化：直接传递参数节点数组，避免中间内存分配
+    Type *func_type = create_function_type_from_params(
+        node->func_decl.return_type, node->func_decl.params,
+        node->func_decl.param_count, false, actx->pool);
+    add_symbol(actx->current_scope, node->func_decl.func_name, func_type, true,
+               true, actx->node_pool);
+    node->sym =
+        find_symbol_in_scope(actx->current_scope, node->func_decl.func_name);
+  }
+}
+
+/**
+ * @brief 在当前作用域中声明一个变量或常量。
+ * @details 全局声明额外检查是否与标准库函数同名以及是否为指针类型。
+ */
+static void declare_object(ASTNode *node, const char *name, Type *type,
+                           bool is_const, AnalysisContext *actx) {
+  char msg[256];
+  bool is_global = actx->current_scope->parent == NULL;
+  if (is_global && is_stdlib_name(name)) {
+    snprintf(msg, sizeof(msg),
+             "Redefinition of standard library symbol '%s' is not allowed.",
+             name);
+    add_error(actx->errors, ERROR_DUPLICATE_SYMBOL, msg, node->loc);
+    actx->error_count++;
+    node->sym = NULL;
+    return;
+  }
+  // 检查在当前作用域中是否重定义
+  Symbol *existing_sym = find_symbol_in_scope(actx->current_scope, name);
+  if (existing_sym) {
+    if (is_global) {
+      snprintf(msg, sizeof(msg), "Redefinition of global symbol '%s'.", name);
+      actx->error_count++;
+      node->sym = existing_sym;
     } else {
-      // 创建函数类型 - 优化：直接传递参数节点数组，避免中间内存分配
-      Type *func_type = create_function_type_from_params(
-          node->func_decl.return_type, node->func_decl.params,
-          node->func_decl.param_count, false, actx->ast_ctx->pool);
-
-      // 添加函数符号到当前作用域
-      add_symbol(actx->current_scope, node->func_decl.func_name, func_type,
-                 true, true, actx->ast_ctx);
-      node->sym =
-          find_symbol_in_scope(actx->current_scope, node->func_decl.func_name);
+      snprintf(msg, sizeof(msg),
+               "Redefinition of symbol '%s' in the same scope.", name);
     }
+    add_error(actx->errors, ERROR_DUPLICATE_SYMBOL, msg, node->loc);
+    return;
+  }
+  if (is_global && type && type->kind == TYPE_POINTER) {
+    add_error(actx->errors, ERROR_TYPE_MISMATCH,
+              "Pointer type variables are not allowed in SysY-2022",
+              node->loc);
+    return;
+  }
+  add_symbol(actx->current_scope, name, type, false, is_const,
+             actx->node_pool);
+  node->sym = find_symbol_in_scope(actx->current_scope, name);
+}
+
+//==============================================================================
+// 6. 单遍语义检查 (Single-Pass Semantic Checking)
+//==============================================================================
 
-    // 函数声明为其参数和函数体引入一个新的作用域
-    SymbolTable *func_scope =
-        create_symbol_table(actx->ast_ctx, actx->current_scope);
+// 在进入节点时建立作用域并声明符号
+static void check_semantics_pre(ASTNode *node, AnalysisContext *actx) {
+  if (!node)
+    return;
+  char msg[256];
+  switch (node->node_type) {
+  case AST_FUNC_DECL: {
+    // 函数内的作用域与局部符号分配在函数体的子内存池中，随函数体一起释放
+    MemoryPool *arena = ast_function_arena(node);
+    if (arena)
+      actx->node_pool = arena;
+
+    // 函数声明为其参数和函数体引入一个新的作用域，挂在工作线程的私有名字表上
+    assert(actx->names && "函数体只在函数体阶段分析");
+    SymbolTable *func_scope = create_symbol_table_in(
+        actx->node_pool, actx->current_scope, actx->names);
     node->func_decl.scope = func_scope;
+    enter_scope(func_scope);
     actx->current_scope = func_scope; // 进入新作用域
+    actx->current_function_return_type = node->func_decl.return_type;
+    actx->has_return_statement = false;
 
-    // 将函数参数添加到函数作用域中
+    // 将函数参数添加到函数作用域中；参数维度已在全局阶段求值
     for (size_t i = 0; i < node->func_decl.param_count; ++i) {
       ASTNode *param_node = node->func_decl.params[i];
       const char *param_name = param_node->func_param.name;
@@ -359,14 +508,14 @@ static void build_symbols_pre(ASTNode *node, AnalysisContext *actx) {
 
       // 检查参数是否重名
       if (find_symbol_in_scope(actx->current_scope, param_name)) {
-        snprintf(msg_buffer, sizeof(msg_buffer),
-                 "Redefinition of parameter '%s'", param_name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
+        snprintf(msg, sizeof(msg), "Redefinition of parameter '%s'",
+                 param_name);
+        add_error(actx->errors, ERROR_DUPLICATE_SYMBOL, msg,
                   param_node->loc);
         actx->error_count++;
       } else {
         add_symbol(actx->current_scope, param_name, param_type, false, false,
-                   actx->ast_ctx);
+                   actx->node_pool);
         param_node->sym = find_symbol_in_scope(actx->current_scope, param_name);
       }
     }
@@ -375,10 +524,12 @@ static void build_symbols_pre(ASTNode *node, AnalysisContext *actx) {
   case AST_COMPOUND_STMT: {
     // 复合语句（代码块）也引入新作用域，除非它是函数体的直接子节点
     // （因为函数声明已经创建了作用域）
-    if (node->parent && node->parent->node_type != AST_FUNC_DECL) {
+    ASTNode *parent = ast_parent(actx->ast_ctx, node);
+    if (parent && parent->node_type != AST_FUNC_DECL) {
       SymbolTable *block_scope =
-          create_symbol_table(actx->ast_ctx, actx->current_scope);
+          create_symbol_table(actx->node_pool, actx->current_scope);
       node->compound_stmt.scope = block_scope;
+      enter_scope(block_scope);
       actx->current_scope = block_scope; // 进入新作用域
     } else {
       // 对于根复合语句或函数体，使用当前作用域
@@ -386,177 +537,27 @@ static void build_symbols_pre(ASTNode *node, AnalysisContext *actx) {
     }
     break;
   }
-  case AST_VAR_DECL: {
-    // 只处理全局变量
-    if (actx->current_scope->parent == NULL) {
-      if (is_stdlib_name(node->var_decl.name)) {
-        snprintf(msg_buffer, sizeof(msg_buffer),
-                 "Redefinition of standard library symbol '%s' is not allowed.",
-                 node->var_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
-                  node->loc);
-        actx->error_count++;
-        node->sym = NULL;
-        break;
-      }
-      // 检查在当前作用域中是否重定义
-      Symbol *existing_sym =
-          find_symbol_in_scope(actx->current_scope, node->var_decl.name);
-      if (existing_sym) {
-        snprintf(msg_buffer, sizeof(msg_buffer),
-                 "Redefinition of global symbol '%s'.", node->var_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
-                  node->loc);
-        actx->error_count++;
-        node->sym = existing_sym;
-      } else {
-        Type *decl_type = node->var_decl.var_type;
-        if (decl_type && decl_type->kind == TYPE_POINTER) {
-          snprintf(msg_buffer, sizeof(msg_buffer),
-                   "Pointer type variables are not allowed in SysY-2022");
-          add_error(&actx->ast_ctx->errors, ERROR_TYPE_MISMATCH, msg_buffer,
-                    node->loc);
-        } else {
-          add_symbol(actx->current_scope, node->var_decl.name,
-                     node->var_decl.var_type, false, false, actx->ast_ctx);
-          node->sym =
-              find_symbol_in_scope(actx->current_scope, node->var_decl.name);
-        }
-      }
-    }
-    // 局部变量在第一遍完全忽略
-    break;
-  }
-  case AST_CONST_DECL: {
-    // 只处理全局常量
-    if (actx->current_scope->parent == NULL) {
-      if (is_stdlib_name(node->const_decl.name)) {
-        snprintf(msg_buffer, sizeof(msg_buffer),
-                 "Redefinition of standard library symbol '%s' is not allowed.",
-                 node->const_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
-                  node->loc);
-        actx->error_count++;
-        node->sym = NULL;
-        break;
-      }
-      // 检查在当前作用域中是否重定义
-      Symbol *existing_sym =
-          find_symbol_in_scope(actx->current_scope, node->const_decl.name);
-      if (existing_sym) {
-        snprintf(msg_buffer, sizeof(msg_buffer),
-                 "Redefinition of global symbol '%s'.", node->const_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg_buffer,
-                  node->loc);
-        actx->error_count++;
-        node->sym = existing_sym;
-      } else {
-        Type *decl_type = node->const_decl.const_type;
-        if (decl_type && decl_type->kind == TYPE_POINTER) {
-          snprintf(msg_buffer, sizeof(msg_buffer),
-                   "Pointer type variables are not allowed in SysY-2022");
-          add_error(&actx->ast_ctx->errors, ERROR_TYPE_MISMATCH, msg_buffer,
-                    node->loc);
-        } else {
-          add_symbol(actx->current_scope, node->const_decl.name,
-                     node->const_decl.const_type, false, true, actx->ast_ctx);
-          node->sym =
-              find_symbol_in_scope(actx->current_scope, node->const_decl.name);
-        }
-      }
-    }
-    // 局部常量在第一遍完全忽略
-    break;
-  }
-  default:
-    break;
-  }
-}
-
-// 在离开节点时构建符号（主要用于退出作用域）
-static void build_symbols_post(ASTNode *node, AnalysisContext *actx) {
-  if (!node)
-    return;
-  // 只对称退出 pre_visit 创建新作用域的节点
-  if (node->node_type == AST_FUNC_DECL ||
-      (node->node_type == AST_COMPOUND_STMT && node->parent &&
-       node->parent->node_type != AST_FUNC_DECL)) {
-    if (actx->current_scope->parent) {
-      actx->current_scope = actx->current_scope->parent;
-    }
-  }
-}
-
-//==============================================================================
-// 6. 语义检查 (第二遍) (Semantic Checking - Pass 2)
-//==============================================================================
-
-// 在进入节点时进行语义检查
-static void check_semantics_pre(ASTNode *node, AnalysisContext *actx) {
-  if (!node)
-    return;
-  char msg[256];
-  switch (node->node_type) {
-  case AST_FUNC_DECL:
-    actx->current_scope = node->func_decl.scope;
-    actx->current_function_return_type = node->func_decl.return_type;
-    actx->has_return_statement = false;
-    // MODIFIED: Removed the check for parameter dimensions.
-    // This logic has been moved to check_semantics_post for AST_FUNC_PARAM
-    // to ensure dimension expressions are evaluated before being used.
-    break;
-  case AST_COMPOUND_STMT:
-    if (node->compound_stmt.scope) {
-      actx->current_scope = node->compound_stmt.scope;
-    }
-    break;
   case AST_WHILE_STMT:
     actx->loop_depth++;
     break;
   case AST_IDENTIFIER: {
     // 只查找符号，不在此处报告未定义错误
-    node->sym = find_symbol(actx->current_scope, node->identifier.name);
+    Symbol *sym = find_symbol(actx->current_scope, node->identifier.name);
+    // 全局符号在函数体阶段之前已全部登记，定义在当前函数之后的对其不可见
+    if (sym && !sym->scope->parent && sym->order >= actx->visible_globals)
+      sym = NULL;
+    node->sym = sym;
     break;
   }
-  // 关键：在这里添加局部符号
-  case AST_VAR_DECL: {
-    if (actx->current_scope->parent != NULL) { // 只处理局部变量
-      Symbol *existing_sym =
-          find_symbol_in_scope(actx->current_scope, node->var_decl.name);
-      if (existing_sym) {
-        snprintf(msg, sizeof(msg),
-                 "Redefinition of symbol '%s' in the same scope.",
-                 node->var_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg,
-                  node->loc);
-      } else {
-        add_symbol(actx->current_scope, node->var_decl.name,
-                   node->var_decl.var_type, false, false, actx->ast_ctx);
-        node->sym =
-            find_symbol_in_scope(actx->current_scope, node->var_decl.name);
-      }
-    }
+  // 声明在进入节点时加入当前作用域，使其初始化表达式之后的代码可见
+  case AST_VAR_DECL:
+    declare_object(node, node->var_decl.name, node->var_decl.var_type, false,
+                   actx);
     break;
-  }
-  case AST_CONST_DECL: {
-    if (actx->current_scope->parent != NULL) { // 只处理局部常量
-      Symbol *existing_sym =
-          find_symbol_in_scope(actx->current_scope, node->const_decl.name);
-      if (existing_sym) {
-        snprintf(msg, sizeof(msg),
-                 "Redefinition of symbol '%s' in the same scope.",
-                 node->const_decl.name);
-        add_error(&actx->ast_ctx->errors, ERROR_DUPLICATE_SYMBOL, msg,
-                  node->loc);
-      } else {
-        add_symbol(actx->current_scope, node->const_decl.name,
-                   node->const_decl.const_type, false, true, actx->ast_ctx);
-        node->sym =
-            find_symbol_in_scope(actx->current_scope, node->const_decl.name);
-      }
-    }
+  case AST_CONST_DECL:
+    declare_object(node, node->const_decl.name, node->const_decl.const_type,
+                   true, actx);
     break;
-  }
   default:
     break;
   }
@@ -571,17 +572,17 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
   switch (node->node_type) {
   case AST_CONSTANT:
     if (node->constant.type == CONST_INT) {
-      node->eval_type = create_basic_type(BASIC_INT, true, ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
     } else {
-      node->eval_type = create_basic_type(BASIC_FLOAT, true, ctx->pool);
+      node->eval_type = create_basic_type(BASIC_FLOAT, true, actx->pool);
     }
     node->const_val = node->constant.value;
     node->is_lvalue = false;
     node->is_constant = true;
     break;
   case AST_STRING_LITERAL: {
-    Type *char_type = create_basic_type(BASIC_I8, true, ctx->pool);
-    node->eval_type = create_pointer_type(char_type, true, ctx->pool);
+    Type *char_type = create_basic_type(BASIC_I8, true, actx->pool);
+    node->eval_type = create_pointer_type(char_type, true, actx->pool);
     node->is_lvalue = false;
     node->is_constant = true;
     break;
@@ -592,49 +593,50 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
     if ((left_type && !is_numeric_type(left_type)) ||
         (right_type && !is_numeric_type(right_type))) {
       if (node->binary_expr.op != OP_AND && node->binary_expr.op != OP_OR) {
-        add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+        add_error(actx->errors, ERROR_TYPE_MISMATCH,
                   "Operands of binary expression must be numeric", node->loc);
       }
     }
     if (node->binary_expr.op >= OP_EQ && node->binary_expr.op <= OP_OR) {
-      node->eval_type = create_basic_type(BASIC_INT, false, ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, false, actx->pool);
     } else {
       if (left_type && right_type && left_type->kind == TYPE_BASIC &&
           right_type->kind == TYPE_BASIC &&
           (left_type->basic == BASIC_FLOAT ||
            right_type->basic == BASIC_FLOAT)) {
-        node->eval_type = create_basic_type(BASIC_FLOAT, false, ctx->pool);
+        node->eval_type = create_basic_type(BASIC_FLOAT, false, actx->pool);
         if (node->binary_expr.op == OP_MOD) {
-          add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+          add_error(actx->errors, ERROR_TYPE_MISMATCH,
                     "Invalid operands to binary % (have 'float')", node->loc);
         }
       } else {
-        node->eval_type = create_basic_type(BASIC_INT, false, ctx->pool);
+        node->eval_type = create_basic_type(BASIC_INT, false, actx->pool);
       }
     }
     node->is_lvalue = false;
-    node->is_constant = is_constant_expression(node->binary_expr.left, actx) &&
-                        is_constant_expression(node->binary_expr.right, actx);
-    if (node->is_constant) {
-      node->const_val = evaluate_const_expr_recursively(node, actx).value;
+    // 子节点已在各自的后序访问中求值并缓存，这里只需做一次运算
+    node->is_constant = false;
+    if (node->binary_expr.left->is_constant &&
+        node->binary_expr.right->is_constant) {
+      evaluate_const_expr_recursively(node, actx);
     }
     break;
   }
   case AST_UNARY_EXPR: {
     Type *op_type = node->unary_expr.operand->eval_type;
     if (op_type && !is_numeric_type(op_type)) {
-      add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+      add_error(actx->errors, ERROR_TYPE_MISMATCH,
                 "Operand of unary expression must be numeric", node->loc);
     }
     if (node->unary_expr.op == OP_NOT) {
-      node->eval_type = create_basic_type(BASIC_INT, false, ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, false, actx->pool);
     } else {
       node->eval_type = op_type;
     }
     node->is_lvalue = false;
-    node->is_constant = is_constant_expression(node->unary_expr.operand, actx);
-    if (node->is_constant) {
-      node->const_val = evaluate_const_expr_recursively(node, actx).value;
+    node->is_constant = false;
+    if (node->unary_expr.operand->is_constant) {
+      evaluate_const_expr_recursively(node, actx);
     }
     break;
   }
@@ -642,9 +644,9 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
     if (node->sym == NULL) {
       snprintf(msg, sizeof(msg), "Use of undeclared identifier '%s'",
                node->identifier.name);
-      add_error(&ctx->errors, ERROR_UNDEFINED_VARIABLE, msg, node->loc);
+      add_error(actx->errors, ERROR_UNDEFINED_VARIABLE, msg, node->loc);
       node->eval_type = create_basic_type(BASIC_INT, true,
-                                          ctx->pool); // 假设为 int 以继续分析
+                                          actx->pool); // 假设为 int 以继续分析
       return;
     }
     node->eval_type = node->sym->type;
@@ -658,13 +660,13 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
     Type *array_type = node->array_access.array->eval_type;
     Type *index_type = node->array_access.index->eval_type;
     node->eval_type =
-        create_basic_type(BASIC_INT, true, ctx->pool); // 默认错误类型
+        create_basic_type(BASIC_INT, true, actx->pool); // 默认错误类型
     node->is_lvalue = false;
     node->is_constant = false;
     if (index_type &&
-        !is_type_compatible(create_basic_type(BASIC_INT, false, ctx->pool),
+        !is_type_compatible(create_basic_type(BASIC_INT, false, actx->pool),
                             index_type, false)) {
-      add_error(&ctx->errors, ERROR_INVALID_ARRAY_ACCESS,
+      add_error(actx->errors, ERROR_INVALID_ARRAY_ACCESS,
                 "Array subscript must be of integer type",
                 node->array_access.index->loc);
     }
@@ -674,24 +676,24 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
         if (array_type->array.dim_count > 1) {
           node->eval_type = create_array_type(
               element_type, &array_type->array.dimensions[1],
-              array_type->array.dim_count - 1, array_type->is_const, ctx->pool);
+              array_type->array.dim_count - 1, array_type->is_const, actx->pool);
           node->is_lvalue = false;
         } else {
           node->eval_type = element_type;
           node->is_lvalue = !element_type->is_const;
         }
       } else {
-        add_error(&ctx->errors, ERROR_INVALID_ARRAY_ACCESS,
+        add_error(actx->errors, ERROR_INVALID_ARRAY_ACCESS,
                   "Subscripted value is not an array",
                   node->array_access.array->loc);
       }
     }
     break;
   }
-  case AST_CALL_EXPR: {
+  case AST_CALL_EXPR:
+    // 所有函数的形参维度都已在全局阶段求值，前向调用也可以立即检查
     check_function_call(node, actx);
     break;
-  }
   case AST_ASSIGN_STMT: {
     Type *lval_type =
         node->assign_stmt.lval ? node->assign_stmt.lval->eval_type : NULL;
@@ -707,18 +709,18 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
                  lval_type->kind == TYPE_BASIC
                      ? (lval_type->basic == BASIC_INT ? "int" : "float")
                      : "non-basic");
-        add_error(&ctx->errors, ERROR_TYPE_MISMATCH, msg, node->loc);
+        add_error(actx->errors, ERROR_TYPE_MISMATCH, msg, node->loc);
       }
     }
     if (node->assign_stmt.lval && node->assign_stmt.lval->sym &&
         node->assign_stmt.lval->sym->is_const) {
-      add_error(&ctx->errors, ERROR_INVALID_ASSIGNMENT,
+      add_error(actx->errors, ERROR_INVALID_ASSIGNMENT,
                 "Cannot assign to const variable", node->assign_stmt.lval->loc);
     }
     if (node->assign_stmt.lval) {
       if (!node->assign_stmt.lval->is_lvalue) {
         add_error(
-            &ctx->errors, ERROR_INVALID_ASSIGNMENT,
+            actx->errors, ERROR_INVALID_ASSIGNMENT,
             "The left side of assignment is not a left value (not assignable)",
             node->assign_stmt.lval->loc);
       }
@@ -730,19 +732,19 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
     if (func_ret_type) {
       if (func_ret_type->kind == TYPE_VOID) {
         if (node->return_stmt.value) {
-          add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+          add_error(actx->errors, ERROR_TYPE_MISMATCH,
                     "Void function cannot return a value", node->loc);
         }
       } else if (func_ret_type->kind == TYPE_BASIC &&
                  (func_ret_type->basic == BASIC_INT ||
                   func_ret_type->basic == BASIC_FLOAT)) {
         if (!node->return_stmt.value) {
-          add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+          add_error(actx->errors, ERROR_TYPE_MISMATCH,
                     "Non-void function must return a value", node->loc);
         } else if (!is_type_compatible(func_ret_type,
                                        node->return_stmt.value->eval_type,
                                        true)) {
-          add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+          add_error(actx->errors, ERROR_TYPE_MISMATCH,
                     "Return value type does not match function declaration",
                     node->loc);
         }
@@ -757,7 +759,7 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
     ASTNode *cond = (node->node_type == AST_IF_STMT) ? node->if_stmt.cond
                                                      : node->while_stmt.cond;
     if (cond->eval_type && !is_numeric_type(cond->eval_type)) {
-      add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+      add_error(actx->errors, ERROR_TYPE_MISMATCH,
                 "Condition of if/while statement must be of a numeric type",
                 cond->loc);
     }
@@ -765,14 +767,14 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
   }
   case AST_BREAK_STMT: {
     if (actx->loop_depth == 0) {
-      add_error(&ctx->errors, ERROR_BREAK_CONTINUE_OUTSIDE_LOOP,
+      add_error(actx->errors, ERROR_BREAK_CONTINUE_OUTSIDE_LOOP,
                 "break statement not within a loop", node->loc);
     }
     break;
   }
   case AST_CONTINUE_STMT: {
     if (actx->loop_depth == 0) {
-      add_error(&ctx->errors, ERROR_BREAK_CONTINUE_OUTSIDE_LOOP,
+      add_error(actx->errors, ERROR_BREAK_CONTINUE_OUTSIDE_LOOP,
                 "continue statement not within a loop", node->loc);
     }
     break;
@@ -783,7 +785,7 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
       Type *ret_type = node->sym->type->function.return_type;
       if (ret_type && ret_type->kind != TYPE_VOID) {
         if (!actx->has_return_statement) {
-          add_error(&ctx->errors, ERROR_MISSING_RETURN,
+          add_error(actx->errors, ERROR_MISSING_RETURN,
                     "Control may reach end of non-void function", node->loc);
         }
       }
@@ -824,18 +826,15 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
         check_array_initializer(init_node, decl_type, false, actx);
       } else if (decl_type && init_node->eval_type &&
                  !is_type_compatible(decl_type, init_node->eval_type, true)) {
-        add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+        add_error(actx->errors, ERROR_TYPE_MISMATCH,
                   "Incompatible type for initializer", node->loc);
       }
     }
     break;
   }
   case AST_CONST_DECL: {
-    // 局部常量求值：仅当在局部作用域时才调用辅助函数 (全局常量已在 Pass 1.5
-    // 中处理)
-    if (actx->current_scope->parent != NULL) {
-      evaluate_single_const_decl(node, actx);
-    }
+    // 常量在离开声明节点时求值，之后对它的引用即可直接折叠
+    evaluate_single_const_decl(node, actx);
     // 数组常量初始化器的额外检查
     Type *decl_type = node->const_decl.const_type;
     ASTNode *init_node = node->const_decl.value;
@@ -851,16 +850,21 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
   switch (node->node_type) {
   case AST_FUNC_DECL:
     if (actx->current_scope->parent) {
+      exit_scope(actx->current_scope);
       actx->current_scope = actx->current_scope->parent;
     }
+    actx->node_pool = actx->pool;
     break;
-  case AST_COMPOUND_STMT:
-    if (node->parent && node->parent->node_type != AST_FUNC_DECL) {
+  case AST_COMPOUND_STMT: {
+    ASTNode *parent = ast_parent(ctx, node);
+    if (parent && parent->node_type != AST_FUNC_DECL) {
       if (actx->current_scope->parent) {
+        exit_scope(actx->current_scope);
         actx->current_scope = actx->current_scope->parent;
       }
     }
     break;
+  }
   case AST_WHILE_STMT:
     actx->loop_depth--;
     break;
@@ -869,6 +873,34 @@ static void check_semantics_post(ASTNode *node, AnalysisContext *actx) {
   }
 }
 
+/**
+ * @brief 函数体阶段的任务：检查一个函数体。
+ * @details 只读访问全局符号与函数签名；作用域、局部符号、新建类型与诊断都写入
+ *          本线程或本函数私有的位置。形参节点已在全局阶段访问过，这里跳过它们，
+ *          只手动触发函数节点本身的前序与后序回调。
+ */
+static void analyze_function_body(size_t index, unsigned worker,
+                                  void *user_data) {
+  FunctionPhase *phase = (FunctionPhase *)user_data;
+  TopLevelItem *item = &phase->items[phase->functions[index]];
+  AnalysisWorker *state = &phase->workers[worker];
+  AnalysisContext actx = {.ast_ctx = phase->ast_ctx,
+                          .current_scope = phase->ast_ctx->global_scope,
+                          .pool = state->pool,
+                          .node_pool = state->pool,
+                          .errors = &item->errors,
+                          .names = state->names,
+                          .visible_globals = item->visible_globals,
+                          .traverse_stack = state->traverse_stack};
+  ASTNode *node = item->node;
+  check_semantics_pre(node, &actx);
+  traverse_ast(node->func_decl.body, check_semantics_pre, check_semantics_post,
+               &actx);
+  check_semantics_post(node, &actx);
+  item->error_count = actx.error_count;
+  item->warning_count = actx.warning_count;
+}
+
 //==============================================================================
 // 7. 类型系统辅助函数 (Type System Helper Functions)
 //==============================================================================
@@ -1007,7 +1039,7 @@ static bool is_type_compatible(Type *target, Type *source,
 // 添加预定义的库函数到全局作用域
 static void add_predefined_symbols(AnalysisContext *actx) {
   ASTContext *ctx = actx->ast_ctx;
-  MemoryPool *pool = ctx->pool;
+  MemoryPool *pool = actx->pool;
   Type *type_int = create_basic_type(BASIC_INT, false, pool);
   Type *type_float = create_basic_type(BASIC_FLOAT, false, pool);
   Type *type_void = create_void_type(pool);
@@ -1023,60 +1055,60 @@ static void add_predefined_symbols(AnalysisContext *actx) {
   Type *type_float_array_param =
       create_array_type(type_float, dyn_dim_ptr, 1, false, pool);
   // getint, getch, getfloat
-  add_symbol(actx->current_scope, "getint",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "getint"),
              create_function_type(type_int, NULL, 0, false, pool), true, true,
-             ctx);
-  add_symbol(actx->current_scope, "getch",
+             pool);
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "getch"),
              create_function_type(type_int, NULL, 0, false, pool), true, true,
-             ctx);
-  add_symbol(actx->current_scope, "getfloat",
+             pool);
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "getfloat"),
              create_function_type(type_float, NULL, 0, false, pool), true, true,
-             ctx);
+             pool);
   // getarray, getfarray
   Type *getarray_params[] = {type_int_array_param};
-  add_symbol(actx->current_scope, "getarray",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "getarray"),
              create_function_type(type_int, getarray_params, 1, false, pool),
-             true, true, ctx);
+             true, true, pool);
   Type *getfarray_params[] = {type_float_array_param};
-  add_symbol(actx->current_scope, "getfarray",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "getfarray"),
              create_function_type(type_int, getfarray_params, 1, false, pool),
-             true, true, ctx);
+             true, true, pool);
   // putint, putch, putfloat
   Type *putint_params[] = {type_int};
-  add_symbol(actx->current_scope, "putint",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putint"),
              create_function_type(type_void, putint_params, 1, false, pool),
-             true, true, ctx);
+             true, true, pool);
   Type *putch_params[] = {type_int};
-  add_symbol(actx->current_scope, "putch",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putch"),
              create_function_type(type_void, putch_params, 1, false, pool),
-             true, true, ctx);
+             true, true, pool);
   Type *putfloat_params[] = {type_float};
-  add_symbol(actx->current_scope, "putfloat",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putfloat"),
              create_function_type(type_void, putfloat_params, 1, false, pool),
-             true, true, ctx);
+             true, true, pool);
   // putarray, putfarray
   Type *putarray_params[] = {type_int, type_int_array_param};
-  add_symbol(actx->current_scope, "putarray",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putarray"),
              create_function_type(type_void, putarray_params, 2, false, pool),
-             true, true, ctx);
+             true, true, pool);
   Type *putfarray_params[] = {type_int, type_float_array_param};
-  add_symbol(actx->current_scope, "putfarray",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putfarray"),
              create_function_type(type_void, putfarray_params, 2, false, pool),
-             true, true, ctx);
+             true, true, pool);
   // putf
   Type *type_const_char_ptr_param =
       create_pointer_type(create_basic_type(BASIC_I8, true, pool), false, pool);
   Type *putf_params[] = {type_const_char_ptr_param};
-  add_symbol(actx->current_scope, "putf",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "putf"),
              create_function_type(type_void, putf_params, 1, true, pool), true,
-             true, ctx);
+             true, pool);
   // starttime, stoptime
-  add_symbol(actx->current_scope, "starttime",
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "starttime"),
              create_function_type(type_void, NULL, 0, false, pool), true, true,
-             ctx);
-  add_symbol(actx->current_scope, "stoptime",
+             pool);
+  add_symbol(actx->current_scope, ast_intern_cstr(ctx, "stoptime"),
              create_function_type(type_void, NULL, 0, false, pool), true, true,
-             ctx);
+             pool);
 }
 
 //==============================================================================
@@ -1127,12 +1159,23 @@ static bool is_constant_expression(ASTNode *node, AnalysisContext *actx) {
   return false;
 }
 
-// 递归地对常量表达式进行求值
+/**
+ * @brief 递归地对常量表达式进行求值。
+ * @details 求值结果缓存在节点的 `is_constant` / `const_val` 上：已求值的节点直接
+ *          返回缓存值，因此每个节点最多被求值一次，常量的链式引用与大型常量
+ *          初始化列表都只需线性时间。非常量结果不缓存。
+ */
 static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
                                                       AnalysisContext *actx) {
   EvaluatedConst result = {.is_const = false, .is_valid = true};
   if (!node)
     return result;
+  // 字符串字面量也标记为 is_constant，但它没有数值
+  if (node->is_constant && node->node_type != AST_STRING_LITERAL) {
+    result.is_const = true;
+    result.value = node->const_val;
+    return result;
+  }
 
   switch (node->node_type) {
   case AST_CONSTANT:
@@ -1140,15 +1183,16 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
     result.value = node->constant.value;
     // 新增：直接在这里设置节点的 eval_type，以供上层使用
     if (node->constant.type == CONST_INT) {
-      node->eval_type = create_basic_type(BASIC_INT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
     } else {
-      node->eval_type =
-          create_basic_type(BASIC_FLOAT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_FLOAT, true, actx->pool);
     }
     break;
   case AST_IDENTIFIER:;
+    // 前序访问时已解析过符号，直接复用
     Symbol *identified_sym =
-        find_symbol(actx->current_scope, node->identifier.name);
+        node->sym ? node->sym
+                  : find_symbol(actx->current_scope, node->identifier.name);
     if (identified_sym && identified_sym->is_const &&
         identified_sym->is_evaluated) {
       result.is_const = true;
@@ -1175,18 +1219,17 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
       float val = op_is_int ? (float)operand_val.value.int_val
                             : operand_val.value.float_val;
       result.value.int_val = (val == 0.0f);
-      node->eval_type = create_basic_type(BASIC_INT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
     } else if (op_is_int) {
       result.value.int_val = (node->unary_expr.op == OP_NEG)
                                  ? -operand_val.value.int_val
                                  : operand_val.value.int_val;
-      node->eval_type = create_basic_type(BASIC_INT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
     } else {
       result.value.float_val = (node->unary_expr.op == OP_NEG)
                                    ? -operand_val.value.float_val
                                    : operand_val.value.float_val;
-      node->eval_type =
-          create_basic_type(BASIC_FLOAT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_FLOAT, true, actx->pool);
     }
     break;
   }
@@ -1227,7 +1270,7 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
           result.value.float_val = lv / rv;
         else {
           result.is_const = false;
-          add_error(&actx->ast_ctx->errors, ERROR_RUNTIME,
+          add_error(actx->errors, ERROR_RUNTIME,
                     "Division by zero in const expr", node->loc);
         }
         break;
@@ -1260,11 +1303,9 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
         break;
       }
       if (node->binary_expr.op >= OP_LT && node->binary_expr.op <= OP_OR) {
-        node->eval_type =
-            create_basic_type(BASIC_INT, true, actx->ast_ctx->pool);
+        node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
       } else {
-        node->eval_type =
-            create_basic_type(BASIC_FLOAT, true, actx->ast_ctx->pool);
+        node->eval_type = create_basic_type(BASIC_FLOAT, true, actx->pool);
       }
     } else { // 整数运算
       int lv = left_val.value.int_val;
@@ -1284,7 +1325,7 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
           result.value.int_val = lv / rv;
         else {
           result.is_const = false;
-          add_error(&actx->ast_ctx->errors, ERROR_RUNTIME,
+          add_error(actx->errors, ERROR_RUNTIME,
                     "Division by zero in const expr", node->loc);
         }
         break;
@@ -1293,7 +1334,7 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
           result.value.int_val = lv % rv;
         else {
           result.is_const = false;
-          add_error(&actx->ast_ctx->errors, ERROR_RUNTIME,
+          add_error(actx->errors, ERROR_RUNTIME,
                     "Modulo by zero in const expr", node->loc);
         }
         break;
@@ -1325,13 +1366,17 @@ static EvaluatedConst evaluate_const_expr_recursively(ASTNode *node,
         result.is_const = false;
         break;
       }
-      node->eval_type = create_basic_type(BASIC_INT, true, actx->ast_ctx->pool);
+      node->eval_type = create_basic_type(BASIC_INT, true, actx->pool);
     }
     break;
   }
   default:
     break;
   }
+  if (result.is_const) {
+    node->is_constant = true;
+    node->const_val = result.value;
+  }
   return result;
 }
 
@@ -1363,14 +1408,14 @@ static void check_array_initializer(ASTNode *init_node, Type *target_type,
   // --- 目标是标量 ---
   if (target_type->kind != TYPE_ARRAY) {
     if (init_node->node_type == AST_ARRAY_INIT) {
-      add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+      add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
                 "Braces around scalar initializer", init_node->loc);
     } else if (init_node->eval_type &&
                !is_type_compatible(target_type, init_node->eval_type, true)) {
-      add_error(&actx->ast_ctx->errors, ERROR_TYPE_MISMATCH,
+      add_error(actx->errors, ERROR_TYPE_MISMATCH,
                 "Scalar initializer type mismatch", init_node->loc);
     } else if (is_const_context && !is_constant_expression(init_node, actx)) {
-      add_error(&actx->ast_ctx->errors, ERROR_INVALID_CONVERSION,
+      add_error(actx->errors, ERROR_INVALID_CONVERSION,
                 "Initializer for const variable must be constant",
                 init_node->loc);
     }
@@ -1379,7 +1424,7 @@ static void check_array_initializer(ASTNode *init_node, Type *target_type,
 
   // --- 目标是数组 ---
   if (init_node->node_type != AST_ARRAY_INIT) {
-    add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+    add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
               "Array requires braced initializer list", init_node->loc);
     return;
   }
@@ -1391,7 +1436,7 @@ static void check_array_initializer(ASTNode *init_node, Type *target_type,
   // 检查是否有过多的初始化元素
   if (init_ctx.current_idx < (int)init_node->array_init.elem_count) {
     // 这意味着顶层列表中的某些元素没有被完全消耗掉
-    add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+    add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
               "Too many elements in array initializer",
               init_node->array_init.elements[init_ctx.current_idx]->loc);
   }
@@ -1417,7 +1462,7 @@ static void check_array_initializer_recursive(InitContext *init_ctx,
     if (current_elem->node_type == AST_ARRAY_INIT) {
       // 一个标量不能被一个列表初始化，但有一个例外: char a = {"a"};
       // SysY 不支持，所以这是个错误。
-      add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+      add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
                 "Braces around scalar initializer", current_elem->loc);
     } else {
       check_array_initializer(current_elem, target_type, is_const_context,
@@ -1431,13 +1476,18 @@ static void check_array_initializer_recursive(InitContext *init_ctx,
   size_t dim_size = target_type->array.dimensions[0].static_size;
   if (dim_size == 0)
     return; // 零长度数组
+  // 列表已用尽：剩余部分隐式为零（IR 中表示为 zeroinitializer 或稀疏聚合的
+  // 省略位置），不必再为子类型分配 Type 并逐元素下降
+  if (init_ctx->current_idx >=
+      (int)init_ctx->init_list_node->array_init.elem_count)
+    return;
 
   Type *sub_type =
       (target_type->array.dim_count > 1)
           ? create_array_type(target_type->array.element_type,
                               target_type->array.dimensions + 1,
                               target_type->array.dim_count - 1,
-                              target_type->is_const, actx->ast_ctx->pool)
+                              target_type->is_const, actx->pool)
           : target_type->array.element_type;
 
   // 循环遍历当前维度的所有元素
@@ -1459,7 +1509,7 @@ static void check_array_initializer_recursive(InitContext *init_ctx,
                                         actx);
 
       if (sub_ctx.current_idx < (int)current_elem->array_init.elem_count) {
-        add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+        add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
                   "Too many elements in sub-initializer",
                   current_elem->array_init.elements[sub_ctx.current_idx]->loc);
       }
@@ -1484,7 +1534,7 @@ static bool check_and_evaluate_dimension(ASTNode *dim_expr, int *evaluated_size,
     }
     // Or if size can be inferred from an initializer (not handled here, but a
     // valid C feature)
-    add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+    add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
               "Array dimension size must be specified",
               (dim_expr ? dim_expr->loc : (SourceLocation){0, 0, 0, 0}));
     return false;
@@ -1504,7 +1554,7 @@ static bool check_and_evaluate_dimension(ASTNode *dim_expr, int *evaluated_size,
   actx->is_in_constant_context = false;
 
   if (!is_const) {
-    add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+    add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
               "Array dimension must be a constant expression", dim_expr->loc);
     *evaluated_size = -1;
     return false;
@@ -1524,14 +1574,14 @@ static bool check_and_evaluate_dimension(ASTNode *dim_expr, int *evaluated_size,
       dim_expr->eval_type->basic == BASIC_INT) {
     size = eval_result.value.int_val;
   } else {
-    add_error(&actx->ast_ctx->errors, ERROR_TYPE_MISMATCH,
+    add_error(actx->errors, ERROR_TYPE_MISMATCH,
               "Array dimension must be of integer type", dim_expr->loc);
     *evaluated_size = -1;
     return false;
   }
 
   if (size <= 0) {
-    add_error(&actx->ast_ctx->errors, ERROR_INVALID_ARRAY_INIT,
+    add_error(actx->errors, ERROR_INVALID_ARRAY_INIT,
               "Array dimension must be a positive integer", dim_expr->loc);
     *evaluated_size = -1;
     return false;
@@ -1546,23 +1596,24 @@ static bool check_and_evaluate_dimension(ASTNode *dim_expr, int *evaluated_size,
 static bool check_function_call(ASTNode *call_node, AnalysisContext *actx) {
   if (!call_node || call_node->node_type != AST_CALL_EXPR)
     return false;
-  ASTContext *ctx = actx->ast_ctx;
   ASTNode *callee = call_node->call_expr.callee_expr;
   if (!callee)
     return false;
   Type *callee_type = callee->eval_type;
   if (!callee_type || callee_type->kind != TYPE_FUNCTION) {
-    add_error(&ctx->errors, ERROR_INVALID_PARAMETER, "Callee is not a function",
+    add_error(actx->errors, ERROR_INVALID_PARAMETER, "Callee is not a function",
               call_node->loc);
-    call_node->eval_type = create_basic_type(BASIC_INT, false, ctx->pool);
+    call_node->eval_type = create_basic_type(BASIC_INT, false, actx->pool);
     return false;
   }
+  // IR 生成从调用节点取得被调函数的符号
+  call_node->sym = callee->sym;
   // 1. putf special check: first argument must be a string literal
   if (callee->node_type == AST_IDENTIFIER &&
       strcmp(callee->identifier.name, "putf") == 0) {
     if (call_node->call_expr.arg_count < 1 || !call_node->call_expr.args[0] ||
         call_node->call_expr.args[0]->node_type != AST_STRING_LITERAL) {
-      add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+      add_error(actx->errors, ERROR_TYPE_MISMATCH,
                 "The first argument to putf must be a string literal",
                 call_node->loc);
     }
@@ -1573,7 +1624,7 @@ static bool check_function_call(ASTNode *call_node, AnalysisContext *actx) {
   size_t actual = call_node->call_expr.arg_count;
   bool variadic = callee_type->function.is_variadic;
   if ((!variadic && actual != expected) || (variadic && actual < expected)) {
-    add_error(&ctx->errors, ERROR_INVALID_PARAMETER,
+    add_error(actx->errors, ERROR_INVALID_PARAMETER,
               "Incorrect number of arguments in function call", call_node->loc);
     call_node->eval_type = callee_type->function.return_type;
     return false;
@@ -1585,14 +1636,14 @@ static bool check_function_call(ASTNode *call_node, AnalysisContext *actx) {
     Type *param_type = callee_type->function.param_types[i];
 
     if (!arg || !arg->eval_type) {
-      add_error(&ctx->errors, ERROR_TYPE_MISMATCH, "Invalid function argument",
+      add_error(actx->errors, ERROR_TYPE_MISMATCH, "Invalid function argument",
                 arg ? arg->loc : call_node->loc);
       continue;
     }
 
     // Unified type compatibility check for all types, including arrays.
     if (!is_type_compatible(param_type, arg->eval_type, true)) {
-      add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+      add_error(actx->errors, ERROR_TYPE_MISMATCH,
                 "Function argument type mismatch", arg->loc);
     }
   }
@@ -1611,12 +1662,11 @@ static void evaluate_single_const_decl(ASTNode *node, AnalysisContext *actx) {
   if (!node || node->node_type != AST_CONST_DECL)
     return;
 
-  ASTContext *ctx = actx->ast_ctx;
   Type *decl_type = node->const_decl.const_type;
   ASTNode *init_node = node->const_decl.value;
 
   if (!init_node) {
-    add_error(&ctx->errors, ERROR_MISSING_INITIALIZER,
+    add_error(actx->errors, ERROR_MISSING_INITIALIZER,
               "const declaration must be initialized", node->loc);
   } else if (node->sym) {
     if (decl_type && decl_type->kind == TYPE_ARRAY) {
@@ -1633,15 +1683,14 @@ static void evaluate_single_const_decl(ASTNode *node, AnalysisContext *actx) {
           evaluate_const_expr_recursively(init_node, actx);
       // 这里只需求值并设置符号，不涉及数组维度判断
       if (const_eval.is_const && const_eval.is_valid) {
-        node->sym->const_val = const_eval.value;
-        node->sym->is_evaluated = true;
+        update_symbol_constant_value(node->sym, const_eval.value);
         // Also check if initializer type is compatible with declaration type
         if (!is_type_compatible(decl_type, init_node->eval_type, true)) {
-          add_error(&ctx->errors, ERROR_TYPE_MISMATCH,
+          add_error(actx->errors, ERROR_TYPE_MISMATCH,
                     "Incompatible types in const initialization", node->loc);
         }
       } else {
-        add_error(&ctx->errors, ERROR_INVALID_CONVERSION,
+        add_error(actx->errors, ERROR_INVALID_CONVERSION,
                   "Initializer for const is not a constant expression",
                   node->loc);
       }
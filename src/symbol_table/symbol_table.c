@@ -1,103 +1,231 @@
 #include "symbol_table.h"
-#include <string.h>
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * @file symbol_table.c
  * @brief 实现了符号表数据结构和API。
  * @details
- * 本文件提供了 symbol_table.h 中声明的函数的具体实现，
- * 包括创建、销毁、添加和查找符号等功能。
+ * 本文件提供了 symbol_table.h 中声明的函数的具体实现。名字表是一张以驻留
+ * 名字指针为键的开放寻址（线性探测）哈希表；名字一旦进入表中就不再删除
+ * （作用域退出后其绑定置为 NULL），因此不需要墓碑标记。私有名字表通过
+ * `outer` 链接到全局名字表，查找时逐级回退，但从不写入外层表。
  */
 
-// 符号表哈希桶的初始容量
-#define INITIAL_CAPACITY 16
+// 名字表的初始容量（必须是 2 的幂）
+#define NAME_TABLE_INITIAL_CAPACITY 256
+// 撤销日志的初始容量
+#define UNDO_LOG_INITIAL_CAPACITY 64
 
 /**
- * @brief 计算字符串的哈希值。
- * @details 使用 djb2 哈希算法，这是一种简单而高效的非加密哈希函数。
- * @param str 要计算哈希值的输入字符串。
- * @return 字符串的无符号长整型哈希值。
+ * @struct NameSlot
+ * @brief 名字表中的一个槽位。
  */
-static unsigned long hash_function(const char *str) {
-    unsigned long hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
+typedef struct NameSlot {
+    const char* name; ///< 驻留后的名字，NULL 表示空槽
+    Symbol* binding;  ///< 该名字当前最内层的可见绑定，可能为 NULL
+} NameSlot;
+
+struct NameTable {
+    NameSlot* slots;          ///< 开放寻址槽位数组
+    size_t capacity;          ///< 槽位数（2 的幂）
+    size_t count;             ///< 已占用的槽位数
+    Symbol** undo_log;        ///< 按压入顺序记录的绑定，退出作用域时逆序弹出
+    size_t undo_count;        ///< 撤销日志长度
+    size_t undo_capacity;     ///< 撤销日志容量
+    SymbolTable* innermost;   ///< 当前最内层的激活作用域
+    NameTable* outer;         ///< 查找未命中时回退的名字表（私有表指向全局表），全局表为 NULL
+};
+
+/** @brief 分配失败时直接终止：符号表无法在内存不足时继续工作。*/
+static void* xrealloc(void* p, size_t size) {
+    void* q = realloc(p, size);
+    if (!q) {
+        fprintf(stderr, "Fatal: out of memory in symbol table.\n");
+        exit(1);
     }
-    return hash;
+    return q;
 }
 
-SymbolTable* create_symbol_table(ASTContext* ctx, SymbolTable* parent) {
-    assert(ctx != NULL && "创建符号表时 ASTContext 不能为空");
-    // 从内存池分配符号表结构体
-    SymbolTable* table = (SymbolTable*)pool_alloc(ctx->pool, sizeof(SymbolTable));
-    
-    table->capacity = INITIAL_CAPACITY;
-    table->count = 0;
-    table->parent = parent;
-    
-    // 从内存池分配哈希桶数组
-    table->buckets = (Symbol**)pool_alloc(ctx->pool, table->capacity * sizeof(Symbol*));
-    // 将所有桶的头指针初始化为 NULL
-    for (size_t i = 0; i < table->capacity; ++i) {
-        table->buckets[i] = NULL;
+/** @brief 将名字表扩容为原来的两倍并重新放置所有槽位。*/
+static void name_table_grow(NameTable* names) {
+    size_t new_capacity = names->capacity * 2;
+    NameSlot* slots = (NameSlot*)calloc(new_capacity, sizeof(NameSlot));
+    if (!slots) {
+        fprintf(stderr, "Fatal: out of memory in symbol table.\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < names->capacity; ++i) {
+        NameSlot* old = &names->slots[i];
+        if (!old->name) continue;
+        size_t j = interned_hash(old->name) & (new_capacity - 1);
+        while (slots[j].name) j = (j + 1) & (new_capacity - 1);
+        slots[j] = *old;
+    }
+    free(names->slots);
+    names->slots = slots;
+    names->capacity = new_capacity;
+}
+
+/**
+ * @brief 查找名字对应的槽位。
+ * @param create 为 true 时，名字不存在则占用一个新槽位；否则返回 NULL。
+ */
+static NameSlot* name_table_slot(NameTable* names, const char* name, bool create) {
+    size_t mask = names->capacity - 1;
+    size_t i = interned_hash(name) & mask;
+    while (names->slots[i].name) {
+        if (names->slots[i].name == name) return &names->slots[i];
+        i = (i + 1) & mask;
+    }
+    if (!create) return NULL;
+    if ((names->count + 1) * 2 > names->capacity) {
+        name_table_grow(names);
+        return name_table_slot(names, name, true);
+    }
+    names->slots[i].name = name;
+    names->count++;
+    return &names->slots[i];
+}
+
+/** @brief 把符号压入名字表成为其名字的最内层绑定，并记入撤销日志。*/
+static void push_binding(NameTable* names, Symbol* symbol) {
+    NameSlot* slot = name_table_slot(names, symbol->name, true);
+    symbol->shadowed = slot->binding;
+    slot->binding = symbol;
+    if (names->undo_count == names->undo_capacity) {
+        names->undo_capacity *= 2;
+        names->undo_log = (Symbol**)xrealloc(names->undo_log, names->undo_capacity * sizeof(Symbol*));
     }
+    names->undo_log[names->undo_count++] = symbol;
+}
 
+/** @brief 分配一张空名字表，其最内层作用域为 innermost。*/
+static NameTable* name_table_create(SymbolTable* innermost, NameTable* outer) {
+    NameTable* names = (NameTable*)calloc(1, sizeof(NameTable));
+    if (!names) {
+        fprintf(stderr, "Fatal: out of memory in symbol table.\n");
+        exit(1);
+    }
+    names->capacity = NAME_TABLE_INITIAL_CAPACITY;
+    names->slots = (NameSlot*)xrealloc(NULL, names->capacity * sizeof(NameSlot));
+    memset(names->slots, 0, names->capacity * sizeof(NameSlot));
+    names->undo_capacity = UNDO_LOG_INITIAL_CAPACITY;
+    names->undo_log = (Symbol**)xrealloc(NULL, names->undo_capacity * sizeof(Symbol*));
+    names->innermost = innermost;
+    names->outer = outer;
+    return names;
+}
+
+SymbolTable* create_symbol_table_in(MemoryPool* pool, SymbolTable* parent, NameTable* names) {
+    assert(pool != NULL && "创建符号表时内存池不能为空");
+    // 作用域记录由调用者指定的内存池分配（函数内的作用域随函数体子内存池一起释放）；
+    // 块作用域不再需要任何桶数组
+    SymbolTable* table = (SymbolTable*)pool_alloc(pool, sizeof(SymbolTable));
+
+    table->parent = parent;
+    table->symbols = NULL;
+    table->count = 0;
+    table->undo_mark = 0;
+    table->names = names;
+    table->depth = parent ? parent->depth + 1 : 0;
     return table;
 }
 
-Symbol* find_symbol_in_scope(SymbolTable* table, const char* name) {
-    if (!table || !name) return NULL;
+SymbolTable* create_symbol_table(MemoryPool* pool, SymbolTable* parent) {
+    if (parent) return create_symbol_table_in(pool, parent, parent->names);
 
-    // 计算哈希索引
-    unsigned long index = hash_function(name) % table->capacity;
-    // 遍历对应桶中的链表
-    for (Symbol* symbol = table->buckets[index]; symbol; symbol = symbol->next) {
-        if (strcmp(symbol->name, name) == 0) {
-            return symbol; // 找到符号
-        }
+    // 全局作用域：创建共享的名字表并立即激活
+    SymbolTable* table = create_symbol_table_in(pool, NULL, NULL);
+    table->names = name_table_create(table, NULL);
+    return table;
+}
+
+NameTable* create_name_table(SymbolTable* global) {
+    assert(global && !global->parent && "私有名字表只能回退到全局作用域");
+    return name_table_create(global, global->names);
+}
+
+void destroy_name_table(NameTable* names) {
+    if (!names) return;
+    assert(names->undo_count == 0 && "销毁私有名字表前必须退出其上的所有作用域");
+    free(names->slots);
+    free(names->undo_log);
+    free(names);
+}
+
+void enter_scope(SymbolTable* table) {
+    assert(table && table->parent && "只能进入非全局作用域");
+    NameTable* names = table->names;
+    assert(names->innermost == table->parent && "进入的作用域必须嵌套在当前最内层作用域中");
+    table->undo_mark = names->undo_count;
+    names->innermost = table;
+    // 再次进入时恢复此前已声明的符号（例如第一遍加入的函数参数）
+    for (Symbol* symbol = table->symbols; symbol; symbol = symbol->next) {
+        push_binding(names, symbol);
     }
-    return NULL; // 在当前作用域未找到
+}
+
+void exit_scope(SymbolTable* table) {
+    assert(table && table->parent && "全局作用域不会被退出");
+    NameTable* names = table->names;
+    assert(names->innermost == table && "只能退出当前最内层作用域");
+    while (names->undo_count > table->undo_mark) {
+        Symbol* symbol = names->undo_log[--names->undo_count];
+        name_table_slot(names, symbol->name, false)->binding = symbol->shadowed;
+    }
+    names->innermost = table->parent;
 }
 
 Symbol* find_symbol(SymbolTable* table, const char* name) {
-    if (!name) return NULL;
-    // 沿着作用域链向上查找符号
-    for (SymbolTable* scope = table; scope != NULL; scope = scope->parent) {
-        Symbol* sym = find_symbol_in_scope(scope, name);
-        if (sym) {
-            return sym; // 在某个作用域中找到符号
+    if (!table || !name) return NULL;
+    for (NameTable* names = table->names; names; names = names->outer) {
+        NameSlot* slot = name_table_slot(names, name, false);
+        if (!slot) continue;
+        // 当前绑定可能来自比 table 更深的激活作用域，跳过它们即可
+        Symbol* symbol = slot->binding;
+        while (symbol && symbol->scope->depth > table->depth) {
+            symbol = symbol->shadowed;
         }
+        if (symbol) return symbol;
     }
-    return NULL; // 所有作用域都未找到
+    return NULL;
+}
+
+Symbol* find_symbol_in_scope(SymbolTable* table, const char* name) {
+    Symbol* symbol = find_symbol(table, name);
+    return symbol && symbol->scope == table ? symbol : NULL;
 }
 
-bool add_symbol(SymbolTable* table, const char* name, Type* type, bool is_func, bool is_const, ASTContext* ctx) {
+bool add_symbol(SymbolTable* table, const char* name, Type* type, bool is_func, bool is_const, MemoryPool* pool) {
     assert(table != NULL && "FATAL: add_symbol 调用时 table 为 NULL。");
-    assert(ctx != NULL && "FATAL: add_symbol 调用时 ASTContext 为 NULL。");
-    
+    assert(pool != NULL && "FATAL: add_symbol 调用时内存池为 NULL。");
+    assert(table->names->innermost == table && "只能向最内层作用域添加符号");
+
     // 仅在 *当前* 作用域检查是否重定义
     if (find_symbol_in_scope(table, name)) {
         return false; // 符号已存在
     }
 
-    // 从内存池分配新符号
-    Symbol* symbol = (Symbol*)pool_alloc(ctx->pool, sizeof(Symbol));
-    
-    symbol->name = pool_strdup(ctx->pool, name); // 复制符号名到内存池
+    Symbol* symbol = (Symbol*)pool_alloc(pool, sizeof(Symbol));
+
+    symbol->name = (char*)name; // 规范指针与驻留表同寿命，无需复制
     symbol->type = type;
     symbol->is_func = is_func;
     symbol->is_const = is_const;
     symbol->is_evaluated = false;
     memset(&symbol->const_val, 0, sizeof(symbol->const_val));
+    symbol->scope = table;
+    symbol->order = (uint32_t)table->count;
 
-    // 将新符号添加到哈希链的头部
-    unsigned long index = hash_function(name) % table->capacity;
-    symbol->next = table->buckets[index];
-    table->buckets[index] = symbol;
+    // 记入作用域的符号链表，再压入名字表遮蔽外层同名绑定
+    symbol->next = table->symbols;
+    table->symbols = symbol;
     table->count++;
-    
+    push_binding(table->names, symbol);
+
     return true; // 添加成功
 }
 
@@ -133,14 +261,16 @@ void update_symbol_constant_value(Symbol* symbol, ConstValueUnion value) {
 
 /**
  * @brief 销毁符号表。
- * @details 由于所有内存都由内存池管理，此函数实际上是一个空操作（no-op）。
- *          内存将在 `destroy_ast_context` 中随内存池一起被释放。
- *          保留此函数是为了API的完整性和未来的扩展性。
- * @param table 要“销毁”的符号表。
+ * @details 作用域记录与符号都由内存池管理，将在 `destroy_ast_context` 中随内存池
+ *          一起被释放；只有全局作用域持有的名字表与撤销日志需要在此释放。
+ * @param table 要销毁的符号表。
  * @param ctx AST 上下文。
  */
 void destroy_symbol_table(SymbolTable* table, ASTContext* ctx) {
-    // 空操作：内存池将一次性释放所有内存
-    (void)table;
     (void)ctx;
+    if (!table || table->parent) return;
+    free(table->names->slots);
+    free(table->names->undo_log);
+    free(table->names);
+    table->names = NULL;
 }
\ No newline at end of file
@@ -282,6 +282,19 @@ bool add_error_with_severity(ErrorContext *ctx, ErrorType type,
   return true;
 }
 
+bool merge_error_context(ErrorContext *dest, const ErrorContext *src) {
+  if (!dest || !src) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t i = 0; i < src->count; ++i) {
+    const ErrorEntry *entry = &src->errors[i];
+    ok &= add_error_with_severity(dest, entry->type, entry->severity,
+                                  entry->message, entry->loc);
+  }
+  return ok;
+}
+
 void free_error_context(ErrorContext *ctx) {
   if (ctx != NULL) {
     // 释放存储错误条目的主数组。
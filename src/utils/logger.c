@@ -1,10 +1,12 @@
 #define _POSIX_C_SOURCE 200809L
 #include "logger.h"
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sched.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -13,6 +15,37 @@
  * @brief 实现了用于编译器的简单、灵活的日志记录工具。
  */
 
+// 环形缓冲区的默认容量（消息条数）
+#define LOG_RING_DEFAULT_CAPACITY 4096
+// 单条缓冲消息的最大长度（含结尾的 '\0'），超出部分被截断
+#define LOG_RING_MESSAGE_SIZE 256
+
+/**
+ * @struct LogRingSlot
+ * @brief 环形缓冲区中的一条消息。
+ * @details `sequence` 等于写入位置时槽位空闲，等于写入位置 + 1 时消息已写完
+ *          可以输出；输出后推进到下一圈的写入位置。
+ */
+typedef struct LogRingSlot {
+  atomic_size_t sequence;
+  LogLevel level;
+  LogCategory category;
+  const char *file;
+  int line;
+  time_t timestamp;
+  char message[LOG_RING_MESSAGE_SIZE];
+} LogRingSlot;
+
+struct LogRingBuffer {
+  LogRingSlot *slots;
+  size_t mask;                     ///< 容量 - 1（容量为 2 的幂）
+  size_t high_water;               ///< 积压达到该条数时由写入者就地输出
+  _Alignas(64) atomic_size_t head; ///< 下一个写入位置，由写入者竞争推进
+  _Alignas(64) atomic_size_t tail; ///< 下一个待输出位置，只由持有 draining 的线程推进
+  atomic_flag draining;            ///< drain 互斥标志，同一时刻只有一个线程输出
+  atomic_size_t dropped;           ///< 缓冲区满时丢弃的消息数
+};
+
 // --- 颜色支持实现 (使用 \x1b) ---
 
 // ANSI颜色转义序列
@@ -133,14 +166,11 @@ void logger_config_init_default(LogConfig *config) {
   config->enable_colors = is_color_supported();
   config->enabled_category_count = 0;
   config->categories_explicitly_set = false;
+  config->ring = NULL;
 }
 
-// 检查类别是否启用的辅助函数
-static bool logger_is_category_enabled(const LogConfig *config,
-                                       LogCategory category) {
-  if (!config->categories_explicitly_set) {
-    return true;
-  }
+// 检查类别是否在显式启用的列表中
+bool logger_category_listed(const LogConfig *config, LogCategory category) {
   for (int i = 0; i < config->enabled_category_count; ++i) {
     if (config->enabled_categories[i] == category) {
       return true;
@@ -254,37 +284,179 @@ bool parse_log_category(const char *str, LogCategory *category) {
 
 // --- 增强的日志记录函数 ---
 
-void logger_vlog(const LogConfig *config, LogLevel level, LogCategory category,
-                 const char *file, int line, const char *format, va_list args) {
-  if (!config || level > config->level)
-    return;
-  if (!logger_is_category_enabled(config, category))
-    return;
-
-  char time_buffer[26] = "";
+// 输出一条日志的前缀（时间戳、级别、类别、位置），直到消息正文之前
+static void write_log_prefix(const LogConfig *config, FILE *stream,
+                             LogLevel level, LogCategory category,
+                             const char *file, int line, time_t timestamp) {
   if (config->enable_timestamps) {
-    time_t timer = time(NULL);
-    struct tm *tm_info = localtime(&timer);
-    strftime(time_buffer, 26, "%Y-%m-%d %H:%M:%S", tm_info);
-    set_log_color(config, LOG_COLOR_WHITE, stderr);
-    fprintf(stderr, "[%s] ", time_buffer);
+    char time_buffer[26] = "";
+    struct tm tm_info;
+    localtime_r(&timestamp, &tm_info);
+    strftime(time_buffer, 26, "%Y-%m-%d %H:%M:%S", &tm_info);
+    set_log_color(config, LOG_COLOR_WHITE, stream);
+    fprintf(stream, "[%s] ", time_buffer);
   }
 
-  set_log_color(config, get_log_level_color(level), stderr);
-  fprintf(stderr, "[%-7s]", get_log_level_string(level));
+  set_log_color(config, get_log_level_color(level), stream);
+  fprintf(stream, "[%-7s]", get_log_level_string(level));
 
   if (config->enable_categories) {
-    set_log_color(config, get_log_category_color(category), stderr);
-    fprintf(stderr, "[%-11s]", get_log_category_string(category));
+    set_log_color(config, get_log_category_color(category), stream);
+    fprintf(stream, "[%-11s]", get_log_category_string(category));
   }
 
   if (config->enable_file_line) {
-    set_log_color(config, LOG_COLOR_CYAN, stderr);
-    fprintf(stderr, "[%s:%d]", file, line);
+    set_log_color(config, LOG_COLOR_CYAN, stream);
+    fprintf(stream, "[%s:%d]", file, line);
   }
 
-  fprintf(stderr, ": ");
-  reset_log_color(config, stderr);
+  fprintf(stream, ": ");
+  reset_log_color(config, stream);
+}
+
+static size_t ring_drain_locked(const LogConfig *config, LogRingBuffer *ring,
+                                FILE *stream);
+
+// 把一条消息格式化进环形缓冲区；缓冲区满时丢弃并计数，从不阻塞
+static void ring_push(LogRingBuffer *ring, LogLevel level,
+                      LogCategory category, const char *file, int line,
+                      time_t timestamp, const char *format, va_list args) {
+  LogRingSlot *slot;
+  size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (seq == pos) {
+      if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if (seq < pos) {
+      // 槽位还留着上一圈未输出的消息：缓冲区已满
+      atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    }
+  }
+
+  slot->level = level;
+  slot->category = category;
+  slot->file = file;
+  slot->line = line;
+  slot->timestamp = timestamp;
+  int len = vsnprintf(slot->message, LOG_RING_MESSAGE_SIZE, format, args);
+  if (len >= LOG_RING_MESSAGE_SIZE) {
+    memcpy(slot->message + LOG_RING_MESSAGE_SIZE - 4, "...", 4);
+  }
+  atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+}
+
+// 积压达到高水位时，抢到 drain 标志的写入者就地输出到 stderr（与未缓冲时
+// 相同的流），避免长阶段（例如 -O2 的 debug 日志）在下一次阶段间 drain 之前
+// 写满缓冲区。抢不到标志的写入者照常返回，不等待。
+static void ring_drain_if_high(const LogConfig *config, LogRingBuffer *ring) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  if (head - tail < ring->high_water)
+    return;
+  if (atomic_flag_test_and_set_explicit(&ring->draining, memory_order_acquire))
+    return;
+  ring_drain_locked(config, ring, stderr);
+  atomic_flag_clear_explicit(&ring->draining, memory_order_release);
+}
+
+LogRingBuffer *logger_ring_create(size_t capacity) {
+  if (capacity == 0)
+    capacity = LOG_RING_DEFAULT_CAPACITY;
+  size_t rounded = 1;
+  while (rounded < capacity)
+    rounded <<= 1;
+
+  LogRingBuffer *ring = (LogRingBuffer *)calloc(1, sizeof(LogRingBuffer));
+  if (!ring)
+    return NULL;
+  ring->slots = (LogRingSlot *)malloc(rounded * sizeof(LogRingSlot));
+  if (!ring->slots) {
+    free(ring);
+    return NULL;
+  }
+  for (size_t i = 0; i < rounded; ++i) {
+    atomic_init(&ring->slots[i].sequence, i);
+  }
+  ring->mask = rounded - 1;
+  ring->high_water = rounded - rounded / 4;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  atomic_flag_clear(&ring->draining);
+  atomic_init(&ring->dropped, 0);
+  return ring;
+}
+
+void logger_ring_destroy(LogRingBuffer *ring) {
+  if (!ring)
+    return;
+  free(ring->slots);
+  free(ring);
+}
+
+// 调用者必须持有 ring->draining
+static size_t ring_drain_locked(const LogConfig *config, LogRingBuffer *ring,
+                                FILE *stream) {
+  size_t drained = 0;
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  for (;;) {
+    LogRingSlot *slot = &ring->slots[tail & ring->mask];
+    size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    // 下一条消息尚未写完：保持写入顺序，留到下次再输出
+    if (seq != tail + 1)
+      break;
+    write_log_prefix(config, stream, slot->level, slot->category, slot->file,
+                     slot->line, slot->timestamp);
+    fprintf(stream, "%s\n", slot->message);
+    atomic_store_explicit(&slot->sequence, tail + ring->mask + 1,
+                          memory_order_release);
+    tail++;
+    atomic_store_explicit(&ring->tail, tail, memory_order_relaxed);
+    drained++;
+  }
+  size_t dropped =
+      atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+  if (dropped) {
+    fprintf(stream, "[logger] %zu message(s) dropped: ring buffer full\n",
+            dropped);
+  }
+  fflush(stream);
+  return drained;
+}
+
+size_t logger_ring_drain(const LogConfig *config, LogRingBuffer *ring,
+                         FILE *stream) {
+  if (!config || !ring)
+    return 0;
+  // 写入者可能正在做高水位输出，等它结束后接着输出
+  while (atomic_flag_test_and_set_explicit(&ring->draining,
+                                           memory_order_acquire))
+    sched_yield();
+  size_t drained = ring_drain_locked(config, ring, stream);
+  atomic_flag_clear_explicit(&ring->draining, memory_order_release);
+  return drained;
+}
+
+void logger_vlog(const LogConfig *config, LogLevel level, LogCategory category,
+                 const char *file, int line, const char *format, va_list args) {
+  if (!logger_enabled(config, level, category))
+    return;
+
+  time_t timestamp = config->enable_timestamps ? time(NULL) : 0;
+  if (config->ring) {
+    ring_push(config->ring, level, category, file, line, timestamp, format,
+              args);
+    ring_drain_if_high(config, config->ring);
+    return;
+  }
+
+  write_log_prefix(config, stderr, level, category, file, line, timestamp);
   vfprintf(stderr, format, args);
   fprintf(stderr, "\n");
   fflush(stderr);
@@ -296,4 +468,4 @@ void logger_log(const LogConfig *config, LogLevel level, LogCategory category,
   va_start(args, format);
   logger_vlog(config, level, category, file, line, format, args);
   va_end(args);
-}
\ No newline at end of file
+}
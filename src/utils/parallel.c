@@ -0,0 +1,74 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @file parallel.c
+ * @brief 实现按任务下标动态分发的线程池。
+ */
+
+/** @brief 所有工作线程共享的分发状态。*/
+typedef struct ParallelJob {
+    atomic_size_t next;    ///< 下一个尚未被领取的任务下标
+    size_t count;          ///< 任务总数
+    ParallelTask task;     ///< 任务回调
+    void* user_data;       ///< 回调上下文
+} ParallelJob;
+
+/** @brief 工作线程的启动参数。*/
+typedef struct ParallelWorker {
+    ParallelJob* job;
+    unsigned id;
+} ParallelWorker;
+
+/** @brief 反复领取并执行任务，直到任务耗尽。*/
+static void run_tasks(ParallelJob* job, unsigned worker) {
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (index >= job->count) return;
+        job->task(index, worker, job->user_data);
+    }
+}
+
+static void* worker_main(void* arg) {
+    ParallelWorker* self = (ParallelWorker*)arg;
+    run_tasks(self->job, self->id);
+    return NULL;
+}
+
+unsigned parallel_default_workers(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+}
+
+void parallel_for(size_t count, unsigned num_workers, ParallelTask task, void* user_data) {
+    if (count == 0) return;
+    ParallelJob job = {.count = count, .task = task, .user_data = user_data};
+    atomic_init(&job.next, 0);
+    if (num_workers > count) num_workers = (unsigned)count;
+    if (num_workers <= 1) {
+        run_tasks(&job, 0);
+        return;
+    }
+
+    // 0 号工作线程就是调用线程，只需额外创建 num_workers - 1 个线程
+    pthread_t* threads = (pthread_t*)malloc((num_workers - 1) * sizeof(pthread_t));
+    ParallelWorker* workers = (ParallelWorker*)malloc((num_workers - 1) * sizeof(ParallelWorker));
+    unsigned started = 0;
+    if (threads && workers) {
+        for (unsigned i = 0; i < num_workers - 1; ++i) {
+            workers[i] = (ParallelWorker){.job = &job, .id = i + 1};
+            if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) != 0) break;
+            started++;
+        }
+    }
+    // 线程创建失败不影响正确性：未被领取的任务全部由调用线程完成
+    run_tasks(&job, 0);
+    for (unsigned i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    free(workers);
+}
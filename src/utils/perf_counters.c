@@ -0,0 +1,212 @@
+#define _GNU_SOURCE // syscall()
+#include "perf_counters.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @file perf_counters.c
+ * @brief 基于 `perf_event_open` 的分阶段/分遍硬件计数器统计。
+ */
+
+// 最多记录的不同区间名字数
+#define PERF_MAX_REGIONS 64
+// 区间栈的最大嵌套深度，更深的区间不被记录
+#define PERF_MAX_DEPTH 16
+
+/** @brief 按名字累计的一个区间。*/
+typedef struct PerfRegion {
+    const char* name;
+    PerfRegionKind kind;
+    unsigned calls;    ///< 区间被度量的次数
+    PerfSample total;  ///< 各次度量差值之和
+} PerfRegion;
+
+static bool enabled = false;
+static int counter_fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+static int open_errno = 0; ///< 第一个打开失败的计数器的 errno
+
+static PerfSample region_stack[PERF_MAX_DEPTH];
+static int region_depth = 0;
+
+static PerfRegion regions[PERF_MAX_REGIONS];
+static int region_count = 0;
+
+static const char* const counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "L1D-miss", "LLC-miss", "br-miss",
+};
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static bool any_counter_open(void) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (counter_fds[i] >= 0) return true;
+    }
+    return false;
+}
+
+#ifdef __linux__
+/** @brief 打开一个只统计用户态、并继承到之后创建的线程的计数器。*/
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1; // -j 的工作线程在 join 时把计数并回主线程
+    // 计数器数量超过硬件寄存器时内核会分时复用，读取时据此缩放
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+bool perf_counters_enable(void) {
+    if (enabled) return any_counter_open();
+    enabled = true;
+#ifdef __linux__
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[PERF_COUNTER_COUNT] = {
+        [PERF_COUNTER_CYCLES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        [PERF_COUNTER_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        [PERF_COUNTER_L1D_MISSES] = {PERF_TYPE_HW_CACHE,
+                                     PERF_COUNT_HW_CACHE_L1D |
+                                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        [PERF_COUNTER_LLC_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        [PERF_COUNTER_BRANCH_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        counter_fds[i] = open_counter(events[i].type, events[i].config);
+        if (counter_fds[i] < 0 && !open_errno) open_errno = errno;
+    }
+#else
+    open_errno = ENOSYS;
+#endif
+    return any_counter_open();
+}
+
+void perf_counters_disable(void) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (counter_fds[i] >= 0) close(counter_fds[i]);
+        counter_fds[i] = -1;
+    }
+    enabled = false;
+    region_depth = 0;
+}
+
+bool perf_counters_enabled(void) {
+    return enabled;
+}
+
+void perf_counters_read(PerfSample* out) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        out->values[i] = 0;
+        if (counter_fds[i] < 0) continue;
+        uint64_t buf[3]; // value, time_enabled, time_running
+        if (read(counter_fds[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue;
+        if (buf[2] == 0) continue;
+        out->values[i] = buf[2] < buf[1]
+            ? (uint64_t)((double)buf[0] * (double)buf[1] / (double)buf[2])
+            : buf[0];
+    }
+    out->ms = monotonic_ms();
+}
+
+void perf_region_begin(void) {
+    if (!enabled) return;
+    if (region_depth < PERF_MAX_DEPTH) perf_counters_read(&region_stack[region_depth]);
+    region_depth++;
+}
+
+/** @brief 查找或创建名为 name 的区间记录；表满时返回 NULL。*/
+static PerfRegion* find_region(PerfRegionKind kind, const char* name) {
+    for (int i = 0; i < region_count; ++i) {
+        if (regions[i].kind == kind &&
+            (regions[i].name == name || strcmp(regions[i].name, name) == 0)) {
+            return &regions[i];
+        }
+    }
+    if (region_count == PERF_MAX_REGIONS) return NULL;
+    PerfRegion* region = &regions[region_count++];
+    memset(region, 0, sizeof(*region));
+    region->name = name;
+    region->kind = kind;
+    return region;
+}
+
+void perf_region_end(PerfRegionKind kind, const char* name) {
+    if (!enabled || region_depth == 0) return;
+    region_depth--;
+    if (region_depth >= PERF_MAX_DEPTH) return;
+
+    PerfSample now;
+    perf_counters_read(&now);
+    const PerfSample* start = &region_stack[region_depth];
+    PerfRegion* region = find_region(kind, name);
+    if (!region) return;
+    region->calls++;
+    region->total.ms += now.ms - start->ms;
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        region->total.values[i] += now.values[i] - start->values[i];
+    }
+}
+
+bool perf_region_end_bool(const char* name, bool result) {
+    perf_region_end(PERF_REGION_PASS, name);
+    return result;
+}
+
+static void report_table(FILE* out, PerfRegionKind kind, const char* title) {
+    bool any_region = false;
+    for (int i = 0; i < region_count; ++i) any_region |= regions[i].kind == kind;
+    if (!any_region) return;
+
+    fprintf(out, "%s:\n  %-16s %7s %11s", title, "name", "calls", "time(ms)");
+    for (int c = 0; c < PERF_COUNTER_COUNT; ++c) {
+        if (counter_fds[c] >= 0) fprintf(out, " %14s", counter_names[c]);
+    }
+    bool ipc = counter_fds[PERF_COUNTER_CYCLES] >= 0 && counter_fds[PERF_COUNTER_INSTRUCTIONS] >= 0;
+    if (ipc) fprintf(out, " %6s", "IPC");
+    fprintf(out, "\n");
+
+    for (int i = 0; i < region_count; ++i) {
+        const PerfRegion* r = &regions[i];
+        if (r->kind != kind) continue;
+        fprintf(out, "  %-16s %7u %11.3f", r->name, r->calls, r->total.ms);
+        for (int c = 0; c < PERF_COUNTER_COUNT; ++c) {
+            if (counter_fds[c] >= 0) fprintf(out, " %14llu", (unsigned long long)r->total.values[c]);
+        }
+        if (ipc) {
+            uint64_t cycles = r->total.values[PERF_COUNTER_CYCLES];
+            fprintf(out, " %6.2f",
+                    cycles ? (double)r->total.values[PERF_COUNTER_INSTRUCTIONS] / (double)cycles : 0.0);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void perf_counters_report(FILE* out) {
+    if (!any_counter_open()) {
+        fprintf(out, "Hardware counters unavailable (perf_event_open: %s); reporting time only.\n",
+                strerror(open_errno ? open_errno : ENOSYS));
+    } else {
+        for (int c = 0; c < PERF_COUNTER_COUNT; ++c) {
+            if (counter_fds[c] < 0) fprintf(out, "Counter '%s' unavailable.\n", counter_names[c]);
+        }
+    }
+    report_table(out, PERF_REGION_PHASE, "Per-phase counters");
+    report_table(out, PERF_REGION_PASS, "Per-pass counters");
+}
@@ -0,0 +1,124 @@
+#include "source_buffer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file source_buffer.c
+ * @brief 实现源文件的映射与载入。
+ */
+
+/**
+ * @brief 把整个文件读到 EOF，存入带结尾填充的堆缓冲区（mmap 不适用时的后备路径）。
+ * @details 管道、FIFO 与 `/dev/stdin` 的 `st_size` 为 0，因此不能按 stat 的大小
+ *          读取，而是以 `size_hint` 为初始容量，读满后倍增。
+ */
+static bool read_whole_file(SourceBuffer* buf, int fd, size_t size_hint) {
+    size_t capacity = size_hint > 0 ? size_hint + 1 : 4096;
+    char* data = (char*)malloc(capacity + SOURCE_BUFFER_PADDING);
+    if (!data) {
+        errno = ENOMEM;
+        return false;
+    }
+    size_t done = 0;
+    for (;;) {
+        if (done == capacity) {
+            // 超过 SourceSpan 的 32 位偏移所能表示的范围
+            if (capacity > UINT32_MAX) {
+                free(data);
+                errno = EFBIG;
+                return false;
+            }
+            char* grown = (char*)realloc(data, capacity * 2 + SOURCE_BUFFER_PADDING);
+            if (!grown) {
+                free(data);
+                errno = ENOMEM;
+                return false;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, data + done, capacity - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            int saved = errno;
+            free(data);
+            errno = saved;
+            return false;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
+    }
+    if (done > UINT32_MAX) {
+        free(data);
+        errno = EFBIG;
+        return false;
+    }
+    memset(data + done, 0, SOURCE_BUFFER_PADDING);
+    buf->data = data;
+    buf->size = done;
+    buf->alloc_size = capacity + SOURCE_BUFFER_PADDING;
+    buf->is_mapped = false;
+    return true;
+}
+
+bool source_buffer_open(SourceBuffer* buf, const char* path) {
+    memset(buf, 0, sizeof(*buf));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    // SourceSpan 以 32 位偏移引用源文本，更大的文件无法表示
+    if (S_ISREG(st.st_mode) && (uint64_t)st.st_size > UINT32_MAX) {
+        close(fd);
+        errno = EFBIG;
+        return false;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    size_t tail = page > 0 ? size % (size_t)page : 0;
+    bool ok = false;
+
+    // 只有最后一页在文件末尾之后留有至少两个字节时，才能依赖内核清零的页尾
+    // 作为 Flex 的结束标记。映射为可写的私有映射：Flex 会在 yytext 末尾临时
+    // 写入 '\0'，写时复制只影响被触及的页，不会写回文件。
+    if (S_ISREG(st.st_mode) && size > 0 && tail != 0 &&
+        tail + SOURCE_BUFFER_PADDING <= (size_t)page) {
+        void* p = mmap(NULL, size + SOURCE_BUFFER_PADDING, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            buf->data = (char*)p;
+            buf->size = size;
+            buf->alloc_size = size + SOURCE_BUFFER_PADDING;
+            buf->is_mapped = true;
+            ok = true;
+        }
+    }
+    if (!ok) ok = read_whole_file(buf, fd, S_ISREG(st.st_mode) ? size : 0);
+
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+void source_buffer_close(SourceBuffer* buf) {
+    if (!buf || !buf->data) return;
+    if (buf->is_mapped) {
+        munmap(buf->data, buf->alloc_size);
+    } else {
+        free(buf->data);
+    }
+    memset(buf, 0, sizeof(*buf));
+}
@@ -0,0 +1,171 @@
+#!/bin/bash
+#
+# SysY 用例回归测试。
+#
+#   reject 模式：目录中的每个 .sy 都必须在语义分析阶段报错；源码中每一行
+#                “// expect-error: <文本>” 给出的文本都必须出现在诊断输出中。
+#   run 模式：   每个 .sy 在 -O0/-O1/-O2 下各编译两次（mem2reg 与 --direct-ssa），
+#                用 -S 输出的 LLVM IR 经 llc 与 cc 链接 runtime/sylib.c 后运行；
+#                标准输出加退出码（SysY 评测的 .out 格式）必须与同名 .out 一致。
+#                同名 .in 存在时作为标准输入。需要 llc（可用 LLC 覆盖）与 cc（CC）。
+#
+# 用法: test/run_sy_cases.sh --compiler <sysyc> --cases DIR [--mode reject|run]
+#                            [--runtime <sylib.c>] [--work-dir DIR]
+#
+# 退出状态: 0 全部通过；1 有用例失败；2 环境或参数错误；77 缺少外部工具，跳过。
+
+set -euo pipefail
+
+COMPILER=""
+CASES=""
+MODE="reject"
+RUNTIME=""
+WORK_DIR=""
+LLC="${LLC:-llc}"
+CC="${CC:-cc}"
+
+FAILURES=0
+PASSED=0
+
+usage() {
+    cat >&2 << EOF
+usage: $0 --compiler <sysyc> --cases DIR [--mode reject|run] [--runtime <sylib.c>]
+          [--work-dir DIR]
+EOF
+    exit 2
+}
+
+die() {
+    echo "run_sy_cases: $*" >&2
+    exit 2
+}
+
+while [ $# -gt 0 ]; do
+    [ $# -ge 2 ] || usage
+    case "$1" in
+        --compiler) COMPILER="$2" ;;
+        --cases) CASES="$2" ;;
+        --mode) MODE="$2" ;;
+        --runtime) RUNTIME="$2" ;;
+        --work-dir) WORK_DIR="$2" ;;
+        *) usage ;;
+    esac
+    shift 2
+done
+
+[ -n "${COMPILER}" ] && [ -n "${CASES}" ] || usage
+[ -x "${COMPILER}" ] || die "compiler '${COMPILER}' is not executable"
+[ -d "${CASES}" ] || die "case directory '${CASES}' not found"
+case "${MODE}" in
+    reject) ;;
+    run)
+        [ -f "${RUNTIME}" ] || die "run mode needs --runtime <sylib.c>"
+        for tool in "${LLC}" "${CC}"; do
+            if ! command -v "${tool}" > /dev/null 2>&1; then
+                echo "run_sy_cases: '${tool}' not found, skipping run cases"
+                exit 77
+            fi
+        done
+        ;;
+    *) die "unknown mode '${MODE}' (reject|run)" ;;
+esac
+
+if [ -z "${WORK_DIR}" ]; then
+    WORK_DIR="$(mktemp -d /tmp/sysyc_cases_XXXXXX)"
+fi
+mkdir -p "${WORK_DIR}"
+
+mapfile -t PROGRAMS < <(find "${CASES}" -maxdepth 1 -name '*.sy' | sort)
+[ ${#PROGRAMS[@]} -gt 0 ] || die "no .sy programs in '${CASES}'"
+
+# 用例必须被拒绝，且诊断包含所有 expect-error 文本
+check_reject() {
+    local src="$1" log="$2"
+    if "${COMPILER}" --log-level error semantic "${src}" > "${log}" 2>&1; then
+        echo "accepted, expected a diagnostic"
+        return 1
+    fi
+    local expected count=0
+    while IFS= read -r expected; do
+        count=$((count + 1))
+        if ! grep -qF -- "${expected}" "${log}"; then
+            echo "missing diagnostic '${expected}'"
+            return 1
+        fi
+    done < <(sed -n 's|^[[:space:]]*//[[:space:]]*expect-error:[[:space:]]*||p' "${src}")
+    if [ ${count} -eq 0 ]; then
+        echo "no expect-error line in the case"
+        return 1
+    fi
+    return 0
+}
+
+# 编译、链接并运行一个用例，输出写成 .out 格式后与期望比较
+check_run_config() {
+    local src="$1" stem="$2"
+    shift 2
+    local expected="${src%.sy}.out" input="${src%.sy}.in"
+    [ -f "${input}" ] || input=/dev/null
+    if ! "${COMPILER}" --log-level error "$@" asm -S -o "${stem}.ll" "${src}" > "${stem}.log" 2>&1; then
+        echo "$*: compile failed"
+        return 1
+    fi
+    if ! "${LLC}" -relocation-model=pic -o "${stem}.s" "${stem}.ll" >> "${stem}.log" 2>&1; then
+        echo "$*: llc rejected the IR"
+        return 1
+    fi
+    if ! "${CC}" -o "${stem}" "${stem}.s" "${WORK_DIR}/sylib.o" -lm -lpthread >> "${stem}.log" 2>&1; then
+        echo "$*: link failed"
+        return 1
+    fi
+    local status=0
+    timeout 10 "${stem}" < "${input}" > "${stem}.stdout" 2>> "${stem}.log" || status=$?
+    {
+        cat "${stem}.stdout"
+        if [ -n "$(tail -c 1 "${stem}.stdout")" ]; then
+            echo
+        fi
+        echo "${status}"
+    } > "${stem}.actual"
+    if ! cmp -s "${stem}.actual" "${expected}"; then
+        echo "$*: output differs from ${expected}"
+        return 1
+    fi
+    return 0
+}
+
+# 每个优化级别分别用 mem2reg 与 --direct-ssa 构造 SSA，结果都必须与 .out 一致
+check_run() {
+    local src="$1" name="$2" level
+    [ -f "${src%.sy}.out" ] || { echo "missing ${name}.out"; return 1; }
+    for level in 0 1 2; do
+        check_run_config "${src}" "${WORK_DIR}/${name}.O${level}" "-O${level}" || return 1
+        check_run_config "${src}" "${WORK_DIR}/${name}.O${level}.direct" "-O${level}" --direct-ssa || return 1
+    done
+    return 0
+}
+
+if [ "${MODE}" = "run" ]; then
+    "${CC}" -c -o "${WORK_DIR}/sylib.o" "${RUNTIME}" || die "cannot compile runtime '${RUNTIME}'"
+fi
+
+for src in "${PROGRAMS[@]}"; do
+    name="$(basename "${src}" .sy)"
+    if [ "${MODE}" = "run" ]; then
+        reason="$(check_run "${src}" "${name}")" && ok=1 || ok=0
+        where="${WORK_DIR}/${name}.*"
+    else
+        log="${WORK_DIR}/${name}.log"
+        reason="$(check_reject "${src}" "${log}")" && ok=1 || ok=0
+        where="${log}"
+    fi
+    if [ ${ok} -eq 1 ]; then
+        PASSED=$((PASSED + 1))
+    else
+        echo "FAIL ${name}: ${reason} (see ${where})"
+        FAILURES=$((FAILURES + 1))
+    fi
+done
+
+echo "run_sy_cases: ${MODE}: ${PASSED} passed, ${FAILURES} failed"
+[ ${FAILURES} -eq 0 ]
@@ -0,0 +1,214 @@
+/**
+ * @file inst_combine_patterns_test.c
+ * @brief inst_combine.pat 中改写模式的单元测试。
+ * @details
+ * 每个用例手写一个只有入口块的函数 `ret (片段)`，运行 run_inst_combine 后检查
+ * 返回值的定义。覆盖 i1/i32/i64 三种位宽、常量折叠的补码回绕，以及 INT_MIN 与
+ * 2 的幂这类按位宽解释常量的边界。
+ */
+#include "ir/transforms/inst_combine.h"
+#include "ir/ir_utils.h"
+#include "ir_test.h"
+#include <limits.h>
+#include <string.h>
+
+typedef IRInstruction *(*BinaryBuilder)(IRBuilder *, IRValue *, IRValue *,
+                                        const char *);
+
+static IRTest T;
+
+// 新建 `basic f(basic a0, basic a1, basic a2)`，插入点在入口块。
+static IRFunction *begin(const char *name, BasicType basic) {
+  Type *type = ir_test_type(&T, basic);
+  Type *params[] = {type, type, type};
+  return ir_test_function(&T, name, type, params, 3);
+}
+
+// 以 value 结束函数，运行指令合并，返回 ret 的操作数。
+static IRValue *combine(IRFunction *func, IRValue *value) {
+  ir_builder_create_ret(&T.builder, value);
+  ir_test_prepare(func);
+  run_inst_combine(func);
+  return ir_test_returned(func);
+}
+
+// `ret (op a0 C)` 的合并结果；*x 为参数 a0。
+static IRValue *combine_with_const(const char *name, BasicType basic,
+                                   BinaryBuilder op, int64_t c, IRValue **x) {
+  IRFunction *func = begin(name, basic);
+  *x = func->args[0];
+  return combine(func, op(&T.builder, *x, ir_test_const(&T, basic, c), "r")->dest);
+}
+
+// 结果是 `op x C`。
+static bool is_binary_with_const(IRValue *v, Opcode op, IRValue *x, int64_t c) {
+  IRInstruction *def = ir_test_def(v, op);
+  return def && ir_test_operand(def, 0) == x &&
+         ir_test_is_const(ir_test_operand(def, 1), c);
+}
+
+// x + 0、x * 1、x & x、x ^ x 对每种位宽都成立。
+static void test_identities_all_widths(void) {
+  static const BasicType widths[] = {BASIC_I1, BASIC_INT, BASIC_I64};
+  for (int i = 0; i < 3; i++) {
+    BasicType basic = widths[i];
+    IRValue *x;
+    IR_CHECK(&T, combine_with_const("add_zero", basic, ir_builder_create_add, 0,
+                                    &x) == x);
+    IR_CHECK(&T, combine_with_const("mul_one", basic, ir_builder_create_mul, 1,
+                                    &x) == x);
+
+    IRFunction *func = begin("and_self", basic);
+    IR_CHECK(&T, combine(func, ir_builder_create_and(&T.builder, func->args[0],
+                                                     func->args[0], "r")
+                                   ->dest) == func->args[0]);
+
+    func = begin("xor_self", basic);
+    IRValue *r = combine(func, ir_builder_create_xor(&T.builder, func->args[0],
+                                                     func->args[0], "r")
+                                   ->dest);
+    IR_CHECK(&T, ir_test_is_const(r, 0));
+    IR_CHECK(&T, r && r->type->basic == basic);
+  }
+}
+
+// (add x x) -> (shl x 1) 只在位宽大于 1 时成立：i1 上移 1 位是 poison。
+static void test_add_self(void) {
+  IRFunction *func = begin("add_self_i32", BASIC_INT);
+  IRValue *x = func->args[0];
+  IRValue *r = combine(func, ir_builder_create_add(&T.builder, x, x, "r")->dest);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_SHL, x, 1));
+
+  func = begin("add_self_i1", BASIC_I1);
+  x = func->args[0];
+  r = combine(func, ir_builder_create_add(&T.builder, x, x, "r")->dest);
+  IR_CHECK(&T, ir_test_def(r, IR_OP_SHL) == NULL);
+}
+
+// 乘以 2 的幂改为左移；移位量按位宽计算，i32 的 INT_MIN 是负数，不是 2 的幂。
+static void test_mul_pow2(void) {
+  IRValue *x;
+  IRValue *r = combine_with_const("mul8", BASIC_INT, ir_builder_create_mul, 8, &x);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_SHL, x, 3));
+
+  r = combine_with_const("mul2_40", BASIC_I64, ir_builder_create_mul,
+                         INT64_C(1) << 40, &x);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_SHL, x, 40));
+
+  r = combine_with_const("mul_int_min", BASIC_INT, ir_builder_create_mul, INT_MIN,
+                         &x);
+  IR_CHECK(&T, r != x);
+  IR_CHECK(&T, !is_binary_with_const(r, IR_OP_SHL, x, 0));
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_MUL, x, INT_MIN));
+
+  // i64 中 0x80000000 是正的 2 的幂
+  r = combine_with_const("mul_2_31_i64", BASIC_I64, ir_builder_create_mul,
+                         INT64_C(1) << 31, &x);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_SHL, x, 31));
+}
+
+// 被除数已知非负时，除以 2 的幂改为逻辑右移，取余改为按位与。
+static void test_div_rem_pow2(void) {
+  IRFunction *func = begin("sdiv16", BASIC_INT);
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0],
+                                     ir_test_const(&T, BASIC_INT, 255), "x")
+                   ->dest;
+  IRValue *r = combine(func, ir_builder_create_sdiv(&T.builder, x,
+                                                    ir_test_const(&T, BASIC_INT, 16),
+                                                    "r")
+                                 ->dest);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_LSHR, x, 4));
+
+  func = begin("srem8", BASIC_INT);
+  x = ir_builder_create_and(&T.builder, func->args[0],
+                            ir_test_const(&T, BASIC_INT, 255), "x")
+          ->dest;
+  r = combine(func, ir_builder_create_srem(&T.builder, x,
+                                           ir_test_const(&T, BASIC_INT, 8), "r")
+                        ->dest);
+  // and x 7 随后与 x 的定义 and a0 255 合并
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_AND, func->args[0], 7));
+
+  // 符号未知时需要符号修正，保持 sdiv
+  r = combine_with_const("sdiv16_signed", BASIC_INT, ir_builder_create_sdiv, 16, &x);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_SDIV, x, 16));
+
+  // INT_MIN 不是 2 的幂，除以它不能改为右移 0 位
+  func = begin("sdiv_int_min", BASIC_INT);
+  x = ir_builder_create_and(&T.builder, func->args[0],
+                            ir_test_const(&T, BASIC_INT, 255), "x")
+          ->dest;
+  r = combine(func, ir_builder_create_sdiv(&T.builder, x,
+                                           ir_test_const(&T, BASIC_INT, INT_MIN),
+                                           "r")
+                        ->dest);
+  IR_CHECK(&T, r != x);
+  IR_CHECK(&T, !is_binary_with_const(r, IR_OP_LSHR, x, 0));
+
+  r = combine_with_const("sdiv_minus_one", BASIC_INT, ir_builder_create_sdiv, -1,
+                         &x);
+  IRInstruction *neg = ir_test_def(r, IR_OP_SUB);
+  IR_CHECK(&T, neg && ir_test_is_const(ir_test_operand(neg, 0), 0) &&
+                   ir_test_operand(neg, 1) == x);
+}
+
+// RHS 中的常量按根指令的位宽回绕：INT_MAX + 1 在 i32 中是 INT_MIN，在 i64 中不是。
+static void test_constant_folding_width(void) {
+  IRFunction *func = begin("reassoc_i32", BASIC_INT);
+  IRValue *x = func->args[0];
+  IRValue *inner = ir_builder_create_add(&T.builder, x,
+                                         ir_test_const(&T, BASIC_INT, INT_MAX), "t")
+                       ->dest;
+  IRValue *r = combine(func, ir_builder_create_add(&T.builder, inner,
+                                                   ir_test_const(&T, BASIC_INT, 1), "r")
+                                 ->dest);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_ADD, x, INT_MIN));
+
+  func = begin("reassoc_i64", BASIC_I64);
+  x = func->args[0];
+  inner = ir_builder_create_add(&T.builder, x,
+                                ir_test_const(&T, BASIC_I64, INT_MAX), "t")
+              ->dest;
+  r = combine(func, ir_builder_create_add(&T.builder, inner,
+                                          ir_test_const(&T, BASIC_I64, 1), "r")
+                        ->dest);
+  IR_CHECK(&T, is_binary_with_const(r, IR_OP_ADD, x, (int64_t)INT_MAX + 1));
+  IR_CHECK(&T, r && r->def_instr &&
+                   ir_test_operand(r->def_instr, 1)->type->basic == BASIC_I64);
+}
+
+// 同一函数中新建的临时值名字互不相同，且与函数被处理的次数无关地递增。
+static void test_temp_names(void) {
+  IRFunction *func = begin("distribute", BASIC_INT);
+  IRValue **a = func->args;
+  IRValue *sums[2];
+  for (int i = 0; i < 2; i++) {
+    IRValue *m1 = ir_builder_create_mul(&T.builder, a[0], a[1], "m")->dest;
+    IRValue *m2 = ir_builder_create_mul(&T.builder, a[0], a[2], "m")->dest;
+    sums[i] = ir_builder_create_add(&T.builder, m1, m2, "s")->dest;
+  }
+  IRValue *total = ir_builder_create_xor(&T.builder, sums[0], sums[1], "x")->dest;
+  combine(func, total);
+
+  const char *names[2] = {NULL, NULL};
+  int count = 0;
+  for (IRInstruction *instr = func->entry->head; instr; instr = instr->next) {
+    if (instr->dest && instr->dest->name && strstr(instr->dest->name, ".ic") &&
+        count < 2)
+      names[count++] = instr->dest->name;
+  }
+  IR_CHECK(&T, count == 2);
+  IR_CHECK(&T, count == 2 && strcmp(names[0], names[1]) != 0);
+  IR_CHECK(&T, func->temp_name_count == 2);
+}
+
+int main(void) {
+  ir_test_init(&T);
+  test_identities_all_widths();
+  test_add_self();
+  test_mul_pow2();
+  test_div_rem_pow2();
+  test_constant_folding_width();
+  test_temp_names();
+  return ir_test_exit_code(&T);
+}
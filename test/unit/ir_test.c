@@ -0,0 +1,128 @@
+/**
+ * @file ir_test.c
+ * @brief 中端单元测试的公共设施实现，见 ir_test.h。
+ */
+#include "ir_test.h"
+#include "ir/analysis/cfg_builder.h"
+#include "ir/analysis/dominators.h"
+#include "ir/ir.h"
+#include "ir/ir_utils.h"
+#include <stdio.h>
+
+IRModule *create_ir_module(const char *source_filename, LogConfig *log_config);
+
+void ir_test_init(IRTest *t) {
+  logger_config_init_default(&t->log_config);
+  t->log_config.level = LOG_LEVEL_NONE;
+  t->module = create_ir_module("unit_test", &t->log_config);
+  t->checks = 0;
+  t->failures = 0;
+}
+
+int ir_test_exit_code(IRTest *t) {
+  printf("%d checks, %d failed\n", t->checks, t->failures);
+  destroy_ir_module(t->module);
+  return t->failures == 0 ? 0 : 1;
+}
+
+void ir_test_check(IRTest *t, bool ok, const char *file, int line,
+                   const char *expr) {
+  t->checks++;
+  if (!ok) {
+    t->failures++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+  }
+}
+
+Type *ir_test_type(IRTest *t, BasicType basic) {
+  return create_basic_type(basic, false, t->module->pool);
+}
+
+IRValue *ir_test_const(IRTest *t, BasicType basic, int64_t value) {
+  MemoryPool *pool = t->module->pool;
+  switch (basic) {
+  case BASIC_I1:
+    return create_constant_i1(value & 1, pool);
+  case BASIC_I64:
+    return create_constant_i64(value, pool);
+  default: {
+    IRValue *v = create_ir_value(pool);
+    v->is_constant = true;
+    v->type = create_basic_type(basic, true, pool);
+    v->int_val = (int)value;
+    return v;
+  }
+  }
+}
+
+IRFunction *ir_test_function(IRTest *t, const char *name, Type *ret_type,
+                             Type **params, int num_params) {
+  MemoryPool *pool = t->module->pool;
+  IRFunction *func = create_ir_function(name, ret_type, t->module, pool);
+  link_function_to_module(func, t->module);
+  func->num_args = num_params;
+  if (num_params > 0)
+    func->args = pool_alloc(pool, num_params * sizeof(IRValue *));
+  for (int i = 0; i < num_params; i++) {
+    char arg_name[16];
+    snprintf(arg_name, sizeof(arg_name), "a%d", i);
+    func->args[i] = create_ir_value(pool);
+    func->args[i]->type = params[i];
+    func->args[i]->name = pool_strdup(pool, arg_name);
+  }
+
+  ir_builder_init(&t->builder, func);
+  IRBasicBlock *entry = ir_builder_create_block(&t->builder, "entry");
+  func->blocks = func->tail = func->entry = entry;
+  func->block_count = 1;
+  ir_builder_set_insertion_block(&t->builder, entry);
+  return func;
+}
+
+IRBasicBlock *ir_test_block(IRTest *t, const char *label) {
+  IRBasicBlock *bb = ir_builder_create_block(&t->builder, label);
+  insert_block_after(bb, t->builder.current_func->tail);
+  return bb;
+}
+
+void ir_test_prepare(IRFunction *func) {
+  build_cfg(func);
+  compute_dominator_tree(func);
+}
+
+IRValue *ir_test_returned(IRFunction *func) {
+  for (IRBasicBlock *bb = func->blocks; bb; bb = bb->next_in_func) {
+    for (IRInstruction *instr = bb->head; instr; instr = instr->next) {
+      if (instr->opcode == IR_OP_RET && instr->operand_head)
+        return instr->operand_head->data.value;
+    }
+  }
+  return NULL;
+}
+
+IRInstruction *ir_test_def(IRValue *v, Opcode opcode) {
+  if (!v || v->is_constant || !v->def_instr || !v->def_instr->parent ||
+      v->def_instr->opcode != opcode)
+    return NULL;
+  return v->def_instr;
+}
+
+IRValue *ir_test_operand(IRInstruction *instr, int i) {
+  IROperand *op = instr ? instr->operand_head : NULL;
+  while (op && i-- > 0)
+    op = op->next_in_instr;
+  return op && op->kind == IR_OP_KIND_VALUE ? op->data.value : NULL;
+}
+
+bool ir_test_is_const(IRValue *v, int64_t value) {
+  if (!v || !v->is_constant || !v->type || v->type->kind != TYPE_BASIC)
+    return false;
+  switch (v->type->basic) {
+  case BASIC_I1:
+    return v->int_val == (int)(value & 1);
+  case BASIC_I64:
+    return v->i64_val == value;
+  default:
+    return v->int_val == (int)value;
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef IR_TEST_H
+#define IR_TEST_H
+
+/**
+ * @file ir_test.h
+ * @brief 中端单元测试的公共设施：用 IRBuilder 手写 IR 片段，运行单个遍或分析后
+ *        直接检查 IR 对象。
+ * @details
+ * 每个测试程序是一个独立的可执行文件（见 CMakeLists.txt 中的 `add_ir_unit_test`），
+ * 以 `IR_CHECK` 记录失败并继续，`ir_test_exit_code` 给出进程退出码。
+ * 片段中的函数不经过 IR 生成器，因此不依赖词法/语法分析。
+ */
+#include "ast.h"
+#include "ir/ir_builder.h"
+#include "ir/ir_data_structures.h"
+#include "logger.h"
+#include <stdint.h>
+
+/** @brief 一个测试程序共享的模块与失败计数。*/
+typedef struct IRTest {
+  LogConfig log_config; ///< 模块的日志配置（静默）
+  IRModule *module;     ///< 所有片段函数所在的模块
+  IRBuilder builder;    ///< 指向最近一次 `ir_test_function` 的入口块
+  int checks;           ///< 已执行的检查数
+  int failures;         ///< 失败的检查数
+} IRTest;
+
+/** @brief 记录一次检查；失败时打印位置与表达式，测试继续执行。*/
+#define IR_CHECK(t, cond)                                                      \
+  ir_test_check((t), (cond), __FILE__, __LINE__, #cond)
+
+void ir_test_init(IRTest *t);
+int ir_test_exit_code(IRTest *t);
+void ir_test_check(IRTest *t, bool ok, const char *file, int line,
+                   const char *expr);
+
+/** @brief 基础类型的简写。*/
+Type *ir_test_type(IRTest *t, BasicType basic);
+
+/** @brief 创建 basic 类型、值为 value 的整数常量（i1 取最低位）。*/
+IRValue *ir_test_const(IRTest *t, BasicType basic, int64_t value);
+
+/**
+ * @brief 新建一个函数及其入口块，并把 builder 的插入点放在入口块末尾。
+ * @param params 参数类型，参数依次命名为 a0、a1……
+ */
+IRFunction *ir_test_function(IRTest *t, const char *name, Type *ret_type,
+                             Type **params, int num_params);
+
+/** @brief 在当前函数末尾追加一个基本块（不移动插入点）。*/
+IRBasicBlock *ir_test_block(IRTest *t, const char *label);
+
+/** @brief 片段构建完成后建立 CFG 与支配树，与优化流水线开始时相同。*/
+void ir_test_prepare(IRFunction *func);
+
+/** @brief 函数中第一条 `ret` 返回的值；没有时返回 NULL。*/
+IRValue *ir_test_returned(IRFunction *func);
+
+/** @brief v 由 opcode 指令定义时返回该指令，否则返回 NULL。*/
+IRInstruction *ir_test_def(IRValue *v, Opcode opcode);
+
+/** @brief 指令的第 i 个值操作数。*/
+IRValue *ir_test_operand(IRInstruction *instr, int i);
+
+/** @brief v 是值为 value 的整数常量（按 v 的位宽比较）。*/
+bool ir_test_is_const(IRValue *v, int64_t value);
+
+#endif // IR_TEST_H
@@ -0,0 +1,148 @@
+/**
+ * @file known_bits_test.c
+ * @brief 已知位分析（analysis/known_bits.h）的单元测试。
+ * @details
+ * 每个用例在一个只有入口块的函数中用参数与常量拼出片段，对片段的结果查询
+ * 已知位。参数的每一位都未知，因此结果中已知的位全部来自被测的推导规则。
+ * 另外检查递归深度截断：超过 `KNOWN_BITS_MAX_DEPTH` 的链给出保守答案，且
+ * 截断的中间结果不写入缓存。
+ */
+#include "ir/analysis/known_bits.h"
+#include "ir_test.h"
+#include <limits.h>
+
+static IRTest T;
+
+// 新建 `basic f(basic a0, basic a1)`，插入点在入口块。
+static IRFunction *begin(const char *name, BasicType basic) {
+  Type *type = ir_test_type(&T, basic);
+  Type *params[] = {type, type};
+  return ir_test_function(&T, name, type, params, 2);
+}
+
+// 用一个新缓存查询 v 的已知位。
+static KnownBits known(IRFunction *func, IRValue *v) {
+  return compute_known_bits(create_known_bits_cache(func), v);
+}
+
+static bool known_is(KnownBits k, uint64_t zero, uint64_t one) {
+  return k.zero == zero && k.one == one;
+}
+
+static IRValue *c32(int64_t value) { return ir_test_const(&T, BASIC_INT, value); }
+
+// 与、或逐位组合：与 0 的位为 0，或 1 的位为 1。
+static void test_and_or(void) {
+  IRFunction *func = begin("and_or", BASIC_INT);
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  IRValue *y = ir_builder_create_or(&T.builder, x, c32(0x3), "y")->dest;
+  IR_CHECK(&T, known_is(known(func, x), 0xFFFFFF0Fu, 0));
+  IR_CHECK(&T, known_is(known(func, y), 0xFFFFFF0Cu, 0x3));
+  IR_CHECK(&T, known(func, y).width == 32);
+
+  // i64 的掩码覆盖全部 64 位
+  func = begin("and_i64", BASIC_I64);
+  x = ir_builder_create_and(&T.builder, func->args[0],
+                            ir_test_const(&T, BASIC_I64, 0xFF), "x")
+          ->dest;
+  IR_CHECK(&T, known_is(known(func, x), ~UINT64_C(0xFF), 0));
+  IR_CHECK(&T, known(func, x).width == 64);
+}
+
+// 常量移位整体平移已知位，移入的位按操作码补 0 或符号位。
+static void test_shifts(void) {
+  IRFunction *func = begin("shifts", BASIC_INT);
+  IRValue *low = ir_builder_create_and(&T.builder, func->args[0], c32(0xF), "low")->dest;
+  IRValue *neg = ir_builder_create_or(&T.builder, func->args[0], c32(INT_MIN), "neg")->dest;
+  IRValue *shl = ir_builder_create_shl(&T.builder, low, c32(4), "shl")->dest;
+  IRValue *lshr = ir_builder_create_lshr(&T.builder, neg, c32(28), "lshr")->dest;
+  IRValue *ashr = ir_builder_create_ashr(&T.builder, neg, c32(28), "ashr")->dest;
+  IR_CHECK(&T, known_is(known(func, shl), 0xFFFFFF0Fu, 0));
+  IR_CHECK(&T, known_is(known(func, lshr), 0xFFFFFFF0u, 0x8));
+  IR_CHECK(&T, known_is(known(func, ashr), 0, 0xFFFFFFF8u));
+
+  // 移位量未知：左移保留末尾零，逻辑右移保留前导零
+  IRValue *even = ir_builder_create_and(&T.builder, func->args[0], c32(-4), "even")->dest;
+  IRValue *shl_any = ir_builder_create_shl(&T.builder, even, func->args[1], "shl_any")->dest;
+  IRValue *lshr_any = ir_builder_create_lshr(&T.builder, low, func->args[1], "lshr_any")->dest;
+  IR_CHECK(&T, known_is(known(func, shl_any), 0x3, 0));
+  IR_CHECK(&T, known_is(known(func, lshr_any), 0xFFFFFFF0u, 0));
+
+  // 移位量不小于位宽时结果未定义，不给出任何已知位
+  IRValue *wide = ir_builder_create_shl(&T.builder, low, c32(32), "wide")->dest;
+  IR_CHECK(&T, known_is(known(func, wide), 0, 0));
+}
+
+// 加法模拟进位链，乘法保留末尾零与不回绕时的前导零。
+static void test_add_mul(void) {
+  IRFunction *func = begin("add_mul", BASIC_INT);
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  IRValue *sum = ir_builder_create_add(&T.builder, x, c32(0x3), "sum")->dest;
+  IR_CHECK(&T, known_is(known(func, sum), 0xFFFFFF0Cu, 0x3));
+
+  // (a0 | 1) + 1：最低位一定为 0，进位使更高的位未知
+  IRValue *odd = ir_builder_create_or(&T.builder, func->args[0], c32(1), "odd")->dest;
+  IRValue *inc = ir_builder_create_add(&T.builder, odd, c32(1), "inc")->dest;
+  IR_CHECK(&T, known_is(known(func, inc), 0x1, 0));
+
+  IRValue *m4 = ir_builder_create_and(&T.builder, func->args[0], c32(-4), "m4")->dest;
+  IRValue *m2 = ir_builder_create_and(&T.builder, func->args[1], c32(-2), "m2")->dest;
+  IRValue *prod = ir_builder_create_mul(&T.builder, m4, m2, "prod")->dest;
+  IR_CHECK(&T, known_is(known(func, prod), 0x7, 0));
+
+  // 两个 8 位数的积不超过 16 位
+  IRValue *b0 = ir_builder_create_and(&T.builder, func->args[0], c32(0xFF), "b0")->dest;
+  IRValue *b1 = ir_builder_create_and(&T.builder, func->args[1], c32(0xFF), "b1")->dest;
+  IRValue *small = ir_builder_create_mul(&T.builder, b0, b1, "small")->dest;
+  IR_CHECK(&T, known_is(known(func, small), 0xFFFF0000u, 0));
+}
+
+// 比较两侧的已知位足以决定结果时，icmp 的结果是 i1 常量。
+static void test_icmp(void) {
+  IRFunction *func = begin("icmp", BASIC_INT);
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  IRValue *eq = ir_builder_create_icmp(&T.builder, "eq", x, c32(1), "eq")->dest;
+  IRValue *slt = ir_builder_create_icmp(&T.builder, "slt", x, c32(256), "slt")->dest;
+  IRValue *sgt = ir_builder_create_icmp(&T.builder, "sgt", x, c32(16), "sgt")->dest;
+  KnownBits k = known(func, eq);
+  IR_CHECK(&T, k.width == 1 && known_bits_is_constant(k) && k.one == 0);
+  k = known(func, slt);
+  IR_CHECK(&T, k.width == 1 && known_bits_is_constant(k) && k.one == 1);
+  IR_CHECK(&T, !known_bits_is_constant(known(func, sgt)));
+}
+
+// `and a0 0xF` 之上叠 n 层 `or _ 0`，返回最外层。
+static IRValue *or_chain(IRValue *base, int n) {
+  IRValue *v = ir_builder_create_and(&T.builder, base, c32(0xF), "low")->dest;
+  for (int i = 0; i < n; i++)
+    v = ir_builder_create_or(&T.builder, v, c32(0), "chain")->dest;
+  return v;
+}
+
+// 深度 6 处的定义不再展开；截断只影响那次查询，不写入缓存。
+static void test_depth_cutoff(void) {
+  IRFunction *func = begin("depth", BASIC_INT);
+  IRValue *shallow = or_chain(func->args[0], 5);
+  IRValue *deep = or_chain(func->args[0], 6);
+  IR_CHECK(&T, known_is(known(func, shallow), 0xFFFFFFF0u, 0));
+  IR_CHECK(&T, known_is(known(func, deep), 0, 0));
+
+  KnownBitsCache *cache = create_known_bits_cache(func);
+  IRValue *inner = ir_test_operand(deep->def_instr, 0);
+  IR_CHECK(&T, known_is(compute_known_bits(cache, deep), 0, 0));
+  IR_CHECK(&T, known_is(compute_known_bits(cache, inner), 0xFFFFFFF0u, 0));
+  // inner 已作为最外层查询写入缓存，deep 经由它不再被截断
+  invalidate_known_bits(cache);
+  IR_CHECK(&T, known_is(compute_known_bits(cache, inner), 0xFFFFFFF0u, 0));
+  IR_CHECK(&T, known_is(compute_known_bits(cache, deep), 0xFFFFFFF0u, 0));
+}
+
+int main(void) {
+  ir_test_init(&T);
+  test_and_or();
+  test_shifts();
+  test_add_mul();
+  test_icmp();
+  test_depth_cutoff();
+  return ir_test_exit_code(&T);
+}
@@ -0,0 +1,119 @@
+/**
+ * @file sccp_test.c
+ * @brief SCCP（transforms/sccp.h）的单元测试。
+ * @details
+ * 检查：格值求得 Bottom 的整数结果在所有位都已知时被细化为常量；两个不同
+ * 常量的运算直接折叠；条件已确定的 `br` 被改写为无条件跳转，死后继不再经由
+ * PHI 影响结果。
+ */
+#include "ir/transforms/sccp.h"
+#include "ir/ir_utils.h"
+#include "ir_test.h"
+
+static IRTest T;
+
+static IRValue *c32(int64_t value) { return ir_test_const(&T, BASIC_INT, value); }
+
+static IRValue *cfloat(float value) {
+  IRValue *v = create_ir_value(T.module->pool);
+  v->is_constant = true;
+  v->type = create_basic_type(BASIC_FLOAT, true, T.module->pool);
+  v->float_val = value;
+  return v;
+}
+
+// 新建 `i32 f(i32 a0)`，插入点在入口块。
+static IRFunction *begin(const char *name) {
+  Type *type = ir_test_type(&T, BASIC_INT);
+  return ir_test_function(&T, name, type, &type, 1);
+}
+
+// 以 value 结束当前块，运行 SCCP，返回 ret 的操作数。
+static IRValue *propagate(IRFunction *func, IRValue *value) {
+  ir_builder_create_ret(&T.builder, value);
+  ir_test_prepare(func);
+  run_sccp(func);
+  return ir_test_returned(func);
+}
+
+// 入口块的终结指令是无条件跳转到 target。
+static bool jumps_to(IRFunction *func, IRBasicBlock *target) {
+  IRInstruction *term = func->entry->tail;
+  return term && term->opcode == IR_OP_BR && term->num_operands == 1 &&
+         term->operand_head->kind == IR_OP_KIND_BASIC_BLOCK &&
+         term->operand_head->data.bb == target;
+}
+
+// 参数使格值为 Bottom，已知位仍能确定结果。
+static void test_known_bits_refinement(void) {
+  IRFunction *func = begin("refine_and");
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  IRValue *y = ir_builder_create_and(&T.builder, x, c32(0x0F), "y")->dest;
+  IR_CHECK(&T, ir_test_is_const(propagate(func, y), 0));
+
+  func = begin("refine_or");
+  x = ir_builder_create_or(&T.builder, func->args[0], c32(-16), "x")->dest;
+  y = ir_builder_create_ashr(&T.builder, x, c32(31), "y")->dest;
+  IR_CHECK(&T, ir_test_is_const(propagate(func, y), -1));
+
+  // 只有部分位已知时保持原值
+  func = begin("partial");
+  x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  IR_CHECK(&T, propagate(func, x) == x);
+}
+
+// entry: br cond, then, else；then/else 各自跳到 merge，merge 中
+// `phi [1, then], [2, else]` 作为返回值。返回 merge 的 ret 操作数。
+static IRValue *diamond(IRFunction *func, IRValue *cond, IRBasicBlock **then_bb,
+                        IRBasicBlock **else_bb) {
+  *then_bb = ir_test_block(&T, "then");
+  *else_bb = ir_test_block(&T, "else");
+  IRBasicBlock *merge = ir_test_block(&T, "merge");
+  ir_builder_create_cond_br(&T.builder, cond, *then_bb, *else_bb);
+  ir_builder_set_insertion_block(&T.builder, *then_bb);
+  ir_builder_create_br(&T.builder, merge);
+  ir_builder_set_insertion_block(&T.builder, *else_bb);
+  ir_builder_create_br(&T.builder, merge);
+  ir_builder_set_insertion_block(&T.builder, merge);
+  IRInstruction *phi =
+      ir_builder_create_phi(&T.builder, ir_test_type(&T, BASIC_INT), "p");
+  ir_phi_add_incoming(phi, c32(1), *then_bb);
+  ir_phi_add_incoming(phi, c32(2), *else_bb);
+  return propagate(func, phi->dest);
+}
+
+// 条件由常量求得，或由已知位确定，分支都被折叠。
+static void test_branch_folding(void) {
+  IRBasicBlock *then_bb, *else_bb;
+  IRFunction *func = begin("fold_const");
+  IRValue *cond = ir_builder_create_icmp(&T.builder, "slt", c32(3), c32(5), "c")->dest;
+  IR_CHECK(&T, ir_test_is_const(diamond(func, cond, &then_bb, &else_bb), 1));
+  IR_CHECK(&T, jumps_to(func, then_bb));
+
+  // 两个不同的常量操作数直接折叠，不依赖已知位（浮点没有已知位）
+  func = begin("fold_fcmp");
+  cond = ir_builder_create_fcmp(&T.builder, "olt", cfloat(2.5f), cfloat(1.5f), "c")->dest;
+  IR_CHECK(&T, ir_test_is_const(diamond(func, cond, &then_bb, &else_bb), 2));
+  IR_CHECK(&T, jumps_to(func, else_bb));
+
+  // a0 & 0xF0 不可能等于 1：走 else
+  func = begin("fold_known_bits");
+  IRValue *x = ir_builder_create_and(&T.builder, func->args[0], c32(0xF0), "x")->dest;
+  cond = ir_builder_create_icmp(&T.builder, "eq", x, c32(1), "c")->dest;
+  IR_CHECK(&T, ir_test_is_const(diamond(func, cond, &then_bb, &else_bb), 2));
+  IR_CHECK(&T, jumps_to(func, else_bb));
+
+  // 条件未知时两个后继都可达，PHI 保持
+  func = begin("no_fold");
+  cond = ir_builder_create_icmp(&T.builder, "slt", func->args[0], c32(5), "c")->dest;
+  IRValue *r = diamond(func, cond, &then_bb, &else_bb);
+  IR_CHECK(&T, ir_test_def(r, IR_OP_PHI) != NULL);
+  IR_CHECK(&T, func->entry->tail && func->entry->tail->num_operands == 3);
+}
+
+int main(void) {
+  ir_test_init(&T);
+  test_known_bits_refinement();
+  test_branch_folding();
+  return ir_test_exit_code(&T);
+}
@@ -0,0 +1,1022 @@
+/**
+ * @file inst_combine_gen.c
+ * @brief 把 inst_combine.pat 中的声明式改写模式编译成匹配表（构建时运行）。
+ * @details
+ * 用法: inst_combine_gen <patterns.pat> <output.inc>
+ *
+ * 处理分四步：
+ * 1.  **解析**: 每行一条模式 `LHS -> RHS [if (谓词 变量...)...]`，语法见
+ *     inst_combine.pat 的文件头。
+ * 2.  **展开交换律**: add/mul/and/or/xor 的两个操作数各生成两种顺序，
+ *     每种组合是一个独立的变体，有自己的记录编号和改写函数。
+ * 3.  **线性化与合并**: 每个变体的 LHS 按先序展开成一串匹配操作，插入一棵
+ *     前缀树，相同的前缀只保留一份。插入时可以越过与新操作互斥的兄弟分支
+ *     （例如检查另一个操作码），并入更早的同前缀分支；与新操作不互斥的
+ *     分支则不能越过，所以模式之间的优先级与文件中的顺序一致。
+ * 4.  **输出**: 前缀树的分叉点输出为 SCOPE（依次回溯尝试）；连续的、以
+ *     操作码检查开头的分支合并成一个 SWITCH_OPCODE，一次比较即可跳到
+ *     唯一可能匹配的分支。匹配表的格式见 inst_combine_matcher.h。
+ */
+#include "ir/transforms/inst_combine_matcher.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define MAX_ARGS 4
+#define MAX_VARS 32
+#define MAX_CONDS 8
+
+// --- 操作码 ---
+
+typedef struct {
+  const char *name;    // DSL 中的名字
+  const char *ir_name; // IR 中的操作码枚举
+  int arity;
+  bool commutative;
+  const char *fold; // RHS 中两个常量操作数的折叠表达式；NULL 表示不可折叠
+} OpInfo;
+
+// 常量以 int64_t（按位宽符号扩展）参与折叠，运算按 64 位补码回绕，移位量取低
+// 6 位，折叠表达式本身不会触发未定义行为。低位的结果与按根指令位宽计算相同，
+// 由 pattern_const 截断。逻辑右移的结果取决于位宽以上的高位，不能这样折叠。
+static const OpInfo op_infos[] = {
+    {"add", "IR_OP_ADD", 2, true, "(int64_t)((uint64_t)(%s) + (uint64_t)(%s))"},
+    {"sub", "IR_OP_SUB", 2, false, "(int64_t)((uint64_t)(%s) - (uint64_t)(%s))"},
+    {"mul", "IR_OP_MUL", 2, true, "(int64_t)((uint64_t)(%s) * (uint64_t)(%s))"},
+    {"sdiv", "IR_OP_SDIV", 2, false, NULL},
+    {"srem", "IR_OP_SREM", 2, false, NULL},
+    {"shl", "IR_OP_SHL", 2, false, "(int64_t)((uint64_t)(%s) << ((%s) & 63))"},
+    {"lshr", "IR_OP_LSHR", 2, false, NULL},
+    {"ashr", "IR_OP_ASHR", 2, false, "((%s) >> ((%s) & 63))"},
+    {"and", "IR_OP_AND", 2, true, "((%s) & (%s))"},
+    {"or", "IR_OP_OR", 2, true, "((%s) | (%s))"},
+    {"xor", "IR_OP_XOR", 2, true, "((%s) ^ (%s))"},
+};
+#define NUM_OP_INFOS ((int)(sizeof(op_infos) / sizeof(op_infos[0])))
+
+static const OpInfo *find_op(const char *name) {
+  for (int i = 0; i < NUM_OP_INFOS; i++) {
+    if (strcmp(op_infos[i].name, name) == 0)
+      return &op_infos[i];
+  }
+  return NULL;
+}
+
+// --- 错误处理与小工具 ---
+
+static const char *input_path;
+
+static void fail(int line, const char *fmt, ...) {
+  va_list ap;
+  fprintf(stderr, "%s:%d: error: ", input_path, line);
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fputc('\n', stderr);
+  exit(1);
+}
+
+static void *xmalloc(size_t size) {
+  void *p = calloc(1, size);
+  if (!p) {
+    fprintf(stderr, "inst_combine_gen: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static void *xrealloc(void *p, size_t size) {
+  p = realloc(p, size);
+  if (!p) {
+    fprintf(stderr, "inst_combine_gen: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static char *xstrdup(const char *s) {
+  char *d = xmalloc(strlen(s) + 1);
+  strcpy(d, s);
+  return d;
+}
+
+// 追加式字符串缓冲。
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+} StrBuf;
+
+static void sb_printf(StrBuf *sb, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  if (sb->len + (size_t)n + 1 > sb->cap) {
+    sb->cap = (sb->len + (size_t)n + 1) * 2;
+    sb->data = xrealloc(sb->data, sb->cap);
+  }
+  va_start(ap, fmt);
+  vsnprintf(sb->data + sb->len, (size_t)n + 1, fmt, ap);
+  va_end(ap);
+  sb->len += (size_t)n;
+}
+
+static char *sb_take(StrBuf *sb) {
+  char *s = sb->data ? sb->data : xstrdup("");
+  sb->data = NULL;
+  sb->len = sb->cap = 0;
+  return s;
+}
+
+// --- 模式表达式 ---
+
+typedef enum {
+  EXPR_INSTR,     // (op a b)，LHS 中匹配一条指令，RHS 中构造一条指令
+  EXPR_VALUE_VAR, // 小写变量：任意值
+  EXPR_CONST_VAR, // 大写变量：与根指令同类型的任意整数常量
+  EXPR_INT,       // 整数字面量
+  EXPR_CALL,      // RHS 中的常量函数 (log2 C)，或 if 后的谓词
+} ExprKind;
+
+typedef struct Expr {
+  ExprKind kind;
+  const OpInfo *op; // EXPR_INSTR
+  char *name;       // 变量名、函数名或谓词名
+  char *binding;    // LHS 中 `name:(...)` 给子指令起的名字
+  int value;        // EXPR_INT
+  struct Expr *args[MAX_ARGS];
+  int num_args;
+  int line;
+} Expr;
+
+typedef struct {
+  Expr *lhs;
+  Expr *rhs;
+  Expr *conds[MAX_CONDS];
+  int num_conds;
+  char *text; // 去掉注释后的源文本，用于生成文件中的注释
+  int line;
+} Pattern;
+
+static Expr *new_expr(ExprKind kind, int line) {
+  Expr *e = xmalloc(sizeof(Expr));
+  e->kind = kind;
+  e->line = line;
+  return e;
+}
+
+static bool same_expr(const Expr *a, const Expr *b) {
+  if (a->kind != b->kind || a->op != b->op || a->value != b->value ||
+      a->num_args != b->num_args)
+    return false;
+  if ((a->name || b->name) &&
+      (!a->name || !b->name || strcmp(a->name, b->name) != 0))
+    return false;
+  if ((a->binding || b->binding) &&
+      (!a->binding || !b->binding || strcmp(a->binding, b->binding) != 0))
+    return false;
+  for (int i = 0; i < a->num_args; i++) {
+    if (!same_expr(a->args[i], b->args[i]))
+      return false;
+  }
+  return true;
+}
+
+// 由常量变量、字面量、可折叠运算和常量函数组成的表达式在改写时直接求值。
+static bool is_const_expr(const Expr *e) {
+  switch (e->kind) {
+  case EXPR_INT:
+  case EXPR_CONST_VAR:
+    return true;
+  case EXPR_VALUE_VAR:
+    return false;
+  case EXPR_INSTR:
+  case EXPR_CALL:
+    for (int i = 0; i < e->num_args; i++) {
+      if (!is_const_expr(e->args[i]))
+        return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+// --- 词法与语法分析 ---
+
+typedef enum {
+  TOK_END,
+  TOK_LPAREN,
+  TOK_RPAREN,
+  TOK_ARROW,
+  TOK_COLON,
+  TOK_IDENT,
+  TOK_INT,
+} TokKind;
+
+typedef struct {
+  const char *p;
+  int line;
+  TokKind kind;
+  char text[64];
+  long value;
+} Lexer;
+
+static void next_token(Lexer *lx) {
+  while (*lx->p && isspace((unsigned char)*lx->p))
+    lx->p++;
+  const char *p = lx->p;
+  if (!*p) {
+    lx->kind = TOK_END;
+    return;
+  }
+  if (*p == '(' || *p == ')' || *p == ':') {
+    lx->kind = *p == '(' ? TOK_LPAREN : *p == ')' ? TOK_RPAREN : TOK_COLON;
+    lx->p++;
+    return;
+  }
+  if (p[0] == '-' && p[1] == '>') {
+    lx->kind = TOK_ARROW;
+    lx->p += 2;
+    return;
+  }
+  if (isdigit((unsigned char)*p) ||
+      (*p == '-' && isdigit((unsigned char)p[1]))) {
+    char *end;
+    errno = 0;
+    lx->value = strtol(p, &end, 0);
+    if (errno || lx->value < INT_MIN || lx->value > UINT_MAX)
+      fail(lx->line, "integer literal out of i32 range");
+    // 0x80000000 之类的写法按 32 位补码解释
+    if (lx->value > INT_MAX)
+      lx->value = (long)(int)(unsigned)lx->value;
+    lx->kind = TOK_INT;
+    lx->p = end;
+    return;
+  }
+  if (isalpha((unsigned char)*p) || *p == '_') {
+    size_t n = 0;
+    while (isalnum((unsigned char)p[n]) || p[n] == '_')
+      n++;
+    if (n >= sizeof(lx->text))
+      fail(lx->line, "identifier too long");
+    memcpy(lx->text, p, n);
+    lx->text[n] = '\0';
+    lx->kind = TOK_IDENT;
+    lx->p += n;
+    return;
+  }
+  fail(lx->line, "unexpected character '%c'", *p);
+}
+
+static Expr *parse_expr(Lexer *lx, bool lhs) {
+  if (lx->kind == TOK_INT) {
+    Expr *e = new_expr(EXPR_INT, lx->line);
+    e->value = (int)lx->value;
+    next_token(lx);
+    return e;
+  }
+  if (lx->kind == TOK_IDENT) {
+    char *name = xstrdup(lx->text);
+    next_token(lx);
+    if (lx->kind == TOK_COLON) {
+      if (!lhs)
+        fail(lx->line, "'%s:' bindings are only allowed on the left side",
+             name);
+      next_token(lx);
+      if (lx->kind != TOK_LPAREN)
+        fail(lx->line, "'%s:' must name an instruction pattern", name);
+      Expr *e = parse_expr(lx, lhs);
+      e->binding = name;
+      return e;
+    }
+    Expr *e = new_expr(isupper((unsigned char)name[0]) ? EXPR_CONST_VAR
+                                                       : EXPR_VALUE_VAR,
+                       lx->line);
+    e->name = name;
+    return e;
+  }
+  if (lx->kind != TOK_LPAREN)
+    fail(lx->line, "expected an expression");
+  next_token(lx);
+  if (lx->kind != TOK_IDENT)
+    fail(lx->line, "expected an opcode or function name after '('");
+  const OpInfo *op = find_op(lx->text);
+  if (!op && lhs)
+    fail(lx->line, "unknown opcode '%s'", lx->text);
+  Expr *e = new_expr(op ? EXPR_INSTR : EXPR_CALL, lx->line);
+  e->op = op;
+  e->name = xstrdup(lx->text);
+  next_token(lx);
+  while (lx->kind != TOK_RPAREN) {
+    if (lx->kind == TOK_END)
+      fail(lx->line, "missing ')'");
+    if (e->num_args == MAX_ARGS)
+      fail(lx->line, "too many operands");
+    e->args[e->num_args++] = parse_expr(lx, lhs);
+  }
+  next_token(lx);
+  if (op && e->num_args != op->arity)
+    fail(e->line, "'%s' takes %d operands", op->name, op->arity);
+  return e;
+}
+
+static Expr *parse_cond(Lexer *lx) {
+  if (lx->kind != TOK_LPAREN)
+    fail(lx->line, "expected '(' to start a condition");
+  next_token(lx);
+  if (lx->kind != TOK_IDENT)
+    fail(lx->line, "expected a predicate name");
+  Expr *e = new_expr(EXPR_CALL, lx->line);
+  e->name = xstrdup(lx->text);
+  next_token(lx);
+  while (lx->kind == TOK_IDENT) {
+    if (e->num_args == MAX_ARGS)
+      fail(lx->line, "too many predicate arguments");
+    e->args[e->num_args++] = parse_expr(lx, false);
+  }
+  if (lx->kind != TOK_RPAREN)
+    fail(lx->line, "predicate arguments must be pattern variables");
+  next_token(lx);
+  return e;
+}
+
+// --- 语义检查 ---
+
+typedef struct {
+  const char *names[MAX_VARS];
+  bool is_binding[MAX_VARS];
+  int count;
+} VarSet;
+
+static int varset_find(const VarSet *vs, const char *name) {
+  for (int i = 0; i < vs->count; i++) {
+    if (strcmp(vs->names[i], name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static void varset_add(VarSet *vs, const char *name, bool is_binding,
+                       int line) {
+  if (vs->count == MAX_VARS)
+    fail(line, "too many pattern variables");
+  vs->names[vs->count] = name;
+  vs->is_binding[vs->count] = is_binding;
+  vs->count++;
+}
+
+static void collect_lhs_vars(const Expr *e, VarSet *vs) {
+  if (e->binding) {
+    if (varset_find(vs, e->binding) >= 0)
+      fail(e->line, "'%s' is bound more than once", e->binding);
+    varset_add(vs, e->binding, true, e->line);
+  }
+  if (e->kind == EXPR_VALUE_VAR || e->kind == EXPR_CONST_VAR) {
+    // 重复出现的变量要求与第一次匹配到同一个值；子指令的名字不能重复
+    int i = varset_find(vs, e->name);
+    if (i < 0)
+      varset_add(vs, e->name, false, e->line);
+    else if (vs->is_binding[i])
+      fail(e->line, "'%s' names a sub-instruction and cannot be repeated",
+           e->name);
+  }
+  for (int i = 0; i < e->num_args; i++)
+    collect_lhs_vars(e->args[i], vs);
+}
+
+static void check_rhs(const Expr *e, const VarSet *vs) {
+  switch (e->kind) {
+  case EXPR_VALUE_VAR:
+  case EXPR_CONST_VAR:
+    if (varset_find(vs, e->name) < 0)
+      fail(e->line, "'%s' is not bound on the left side", e->name);
+    return;
+  case EXPR_INT:
+    return;
+  case EXPR_CALL:
+    if (!is_const_expr(e))
+      fail(e->line, "arguments of '%s' must be constants", e->name);
+    break;
+  case EXPR_INSTR:
+    if (is_const_expr(e) && !e->op->fold)
+      fail(e->line, "'%s' of constants cannot be folded here", e->op->name);
+    break;
+  }
+  for (int i = 0; i < e->num_args; i++)
+    check_rhs(e->args[i], vs);
+}
+
+static void check_pattern(const Pattern *pat) {
+  if (pat->lhs->kind != EXPR_INSTR)
+    fail(pat->line, "the left side must be an instruction pattern");
+  VarSet vs = {0};
+  collect_lhs_vars(pat->lhs, &vs);
+  check_rhs(pat->rhs, &vs);
+  for (int i = 0; i < pat->num_conds; i++) {
+    for (int j = 0; j < pat->conds[i]->num_args; j++) {
+      const Expr *arg = pat->conds[i]->args[j];
+      if (varset_find(&vs, arg->name) < 0)
+        fail(arg->line, "'%s' is not bound on the left side", arg->name);
+    }
+  }
+}
+
+// --- 交换律展开 ---
+
+typedef struct {
+  Expr **items;
+  int count;
+  int cap;
+} ExprList;
+
+static void list_push(ExprList *list, Expr *e) {
+  if (list->count == list->cap) {
+    list->cap = list->cap ? list->cap * 2 : 4;
+    list->items = xrealloc(list->items, list->cap * sizeof(Expr *));
+  }
+  list->items[list->count++] = e;
+}
+
+static void list_push_unique(ExprList *list, Expr *e) {
+  for (int i = 0; i < list->count; i++) {
+    if (same_expr(list->items[i], e))
+      return;
+  }
+  list_push(list, e);
+}
+
+static ExprList expand_commutative(Expr *e) {
+  ExprList out = {0};
+  if (e->kind != EXPR_INSTR) {
+    list_push(&out, e);
+    return out;
+  }
+  // 本设计中所有操作码都是二元的
+  ExprList lhs = expand_commutative(e->args[0]);
+  ExprList rhs = expand_commutative(e->args[1]);
+  for (int i = 0; i < lhs.count; i++) {
+    for (int j = 0; j < rhs.count; j++) {
+      Expr *v = xmalloc(sizeof(Expr));
+      *v = *e;
+      v->args[0] = lhs.items[i];
+      v->args[1] = rhs.items[j];
+      list_push_unique(&out, v);
+      if (e->op->commutative) {
+        Expr *s = xmalloc(sizeof(Expr));
+        *s = *v;
+        s->args[0] = v->args[1];
+        s->args[1] = v->args[0];
+        list_push_unique(&out, s);
+      }
+    }
+  }
+  free(lhs.items);
+  free(rhs.items);
+  return out;
+}
+
+// --- 线性化 ---
+
+typedef struct {
+  int kind; // MatcherOpcode
+  int a;
+  int b;
+} MOp;
+
+typedef struct {
+  char *name;
+  int record;
+} Slot;
+
+// 一个变体的编译结果：匹配操作序列与变量到记录编号的映射。
+typedef struct {
+  MOp *ops;
+  int num_ops;
+  int cap_ops;
+  Slot slots[MAX_VARS];
+  int num_slots;
+  int num_records;
+  int depth;
+  int max_depth;
+} Variant;
+
+static void push_op(Variant *v, int kind, int a, int b) {
+  if (v->num_ops == v->cap_ops) {
+    v->cap_ops = v->cap_ops ? v->cap_ops * 2 : 16;
+    v->ops = xrealloc(v->ops, v->cap_ops * sizeof(MOp));
+  }
+  v->ops[v->num_ops++] = (MOp){kind, a, b};
+}
+
+static int find_slot(const Variant *v, const char *name) {
+  for (int i = 0; i < v->num_slots; i++) {
+    if (strcmp(v->slots[i].name, name) == 0)
+      return v->slots[i].record;
+  }
+  return -1;
+}
+
+static void record_slot(Variant *v, char *name) {
+  v->slots[v->num_slots].name = name;
+  v->slots[v->num_slots].record = v->num_records++;
+  v->num_slots++;
+  push_op(v, MATCHER_RECORD, 0, 0);
+}
+
+static void linearize(Variant *v, const Expr *e) {
+  if (e->binding)
+    record_slot(v, e->binding);
+  switch (e->kind) {
+  case EXPR_INSTR:
+    push_op(v, MATCHER_CHECK_OPCODE, (int)(e->op - op_infos), e->num_args);
+    for (int i = 0; i < e->num_args; i++) {
+      push_op(v, MATCHER_MOVE_CHILD, i, 0);
+      if (++v->depth > v->max_depth)
+        v->max_depth = v->depth;
+      linearize(v, e->args[i]);
+      push_op(v, MATCHER_MOVE_PARENT, 0, 0);
+      v->depth--;
+    }
+    break;
+  case EXPR_VALUE_VAR:
+  case EXPR_CONST_VAR: {
+    int rec = find_slot(v, e->name);
+    if (rec >= 0) {
+      push_op(v, MATCHER_CHECK_SAME, rec, 0);
+    } else {
+      if (e->kind == EXPR_CONST_VAR)
+        push_op(v, MATCHER_CHECK_CONST, 0, 0);
+      record_slot(v, e->name);
+    }
+    break;
+  }
+  case EXPR_INT:
+    push_op(v, MATCHER_CHECK_INT, e->value, 0);
+    break;
+  case EXPR_CALL:
+    break;
+  }
+}
+
+// --- 改写函数生成 ---
+
+typedef struct {
+  const Variant *variant;
+  StrBuf body;
+  int num_temps;
+  bool uses_rec;
+  bool uses_ctx;
+} RewriteGen;
+
+static char *gen_const(RewriteGen *g, const Expr *e) {
+  StrBuf sb = {0};
+  switch (e->kind) {
+  case EXPR_INT:
+    sb_printf(&sb, e->value < 0 ? "INT64_C(%d)" : "%d", e->value);
+    break;
+  case EXPR_CONST_VAR:
+    sb_printf(&sb, "pattern_const_value(rec[%d])",
+              find_slot(g->variant, e->name));
+    g->uses_rec = true;
+    break;
+  case EXPR_INSTR: {
+    char *a = gen_const(g, e->args[0]);
+    char *b = gen_const(g, e->args[1]);
+    sb_printf(&sb, e->op->fold, a, b);
+    free(a);
+    free(b);
+    break;
+  }
+  case EXPR_CALL:
+    sb_printf(&sb, "pattern_fn_%s(", e->name);
+    for (int i = 0; i < e->num_args; i++) {
+      char *a = gen_const(g, e->args[i]);
+      sb_printf(&sb, "%s%s", i ? ", " : "", a);
+      free(a);
+    }
+    sb_printf(&sb, ")");
+    break;
+  case EXPR_VALUE_VAR:
+    break;
+  }
+  return sb_take(&sb);
+}
+
+static char *gen_value(RewriteGen *g, const Expr *e) {
+  StrBuf sb = {0};
+  if (e->kind == EXPR_VALUE_VAR || e->kind == EXPR_CONST_VAR) {
+    sb_printf(&sb, "rec[%d]", find_slot(g->variant, e->name));
+    g->uses_rec = true;
+  } else if (is_const_expr(e)) {
+    char *c = gen_const(g, e);
+    sb_printf(&sb, "pattern_const(ctx, %s)", c);
+    g->uses_ctx = true;
+    free(c);
+  } else {
+    char *a = gen_value(g, e->args[0]);
+    char *b = gen_value(g, e->args[1]);
+    int t = g->num_temps++;
+    g->uses_ctx = true;
+    sb_printf(&g->body,
+              "  IRValue *t%d = pattern_build_binary(ctx, %s, %s, %s);\n", t,
+              e->op->ir_name, a, b);
+    sb_printf(&sb, "t%d", t);
+    free(a);
+    free(b);
+  }
+  return sb_take(&sb);
+}
+
+static void gen_rewrite(FILE *out, const Pattern *pat, const Variant *v,
+                        int id) {
+  RewriteGen g = {.variant = v};
+  StrBuf conds = {0};
+  for (int i = 0; i < pat->num_conds; i++) {
+    const Expr *c = pat->conds[i];
+    sb_printf(&conds, "  if (!pattern_pred_%s(ctx", c->name);
+    for (int j = 0; j < c->num_args; j++)
+      sb_printf(&conds, ", rec[%d]", find_slot(v, c->args[j]->name));
+    sb_printf(&conds, "))\n    return false;\n");
+    g.uses_rec = true;
+    g.uses_ctx = true;
+  }
+
+  const Expr *rhs = pat->rhs;
+  if (rhs->kind == EXPR_INSTR && !is_const_expr(rhs)) {
+    // 根指令原地改写：操作码与操作数替换，随后由工作列表重新访问
+    char *a = gen_value(&g, rhs->args[0]);
+    char *b = gen_value(&g, rhs->args[1]);
+    sb_printf(&g.body, "  pattern_rewrite_root(ctx, %s, %s, %s);\n",
+              rhs->op->ir_name, a, b);
+    g.uses_ctx = true;
+    sb_printf(&g.body, "  *result = NULL;\n  return true;\n");
+    free(a);
+    free(b);
+  } else {
+    char *r = gen_value(&g, rhs);
+    sb_printf(&g.body, "  *result = %s;\n  return true;\n", r);
+    free(r);
+  }
+
+  fprintf(out, "// %s:%d: %s\n", input_path, pat->line, pat->text);
+  fprintf(out,
+          "static bool inst_combine_rewrite_%d(InstCombineContext *ctx, "
+          "IRValue **rec,\n"
+          "                                    IRValue **result) {\n",
+          id);
+  if (!g.uses_ctx)
+    fprintf(out, "  (void)ctx;\n");
+  if (!g.uses_rec)
+    fprintf(out, "  (void)rec;\n");
+  fputs(conds.data ? conds.data : "", out);
+  fputs(g.body.data, out);
+  fprintf(out, "}\n\n");
+  free(conds.data);
+  free(g.body.data);
+}
+
+// --- 前缀树 ---
+
+typedef struct TrieNode {
+  MOp op;
+  const char *comment; // COMPLETE 节点：对应的模式文本
+  struct TrieNode **children;
+  int num_children;
+  int cap_children;
+} TrieNode;
+
+static bool same_op(MOp x, MOp y) {
+  // COMPLETE 的编号各不相同，因此两条模式永远不会共用同一个叶子
+  return x.kind == y.kind && x.a == y.a && x.b == y.b;
+}
+
+// 在同一个当前节点上，两个检查不可能同时成立。
+static bool exclusive_ops(MOp x, MOp y) {
+  bool x_opc = x.kind == MATCHER_CHECK_OPCODE;
+  bool y_opc = y.kind == MATCHER_CHECK_OPCODE;
+  bool x_const = x.kind == MATCHER_CHECK_INT || x.kind == MATCHER_CHECK_CONST;
+  bool y_const = y.kind == MATCHER_CHECK_INT || y.kind == MATCHER_CHECK_CONST;
+  if (x_opc && y_opc)
+    return !same_op(x, y);
+  if ((x_opc && y_const) || (x_const && y_opc))
+    return true;
+  return x.kind == MATCHER_CHECK_INT && y.kind == MATCHER_CHECK_INT &&
+         x.a != y.a;
+}
+
+static TrieNode *trie_child(TrieNode *node, MOp op) {
+  for (int i = node->num_children - 1; i >= 0; i--) {
+    MOp other = node->children[i]->op;
+    if (same_op(other, op))
+      return node->children[i];
+    if (!exclusive_ops(other, op))
+      break;
+  }
+  if (node->num_children == node->cap_children) {
+    node->cap_children = node->cap_children ? node->cap_children * 2 : 4;
+    node->children = xrealloc(node->children,
+                              node->cap_children * sizeof(TrieNode *));
+  }
+  TrieNode *child = xmalloc(sizeof(TrieNode));
+  child->op = op;
+  node->children[node->num_children++] = child;
+  return child;
+}
+
+static void trie_insert(TrieNode *root, const Variant *v, const char *text) {
+  TrieNode *node = root;
+  for (int i = 0; i < v->num_ops; i++)
+    node = trie_child(node, v->ops[i]);
+  node->comment = text;
+}
+
+// --- 匹配表输出 ---
+
+typedef struct {
+  int indent;
+  int count; // 本行包含的表项个数
+  char *text;
+  const char *comment;
+} TableLine;
+
+typedef struct {
+  TableLine *lines;
+  int num_lines;
+  int cap_lines;
+  int count; // 表项总数
+} Table;
+
+static void table_line(Table *t, int indent, int count, const char *comment,
+                       const char *fmt, ...) {
+  if (t->num_lines == t->cap_lines) {
+    t->cap_lines = t->cap_lines ? t->cap_lines * 2 : 16;
+    t->lines = xrealloc(t->lines, t->cap_lines * sizeof(TableLine));
+  }
+  StrBuf sb = {0};
+  va_list ap;
+  va_start(ap, fmt);
+  char buf[256];
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  sb_printf(&sb, "%s", buf);
+  t->lines[t->num_lines++] =
+      (TableLine){indent, count, sb_take(&sb), comment};
+  t->count += count;
+}
+
+static void table_append(Table *t, Table *sub) {
+  for (int i = 0; i < sub->num_lines; i++) {
+    TableLine *l = &sub->lines[i];
+    table_line(t, l->indent, l->count, l->comment, "%s", l->text);
+    free(l->text);
+  }
+  free(sub->lines);
+  *sub = (Table){0};
+}
+
+static int max_scopes;
+
+static void emit_children(const TrieNode *node, Table *t, int indent,
+                          int scopes);
+
+static void emit_op(const TrieNode *node, Table *t, int indent) {
+  MOp op = node->op;
+  switch (op.kind) {
+  case MATCHER_CHECK_OPCODE:
+    table_line(t, indent, 3, NULL, "MATCHER_CHECK_OPCODE, %s, %d,",
+               op_infos[op.a].ir_name, op.b);
+    break;
+  case MATCHER_MOVE_CHILD:
+    table_line(t, indent, 2, NULL, "MATCHER_MOVE_CHILD, %d,", op.a);
+    break;
+  case MATCHER_MOVE_PARENT:
+    table_line(t, indent, 1, NULL, "MATCHER_MOVE_PARENT,");
+    break;
+  case MATCHER_RECORD:
+    table_line(t, indent, 1, NULL, "MATCHER_RECORD,");
+    break;
+  case MATCHER_CHECK_SAME:
+    table_line(t, indent, 2, NULL, "MATCHER_CHECK_SAME, %d,", op.a);
+    break;
+  case MATCHER_CHECK_CONST:
+    table_line(t, indent, 1, NULL, "MATCHER_CHECK_CONST,");
+    break;
+  case MATCHER_CHECK_INT:
+    table_line(t, indent, 2, NULL, "MATCHER_CHECK_INT, %d,", op.a);
+    break;
+  case MATCHER_COMPLETE:
+    table_line(t, indent, 2, node->comment, "MATCHER_COMPLETE, %d,", op.a);
+    break;
+  }
+}
+
+// children[begin, end) 是一组连续的、以操作码检查开头的分支。
+static void emit_switch(const TrieNode *node, int begin, int end, Table *t,
+                        int indent, int scopes) {
+  table_line(t, indent, 1, NULL, "MATCHER_SWITCH_OPCODE,");
+  for (int i = begin; i < end; i++) {
+    const TrieNode *child = node->children[i];
+    Table sub = {0};
+    emit_children(child, &sub, indent + 2, scopes);
+    table_line(t, indent + 1, 3, NULL, "%d, %s, %d,", sub.count,
+               op_infos[child->op.a].ir_name, child->op.b);
+    table_append(t, &sub);
+  }
+  table_line(t, indent, 1, NULL, "0,");
+}
+
+static void emit_segment(const TrieNode *node, int begin, int end, Table *t,
+                         int indent, int scopes) {
+  if (end - begin > 1) {
+    emit_switch(node, begin, end, t, indent, scopes);
+  } else {
+    emit_op(node->children[begin], t, indent);
+    emit_children(node->children[begin], t, indent, scopes);
+  }
+}
+
+static int segment_end(const TrieNode *node, int begin) {
+  int end = begin + 1;
+  if (node->children[begin]->op.kind == MATCHER_CHECK_OPCODE) {
+    while (end < node->num_children &&
+           node->children[end]->op.kind == MATCHER_CHECK_OPCODE)
+      end++;
+  }
+  return end;
+}
+
+static void emit_children(const TrieNode *node, Table *t, int indent,
+                          int scopes) {
+  if (node->num_children == 0)
+    return;
+  if (segment_end(node, 0) == node->num_children) {
+    emit_segment(node, 0, node->num_children, t, indent, scopes);
+    return;
+  }
+  if (scopes + 1 > max_scopes)
+    max_scopes = scopes + 1;
+  table_line(t, indent, 1, NULL, "MATCHER_SCOPE,");
+  for (int begin = 0; begin < node->num_children;) {
+    int end = segment_end(node, begin);
+    Table sub = {0};
+    emit_segment(node, begin, end, &sub, indent + 2, scopes + 1);
+    table_line(t, indent + 1, 1, NULL, "%d,", sub.count);
+    table_append(t, &sub);
+    begin = end;
+  }
+  table_line(t, indent, 1, NULL, "0,");
+}
+
+// --- 主流程 ---
+
+static char *trim(char *s) {
+  while (isspace((unsigned char)*s))
+    s++;
+  size_t n = strlen(s);
+  while (n > 0 && isspace((unsigned char)s[n - 1]))
+    s[--n] = '\0';
+  return s;
+}
+
+static int parse_file(FILE *in, Pattern **out_patterns) {
+  Pattern *patterns = NULL;
+  int count = 0;
+  int cap = 0;
+  char buf[MAX_LINE];
+  for (int line = 1; fgets(buf, sizeof(buf), in); line++) {
+    if (!strchr(buf, '\n') && !feof(in))
+      fail(line, "line too long");
+    char *hash = strchr(buf, '#');
+    if (hash)
+      *hash = '\0';
+    char *text = trim(buf);
+    if (!*text)
+      continue;
+
+    Pattern pat = {.line = line, .text = xstrdup(text)};
+    Lexer lx = {.p = text, .line = line};
+    next_token(&lx);
+    pat.lhs = parse_expr(&lx, true);
+    if (lx.kind != TOK_ARROW)
+      fail(line, "expected '->'");
+    next_token(&lx);
+    pat.rhs = parse_expr(&lx, false);
+    if (lx.kind == TOK_IDENT && strcmp(lx.text, "if") == 0) {
+      next_token(&lx);
+      do {
+        if (pat.num_conds == MAX_CONDS)
+          fail(line, "too many conditions");
+        pat.conds[pat.num_conds++] = parse_cond(&lx);
+      } while (lx.kind == TOK_LPAREN);
+    }
+    if (lx.kind != TOK_END)
+      fail(line, "unexpected trailing tokens");
+    check_pattern(&pat);
+
+    if (count == cap) {
+      cap = cap ? cap * 2 : 64;
+      patterns = xrealloc(patterns, cap * sizeof(Pattern));
+    }
+    patterns[count++] = pat;
+  }
+  *out_patterns = patterns;
+  return count;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <patterns.pat> <output.inc>\n", argv[0]);
+    return 2;
+  }
+  input_path = argv[1];
+  FILE *in = fopen(argv[1], "r");
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+  Pattern *patterns;
+  int num_patterns = parse_file(in, &patterns);
+  fclose(in);
+  if (num_patterns == 0)
+    fail(1, "no patterns");
+
+  // 生成文件中的注释只保留文件名，避免把构建目录写进源码
+  const char *slash = strrchr(input_path, '/');
+  input_path = slash ? slash + 1 : input_path;
+
+  char tmp_path[4096];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", argv[2]);
+  FILE *out = fopen(tmp_path, "w");
+  if (!out) {
+    perror(tmp_path);
+    return 1;
+  }
+
+  TrieNode root = {0};
+  int num_variants = 0;
+  int max_records = 1;
+  int max_depth = 1;
+  StrBuf rewrites = {0};
+  fprintf(out, "// 由 inst_combine_gen 根据 %s 生成，请勿手工修改。\n\n",
+          input_path);
+  for (int i = 0; i < num_patterns; i++) {
+    ExprList variants = expand_commutative(patterns[i].lhs);
+    for (int j = 0; j < variants.count; j++) {
+      Variant v = {0};
+      linearize(&v, variants.items[j]);
+      while (v.num_ops > 0 && v.ops[v.num_ops - 1].kind == MATCHER_MOVE_PARENT)
+        v.num_ops--; // 匹配结束时不需要回到根
+      push_op(&v, MATCHER_COMPLETE, num_variants, 0);
+      trie_insert(&root, &v, patterns[i].text);
+      gen_rewrite(out, &patterns[i], &v, num_variants);
+      sb_printf(&rewrites, "    inst_combine_rewrite_%d,\n", num_variants);
+      if (v.num_records > max_records)
+        max_records = v.num_records;
+      if (v.max_depth > max_depth)
+        max_depth = v.max_depth;
+      num_variants++;
+      free(v.ops);
+    }
+    free(variants.items);
+  }
+
+  Table table = {0};
+  emit_children(&root, &table, 0, 0);
+
+  fprintf(out, "#define INST_COMBINE_MATCHER_MAX_RECORDS %d\n", max_records);
+  fprintf(out, "#define INST_COMBINE_MATCHER_MAX_DEPTH %d\n", max_depth);
+  fprintf(out, "#define INST_COMBINE_MATCHER_MAX_SCOPES %d\n\n",
+          max_scopes > 0 ? max_scopes : 1);
+  fprintf(out, "static const PatternRewriteFn inst_combine_rewrites[%d] = {\n",
+          num_variants);
+  fputs(rewrites.data, out);
+  fprintf(out, "};\n\n");
+
+  fprintf(out,
+          "// %d 条模式展开为 %d 个变体，匹配表共 %d 项。\n"
+          "static const int32_t inst_combine_matcher_table[%d] = {\n",
+          num_patterns, num_variants, table.count, table.count);
+  int index = 0;
+  for (int i = 0; i < table.num_lines; i++) {
+    TableLine *l = &table.lines[i];
+    fprintf(out, "/* %5d */ %*s%s", index, l->indent * 2, "", l->text);
+    if (l->comment)
+      fprintf(out, " // %s", l->comment);
+    fputc('\n', out);
+    index += l->count;
+  }
+  fprintf(out, "};\n");
+
+  if (fclose(out) != 0 || rename(tmp_path, argv[2]) != 0) {
+    perror(argv[2]);
+    return 1;
+  }
+  return 0;
+}